@@ -33,6 +33,10 @@
 #include <fcntl.h>
 #else
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 namespace X265_NS {
@@ -306,4 +310,76 @@ error:
     return NULL;
 }
 
+/* Map a whole file read-only into memory. The pages are faulted in by the OS
+ * on first access, so large files can be walked sequentially without an
+ * intermediate copy. Returns NULL on failure, otherwise the file size is
+ * returned in *size and the mapping must be released by x265_unmap_file() */
+void* x265_map_file(const char *filename, size_t *size)
+{
+    if (!filename || !size)
+        return NULL;
+
+    void *map = NULL;
+#if _WIN32
+    wchar_t buf_utf16[MAX_PATH * 2];
+    if (!MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, filename, -1, buf_utf16, sizeof(buf_utf16)/sizeof(wchar_t)))
+        return NULL;
+    HANDLE file = CreateFileW(buf_utf16, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        x265_log_file(NULL, X265_LOG_ERROR, "unable to open file %s\n", filename);
+        return NULL;
+    }
+    LARGE_INTEGER fSize;
+    if (GetFileSizeEx(file, &fSize) && fSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)fSize.QuadPart;
+    }
+    CloseHandle(file);
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        x265_log_file(NULL, X265_LOG_ERROR, "unable to open file %s\n", filename);
+        return NULL;
+    }
+    struct stat st;
+    if (!fstat(fd, &st) && st.st_size > 0)
+    {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+            map = NULL;
+        else
+        {
+#if defined(POSIX_MADV_SEQUENTIAL)
+            posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+            *size = (size_t)st.st_size;
+        }
+    }
+    close(fd);
+#endif
+    if (!map)
+        x265_log(NULL, X265_LOG_ERROR, "unable to map the file %s\n", filename);
+    return map;
+}
+
+void x265_unmap_file(void *map, size_t size)
+{
+    if (!map)
+        return;
+#if _WIN32
+    (void)size;
+    UnmapViewOfFile(map);
+#else
+    munmap(map, size);
+#endif
+}
+
 }
@@ -95,6 +95,7 @@ const cpu_name_t cpu_names[] =
     { "SlowAtom",        X265_CPU_SLOW_ATOM },
     { "SlowPshufb",      X265_CPU_SLOW_PSHUFB },
     { "SlowPalignr",     X265_CPU_SLOW_PALIGNR },
+    { "PCLMUL",          X265_CPU_PCLMUL },
     { "SlowShuffle",     X265_CPU_SLOW_SHUFFLE },
     { "UnalignedStack",  X265_CPU_STACK_MOD4 },
 
@@ -163,6 +164,8 @@ uint32_t cpu_detect(bool benableavx512 )
         cpu |= X265_CPU_SSE4;
     if (ecx & 0x00100000)
         cpu |= X265_CPU_SSE42;
+    if (ecx & 0x00000002)
+        cpu |= X265_CPU_PCLMUL;
 
     if (ecx & 0x08000000) /* XGETBV supported and XSAVE enabled by OS */
     {
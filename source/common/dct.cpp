@@ -1068,6 +1068,49 @@ static void psyRdoQuant_c_2(int16_t *m_resiDctCoeff, int16_t *m_fencDctCoeff, in
 	}
 }
 
+/* Costs of the 4x4 coefficient group at blkPos needed by RDOQ, independent of
+ * the CABAC state: the uncoded cost of each coefficient in costUncoded[] and,
+ * in group raster order, the distortion of coding its quantized level in
+ * costLevel[0..15] and of coding that level less one in costLevel[16..31].
+ * Psy-rd bias applies to all but the DC coefficient; psyScale 0 disables it */
+template<int log2TrSize>
+static void rdoQuantLevelDist_c(const int16_t* resiDctCoeff, const int16_t* fencDctCoeff, const int16_t* levels, const int32_t* unquantScale, int64_t* costUncoded, int64_t* costLevel, int64_t psyScale, int per, int unquantShift, uint32_t blkPos)
+{
+    const int transformShift = MAX_TR_DYNAMIC_RANGE - X265_DEPTH - log2TrSize; /* Represents scaling through forward transform */
+    const int scaleBits = SCALE_BITS - 2 * transformShift;
+    const int psyShift = X265_MAX(0, (2 * transformShift + 1));
+    const int unquantRound = (unquantShift > per) ? 1 << (unquantShift - per - 1) : 0;
+    const uint32_t trSize = 1 << log2TrSize;
+
+    for (int y = 0; y < MLS_CG_SIZE; y++)
+    {
+        for (int x = 0; x < MLS_CG_SIZE; x++)
+        {
+            const uint32_t pos = blkPos + x;
+            const int signCoef = resiDctCoeff[pos];                 /* pre-quantization DCT coeff */
+            const int predictedCoef = fencDctCoeff[pos] - signCoef; /* predicted DCT = source DCT - residual DCT */
+            const int64_t psy = pos ? psyScale : 0;
+            const int sign = signCoef >> 31;
+            int64_t* cost = &costLevel[y * MLS_CG_SIZE + x];
+
+            costUncoded[pos] = ((int64_t)signCoef * signCoef) << scaleBits;
+            costUncoded[pos] -= (psy * predictedCoef) >> psyShift;
+
+            const uint32_t level = levels[pos];
+            const uint32_t levelScale = unquantScale[pos] << per;
+            const uint32_t unQuantLevel = level * levelScale + unquantRound;
+            const int unquantAbsLevel0 = unQuantLevel >> unquantShift;
+            const int unquantAbsLevel1 = (unQuantLevel - (level ? levelScale : 0)) >> unquantShift;
+            const int d0 = abs(signCoef) - unquantAbsLevel0;
+            const int d1 = abs(signCoef) - unquantAbsLevel1;
+
+            cost[0] = (((int64_t)d0 * d0) << scaleBits) - ((psy * abs(unquantAbsLevel0 + ((predictedCoef ^ sign) - sign))) >> psyShift);
+            cost[MLS_CG_BLK_SIZE] = (((int64_t)d1 * d1) << scaleBits) - ((psy * abs(unquantAbsLevel1 + ((predictedCoef ^ sign) - sign))) >> psyShift);
+        }
+        blkPos += trSize;
+    }
+}
+
 namespace X265_NS {
 // x265 private namespace
 void setupDCTPrimitives_c(EncoderPrimitives& p)
@@ -1112,6 +1155,10 @@ void setupDCTPrimitives_c(EncoderPrimitives& p)
 	p.cu[BLOCK_16x16].psyRdoQuant_2p = psyRdoQuant_c_2<4>;
 	p.cu[BLOCK_32x32].psyRdoQuant_1p = psyRdoQuant_c_1<5>;
 	p.cu[BLOCK_32x32].psyRdoQuant_2p = psyRdoQuant_c_2<5>;
+    p.cu[BLOCK_4x4].rdoQuantLevelDist = rdoQuantLevelDist_c<2>;
+    p.cu[BLOCK_8x8].rdoQuantLevelDist = rdoQuantLevelDist_c<3>;
+    p.cu[BLOCK_16x16].rdoQuantLevelDist = rdoQuantLevelDist_c<4>;
+    p.cu[BLOCK_32x32].rdoQuantLevelDist = rdoQuantLevelDist_c<5>;
     p.scanPosLast = scanPosLast_c;
     p.findPosFirstLast = findPosFirstLast_c;
     p.costCoeffNxN = costCoeffNxN_c;
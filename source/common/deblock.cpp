@@ -34,13 +34,54 @@ using namespace X265_NS;
 #define DEBLOCK_SMALLEST_BLOCK  8
 #define DEFAULT_INTRA_TC_OFFSET 2
 
-void Deblock::deblockCTU(const CUData* ctu, const CUGeom& cuGeom, int32_t dir)
+void Deblock::setEdgeMap(const CUData* ctu, const CUGeom& cuGeom, EdgeMap& map)
 {
     uint8_t blockStrength[MAX_NUM_PARTITIONS];
+    bool bCheckNoFilter = ctu->m_slice->m_pps->bTransquantBypassEnabled;
 
-    memset(blockStrength, 0, sizeof(uint8_t) * cuGeom.numPartitions);
+    for (int32_t dir = EDGE_VER; dir <= EDGE_HOR; dir++)
+    {
+        memset(blockStrength, 0, sizeof(uint8_t) * cuGeom.numPartitions);
+        setEdgefilterCU(ctu, cuGeom, dir, blockStrength);
+
+        memset(map.bs[dir], 0, sizeof(map.bs[dir]));
+        for (uint32_t partQ = 0; partQ < cuGeom.numPartitions; partQ++)
+        {
+            // only units on the 8x8 grid hold the strength of an edge
+            if ((partQ & (1 << dir)) || !blockStrength[partQ])
+                continue;
+
+            uint32_t partP;
+            const CUData* cuP = (dir == EDGE_VER ? ctu->getPULeft(partP, partQ) : ctu->getPUAbove(partP, partQ));
+            uint32_t unit = g_zscanToRaster[partQ];
+
+            map.bs[dir][unit] = blockStrength[partQ];
+            map.qp[dir][unit] = (int8_t)((cuP->m_qp[partP] + ctu->m_qp[partQ] + 1) >> 1);
+            map.bypass[dir][unit] = bCheckNoFilter ? (uint8_t)((cuP->m_tqBypass[partP] ? 1 : 0) | (ctu->m_tqBypass[partQ] ? 2 : 0)) : 0;
+        }
+    }
+}
+
+/* The edges of one direction are 8 samples apart and the filters change at
+ * most 3 samples on either side, so they may be filtered in any order */
+void Deblock::deblockCTU(const CUData* ctu, const EdgeMap& map, int32_t dir)
+{
+    const SPS* sps = ctu->m_slice->m_sps;
+    uint32_t width = X265_MIN(g_maxCUSize, sps->picWidthInLumaSamples - ctu->m_cuPelX);
+    uint32_t height = X265_MIN(g_maxCUSize, sps->picHeightInLumaSamples - ctu->m_cuPelY);
+    uint32_t numEdges = (dir == EDGE_VER ? width : height) >> LOG2_UNIT_SIZE;
+    uint32_t numUnits = (dir == EDGE_VER ? height : width) >> LOG2_UNIT_SIZE;
+
+    const uint32_t partIdxIncr = DEBLOCK_SMALLEST_BLOCK >> LOG2_UNIT_SIZE;
+    uint32_t shiftFactor = (dir == EDGE_VER) ? ctu->m_hChromaShift : ctu->m_vChromaShift;
+    uint32_t chromaMask = ((DEBLOCK_SMALLEST_BLOCK << shiftFactor) >> LOG2_UNIT_SIZE) - 1;
 
-    deblockCU(ctu, cuGeom, dir, blockStrength);
+    for (uint32_t e = 0; e < numEdges; e += partIdxIncr)
+    {
+        edgeFilterLuma(ctu, map, dir, e, numUnits);
+        if (!(e & chromaMask) && ctu->m_chromaFormat != X265_CSP_I400)
+            edgeFilterChroma(ctu, map, dir, e, numUnits);
+    }
 }
 
 static inline uint8_t bsCuEdge(const CUData* cu, uint32_t absPartIdx, int32_t dir)
@@ -67,9 +108,9 @@ static inline uint8_t bsCuEdge(const CUData* cu, uint32_t absPartIdx, int32_t di
     return 0;
 }
 
-/* Deblocking filter process in CU-based (the same function as conventional's)
+/* Boundary strengths of the edges of a CU in one direction, before any filtering
  * param Edge the direction of the edge in block boundary (horizonta/vertical), which is added newly */
-void Deblock::deblockCU(const CUData* cu, const CUGeom& cuGeom, const int32_t dir, uint8_t blockStrength[])
+void Deblock::setEdgefilterCU(const CUData* cu, const CUGeom& cuGeom, const int32_t dir, uint8_t blockStrength[])
 {
     uint32_t absPartIdx = cuGeom.absPartIdx;
     uint32_t depth = cuGeom.depth;
@@ -82,7 +123,7 @@ void Deblock::deblockCU(const CUData* cu, const CUGeom& cuGeom, const int32_t di
         {
             const CUGeom& childGeom = *(&cuGeom + cuGeom.childOffset + subPartIdx);
             if (childGeom.flags & CUGeom::PRESENT)
-                deblockCU(cu, childGeom, dir, blockStrength);
+                setEdgefilterCU(cu, childGeom, dir, blockStrength);
         }
         return;
     }
@@ -100,18 +141,6 @@ void Deblock::deblockCU(const CUData* cu, const CUGeom& cuGeom, const int32_t di
         if (bsCheck && blockStrength[partIdx])
             blockStrength[partIdx] = getBoundaryStrength(cu, dir, partIdx, blockStrength);
     }
-
-    const uint32_t partIdxIncr = DEBLOCK_SMALLEST_BLOCK >> LOG2_UNIT_SIZE;
-    uint32_t shiftFactor = (dir == EDGE_VER) ? cu->m_hChromaShift : cu->m_vChromaShift;
-    uint32_t chromaMask = ((DEBLOCK_SMALLEST_BLOCK << shiftFactor) >> LOG2_UNIT_SIZE) - 1;
-    uint32_t e0 = (dir == EDGE_VER ? g_zscanToPelX[absPartIdx] : g_zscanToPelY[absPartIdx]) >> LOG2_UNIT_SIZE;
-        
-    for (uint32_t e = 0; e < numUnits; e += partIdxIncr)
-    {
-        edgeFilterLuma(cu, absPartIdx, depth, dir, e, blockStrength);
-        if (!((e0 + e) & chromaMask) && cu->m_chromaFormat != X265_CSP_I400)
-            edgeFilterChroma(cu, absPartIdx, depth, dir, e, blockStrength);
-    }
 }
 
 static inline uint32_t calcBsIdx(uint32_t absPartIdx, int32_t dir, int32_t edgeIdx, int32_t baseUnitIdx)
@@ -314,20 +343,60 @@ static inline void pelFilterLuma(pixel* src, intptr_t srcStep, intptr_t offset,
     }
 }
 
-void Deblock::edgeFilterLuma(const CUData* cuQ, uint32_t absPartIdx, uint32_t depth, int32_t dir, int32_t edge, const uint8_t blockStrength[])
+/* One segment of UNIT_SIZE lines across a luma edge, sides masked off where
+ * they are coded lossless */
+static void filterLumaUnit(int32_t dir, pixel* src, intptr_t srcStep, intptr_t offset, int32_t beta, int32_t tc, int32_t maskP, int32_t maskQ)
 {
-    PicYuv* reconPic = cuQ->m_encData->m_reconPic;
-    pixel* src = reconPic->getLumaAddr(cuQ->m_cuAddr, absPartIdx);
+    int32_t dp0 = calcDP(src              , offset);
+    int32_t dq0 = calcDQ(src              , offset);
+    int32_t dp3 = calcDP(src + srcStep * 3, offset);
+    int32_t dq3 = calcDQ(src + srcStep * 3, offset);
+    int32_t d0 = dp0 + dq0;
+    int32_t d3 = dp3 + dq3;
+
+    int32_t d =  d0 + d3;
+
+    if (d >= beta)
+        return;
+
+    bool sw = (2 * d0 < (beta >> 2) &&
+               2 * d3 < (beta >> 2) &&
+               useStrongFiltering(offset, beta, tc, src              ) &&
+               useStrongFiltering(offset, beta, tc, src + srcStep * 3));
+
+    if (sw)
+    {
+        int32_t tc2 = 2 * tc;
+        int32_t tcP = (tc2 & maskP);
+        int32_t tcQ = (tc2 & maskQ);
+        primitives.pelFilterLumaStrong[dir](src, srcStep, offset, tcP, tcQ);
+    }
+    else
+    {
+        int32_t sideThreshold = (beta + (beta >> 1)) >> 3;
+        int32_t dp = dp0 + dp3;
+        int32_t dq = dq0 + dq3;
+        int32_t maskP1 = (dp < sideThreshold ? -1 : 0);
+        int32_t maskQ1 = (dq < sideThreshold ? -1 : 0);
+
+        pelFilterLuma(src, srcStep, offset, tc, maskP, maskQ, maskP1, maskQ1);
+    }
+}
+
+/* Gathers the thresholds of every unit along the edge and filters the edge in
+ * one call; units with a lossless side are filtered one at a time */
+void Deblock::edgeFilterLuma(const CUData* ctu, const EdgeMap& map, int32_t dir, uint32_t edge, uint32_t numUnits)
+{
+    PicYuv* reconPic = ctu->m_encData->m_reconPic;
+    pixel* src = reconPic->getLumaAddr(ctu->m_cuAddr);
     intptr_t stride = reconPic->m_stride;
-    const PPS* pps = cuQ->m_slice->m_pps;
+    const PPS* pps = ctu->m_slice->m_pps;
 
     intptr_t offset, srcStep;
 
-    int32_t maskP = -1;
-    int32_t maskQ = -1;
     int32_t betaOffset = pps->deblockingFilterBetaOffsetDiv2 << 1;
     int32_t tcOffset = pps->deblockingFilterTcOffsetDiv2 << 1;
-    bool bCheckNoFilter = pps->bTransquantBypassEnabled;
+    const int32_t bitdepthShift = X265_DEPTH - 8;
 
     if (dir == EDGE_VER)
     {
@@ -342,109 +411,73 @@ void Deblock::edgeFilterLuma(const CUData* cuQ, uint32_t absPartIdx, uint32_t de
         src += (edge << LOG2_UNIT_SIZE) * stride;
     }
 
-    uint32_t numUnits = cuQ->m_slice->m_sps->numPartInCUSize >> depth;
+    int16_t beta[RASTER_SIZE];
+    int16_t tc[RASTER_SIZE];
+    bool bFilter = false;
+
     for (uint32_t idx = 0; idx < numUnits; idx++)
     {
-        uint32_t partQ = calcBsIdx(absPartIdx, dir, edge, idx);
-        uint32_t bs = blockStrength[partQ];
+        uint32_t unit = (dir == EDGE_VER ? (idx << LOG2_RASTER_SIZE) + edge : (edge << LOG2_RASTER_SIZE) + idx);
+        uint32_t bs = map.bs[dir][unit];
 
+        beta[idx] = tc[idx] = 0;
         if (!bs)
             continue;
 
-        // Derive neighboring PU index
-        uint32_t partP;
-        const CUData* cuP = (dir == EDGE_VER ? cuQ->getPULeft(partP, partQ) : cuQ->getPUAbove(partP, partQ));
-
-        if (bCheckNoFilter)
-        {
-            // check if each of PUs is lossless coded
-            maskP = cuP->m_tqBypass[partP] - 1;
-            maskQ = cuQ->m_tqBypass[partQ] - 1;
-            if (!(maskP | maskQ))
-                continue;
-        }
-
-        int32_t qpQ = cuQ->m_qp[partQ];
-        int32_t qpP = cuP->m_qp[partP];
-        int32_t qp  = (qpP + qpQ + 1) >> 1;
-
+        int32_t qp = map.qp[dir][unit];
         int32_t indexB = x265_clip3(0, QP_MAX_SPEC, qp + betaOffset);
-
-        const int32_t bitdepthShift = X265_DEPTH - 8;
-        int32_t beta = s_betaTable[indexB] << bitdepthShift;
-
-        intptr_t unitOffset = idx * srcStep << LOG2_UNIT_SIZE;
-        int32_t dp0 = calcDP(src + unitOffset              , offset);
-        int32_t dq0 = calcDQ(src + unitOffset              , offset);
-        int32_t dp3 = calcDP(src + unitOffset + srcStep * 3, offset);
-        int32_t dq3 = calcDQ(src + unitOffset + srcStep * 3, offset);
-        int32_t d0 = dp0 + dq0;
-        int32_t d3 = dp3 + dq3;
-
-        int32_t d =  d0 + d3;
-
-        if (d >= beta)
-            continue;
-
         int32_t indexTC = x265_clip3(0, QP_MAX_SPEC + DEFAULT_INTRA_TC_OFFSET, int32_t(qp + DEFAULT_INTRA_TC_OFFSET * (bs - 1) + tcOffset));
-        int32_t tc = s_tcTable[indexTC] << bitdepthShift;
+        int32_t unitBeta = s_betaTable[indexB] << bitdepthShift;
+        int32_t unitTc = s_tcTable[indexTC] << bitdepthShift;
 
-        bool sw = (2 * d0 < (beta >> 2) &&
-                   2 * d3 < (beta >> 2) &&
-                   useStrongFiltering(offset, beta, tc, src + unitOffset              ) &&
-                   useStrongFiltering(offset, beta, tc, src + unitOffset + srcStep * 3));
-
-        if (sw)
+        if (map.bypass[dir][unit])
         {
-            int32_t tc2 = 2 * tc;
-            int32_t tcP = (tc2 & maskP);
-            int32_t tcQ = (tc2 & maskQ);
-            primitives.pelFilterLumaStrong[dir](src + unitOffset, srcStep, offset, tcP, tcQ);
+            int32_t maskP = (map.bypass[dir][unit] & 1) ? 0 : -1;
+            int32_t maskQ = (map.bypass[dir][unit] & 2) ? 0 : -1;
+            if (maskP | maskQ)
+                filterLumaUnit(dir, src + (idx * srcStep << LOG2_UNIT_SIZE), srcStep, offset, unitBeta, unitTc, maskP, maskQ);
+            continue;
         }
-        else
-        {
-            int32_t sideThreshold = (beta + (beta >> 1)) >> 3;
-            int32_t dp = dp0 + dp3;
-            int32_t dq = dq0 + dq3;
-            int32_t maskP1 = (dp < sideThreshold ? -1 : 0);
-            int32_t maskQ1 = (dq < sideThreshold ? -1 : 0);
 
-            pelFilterLuma(src + unitOffset, srcStep, offset, tc, maskP, maskQ, maskP1, maskQ1);
-        }
+        beta[idx] = (int16_t)unitBeta;
+        tc[idx] = (int16_t)unitTc;
+        bFilter |= unitBeta > 0;
     }
+
+    if (bFilter)
+        primitives.pelFilterLumaEdge[dir](src, srcStep, offset, beta, tc, numUnits);
 }
 
-void Deblock::edgeFilterChroma(const CUData* cuQ, uint32_t absPartIdx, uint32_t depth, int32_t dir, int32_t edge, const uint8_t blockStrength[])
+void Deblock::edgeFilterChroma(const CUData* ctu, const EdgeMap& map, int32_t dir, uint32_t edge, uint32_t numUnits)
 {
-    int32_t chFmt = cuQ->m_chromaFormat, chromaShift;
+    int32_t chFmt = ctu->m_chromaFormat, chromaShift;
     intptr_t offset, srcStep;
-    const PPS* pps = cuQ->m_slice->m_pps;
+    const PPS* pps = ctu->m_slice->m_pps;
 
     int32_t maskP = -1;
     int32_t maskQ = -1;
     int32_t tcOffset = pps->deblockingFilterTcOffsetDiv2 << 1;
 
     X265_CHECK(((dir == EDGE_VER)
-                ? ((g_zscanToPelX[absPartIdx] + edge * UNIT_SIZE) >> cuQ->m_hChromaShift)
-                : ((g_zscanToPelY[absPartIdx] + edge * UNIT_SIZE) >> cuQ->m_vChromaShift)) % DEBLOCK_SMALLEST_BLOCK == 0,
+                ? ((edge * UNIT_SIZE) >> ctu->m_hChromaShift)
+                : ((edge * UNIT_SIZE) >> ctu->m_vChromaShift)) % DEBLOCK_SMALLEST_BLOCK == 0,
                "invalid edge\n");
 
-    PicYuv* reconPic = cuQ->m_encData->m_reconPic;
+    PicYuv* reconPic = ctu->m_encData->m_reconPic;
     intptr_t stride = reconPic->m_strideC;
-    intptr_t srcOffset = reconPic->getChromaAddrOffset(cuQ->m_cuAddr, absPartIdx);
-    bool bCheckNoFilter = pps->bTransquantBypassEnabled;
+    intptr_t srcOffset = reconPic->m_cuOffsetC[ctu->m_cuAddr];
 
     if (dir == EDGE_VER)
     {
-        chromaShift = cuQ->m_vChromaShift;
-        srcOffset += (edge << (LOG2_UNIT_SIZE - cuQ->m_hChromaShift));
+        chromaShift = ctu->m_vChromaShift;
+        srcOffset += (edge << (LOG2_UNIT_SIZE - ctu->m_hChromaShift));
         offset     = 1;
         srcStep    = stride;
     }
     else // (dir == EDGE_HOR)
     {
-        chromaShift = cuQ->m_hChromaShift;
-        srcOffset += edge * stride << (LOG2_UNIT_SIZE - cuQ->m_vChromaShift);
+        chromaShift = ctu->m_hChromaShift;
+        srcOffset += edge * stride << (LOG2_UNIT_SIZE - ctu->m_vChromaShift);
         offset     = stride;
         srcStep    = 1;
     }
@@ -453,31 +486,26 @@ void Deblock::edgeFilterChroma(const CUData* cuQ, uint32_t absPartIdx, uint32_t
     srcChroma[0] = reconPic->m_picOrg[1] + srcOffset;
     srcChroma[1] = reconPic->m_picOrg[2] + srcOffset;
 
-    uint32_t numUnits = cuQ->m_slice->m_sps->numPartInCUSize >> (depth + chromaShift);
-    for (uint32_t idx = 0; idx < numUnits; idx++)
+    for (uint32_t idx = 0; idx < (numUnits >> chromaShift); idx++)
     {
-        uint32_t partQ = calcBsIdx(absPartIdx, dir, edge, idx << chromaShift);
-        uint32_t bs = blockStrength[partQ];
+        uint32_t along = idx << chromaShift;
+        uint32_t unit = (dir == EDGE_VER ? (along << LOG2_RASTER_SIZE) + edge : (edge << LOG2_RASTER_SIZE) + along);
 
-        if (bs <= 1)
+        if (map.bs[dir][unit] <= 1)
             continue;
 
-        // Derive neighboring PU index
-        uint32_t partP;
-        const CUData* cuP = (dir == EDGE_VER ? cuQ->getPULeft(partP, partQ) : cuQ->getPUAbove(partP, partQ));
-
-        if (bCheckNoFilter)
+        if (map.bypass[dir][unit])
         {
             // check if each of PUs is lossless coded
-            maskP = (cuP->m_tqBypass[partP] ? 0 : -1);
-            maskQ = (cuQ->m_tqBypass[partQ] ? 0 : -1);
+            maskP = (map.bypass[dir][unit] & 1) ? 0 : -1;
+            maskQ = (map.bypass[dir][unit] & 2) ? 0 : -1;
             if (!(maskP | maskQ))
                 continue;
         }
+        else
+            maskP = maskQ = -1;
 
-        int32_t qpQ = cuQ->m_qp[partQ];
-        int32_t qpP = cuP->m_qp[partP];
-        int32_t qpA = (qpP + qpQ + 1) >> 1;
+        int32_t qpA = map.qp[dir][unit];
 
         intptr_t unitOffset = idx * srcStep << LOG2_UNIT_SIZE;
         for (uint32_t chromaIdx = 0; chromaIdx < 2; chromaIdx++)
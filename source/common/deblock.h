@@ -38,12 +38,27 @@ class Deblock
 public:
     enum { EDGE_VER, EDGE_HOR };
 
-    static void deblockCTU(const CUData* ctu, const CUGeom& cuGeom, int32_t dir);
+    /* Filter inputs of the 4x4 units of a CTU, taken from its coding data once
+     * for both passes. Per direction and in raster order of the units: the
+     * boundary strength of the left or top edge of the unit (0 where the edge
+     * is not filtered), the average QP of the two sides of the edge and which
+     * sides are coded lossless (bit 0 P, bit 1 Q) */
+    struct EdgeMap
+    {
+        uint8_t bs[2][MAX_NUM_PARTITIONS];
+        int8_t  qp[2][MAX_NUM_PARTITIONS];
+        uint8_t bypass[2][MAX_NUM_PARTITIONS];
+    };
+
+    static void setEdgeMap(const CUData* ctu, const CUGeom& cuGeom, EdgeMap& map);
+
+    // filter the edges of one direction over the whole CTU
+    static void deblockCTU(const CUData* ctu, const EdgeMap& map, int32_t dir);
 
 protected:
 
-    // CU-level deblocking function
-    static void deblockCU(const CUData* cu, const CUGeom& cuGeom, const int32_t dir, uint8_t blockStrength[]);
+    // CU-level boundary strength derivation
+    static void setEdgefilterCU(const CUData* cu, const CUGeom& cuGeom, const int32_t dir, uint8_t blockStrength[]);
 
     // set filtering functions
     static void setEdgefilterTU(const CUData* cu, uint32_t absPartIdx, uint32_t tuDepth, int32_t dir, uint8_t blockStrength[]);
@@ -53,9 +68,9 @@ protected:
     // get filtering functions
     static uint8_t getBoundaryStrength(const CUData* cuQ, int32_t dir, uint32_t partQ, const uint8_t blockStrength[]);
 
-    // filter luma/chroma functions
-    static void edgeFilterLuma(const CUData* cuQ, uint32_t absPartIdx, uint32_t depth, int32_t dir, int32_t edge, const uint8_t blockStrength[]);
-    static void edgeFilterChroma(const CUData* cuQ, uint32_t absPartIdx, uint32_t depth, int32_t dir, int32_t edge, const uint8_t blockStrength[]);
+    // filter luma/chroma functions, numUnits units along the edge
+    static void edgeFilterLuma(const CUData* ctu, const EdgeMap& map, int32_t dir, uint32_t edge, uint32_t numUnits);
+    static void edgeFilterChroma(const CUData* ctu, const EdgeMap& map, int32_t dir, uint32_t edge, uint32_t numUnits);
 
     static const uint8_t s_tcTable[54];
     static const uint8_t s_betaTable[52];
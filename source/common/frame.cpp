@@ -57,6 +57,7 @@ Frame::Frame()
     m_addOnPrevChange = NULL;
     m_classifyFrame = false;
     m_fieldNum = 0;
+    m_vmafMotion = 0;
     m_picStruct = 0;
     m_edgePic = NULL;
     m_gaussianPic = NULL;
@@ -144,20 +145,12 @@ bool Frame::allocEncodeData(x265_param *param, const SPS& sps)
     bool ok = m_encData->create(*param, sps, m_fencPic->m_picCsp) && m_reconPic->create(param);
     if (ok)
     {
-        /* initialize right border of m_reconpicYuv as SAO may read beyond the
-         * end of the picture accessing uninitialized pixels */
-        int maxHeight = sps.numCuInHeight * param->maxCUSize;
-        memset(m_reconPic->m_picOrg[0], 0, sizeof(pixel)* m_reconPic->m_stride * maxHeight);
-
         /* use pre-calculated cu/pu offsets cached in the SPS structure */
         m_reconPic->m_cuOffsetY = sps.cuOffsetY;
         m_reconPic->m_buOffsetY = sps.buOffsetY;
 
         if (param->internalCsp != X265_CSP_I400)
         {
-            memset(m_reconPic->m_picOrg[1], 0, sizeof(pixel) * m_reconPic->m_strideC * (maxHeight >> m_reconPic->m_vChromaShift));
-            memset(m_reconPic->m_picOrg[2], 0, sizeof(pixel) * m_reconPic->m_strideC * (maxHeight >> m_reconPic->m_vChromaShift));
-
             /* use pre-calculated cu/pu offsets cached in the SPS structure */
             m_reconPic->m_cuOffsetC = sps.cuOffsetC;
             m_reconPic->m_buOffsetC = sps.buOffsetC;
@@ -166,6 +159,23 @@ bool Frame::allocEncodeData(x265_param *param, const SPS& sps)
     return ok;
 }
 
+/* initialize right border of m_reconpicYuv as SAO may read beyond the end of
+ * the picture accessing uninitialized pixels. This is the first write to the
+ * recon planes, so it is left to the frame encoder thread to place their pages
+ * on its NUMA node */
+void Frame::clearRecon(const SPS& sps)
+{
+    int maxHeight = sps.numCuInHeight * m_param->maxCUSize;
+    memset(m_reconPic->m_picOrg[0], 0, sizeof(pixel) * m_reconPic->m_stride * maxHeight);
+
+    if (m_param->internalCsp != X265_CSP_I400)
+    {
+        memset(m_reconPic->m_picOrg[1], 0, sizeof(pixel) * m_reconPic->m_strideC * (maxHeight >> m_reconPic->m_vChromaShift));
+        memset(m_reconPic->m_picOrg[2], 0, sizeof(pixel) * m_reconPic->m_strideC * (maxHeight >> m_reconPic->m_vChromaShift));
+    }
+    m_encData->m_bReconCleared = true;
+}
+
 /* prepare to re-use a FrameData instance to encode a new picture */
 void Frame::reinit(const SPS& sps)
 {
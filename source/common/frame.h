@@ -131,6 +131,7 @@ public:
 
     bool                   m_classifyFrame;
     int                    m_fieldNum;
+    double                 m_vmafMotion;         // motion feature against the previous source picture
 
     /* aq-mode 4 : Gaussian, edge and theta frames for edge information */
     pixel*                 m_edgePic;
@@ -141,6 +142,7 @@ public:
 
     bool create(x265_param *param, float* quantOffsets);
     bool allocEncodeData(x265_param *param, const SPS& sps);
+    void clearRecon(const SPS& sps);
     void reinit(const SPS& sps);
     void destroy();
 };
@@ -118,6 +118,8 @@ public:
     PicYuv*        m_reconPic;
     bool           m_bHasReferences;   /* used during DPB/RPS updates */
     int            m_frameEncoderID;   /* the ID of the FrameEncoder encoding this frame */
+    int            m_poolId;           /* thread pool (NUMA node) whose frame encoder first wrote m_reconPic */
+    bool           m_bReconCleared;    /* m_reconPic has been zeroed by the first frame encoder to use it */
     JobProvider*   m_jobProvider;
 
     CUDataMemPool  m_cuMemPool;
@@ -171,6 +173,9 @@ public:
     uint32_t*              m_meIntegral[INTEGRAL_PLANE_NUM];       // 12 integral planes for 32x32, 32x24, 32x8, 24x32, 16x16, 16x12, 16x4, 12x16, 8x32, 8x8, 4x16 and 4x4.
     uint32_t*              m_meBuffer[INTEGRAL_PLANE_NUM];
 
+    pixel*                 m_hpelPlane[3];       // half-pel luma planes: horizontal, vertical and diagonal
+    pixel*                 m_hpelBuffer[3];
+
     FrameData();
 
     bool create(const x265_param& param, const SPS& sps, int csp);
@@ -158,6 +158,83 @@ static void pelFilterLumaStrong_c(pixel* src, intptr_t srcStep, intptr_t offset,
     }
 }
 
+/* Deblocking of all segments of UNIT_SIZE lines along one luma edge, with the
+ * filter decisions of each segment taken from its first and last line
+* \param src     pointer to the first line at the edge
+* \param srcStep offset between lines
+* \param offset  offset across the edge
+* \param beta    beta of each segment, 0 when the segment is not filtered
+* \param tc      tc of each segment
+* \param numSegs number of segments along the edge */
+static void pelFilterLumaEdge_c(pixel* src, intptr_t srcStep, intptr_t offset, const int16_t* beta, const int16_t* tc, int numSegs)
+{
+    for (int seg = 0; seg < numSegs; seg++, src += srcStep * UNIT_SIZE)
+    {
+        if (!beta[seg])
+            continue;
+
+        int32_t b = beta[seg];
+        int32_t t = tc[seg];
+        int32_t dp0 = abs(src[-offset * 3] - 2 * src[-offset * 2] + src[-offset]);
+        int32_t dq0 = abs(src[0] - 2 * src[offset] + src[offset * 2]);
+        pixel* src3 = src + srcStep * 3;
+        int32_t dp3 = abs(src3[-offset * 3] - 2 * src3[-offset * 2] + src3[-offset]);
+        int32_t dq3 = abs(src3[0] - 2 * src3[offset] + src3[offset * 2]);
+        int32_t d0 = dp0 + dq0;
+        int32_t d3 = dp3 + dq3;
+
+        if (d0 + d3 >= b)
+            continue;
+
+        bool sw = 2 * d0 < (b >> 2) && 2 * d3 < (b >> 2);
+        for (int i = 0; i < 4 && sw; i += 3)
+        {
+            pixel* s = src + srcStep * i;
+            sw = abs(s[-offset * 4] - s[-offset]) + abs(s[offset * 3] - s[0]) < (b >> 3) &&
+                 abs(s[-offset] - s[0]) < ((t * 5 + 1) >> 1);
+        }
+
+        if (sw)
+        {
+            pelFilterLumaStrong_c(src, srcStep, offset, 2 * t, 2 * t);
+            continue;
+        }
+
+        int32_t sideThreshold = (b + (b >> 1)) >> 3;
+        bool bP1 = dp0 + dp3 < sideThreshold;
+        bool bQ1 = dq0 + dq3 < sideThreshold;
+        int32_t thrCut = t * 10;
+        int32_t t2 = t >> 1;
+        pixel* s = src;
+
+        for (int32_t i = 0; i < UNIT_SIZE; i++, s += srcStep)
+        {
+            int16_t m4 = (int16_t)s[0];
+            int16_t m3 = (int16_t)s[-offset];
+            int16_t m5 = (int16_t)s[offset];
+            int16_t m2 = (int16_t)s[-offset * 2];
+
+            int32_t delta = (9 * (m4 - m3) - 3 * (m5 - m2) + 8) >> 4;
+            if (abs(delta) >= thrCut)
+                continue;
+
+            delta = x265_clip3(-t, t, delta);
+            s[-offset] = x265_clip(m3 + delta);
+            s[0] = x265_clip(m4 - delta);
+            if (bP1)
+            {
+                int16_t m1 = (int16_t)s[-offset * 3];
+                s[-offset * 2] = x265_clip(m2 + x265_clip3(-t2, t2, ((((m1 + m3 + 1) >> 1) - m2 + delta) >> 1)));
+            }
+            if (bQ1)
+            {
+                int16_t m6 = (int16_t)s[offset * 2];
+                s[offset] = x265_clip(m5 + x265_clip3(-t2, t2, ((((m6 + m4 + 1) >> 1) - m5 - delta) >> 1)));
+            }
+        }
+    }
+}
+
 /* Deblocking of one line/column for the chrominance component
 * \param src     pointer to picture data
 * \param offset  offset value for picture data
@@ -198,5 +275,7 @@ void setupLoopFilterPrimitives_c(EncoderPrimitives &p)
     p.pelFilterLumaStrong[1] = pelFilterLumaStrong_c;
     p.pelFilterChroma[0]     = pelFilterChroma_c;
     p.pelFilterChroma[1]     = pelFilterChroma_c;
+    p.pelFilterLumaEdge[0]   = pelFilterLumaEdge_c;
+    p.pelFilterLumaEdge[1]   = pelFilterLumaEdge_c;
 }
 }
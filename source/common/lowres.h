@@ -38,6 +38,7 @@ struct ReferencePlanes
 
     pixel*   fpelPlane[3];
     pixel*   lowresPlane[4];
+    pixel*   hpelPlane[3];     /* precomputed half-pel luma (H, V, HV) of the unweighted plane, or NULL */
     PicYuv*  reconPic;
 
     /* 1/16th resolution : Level-0 HME planes */
@@ -180,6 +180,26 @@ void x265_param_default(x265_param* param)
     param->bEnableSceneCutAwareQp = 0;
     param->scenecutWindow = 500;
     param->maxQpDelta = 5;
+    param->bDeterministic = 0;
+    param->statsFormat = X265_STATS_FORMAT_TEXT;
+    param->segmentFrames = 0;
+    param->segmentIndex = -1;
+    param->segmentPlanFile = NULL;
+    param->bSpeculativeRC = 0;
+    param->bEnableCUPredictor = 0;
+    param->cuPredictorModel = NULL;
+    param->cuPredictorDump = NULL;
+    param->bLowresMVConfidence = 0;
+    param->subpelCacheSize = 0;
+    param->bHpelPlanes = 0;
+    param->bPModeGraph = 0;
+    param->bRdoqApprox = 0;
+    param->bRateEstimate = 0;
+    param->bRateEstimateCheck = 0;
+    param->bParallelHash = 0;
+    param->bVmafFeatures = 0;
+    param->bSaoSkipCopied = 0;
+    param->bSkipNonRefFilter = 0;
 
     /* Intra Coding Tools */
     param->bEnableConstrainedIntra = 0;
@@ -1352,6 +1372,26 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
             sscanf(value, "%d,%d,%d", &p->hmeRange[0], &p->hmeRange[1], &p->hmeRange[2]);
             p->bEnableHME = true;
         }
+        OPT("deterministic") p->bDeterministic = atobool(value);
+        OPT("stats-format") p->statsFormat = parseName(value, x265_stats_format_names, bError);
+        OPT("segment-frames") p->segmentFrames = atoi(value);
+        OPT("segment-index") p->segmentIndex = atoi(value);
+        OPT("segment-plan") p->segmentPlanFile = strdup(value);
+        OPT("speculative-rc") p->bSpeculativeRC = atobool(value);
+        OPT("cu-predictor") p->bEnableCUPredictor = atobool(value);
+        OPT("cu-predictor-model") p->cuPredictorModel = strdup(value);
+        OPT("cu-predictor-dump") p->cuPredictorDump = strdup(value);
+        OPT("lowres-mv-confidence") p->bLowresMVConfidence = atobool(value);
+        OPT("subpel-cache") p->subpelCacheSize = atoi(value);
+        OPT("hpel-planes") p->bHpelPlanes = atobool(value);
+        OPT("pmode-graph") p->bPModeGraph = atobool(value);
+        OPT("rdoq-approx") p->bRdoqApprox = atobool(value);
+        OPT("rate-est") p->bRateEstimate = atobool(value);
+        OPT("rate-est-check") p->bRateEstimateCheck = atobool(value);
+        OPT("parallel-hash") p->bParallelHash = atobool(value);
+        OPT("vmaf-features") p->bVmafFeatures = atobool(value);
+        OPT("sao-skip-copied") p->bSaoSkipCopied = atobool(value);
+        OPT("skip-nonref-filter") p->bSkipNonRefFilter = atobool(value);
         else
             return X265_PARAM_BAD_NAME;
     }
@@ -1530,6 +1570,8 @@ int x265_check_params(x265_param* param)
           "Search Range must be more than 0");
     CHECK(param->searchRange >= 32768,
           "Search Range must be less than 32768");
+    CHECK(param->subpelCacheSize < 0 || param->subpelCacheSize > 1048576,
+          "subpel-cache must be between 0 and 1048576 KiB");
     CHECK(param->subpelRefine > X265_MAX_SUBPEL_LEVEL,
           "subme must be less than or equal to X265_MAX_SUBPEL_LEVEL (7)");
     CHECK(param->subpelRefine < 0,
@@ -1694,6 +1736,14 @@ int x265_check_params(x265_param* param)
         CHECK(0 > param->noiseReductionInter || param->noiseReductionInter > 2000, "Valid noise reduction range 0 - 2000");
     CHECK(param->rc.rateControlMode == X265_RC_CQP && param->rc.bStatRead,
           "Constant QP is incompatible with 2pass");
+    CHECK(param->statsFormat < X265_STATS_FORMAT_TEXT || param->statsFormat > X265_STATS_FORMAT_BINARY,
+          "Stats file format must be text or binary");
+    CHECK(param->segmentFrames < 0,
+          "Segment length must be positive");
+    CHECK(param->segmentIndex < -1,
+          "Segment index must be -1 (all segments) or greater");
+    CHECK((param->segmentIndex >= 0 || param->segmentPlanFile) && (!param->segmentFrames || !param->rc.bStatRead),
+          "Segment planning requires segment-frames and a stats file to read");
     CHECK(param->rc.bStrictCbr && (param->rc.bitrate <= 0 || param->rc.vbvBufferSize <=0),
           "Strict-cbr cannot be applied without specifying target bitrate or vbv bufsize");
     CHECK((param->analysisSave || param->analysisLoad) && (param->analysisReuseLevel < 1 || param->analysisReuseLevel > 10),
@@ -1879,6 +1929,12 @@ void x265_print_params(x265_param* param)
     TOOLOPT(param->bEnableRectInter, "rect");
     TOOLOPT(param->bEnableAMP, "amp");
     TOOLOPT(param->limitModes, "limit-modes");
+    TOOLOPT(param->bLowresMVConfidence, "lowres-mv-confidence");
+    TOOLVAL(param->subpelCacheSize, "subpel-cache=%d");
+    TOOLOPT(param->bHpelPlanes, "hpel-planes");
+    TOOLOPT(param->bPModeGraph, "pmode-graph");
+    TOOLOPT(param->bRdoqApprox && param->rdoqLevel, "rdoq-approx");
+    TOOLOPT(param->bRateEstimate && param->rdLevel >= 3, "rate-est");
     TOOLVAL(param->rdLevel, "rd=%d");
     TOOLVAL(param->dynamicRd, "dynamic-rd=%.2f");
     TOOLOPT(param->bSsimRd, "ssim-rd");
@@ -1888,6 +1944,7 @@ void x265_print_params(x265_param* param)
     TOOLOPT(param->bEnableRdRefine, "rd-refine");
     TOOLOPT(param->bEnableEarlySkip, "early-skip");
     TOOLOPT(param->bEnableRecursionSkip, "rskip");
+    TOOLOPT(param->bEnableCUPredictor, "cu-predictor");
     TOOLOPT(param->bEnableSplitRdSkip, "splitrd-skip");
     TOOLVAL(param->noiseReductionIntra, "nr-intra=%d");
     TOOLVAL(param->noiseReductionInter, "nr-inter=%d");
@@ -1929,7 +1986,10 @@ void x265_print_params(x265_param* param)
         TOOLOPT(param->selectiveSAO, "selective-sao");
     TOOLOPT(param->rc.bStatWrite, "stats-write");
     TOOLOPT(param->rc.bStatRead,  "stats-read");
+    TOOLOPT(param->rc.bStatWrite && param->statsFormat == X265_STATS_FORMAT_BINARY, "stats-binary");
     TOOLOPT(param->bSingleSeiNal, "single-sei");
+    TOOLOPT(param->bDeterministic, "deterministic");
+    TOOLOPT(param->bSpeculativeRC, "speculative-rc");
 #if ENABLE_HDR10_PLUS
     TOOLOPT(param->toneMapFile != NULL, "dhdr10-info");
 #endif
@@ -1954,11 +2014,14 @@ char *x265_param2string(x265_param* p, int padx, int pady)
 
     s += sprintf(s, "cpuid=%d", p->cpuid);
     s += sprintf(s, " frame-threads=%d", p->frameNumThreads);
-    if (p->numaPools)
+    /* the pools have no effect on deterministic outputs, including the info SEI */
+    if (p->numaPools && !p->bDeterministic)
         s += sprintf(s, " numa-pools=%s", p->numaPools);
     BOOL(p->bEnableWavefront, "wpp");
     BOOL(p->bDistributeModeAnalysis, "pmode");
     BOOL(p->bDistributeMotionEstimation, "pme");
+    BOOL(p->bDeterministic, "deterministic");
+    BOOL(p->bSpeculativeRC, "speculative-rc");
     BOOL(p->bEnablePsnr, "psnr");
     BOOL(p->bEnableSsim, "ssim");
     s += sprintf(s, " log-level=%d", p->logLevel);
@@ -1974,6 +2037,8 @@ char *x265_param2string(x265_param* p, int padx, int pady)
         s += sprintf(s, " chunk-start=%d", p->chunkStart);
     if (p->chunkEnd)
         s += sprintf(s, " chunk-end=%d", p->chunkEnd);
+    if (p->segmentIndex >= 0)
+        s += sprintf(s, " segment-frames=%d segment-index=%d", p->segmentFrames, p->segmentIndex);
     s += sprintf(s, " level-idc=%d", p->levelIdc);
     s += sprintf(s, " high-tier=%d", p->bHighTier);
     s += sprintf(s, " uhd-bd=%d", p->uhdBluray);
@@ -2029,6 +2094,16 @@ char *x265_param2string(x265_param* p, int padx, int pady)
     if(p->bEnableFrameDuplication)
         s += sprintf(s, " dup-threshold=%d", p->dupThreshold);
     BOOL(p->bEnableHME, "hme");
+    BOOL(p->bLowresMVConfidence, "lowres-mv-confidence");
+    s += sprintf(s, " subpel-cache=%d", p->subpelCacheSize);
+    BOOL(p->bHpelPlanes, "hpel-planes");
+    BOOL(p->bPModeGraph, "pmode-graph");
+    BOOL(p->bRdoqApprox, "rdoq-approx");
+    BOOL(p->bRateEstimate, "rate-est");
+    BOOL(p->bParallelHash, "parallel-hash");
+    BOOL(p->bVmafFeatures, "vmaf-features");
+    BOOL(p->bSaoSkipCopied, "sao-skip-copied");
+    BOOL(p->bSkipNonRefFilter, "skip-nonref-filter");
     if (p->bEnableHME)
     {
         s += sprintf(s, " Level 0,1,2=%d,%d,%d", p->hmeSearchMethod[0], p->hmeSearchMethod[1], p->hmeSearchMethod[2]);
@@ -2046,6 +2121,7 @@ char *x265_param2string(x265_param* p, int padx, int pady)
     s += sprintf(s, " selective-sao=%d", p->selectiveSAO);
     BOOL(p->bEnableEarlySkip, "early-skip");
     BOOL(p->bEnableRecursionSkip, "rskip");
+    BOOL(p->bEnableCUPredictor, "cu-predictor");
     BOOL(p->bEnableFastIntra, "fast-intra");
     BOOL(p->bEnableTSkipFast, "tskip-fast");
     BOOL(p->bCULossless, "cu-lossless");
@@ -2526,6 +2602,29 @@ void x265_copy_params(x265_param* dst, x265_param* src)
     dst->scenecutWindow = src->scenecutWindow;
     dst->maxQpDelta = src->maxQpDelta;
     dst->bField = src->bField;
+    dst->bDeterministic = src->bDeterministic;
+    dst->statsFormat = src->statsFormat;
+    dst->segmentFrames = src->segmentFrames;
+    dst->segmentIndex = src->segmentIndex;
+    if (src->segmentPlanFile) dst->segmentPlanFile = strdup(src->segmentPlanFile);
+    else dst->segmentPlanFile = NULL;
+    dst->bSpeculativeRC = src->bSpeculativeRC;
+    dst->bEnableCUPredictor = src->bEnableCUPredictor;
+    if (src->cuPredictorModel) dst->cuPredictorModel = strdup(src->cuPredictorModel);
+    else dst->cuPredictorModel = NULL;
+    if (src->cuPredictorDump) dst->cuPredictorDump = strdup(src->cuPredictorDump);
+    else dst->cuPredictorDump = NULL;
+    dst->bLowresMVConfidence = src->bLowresMVConfidence;
+    dst->subpelCacheSize = src->subpelCacheSize;
+    dst->bHpelPlanes = src->bHpelPlanes;
+    dst->bPModeGraph = src->bPModeGraph;
+    dst->bRdoqApprox = src->bRdoqApprox;
+    dst->bRateEstimate = src->bRateEstimate;
+    dst->bRateEstimateCheck = src->bRateEstimateCheck;
+    dst->bParallelHash = src->bParallelHash;
+    dst->bVmafFeatures = src->bVmafFeatures;
+    dst->bSaoSkipCopied = src->bSaoSkipCopied;
+    dst->bSkipNonRefFilter = src->bSkipNonRefFilter;
 
 #ifdef SVT_HEVC
     memcpy(dst->svtHevcParam, src->svtHevcParam, sizeof(EB_H265_ENC_CONFIGURATION));
@@ -492,6 +492,16 @@ static void md5_plane(MD5Context& md5, const pixel* plane, uint32_t width, uint3
     uint32_t width_modN = width % N;
     uint32_t width_less_modN = width - width_modN;
 
+#ifndef ARCH_BIG_ENDIAN
+    /* samples are already stored as the SEI lays them out, hash rows in place */
+    if (OUTPUT_BITDEPTH_DIV8 == sizeof(pixel))
+    {
+        for (uint32_t y = 0; y < height; y++)
+            MD5Update(&md5, (uint8_t*)&plane[y * stride], width * OUTPUT_BITDEPTH_DIV8);
+        return;
+    }
+#endif
+
     for (uint32_t y = 0; y < height; y++)
     {
         /* convert pel's into uint32_t chars in little endian byte order.
@@ -506,37 +516,7 @@ static void md5_plane(MD5Context& md5, const pixel* plane, uint32_t width, uint3
 
 void updateCRC(const pixel* plane, uint32_t& crcVal, uint32_t height, uint32_t width, intptr_t stride)
 {
-    uint32_t crcMsb;
-    uint32_t bitVal;
-    uint32_t bitIdx;
-
-    for (uint32_t y = 0; y < height; y++)
-    {
-        for (uint32_t x = 0; x < width; x++)
-        {
-            // take CRC of first pictureData byte
-            for (bitIdx = 0; bitIdx < 8; bitIdx++)
-            {
-                crcMsb = (crcVal >> 15) & 1;
-                bitVal = (plane[y * stride + x] >> (7 - bitIdx)) & 1;
-                crcVal = (((crcVal << 1) + bitVal) & 0xffff) ^ (crcMsb * 0x1021);
-            }
-
-#if _MSC_VER
-#pragma warning(disable: 4127) // conditional expression is constant
-#endif
-            // take CRC of second pictureData byte if bit depth is greater than 8-bits
-            if (X265_DEPTH > 8)
-            {
-                for (bitIdx = 0; bitIdx < 8; bitIdx++)
-                {
-                    crcMsb = (crcVal >> 15) & 1;
-                    bitVal = (plane[y * stride + x] >> (15 - bitIdx)) & 1;
-                    crcVal = (((crcVal << 1) + bitVal) & 0xffff) ^ (crcMsb * 0x1021);
-                }
-            }
-        }
-    }
+    crcVal = primitives.hash_crc(plane, stride, width, height, crcVal);
 }
 
 void crcFinish(uint32_t& crcVal, uint8_t digest[16])
@@ -555,19 +535,8 @@ void crcFinish(uint32_t& crcVal, uint8_t digest[16])
 
 void updateChecksum(const pixel* plane, uint32_t& checksumVal, uint32_t height, uint32_t width, intptr_t stride, int row, uint32_t cuHeight)
 {
-    uint8_t xor_mask;
-
-    for (uint32_t y = row * cuHeight; y < ((row * cuHeight) + height); y++)
-    {
-        for (uint32_t x = 0; x < width; x++)
-        {
-            xor_mask = (uint8_t)((x & 0xff) ^ (y & 0xff) ^ (x >> 8) ^ (y >> 8));
-            checksumVal = (checksumVal + ((plane[y * stride + x] & 0xff) ^ xor_mask)) & 0xffffffff;
-
-            if (X265_DEPTH > 8)
-                checksumVal = (checksumVal + ((plane[y * stride + x] >> 7 >> 1) ^ xor_mask)) & 0xffffffff;
-        }
-    }
+    uint32_t y = row * cuHeight;
+    checksumVal = primitives.hash_checksum(plane + y * stride, stride, width, height, y, checksumVal);
 }
 
 void checksumFinish(uint32_t checksum, uint8_t digest[16])
@@ -995,6 +995,102 @@ static pixel planeClipAndMax_c(pixel *src, intptr_t stride, int width, int heigh
 }
 
 #endif
+
+/* The SEI CRC shifts each picture byte, least significant byte of a sample
+ * first, through a 16-bit register; a byte at a time the register becomes
+ * (crc << 8 | byte) less the multiple of the polynomial named by its top byte */
+static uint32_t hash_crc_c(const pixel* src, intptr_t stride, int width, int height, uint32_t crc)
+{
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            crc = (((crc << 8) | (src[x] & 0xff)) & 0xffff) ^ g_crc16Table[crc >> 8];
+#if HIGH_BIT_DEPTH
+            crc = (((crc << 8) | (src[x] >> 8)) & 0xffff) ^ g_crc16Table[crc >> 8];
+#endif
+        }
+        src += stride;
+    }
+    return crc;
+}
+
+static uint32_t hash_checksum_c(const pixel* src, intptr_t stride, int width, int height, int y, uint32_t sum)
+{
+    for (int j = 0; j < height; j++, y++)
+    {
+        uint32_t yMask = (y & 0xff) ^ (y >> 8);
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t xorMask = (x & 0xff) ^ (x >> 8) ^ yMask;
+            sum += (src[x] & 0xff) ^ xorMask;
+#if HIGH_BIT_DEPTH
+            sum += (src[x] >> 8) ^ xorMask;
+#endif
+        }
+        src += stride;
+    }
+    return sum;
+}
+
+static void vif_stats_c(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, uint32_t sums[5])
+{
+    uint32_t s = 0, r = 0, ss = 0, rr = 0, sr = 0;
+    for (int y = 0; y < 8; y++)
+    {
+        for (int x = 0; x < 8; x++)
+        {
+            s += src[x];
+            r += rec[x];
+            ss += src[x] * src[x];
+            rr += rec[x] * rec[x];
+            sr += src[x] * rec[x];
+        }
+        src += srcStride;
+        rec += recStride;
+    }
+    sums[0] = s;
+    sums[1] = r;
+    sums[2] = ss;
+    sums[3] = rr;
+    sums[4] = sr;
+}
+
+static void adm_stats_c(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, int width,
+                        pixel* srcNext, pixel* recNext, uint64_t sums[2])
+{
+    uint64_t restored = 0, total = 0;
+
+    for (int x = 0; x < width; x++, src += 2, rec += 2)
+    {
+        int srcDetail[3] = { src[0] + src[1] - src[srcStride] - src[srcStride + 1],
+                             src[0] - src[1] + src[srcStride] - src[srcStride + 1],
+                             src[0] - src[1] - src[srcStride] + src[srcStride + 1] };
+        int recDetail[3] = { rec[0] + rec[1] - rec[recStride] - rec[recStride + 1],
+                             rec[0] - rec[1] + rec[recStride] - rec[recStride + 1],
+                             rec[0] - rec[1] - rec[recStride] + rec[recStride + 1] };
+
+        for (int band = 0; band < 3; band++)
+        {
+            uint64_t mag = abs(srcDetail[band]);
+            total += mag * mag * mag;
+            if ((srcDetail[band] ^ recDetail[band]) >= 0)
+            {
+                mag = X265_MIN(mag, (uint64_t)abs(recDetail[band]));
+                restored += mag * mag * mag;
+            }
+        }
+
+        if (srcNext)
+        {
+            srcNext[x] = (pixel)((src[0] + src[1] + src[srcStride] + src[srcStride + 1] + 2) >> 2);
+            recNext[x] = (pixel)((rec[0] + rec[1] + rec[recStride] + rec[recStride + 1] + 2) >> 2);
+        }
+    }
+
+    sums[0] += restored;
+    sums[1] += total;
+}
 }  // end anonymous namespace
 
 namespace X265_NS {
@@ -1319,6 +1415,11 @@ void setupPixelPrimitives_c(EncoderPrimitives &p)
 #if HIGH_BIT_DEPTH
     p.planeClipAndMax = planeClipAndMax_c;
 #endif
+    p.hash_crc = hash_crc_c;
+    p.hash_checksum = hash_checksum_c;
+
+    p.vif_stats = vif_stats_c;
+    p.adm_stats = adm_stats_c;
     p.propagateCost = estimateCUPropagateCost;
     p.fix8Unpack = cuTreeFix8Unpack;
     p.fix8Pack = cuTreeFix8Pack;
@@ -57,6 +57,7 @@ inline pixel weightBidir(int w0, int16_t P0, int w1, int16_t P1, int round, int
 
 Predict::Predict()
 {
+    m_subpelCache = NULL;
 }
 
 Predict::~Predict()
@@ -255,6 +256,17 @@ void Predict::predInterLumaPixel(const PredictionUnit& pu, Yuv& dstYuv, const Pi
     int xFrac = mv.x & 3;
     int yFrac = mv.y & 3;
 
+    if ((yFrac | xFrac) && m_subpelCache)
+    {
+        intptr_t cacheStride;
+        const pixel* cached = m_subpelCache->getBlock(refPic.m_picOrg[0], srcStride, src - refPic.m_picOrg[0], xFrac, yFrac, pu.width, pu.height, cacheStride);
+        if (cached)
+        {
+            primitives.pu[partEnum].copy_pp(dst, dstStride, cached, cacheStride);
+            return;
+        }
+    }
+
     if (!(yFrac | xFrac))
         primitives.pu[partEnum].copy_pp(dst, dstStride, src, srcStride);
     else if (!yFrac)
@@ -30,6 +30,7 @@
 #include "quant.h"
 #include "shortyuv.h"
 #include "yuv.h"
+#include "subpelcache.h"
 
 namespace X265_NS {
 
@@ -73,6 +74,7 @@ public:
     };
 
     ShortYuv  m_predShortYuv[2]; /* temporary storage for weighted prediction */
+    SubpelCache* m_subpelCache;  /* optional, owned by Search */
 
     // Unfiltered/filtered neighbours of the current partition.
     pixel     intraNeighbourBuf[2][258];
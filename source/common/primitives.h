@@ -200,12 +200,30 @@ typedef void (*saoCuStatsE0_t)(const int16_t *diff, const pixel *rec, intptr_t s
 typedef void (*saoCuStatsE1_t)(const int16_t *diff, const pixel *rec, intptr_t stride, int8_t *upBuff1, int endX, int endY, int32_t *stats, int32_t *count);
 typedef void (*saoCuStatsE2_t)(const int16_t *diff, const pixel *rec, intptr_t stride, int8_t *upBuff1, int8_t *upBuff, int endX, int endY, int32_t *stats, int32_t *count);
 typedef void (*saoCuStatsE3_t)(const int16_t *diff, const pixel *rec, intptr_t stride, int8_t *upBuff1, int endX, int endY, int32_t *stats, int32_t *count);
+/* all SAO types at once from source and recon; bounds, stats and count are
+ * indexed by SAO type (EO 0..3, BO), with 32 classes per type */
+typedef void (*saoCuStatsAll_t)(const pixel *fenc, const pixel *rec, intptr_t stride, const int32_t bounds[][4], int32_t *stats, int32_t *count);
 
 typedef void (*sign_t)(int8_t *dst, const pixel *src1, const pixel *src2, const int endX);
 typedef void (*planecopy_cp_t) (const uint8_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift);
 typedef void (*planecopy_sp_t) (const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask);
 typedef pixel (*planeClipAndMax_t)(pixel *src, intptr_t stride, int width, int height, uint64_t *outsum, const pixel minPix, const pixel maxPix);
 
+/* Decoded picture hash SEI. Both continue the value passed in over the rows of
+ * a plane region; the checksum takes the picture row number of its first row */
+typedef uint32_t (*hash_crc_t)(const pixel* src, intptr_t stride, int width, int height, uint32_t crc);
+typedef uint32_t (*hash_checksum_t)(const pixel* src, intptr_t stride, int width, int height, int y, uint32_t sum);
+
+/* Sums of source, recon, source squared, recon squared and source times recon
+ * over an 8x8 window, for the VIF feature */
+typedef void (*vif_stats_t)(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, uint32_t sums[5]);
+
+/* Adds the restored and total cubed Haar detail of a row of width 2x2 quads
+ * of source and recon to sums[0] and sums[1], for the ADM feature. The quad
+ * averages are written to srcNext and recNext unless they are NULL */
+typedef void (*adm_stats_t)(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, int width,
+                            pixel* srcNext, pixel* recNext, uint64_t sums[2]);
+
 typedef void (*cutree_propagate_cost) (int* dst, const uint16_t* propagateIn, const int32_t* intraCosts, const uint16_t* interCosts, const int32_t* invQscales, const double* fpsFactor, int len);
 
 typedef void (*cutree_fix8_unpack)(double *dst, uint16_t *src, int count);
@@ -220,6 +238,7 @@ typedef uint32_t (*costC1C2Flag_t)(uint16_t *absCoeff, intptr_t numC1Flag, uint8
 
 typedef void (*pelFilterLumaStrong_t)(pixel* src, intptr_t srcStep, intptr_t offset, int32_t tcP, int32_t tcQ);
 typedef void (*pelFilterChroma_t)(pixel* src, intptr_t srcStep, intptr_t offset, int32_t tc, int32_t maskP, int32_t maskQ);
+typedef void (*pelFilterLumaEdge_t)(pixel* src, intptr_t srcStep, intptr_t offset, const int16_t* beta, const int16_t* tc, int numSegs);
 
 typedef void (*integralv_t)(uint32_t *sum, intptr_t stride);
 typedef void (*integralh_t)(uint32_t *sum, pixel *pix, intptr_t stride);
@@ -227,6 +246,7 @@ typedef void(*nonPsyRdoQuant_t)(int16_t *m_resiDctCoeff, int64_t *costUncoded, i
 typedef void(*psyRdoQuant_t)(int16_t *m_resiDctCoeff, int16_t *m_fencDctCoeff, int64_t *costUncoded, int64_t *totalUncodedCost, int64_t *totalRdCost, int64_t *psyScale, uint32_t blkPos);
 typedef void(*psyRdoQuant_t1)(int16_t *m_resiDctCoeff, int64_t *costUncoded, int64_t *totalUncodedCost, int64_t *totalRdCost,uint32_t blkPos);
 typedef void(*psyRdoQuant_t2)(int16_t *m_resiDctCoeff, int16_t *m_fencDctCoeff, int64_t *costUncoded, int64_t *totalUncodedCost, int64_t *totalRdCost, int64_t *psyScale, uint32_t blkPos);
+typedef void (*rdoQuantLevelDist_t)(const int16_t* resiDctCoeff, const int16_t* fencDctCoeff, const int16_t* levels, const int32_t* unquantScale, int64_t* costUncoded, int64_t* costLevel, int64_t psyScale, int per, int unquantShift, uint32_t blkPos);
 typedef void(*ssimDistortion_t)(const pixel *fenc, uint32_t fStride, const pixel *recon,  intptr_t rstride, uint64_t *ssBlock, int shift, uint64_t *ac_k);
 typedef void(*normFactor_t)(const pixel *src, uint32_t blockSize, int shift, uint64_t *z_k);
 /* Function pointers to optimized encoder primitives. Each pointer can reference
@@ -305,6 +325,7 @@ struct EncoderPrimitives
         psyRdoQuant_t    psyRdoQuant;
 		psyRdoQuant_t1   psyRdoQuant_1p;
 		psyRdoQuant_t2   psyRdoQuant_2p;
+        rdoQuantLevelDist_t rdoQuantLevelDist; // RDOQ distortion of the candidate levels of a coded 4x4 group
         ssimDistortion_t ssimDist;
         normFactor_t     normFact;
     }
@@ -347,6 +368,7 @@ struct EncoderPrimitives
     saoCuStatsE1_t        saoCuStatsE1;
     saoCuStatsE2_t        saoCuStatsE2;
     saoCuStatsE3_t        saoCuStatsE3;
+    saoCuStatsAll_t       saoCuStatsAll;
 
     downscale_t           frameInitLowres;
     downscale_t           frameInitLowerRes;
@@ -360,6 +382,12 @@ struct EncoderPrimitives
     planecopy_sp_t        planecopy_sp_shl;
     planeClipAndMax_t     planeClipAndMax;
 
+    hash_crc_t            hash_crc;
+    hash_checksum_t       hash_checksum;
+
+    vif_stats_t           vif_stats;
+    adm_stats_t           adm_stats;
+
     weightp_sp_t          weight_sp;
     weightp_pp_t          weight_pp;
 
@@ -373,6 +401,7 @@ struct EncoderPrimitives
 
     pelFilterLumaStrong_t pelFilterLumaStrong[2]; // EDGE_VER = 0, EDGE_HOR = 1
     pelFilterChroma_t     pelFilterChroma[2];     // EDGE_VER = 0, EDGE_HOR = 1
+    pelFilterLumaEdge_t   pelFilterLumaEdge[2];   // EDGE_VER = 0, EDGE_HOR = 1
 
     integralv_t            integral_initv[NUM_INTEGRAL_SIZE];
     integralh_t            integral_inith[NUM_INTEGRAL_SIZE];
@@ -134,6 +134,33 @@ inline int getICRateLessVlc(uint32_t absLevel, int32_t diffLevel, const uint32_t
     return rate;
 }
 
+/* Bins of the coeff_abs_level_remaining codes of the first symbols for each
+ * Rice parameter, covering most levels chosen by RDOQ without a CLZ */
+static const uint8_t s_remainBins[5][32] =
+{
+    { 1, 2, 3, 4, 6, 6, 8, 8, 8, 8, 10, 10, 10, 10, 10, 10, 10, 10, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12 },
+    { 2, 2, 3, 3, 4, 4, 5, 5, 7, 7, 7, 7, 9, 9, 9, 9, 9, 9, 9, 9, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11 },
+    { 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 8, 8, 8, 8, 8, 8, 8, 8, 10, 10, 10, 10, 10, 10, 10, 10 },
+    { 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 6, 7, 7, 7, 7, 7, 7, 7, 7 },
+    { 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6 }
+};
+
+inline uint32_t getRemainBins(uint32_t symbol, uint32_t absGoRice)
+{
+    if ((symbol >> absGoRice) < COEF_REMAIN_BIN_REDUCTION)
+        return (symbol >> absGoRice) + 1 + absGoRice;
+
+    uint32_t length = 0;
+    symbol = (symbol >> absGoRice) - COEF_REMAIN_BIN_REDUCTION;
+    if (symbol)
+    {
+        unsigned long idx;
+        CLZ(idx, symbol + 1);
+        length = idx;
+    }
+    return COEF_REMAIN_BIN_REDUCTION + length + absGoRice + 1 + length;
+}
+
 /* Calculates the cost for specific absolute transform level */
 inline uint32_t getICRateCost(uint32_t absLevel, int32_t diffLevel, const int* greaterOneBits, const int* levelAbsBits, uint32_t absGoRice, const uint32_t c1c2Rate)
 {
@@ -150,28 +177,11 @@ inline uint32_t getICRateCost(uint32_t absLevel, int32_t diffLevel, const int* g
     }
     else
     {
-        uint32_t rate;
+        X265_CHECK(absGoRice <= 4, "absGoRice check failure\n");
         uint32_t symbol = diffLevel;
-        if ((symbol >> absGoRice) < COEF_REMAIN_BIN_REDUCTION)
-        {
-            uint32_t length = symbol >> absGoRice;
-            rate = (length + 1 + absGoRice) << 15;
-        }
-        else
-        {
-            uint32_t length = 0;
-            symbol = (symbol >> absGoRice) - COEF_REMAIN_BIN_REDUCTION;
-            if (symbol)
-            {
-                unsigned long idx;
-                CLZ(idx, symbol + 1);
-                length = idx;
-            }
-
-            rate = (COEF_REMAIN_BIN_REDUCTION + length + absGoRice + 1 + length) << 15;
-        }
-        rate += c1c2Rate;
-        return rate;
+        uint32_t bins = symbol < 32 ? s_remainBins[absGoRice][symbol] : getRemainBins(symbol, absGoRice);
+        X265_CHECK(bins == getRemainBins(symbol, absGoRice), "remaining level bins mismatch\n");
+        return (bins << 15) + c1c2Rate;
     }
 }
 
@@ -223,6 +233,7 @@ void Quant::setQPforQuant(const CUData& ctu, int qp)
     m_nr = m_frameNr ? &m_frameNr[ctu.m_encData->m_frameEncoderID] : NULL;
     m_qpParam[TEXT_LUMA].setQpParam(qp + QP_BD_OFFSET);
     m_rdoqLevel = ctu.m_encData->m_param->rdoqLevel;
+    m_bRdoqApprox = !!ctu.m_encData->m_param->bRdoqApprox;
     if (ctu.m_chromaFormat != X265_CSP_I400)
     {
         setChromaQP(qp + ctu.m_slice->m_pps->chromaQpOffset[0] + ctu.m_slice->m_chromaQpOffset[0], TEXT_CHROMA_U, ctu.m_chromaFormat);
@@ -645,6 +656,7 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
     int64_t costCoeff[trSize * trSize];   /* d*d + lambda * bits */
     int64_t costUncoded[trSize * trSize]; /* d*d + lambda * 0    */
     int64_t costSig[trSize * trSize];     /* lambda * bits       */
+    int64_t costLevel[2 * MLS_CG_BLK_SIZE]; /* d*d of the levels of a coded group, then of those levels less one */
 
     int rateIncUp[trSize * trSize];      /* signal overhead of increasing level */
     int rateIncDown[trSize * trSize];    /* signal overhead of decreasing level */
@@ -857,6 +869,10 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
 
         coeffGroupRDStats cgRdStats;
         memset(&cgRdStats, 0, sizeof(coeffGroupRDStats));
+        /* distortion of the candidate levels of the whole group, independent of the rate */
+        primitives.cu[log2TrSize - 2].rdoQuantLevelDist(m_resiDctCoeff, m_fencDctCoeff, dstCoeff, unquantScale, costUncoded, costLevel,
+                                                        usePsy ? psyScale : 0, per, unquantShift, codeParams.scan[cgScanPos << MLS_CG_SIZE]);
+
 
         uint32_t subFlagMask = coeffFlag[cgScanPos];
         int    c2            = 0;
@@ -870,19 +886,22 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
             scanPos              = (cgScanPos << MLS_CG_SIZE) + scanPosinCG;
             uint32_t blkPos      = codeParams.scan[scanPos];
             uint32_t maxAbsLevel = dstCoeff[blkPos];                  /* abs(quantized coeff) */
+#if CHECKED_BUILD || _DEBUG
             int signCoef         = m_resiDctCoeff[blkPos];            /* pre-quantization DCT coeff */
             int predictedCoef    = m_fencDctCoeff[blkPos] - signCoef; /* predicted DCT = source DCT - residual DCT*/
+#endif
+            const int64_t* levelDist = &costLevel[g_scan4x4[codeParams.scanType][scanPosinCG]];
 
             /* RDOQ measures distortion as the squared difference between the unquantized coded level
              * and the original DCT coefficient. The result is shifted scaleBits to account for the
-             * FIX15 nature of the CABAC cost tables minus the forward transform scale */
-
-            /* cost of not coding this coefficient (all distortion, no signal bits) */
-            costUncoded[blkPos] = ((int64_t)signCoef * signCoef) << scaleBits;
+             * FIX15 nature of the CABAC cost tables minus the forward transform scale. The cost of
+             * not coding this coefficient (all distortion, no signal bits) and the distortion of
+             * its candidate levels, psy biased, were measured for the whole group above */
             X265_CHECK((!!scanPos ^ !!blkPos) == 0, "failed on (blkPos=0 && scanPos!=0)\n");
-            if (usePsyMask & scanPos)
-                /* when no residual coefficient is coded, predicted coef == recon coef */
-                costUncoded[blkPos] -= PSYVALUE(predictedCoef);
+            X265_CHECK(blkPos == codeParams.scan[cgScanPos << MLS_CG_SIZE] + (g_scan4x4[codeParams.scanType][scanPosinCG] >> 2) * trSize + (g_scan4x4[codeParams.scanType][scanPosinCG] & 3),
+                       "coefficient group scan check failure\n");
+            X265_CHECK(costUncoded[blkPos] == (((int64_t)signCoef * signCoef) << scaleBits) - ((usePsyMask & scanPos) ? PSYVALUE(predictedCoef) : 0),
+                       "uncoded cost check failure\n");
 
             totalUncodedCost += costUncoded[blkPos];
 
@@ -953,24 +972,16 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
                     sigCoefBits = estBitsSbac.significantBits[1][ctxSig];
                 }
 
-                const uint32_t unQuantLevel = (maxAbsLevel * (unquantScale[blkPos] << per) + unquantRound);
                 // NOTE: X265_MAX(maxAbsLevel - 1, 1) ==> (X>=2 -> X-1), (X<2 -> 1)  | (0 < X < 2 ==> X=1)
                 if (maxAbsLevel == 1)
                 {
                     uint32_t levelBits = (c1c2idx & 1) ? greaterOneBits[0] + IEP_RATE : ((1 + goRiceParam) << 15) + IEP_RATE;
                     X265_CHECK(levelBits == getICRateCost(1, 1 - baseLevel, greaterOneBits, levelAbsBits, goRiceParam, c1c2Rate) + IEP_RATE, "levelBits mistake\n");
 
-                    int unquantAbsLevel = unQuantLevel >> unquantShift;
-                    X265_CHECK(UNQUANT(1) == unquantAbsLevel, "DQuant check failed\n");
-                    int d = abs(signCoef) - unquantAbsLevel;
-                    int64_t curCost = RDCOST(d, sigCoefBits + levelBits);
-
                     /* Psy RDOQ: bias in favor of higher AC coefficients in the reconstructed frame */
-                    if (usePsyMask & scanPos)
-                    {
-                        int reconCoef = abs(unquantAbsLevel + SIGN(predictedCoef, signCoef));
-                        curCost -= PSYVALUE(reconCoef);
-                    }
+                    X265_CHECK(levelDist[0] == ((int64_t)(abs(signCoef) - UNQUANT(1)) * (abs(signCoef) - UNQUANT(1)) << scaleBits) -
+                               ((usePsyMask & scanPos) ? PSYVALUE(abs(UNQUANT(1) + SIGN(predictedCoef, signCoef))) : 0), "level distortion check failure\n");
+                    int64_t curCost = levelDist[0] + SIGCOST(sigCoefBits + levelBits);
 
                     if (curCost < costCoeff[scanPos])
                     {
@@ -982,41 +993,33 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
                 else if (maxAbsLevel)
                 {
                     uint32_t levelBits0 = getICRateCost(maxAbsLevel,     maxAbsLevel     - baseLevel, greaterOneBits, levelAbsBits, goRiceParam, c1c2Rate) + IEP_RATE;
-                    uint32_t levelBits1 = getICRateCost(maxAbsLevel - 1, maxAbsLevel - 1 - baseLevel, greaterOneBits, levelAbsBits, goRiceParam, c1c2Rate) + IEP_RATE;
-
-                    const uint32_t preDQuantLevelDiff = (unquantScale[blkPos] << per);
-
-                    const int unquantAbsLevel0 = unQuantLevel >> unquantShift;
-                    X265_CHECK(UNQUANT(maxAbsLevel) == (uint32_t)unquantAbsLevel0, "DQuant check failed\n");
-                    int d0 = abs(signCoef) - unquantAbsLevel0;
-                    int64_t curCost0 = RDCOST(d0, sigCoefBits + levelBits0);
-
-                    const int unquantAbsLevel1 = (unQuantLevel - preDQuantLevelDiff) >> unquantShift;
-                    X265_CHECK(UNQUANT(maxAbsLevel - 1) == (uint32_t)unquantAbsLevel1, "DQuant check failed\n");
-                    int d1 = abs(signCoef) - unquantAbsLevel1;
-                    int64_t curCost1 = RDCOST(d1, sigCoefBits + levelBits1);
 
                     /* Psy RDOQ: bias in favor of higher AC coefficients in the reconstructed frame */
-                    if (usePsyMask & scanPos)
-                    {
-                        int reconCoef;
-                        reconCoef = abs(unquantAbsLevel0 + SIGN(predictedCoef, signCoef));
-                        curCost0 -= PSYVALUE(reconCoef);
+                    X265_CHECK(levelDist[0] == ((int64_t)(abs(signCoef) - (int)UNQUANT(maxAbsLevel)) * (abs(signCoef) - (int)UNQUANT(maxAbsLevel)) << scaleBits) -
+                               ((usePsyMask & scanPos) ? PSYVALUE(abs((int)UNQUANT(maxAbsLevel) + SIGN(predictedCoef, signCoef))) : 0), "level distortion check failure\n");
+                    X265_CHECK(levelDist[MLS_CG_BLK_SIZE] == ((int64_t)(abs(signCoef) - (int)UNQUANT(maxAbsLevel - 1)) * (abs(signCoef) - (int)UNQUANT(maxAbsLevel - 1)) << scaleBits) -
+                               ((usePsyMask & scanPos) ? PSYVALUE(abs((int)UNQUANT(maxAbsLevel - 1) + SIGN(predictedCoef, signCoef))) : 0), "level distortion check failure\n");
+                    int64_t curCost0 = levelDist[0] + SIGCOST(sigCoefBits + levelBits0);
 
-                        reconCoef = abs(unquantAbsLevel1 + SIGN(predictedCoef, signCoef));
-                        curCost1 -= PSYVALUE(reconCoef);
-                    }
                     if (curCost0 < costCoeff[scanPos])
                     {
                         level = maxAbsLevel;
                         costCoeff[scanPos] = curCost0;
                         costSig[scanPos] = SIGCOST(sigCoefBits);
                     }
-                    if (curCost1 < costCoeff[scanPos])
+
+                    /* the approximate mode keeps large levels, where rounding down one rarely pays */
+                    if (!m_bRdoqApprox || maxAbsLevel < RDOQ_APPROX_LEVEL)
                     {
-                        level = maxAbsLevel - 1;
-                        costCoeff[scanPos] = curCost1;
-                        costSig[scanPos] = SIGCOST(sigCoefBits);
+                        uint32_t levelBits1 = getICRateCost(maxAbsLevel - 1, maxAbsLevel - 1 - baseLevel, greaterOneBits, levelAbsBits, goRiceParam, c1c2Rate) + IEP_RATE;
+                        int64_t curCost1 = levelDist[MLS_CG_BLK_SIZE] + SIGCOST(sigCoefBits + levelBits1);
+
+                        if (curCost1 < costCoeff[scanPos])
+                        {
+                            level = maxAbsLevel - 1;
+                            costCoeff[scanPos] = curCost1;
+                            costSig[scanPos] = SIGCOST(sigCoefBits);
+                        }
                     }
                 }
 
@@ -84,12 +84,14 @@ protected:
     QpParam            m_qpParam[3];
 
     int                m_rdoqLevel;
+    bool               m_bRdoqApprox;
     int32_t            m_psyRdoqScale;  // dynamic range [0,50] * 256 = 14-bits
     int16_t*           m_resiDctCoeff;
     int16_t*           m_fencDctCoeff;
     int16_t*           m_fencShortBuf;
 
     enum { IEP_RATE = 32768 }; /* FIX15 cost of an equal probable bit */
+    enum { RDOQ_APPROX_LEVEL = 4 }; /* smallest level kept without evaluating level - 1 by --rdoq-approx */
 
 public:
 
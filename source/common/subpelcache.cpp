@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "subpelcache.h"
+
+using namespace X265_NS;
+
+SubpelCache::SubpelCache()
+{
+    m_slots = NULL;
+    m_buf = NULL;
+    m_tileValid = NULL;
+    m_numSlots = 0;
+    m_numUsed = 0;
+    m_useCount = 0;
+    m_poc = -1;
+    m_ctuAddr = (uint32_t)-1;
+    m_curStats = NULL;
+}
+
+bool SubpelCache::create(const x265_param& param)
+{
+    m_maxCUSize = param.maxCUSize;
+    m_numCuInWidth = (param.sourceWidth + param.maxCUSize - 1) / param.maxCUSize;
+    uint32_t numCuInHeight = (param.sourceHeight + param.maxCUSize - 1) / param.maxCUSize;
+
+    /* reference planes are padded as in PicYuv::create() */
+    m_lumaMarginX = param.maxCUSize + 32;
+    m_lumaMarginY = param.maxCUSize + 16;
+    m_planeStride = (m_numCuInWidth * param.maxCUSize) + (m_lumaMarginX << 1);
+
+    /* the 8-tap filters read 3 pixels before and 4 after each output */
+    m_minX = 3 - m_lumaMarginX;
+    m_maxX = (int)(m_numCuInWidth * param.maxCUSize) + m_lumaMarginX - 4;
+    m_minY = 3 - m_lumaMarginY;
+    m_maxY = (int)(numCuInHeight * param.maxCUSize) + m_lumaMarginY - 4;
+
+    m_margin = param.searchRange + 8;
+    int size = (param.maxCUSize + 2 * m_margin + TILE_SIZE - 1) & ~(TILE_SIZE - 1);
+    m_winWidth = X265_MIN(size, (m_maxX - m_minX) & ~(TILE_SIZE - 1));
+    m_winHeight = X265_MIN(size, (m_maxY - m_minY) & ~(TILE_SIZE - 1));
+    m_tilesInRow = m_winWidth >> LOG2_TILE_SIZE;
+    m_numTiles = m_tilesInRow * (m_winHeight >> LOG2_TILE_SIZE);
+
+    int64_t slotBytes = (int64_t)m_winWidth * m_winHeight * sizeof(pixel) + m_numTiles;
+    m_numSlots = (int)X265_MIN(((int64_t)param.subpelCacheSize << 10) / slotBytes, 256);
+    if (m_numSlots < 1)
+    {
+        x265_log(&param, X265_LOG_WARNING, "subpel-cache: %d KiB cannot hold one %dx%d window, cache disabled\n",
+                 param.subpelCacheSize, m_winWidth, m_winHeight);
+        return false;
+    }
+
+    CHECKED_MALLOC(m_slots, Slot, m_numSlots);
+    CHECKED_MALLOC(m_buf, pixel, (size_t)m_numSlots * m_winWidth * m_winHeight);
+    CHECKED_MALLOC(m_tileValid, uint8_t, (size_t)m_numSlots * m_numTiles);
+    return true;
+
+fail:
+    return false;
+}
+
+void SubpelCache::destroy()
+{
+    X265_FREE(m_slots);
+    X265_FREE(m_buf);
+    X265_FREE(m_tileValid);
+    m_slots = NULL;
+    m_buf = NULL;
+    m_tileValid = NULL;
+    m_curStats = NULL;
+}
+
+void SubpelCache::prepare(int frameEncoderID, int poc, uint32_t ctuAddr, bool bForce)
+{
+    m_curStats = &m_stats[frameEncoderID];
+    if (!bForce && poc == m_poc && ctuAddr == m_ctuAddr)
+        return;
+
+    m_poc = poc;
+    m_ctuAddr = ctuAddr;
+    m_numUsed = 0;
+
+    int ctuX = (int)((ctuAddr % m_numCuInWidth) * m_maxCUSize);
+    int ctuY = (int)((ctuAddr / m_numCuInWidth) * m_maxCUSize);
+    m_winX = x265_clip3(m_minX, m_maxX - m_winWidth, ctuX - m_margin);
+    m_winY = x265_clip3(m_minY, m_maxY - m_winHeight, ctuY - m_margin);
+}
+
+int SubpelCache::findSlot(const pixel* plane, int phase)
+{
+    for (int i = 0; i < m_numUsed; i++)
+    {
+        if (m_slots[i].plane == plane && m_slots[i].phase == phase)
+            return i;
+    }
+
+    int s = 0;
+    if (m_numUsed < m_numSlots)
+        s = m_numUsed++;
+    else
+    {
+        for (int i = 1; i < m_numSlots; i++)
+        {
+            if (m_slots[i].lastUse < m_slots[s].lastUse)
+                s = i;
+        }
+    }
+
+    m_slots[s].plane = plane;
+    m_slots[s].phase = phase;
+    memset(m_tileValid + (size_t)s * m_numTiles, 0, m_numTiles);
+    return s;
+}
+
+void SubpelCache::fillTile(int slotIdx, int tileX, int tileY)
+{
+    const Slot& slot = m_slots[slotIdx];
+    const pixel* src = slot.plane + (m_winY + (tileY << LOG2_TILE_SIZE)) * m_planeStride + m_winX + (tileX << LOG2_TILE_SIZE);
+    pixel* dst = m_buf + (size_t)slotIdx * m_winWidth * m_winHeight + (tileY << LOG2_TILE_SIZE) * m_winWidth + (tileX << LOG2_TILE_SIZE);
+    int xFrac = slot.phase & 3;
+    int yFrac = slot.phase >> 2;
+
+    if (!yFrac)
+        primitives.pu[LUMA_16x16].luma_hpp(src, m_planeStride, dst, m_winWidth, xFrac);
+    else if (!xFrac)
+        primitives.pu[LUMA_16x16].luma_vpp(src, m_planeStride, dst, m_winWidth, yFrac);
+    else
+        primitives.pu[LUMA_16x16].luma_hvpp(src, m_planeStride, dst, m_winWidth, xFrac, yFrac);
+}
+
+const pixel* SubpelCache::getBlock(const pixel* plane, intptr_t planeStride, intptr_t offset, int xFrac, int yFrac, int width, int height, intptr_t& stride)
+{
+    if (!m_curStats || planeStride != m_planeStride)
+        return NULL;
+
+    m_curStats->lookups++;
+
+    /* picture relative position of the block, which may lie in the padding */
+    intptr_t padOffset = offset + m_lumaMarginY * m_planeStride + m_lumaMarginX;
+    int x = (int)(padOffset % m_planeStride) - m_lumaMarginX - m_winX;
+    int y = (int)(padOffset / m_planeStride) - m_lumaMarginY - m_winY;
+    if (padOffset < 0 || x < 0 || y < 0 || x + width > m_winWidth || y + height > m_winHeight)
+    {
+        m_curStats->bypassed++;
+        return NULL;
+    }
+
+    int s = findSlot(plane, (yFrac << 2) | xFrac);
+    m_slots[s].lastUse = ++m_useCount;
+
+    uint8_t* valid = m_tileValid + (size_t)s * m_numTiles;
+    bool bHit = true;
+    for (int ty = y >> LOG2_TILE_SIZE; ty <= (y + height - 1) >> LOG2_TILE_SIZE; ty++)
+    {
+        for (int tx = x >> LOG2_TILE_SIZE; tx <= (x + width - 1) >> LOG2_TILE_SIZE; tx++)
+        {
+            if (!valid[ty * m_tilesInRow + tx])
+            {
+                fillTile(s, tx, ty);
+                valid[ty * m_tilesInRow + tx] = 1;
+                m_curStats->tilesFilled++;
+                bHit = false;
+            }
+        }
+    }
+    if (bHit)
+        m_curStats->hits++;
+
+    stride = m_winWidth;
+    return m_buf + (size_t)s * m_winWidth * m_winHeight + y * m_winWidth + x;
+}
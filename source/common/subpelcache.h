@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_SUBPELCACHE_H
+#define X265_SUBPELCACHE_H
+
+#include "common.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+struct SubpelCacheStats
+{
+    uint64_t lookups;          /* sub-pel luma blocks requested */
+    uint64_t hits;             /* blocks served without interpolating a tile */
+    uint64_t bypassed;         /* blocks outside the window, interpolated by the caller */
+    uint64_t tilesFilled;      /* tiles interpolated */
+
+    SubpelCacheStats() { clear(); }
+
+    void clear()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void accumulate(const SubpelCacheStats& other)
+    {
+        lookups += other.lookups;
+        hits += other.hits;
+        bypassed += other.bypassed;
+        tilesFilled += other.tilesFilled;
+    }
+};
+
+/* Interpolated luma of the reference planes around one CTU. Each slot holds one
+ * sub-pel phase of one reference plane over a window covering the CTU and the
+ * search range about it, filled lazily in tiles of TILE_SIZE x TILE_SIZE as
+ * blocks are requested. Slots are recycled least recently used first once the
+ * memory cap is reached. A cache is used by a single thread; prepare() binds
+ * it to the CTU being analysed, dropping all slots when the CTU changes */
+class SubpelCache
+{
+public:
+
+    enum { TILE_SIZE = 16, LOG2_TILE_SIZE = 4 };
+
+    /* Accumulate statistics separately for each frame encoder */
+    SubpelCacheStats m_stats[X265_MAX_FRAME_THREADS];
+
+    SubpelCache();
+    ~SubpelCache() { destroy(); }
+
+    bool create(const x265_param& param);
+    void destroy();
+
+    void prepare(int frameEncoderID, int poc, uint32_t ctuAddr, bool bForce);
+
+    /* Returns the block of the given phase at full-pel offset 'offset' from the
+     * picture origin of the plane, setting its stride, or NULL when the block is
+     * not covered by the window */
+    const pixel* getBlock(const pixel* plane, intptr_t planeStride, intptr_t offset, int xFrac, int yFrac, int width, int height, intptr_t& stride);
+
+protected:
+
+    struct Slot
+    {
+        const pixel* plane;
+        int          phase;
+        uint32_t     lastUse;
+    };
+
+    Slot*     m_slots;
+    pixel*    m_buf;
+    uint8_t*  m_tileValid;
+    int       m_numSlots;
+    int       m_numUsed;
+    uint32_t  m_useCount;
+
+    int       m_winWidth;      /* window size in pixels, multiples of TILE_SIZE */
+    int       m_winHeight;
+    int       m_tilesInRow;
+    int       m_numTiles;
+    int       m_margin;        /* pixels about the CTU, before clamping to the plane */
+    int       m_minX, m_maxX;  /* window limits keeping filter taps within the padded plane */
+    int       m_minY, m_maxY;
+    int       m_winX;          /* top-left of the window relative to the picture */
+    int       m_winY;
+
+    intptr_t  m_planeStride;
+    int       m_lumaMarginX;
+    int       m_lumaMarginY;
+    uint32_t  m_maxCUSize;
+    uint32_t  m_numCuInWidth;
+
+    int       m_poc;
+    uint32_t  m_ctuAddr;
+    SubpelCacheStats* m_curStats;
+
+    int  findSlot(const pixel* plane, int phase);
+    void fillTile(int slotIdx, int tileX, int tileY);
+};
+}
+
+#endif // ifndef X265_SUBPELCACHE_H
@@ -100,9 +100,92 @@ static void dequant_scaling(const int16_t* quantCoef, const int32_t *deQuantCoef
     }
 }
 
+/* (psy * x) >> shift of two 64-bit lanes, for psy >= 0 and sign extended
+ * 32-bit x. SSE4.1 has no 64-bit multiply or arithmetic 64-bit shift, so
+ * the magnitude is multiplied in 32-bit halves and a negative product p is
+ * shifted as ~(~p >> shift), where ~p = |p| - 1 */
+static inline __m128i psyProduct(__m128i psy, __m128i x, __m128i shift)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i neg = _mm_cmpgt_epi32(zero, x);
+    __m128i mag = _mm_sub_epi64(_mm_xor_si128(x, neg), neg);
+    __m128i prod = _mm_add_epi64(_mm_mul_epu32(psy, mag), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(psy, 32), mag), 32));
+
+    neg = _mm_andnot_si128(_mm_cmpeq_epi64(prod, zero), neg);
+    return _mm_xor_si128(_mm_srl_epi64(_mm_add_epi64(prod, neg), shift), neg);
+}
+
+/* Costs of two neighbouring coefficients, all inputs sign extended to 64 bits */
+static inline void levelDistPair(int64_t* costUncoded, int64_t* cost, __m128i psy, __m128i signCoef, __m128i predictedCoef,
+                                 __m128i d0, __m128i d1, __m128i rec0, __m128i rec1, __m128i scaleBits, __m128i psyShift)
+{
+    __m128i uncoded = _mm_sll_epi64(_mm_mul_epi32(signCoef, signCoef), scaleBits);
+    __m128i cost0 = _mm_sll_epi64(_mm_mul_epi32(d0, d0), scaleBits);
+    __m128i cost1 = _mm_sll_epi64(_mm_mul_epi32(d1, d1), scaleBits);
+
+    _mm_storeu_si128((__m128i*)costUncoded, _mm_sub_epi64(uncoded, psyProduct(psy, predictedCoef, psyShift)));
+    _mm_storeu_si128((__m128i*)cost, _mm_sub_epi64(cost0, psyProduct(psy, rec0, psyShift)));
+    _mm_storeu_si128((__m128i*)(cost + MLS_CG_BLK_SIZE), _mm_sub_epi64(cost1, psyProduct(psy, rec1, psyShift)));
+}
+
+#define LOW64(v)  _mm_cvtepi32_epi64(v)
+#define HIGH64(v) _mm_cvtepi32_epi64(_mm_unpackhi_epi64(v, v))
+
+/* One row of the coefficient group per iteration, see rdoQuantLevelDist_c */
+template<int log2TrSize>
+static void rdoQuantLevelDist(const int16_t* resiDctCoeff, const int16_t* fencDctCoeff, const int16_t* levels, const int32_t* unquantScale, int64_t* costUncoded, int64_t* costLevel, int64_t psyScale, int per, int unquantShift, uint32_t blkPos)
+{
+    const int transformShift = MAX_TR_DYNAMIC_RANGE - X265_DEPTH - log2TrSize; /* Represents scaling through forward transform */
+    const __m128i scaleBits = _mm_cvtsi32_si128(SCALE_BITS - 2 * transformShift);
+    const __m128i psyShift = _mm_cvtsi32_si128(X265_MAX(0, (2 * transformShift + 1)));
+    const __m128i unquantRound = _mm_set1_epi32((unquantShift > per) ? 1 << (unquantShift - per - 1) : 0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i psy = _mm_set1_epi64x(psyScale);
+    const uint32_t trSize = 1 << log2TrSize;
+
+    for (int y = 0; y < MLS_CG_SIZE; y++)
+    {
+        const uint32_t pos = blkPos + y * trSize;
+        __m128i signCoef = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(resiDctCoeff + pos)));
+        __m128i fencCoef = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(fencDctCoeff + pos)));
+        __m128i level = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(levels + pos)));
+        __m128i levelScale = _mm_sll_epi32(_mm_loadu_si128((const __m128i*)(unquantScale + pos)), _mm_cvtsi32_si128(per));
+        __m128i predictedCoef = _mm_sub_epi32(fencCoef, signCoef);
+
+        __m128i unQuantLevel = _mm_add_epi32(_mm_mullo_epi32(level, levelScale), unquantRound);
+        __m128i unquantAbsLevel0 = _mm_srl_epi32(unQuantLevel, _mm_cvtsi32_si128(unquantShift));
+        __m128i unquantAbsLevel1 = _mm_srl_epi32(_mm_sub_epi32(unQuantLevel, _mm_andnot_si128(_mm_cmpeq_epi32(level, zero), levelScale)),
+                                                 _mm_cvtsi32_si128(unquantShift));
+        __m128i absCoef = _mm_abs_epi32(signCoef);
+        __m128i d0 = _mm_sub_epi32(absCoef, unquantAbsLevel0);
+        __m128i d1 = _mm_sub_epi32(absCoef, unquantAbsLevel1);
+
+        __m128i sign = _mm_srai_epi32(signCoef, 31);
+        __m128i signedPred = _mm_sub_epi32(_mm_xor_si128(predictedCoef, sign), sign);
+        __m128i rec0 = _mm_abs_epi32(_mm_add_epi32(unquantAbsLevel0, signedPred));
+        __m128i rec1 = _mm_abs_epi32(_mm_add_epi32(unquantAbsLevel1, signedPred));
+
+        /* no psy-rd bias on the DC coefficient */
+        __m128i psyLow = pos ? psy : _mm_unpackhi_epi64(zero, psy);
+        int64_t* cost = costLevel + y * MLS_CG_SIZE;
+
+        levelDistPair(costUncoded + pos, cost, psyLow, LOW64(signCoef), LOW64(predictedCoef),
+                      LOW64(d0), LOW64(d1), LOW64(rec0), LOW64(rec1), scaleBits, psyShift);
+        levelDistPair(costUncoded + pos + 2, cost + 2, psy, HIGH64(signCoef), HIGH64(predictedCoef),
+                      HIGH64(d0), HIGH64(d1), HIGH64(rec0), HIGH64(rec1), scaleBits, psyShift);
+    }
+}
+
+#undef LOW64
+#undef HIGH64
+
 namespace X265_NS {
 void setupIntrinsicDCT_sse41(EncoderPrimitives &p)
 {
     p.dequant_scaling = dequant_scaling;
+    p.cu[BLOCK_4x4].rdoQuantLevelDist = rdoQuantLevelDist<2>;
+    p.cu[BLOCK_8x8].rdoQuantLevelDist = rdoQuantLevelDist<3>;
+    p.cu[BLOCK_16x16].rdoQuantLevelDist = rdoQuantLevelDist<4>;
+    p.cu[BLOCK_32x32].rdoQuantLevelDist = rdoQuantLevelDist<5>;
 }
 }
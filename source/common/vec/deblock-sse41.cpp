@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+
+#include "common.h"
+#include "primitives.h"
+#include <smmintrin.h> // SSE4.1
+
+using namespace X265_NS;
+
+namespace {
+
+/* Two segments of UNIT_SIZE lines are filtered together, one line per 16-bit
+ * lane. v[0..7] hold p3..p0 and q0..q3 across the edge. The weak filter takes
+ * 9 times a sample difference, which fits 16 bits for up to 10-bit samples */
+#define SEGS_PER_ITER 2
+
+inline __m128i loadRow(const pixel* src)
+{
+#if HIGH_BIT_DEPTH
+    return _mm_loadu_si128((const __m128i*)src);
+#else
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)src));
+#endif
+}
+
+inline void storeRow(pixel* dst, __m128i row)
+{
+#if HIGH_BIT_DEPTH
+    _mm_storeu_si128((__m128i*)dst, row);
+#else
+    _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(row, row));
+#endif
+}
+
+inline void transpose8x8(__m128i v[8])
+{
+    __m128i a0 = _mm_unpacklo_epi16(v[0], v[1]);
+    __m128i a1 = _mm_unpackhi_epi16(v[0], v[1]);
+    __m128i a2 = _mm_unpacklo_epi16(v[2], v[3]);
+    __m128i a3 = _mm_unpackhi_epi16(v[2], v[3]);
+    __m128i a4 = _mm_unpacklo_epi16(v[4], v[5]);
+    __m128i a5 = _mm_unpackhi_epi16(v[4], v[5]);
+    __m128i a6 = _mm_unpacklo_epi16(v[6], v[7]);
+    __m128i a7 = _mm_unpackhi_epi16(v[6], v[7]);
+
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    v[0] = _mm_unpacklo_epi64(b0, b4);
+    v[1] = _mm_unpackhi_epi64(b0, b4);
+    v[2] = _mm_unpacklo_epi64(b1, b5);
+    v[3] = _mm_unpackhi_epi64(b1, b5);
+    v[4] = _mm_unpacklo_epi64(b2, b6);
+    v[5] = _mm_unpackhi_epi64(b2, b6);
+    v[6] = _mm_unpacklo_epi64(b3, b7);
+    v[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+inline __m128i clip3(__m128i minVal, __m128i maxVal, __m128i v)
+{
+    return _mm_min_epi16(_mm_max_epi16(v, minVal), maxVal);
+}
+
+/* the decisions of a segment are taken from its first and last line */
+inline void filterSegs(__m128i v[8], const int16_t* beta, const int16_t* tc)
+{
+    const __m128i line0 = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 8, 9, 8, 9, 8, 9, 8, 9);
+    const __m128i line3 = _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+    const __m128i segs = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxPix = _mm_set1_epi16((1 << X265_DEPTH) - 1);
+
+    __m128i b = _mm_shuffle_epi8(_mm_cvtsi32_si128(*(const int32_t*)beta), segs);
+    __m128i t = _mm_shuffle_epi8(_mm_cvtsi32_si128(*(const int32_t*)tc), segs);
+
+    __m128i p3 = v[0], p2 = v[1], p1 = v[2], p0 = v[3];
+    __m128i q0 = v[4], q1 = v[5], q2 = v[6], q3 = v[7];
+
+    __m128i dp = _mm_abs_epi16(_mm_add_epi16(_mm_sub_epi16(p2, _mm_add_epi16(p1, p1)), p0));
+    __m128i dq = _mm_abs_epi16(_mm_add_epi16(_mm_sub_epi16(q2, _mm_add_epi16(q1, q1)), q0));
+    __m128i d0 = _mm_shuffle_epi8(_mm_add_epi16(dp, dq), line0);
+    __m128i d3 = _mm_shuffle_epi8(_mm_add_epi16(dp, dq), line3);
+
+    __m128i bFilter = _mm_cmplt_epi16(_mm_add_epi16(d0, d3), b);
+    if (_mm_testz_si128(bFilter, bFilter))
+        return;
+
+    /* strong filter decision */
+    __m128i b2 = _mm_srai_epi16(b, 2);
+    __m128i strongLine = _mm_and_si128(
+        _mm_cmplt_epi16(_mm_add_epi16(_mm_abs_epi16(_mm_sub_epi16(p3, p0)), _mm_abs_epi16(_mm_sub_epi16(q3, q0))), _mm_srai_epi16(b, 3)),
+        _mm_cmplt_epi16(_mm_abs_epi16(_mm_sub_epi16(p0, q0)), _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(t, _mm_set1_epi16(5)), _mm_set1_epi16(1)), 1)));
+    __m128i bStrong = _mm_and_si128(_mm_and_si128(_mm_cmplt_epi16(_mm_add_epi16(d0, d0), b2), _mm_cmplt_epi16(_mm_add_epi16(d3, d3), b2)),
+                                    _mm_and_si128(_mm_shuffle_epi8(strongLine, line0), _mm_shuffle_epi8(strongLine, line3)));
+
+    /* strong filter */
+    __m128i tc2 = _mm_add_epi16(t, t);
+    __m128i four = _mm_set1_epi16(4);
+    __m128i two = _mm_set1_epi16(2);
+    __m128i p1p0q0 = _mm_add_epi16(_mm_add_epi16(p1, p0), q0);
+    __m128i p0q0q1 = _mm_add_epi16(_mm_add_epi16(p0, q0), q1);
+
+    __m128i sp2 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(p3, p3), _mm_mullo_epi16(p2, _mm_set1_epi16(3))), _mm_add_epi16(p1p0q0, four)), 3);
+    __m128i sp1 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(p2, p1p0q0), two), 2);
+    __m128i sp0 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(p2, _mm_add_epi16(p1, p1)), _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(p0, p0), _mm_add_epi16(q0, q0)), _mm_add_epi16(q1, four))), 3);
+    __m128i sq0 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(p1, _mm_add_epi16(p0, p0)), _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(q0, q0), _mm_add_epi16(q1, q1)), _mm_add_epi16(q2, four))), 3);
+    __m128i sq1 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(p0q0q1, q2), two), 2);
+    __m128i sq2 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_mm_add_epi16(q3, q3), _mm_mullo_epi16(q2, _mm_set1_epi16(3))), _mm_add_epi16(p0q0q1, four)), 3);
+
+    sp2 = clip3(_mm_sub_epi16(p2, tc2), _mm_add_epi16(p2, tc2), sp2);
+    sp1 = clip3(_mm_sub_epi16(p1, tc2), _mm_add_epi16(p1, tc2), sp1);
+    sp0 = clip3(_mm_sub_epi16(p0, tc2), _mm_add_epi16(p0, tc2), sp0);
+    sq0 = clip3(_mm_sub_epi16(q0, tc2), _mm_add_epi16(q0, tc2), sq0);
+    sq1 = clip3(_mm_sub_epi16(q1, tc2), _mm_add_epi16(q1, tc2), sq1);
+    sq2 = clip3(_mm_sub_epi16(q2, tc2), _mm_add_epi16(q2, tc2), sq2);
+
+    /* weak filter */
+    __m128i delta = _mm_sub_epi16(_mm_mullo_epi16(_mm_sub_epi16(q0, p0), _mm_set1_epi16(9)), _mm_mullo_epi16(_mm_sub_epi16(q1, p1), _mm_set1_epi16(3)));
+    delta = _mm_srai_epi16(_mm_add_epi16(delta, _mm_set1_epi16(8)), 4);
+    __m128i bWeak = _mm_cmplt_epi16(_mm_abs_epi16(delta), _mm_mullo_epi16(t, _mm_set1_epi16(10)));
+    delta = clip3(_mm_sub_epi16(zero, t), t, delta);
+
+    __m128i sideThreshold = _mm_srai_epi16(_mm_add_epi16(b, _mm_srai_epi16(b, 1)), 3);
+    __m128i bP1 = _mm_cmplt_epi16(_mm_add_epi16(_mm_shuffle_epi8(dp, line0), _mm_shuffle_epi8(dp, line3)), sideThreshold);
+    __m128i bQ1 = _mm_cmplt_epi16(_mm_add_epi16(_mm_shuffle_epi8(dq, line0), _mm_shuffle_epi8(dq, line3)), sideThreshold);
+    __m128i tcHalf = _mm_srai_epi16(t, 1);
+    __m128i tcHalfNeg = _mm_sub_epi16(zero, tcHalf);
+
+    __m128i wp0 = clip3(zero, maxPix, _mm_add_epi16(p0, delta));
+    __m128i wq0 = clip3(zero, maxPix, _mm_sub_epi16(q0, delta));
+    __m128i dp1 = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_avg_epu16(p2, p0), p1), delta), 1);
+    __m128i dq1 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(_mm_avg_epu16(q2, q0), q1), delta), 1);
+    __m128i wp1 = clip3(zero, maxPix, _mm_add_epi16(p1, clip3(tcHalfNeg, tcHalf, dp1)));
+    __m128i wq1 = clip3(zero, maxPix, _mm_add_epi16(q1, clip3(tcHalfNeg, tcHalf, dq1)));
+    wp1 = _mm_blendv_epi8(p1, wp1, bP1);
+    wq1 = _mm_blendv_epi8(q1, wq1, bQ1);
+
+    /* lanes of skipped segments and of lines the weak filter leaves alone keep their samples */
+    bWeak = _mm_and_si128(bWeak, bFilter);
+    bStrong = _mm_and_si128(bStrong, bFilter);
+    v[1] = _mm_blendv_epi8(p2, sp2, bStrong);
+    v[2] = _mm_blendv_epi8(_mm_blendv_epi8(p1, wp1, bWeak), sp1, bStrong);
+    v[3] = _mm_blendv_epi8(_mm_blendv_epi8(p0, wp0, bWeak), sp0, bStrong);
+    v[4] = _mm_blendv_epi8(_mm_blendv_epi8(q0, wq0, bWeak), sq0, bStrong);
+    v[5] = _mm_blendv_epi8(_mm_blendv_epi8(q1, wq1, bWeak), sq1, bStrong);
+    v[6] = _mm_blendv_epi8(q2, sq2, bStrong);
+}
+
+/* vertical edge, lines are rows of 8 samples across the edge */
+void pelFilterLumaEdge_V_sse41(pixel* src, intptr_t srcStep, intptr_t /*offset*/, const int16_t* beta, const int16_t* tc, int numSegs)
+{
+    X265_CHECK(!(numSegs % SEGS_PER_ITER), "odd number of edge segments\n");
+    for (int seg = 0; seg < numSegs; seg += SEGS_PER_ITER, src += srcStep * UNIT_SIZE * SEGS_PER_ITER)
+    {
+        if (!(beta[seg] | beta[seg + 1]))
+            continue;
+
+        __m128i v[8];
+        for (int i = 0; i < 8; i++)
+            v[i] = loadRow(src + i * srcStep - 4);
+
+        transpose8x8(v);
+        filterSegs(v, beta + seg, tc + seg);
+        transpose8x8(v);
+
+        for (int i = 0; i < 8; i++)
+            storeRow(src + i * srcStep - 4, v[i]);
+    }
+}
+
+/* horizontal edge, each row holds one sample of 8 consecutive lines */
+void pelFilterLumaEdge_H_sse41(pixel* src, intptr_t /*srcStep*/, intptr_t offset, const int16_t* beta, const int16_t* tc, int numSegs)
+{
+    X265_CHECK(!(numSegs % SEGS_PER_ITER), "odd number of edge segments\n");
+    for (int seg = 0; seg < numSegs; seg += SEGS_PER_ITER, src += UNIT_SIZE * SEGS_PER_ITER)
+    {
+        if (!(beta[seg] | beta[seg + 1]))
+            continue;
+
+        __m128i v[8];
+        for (int i = 0; i < 8; i++)
+            v[i] = loadRow(src + (i - 4) * offset);
+
+        filterSegs(v, beta + seg, tc + seg);
+
+        for (int i = 1; i < 7; i++)
+            storeRow(src + (i - 4) * offset, v[i]);
+    }
+}
+}
+
+namespace X265_NS {
+void setupIntrinsicDeblock_sse41(EncoderPrimitives &p)
+{
+#if X265_DEPTH <= 10
+    p.pelFilterLumaEdge[0] = pelFilterLumaEdge_V_sse41;
+    p.pelFilterLumaEdge[1] = pelFilterLumaEdge_H_sse41;
+#else
+    (void)p;
+#endif
+}
+}
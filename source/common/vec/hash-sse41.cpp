@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "constants.h"
+#include <smmintrin.h> // SSE4.1
+#include <wmmintrin.h> // PCLMULQDQ
+
+using namespace X265_NS;
+
+namespace {
+
+/* x^n mod P, P = x^16 + x^12 + x^5 + 1, for the folding distances below */
+#define CRC16_X128 0xaefc
+#define CRC16_X192 0x650b
+#define CRC16_X512 0x13fc
+#define CRC16_X576 0x8832
+
+uint32_t crc16Bytes(const uint8_t* buf, intptr_t len, uint32_t crc)
+{
+    for (intptr_t i = 0; i < len; i++)
+        crc = (((crc << 8) | buf[i]) & 0xffff) ^ g_crc16Table[crc >> 8];
+    return crc;
+}
+
+/* Blocks are loaded as polynomials of degree < 128, first byte highest */
+inline __m128i loadBlock(const uint8_t* buf, __m128i bswap)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)buf), bswap);
+}
+
+/* x * x^n + d, reduced to degree < 128 given k = { x^n mod P, x^(n+64) mod P } */
+inline __m128i foldBlock(__m128i x, __m128i k, __m128i d)
+{
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), d);
+}
+
+/* The SEI register after a run of bytes is the remainder of crc * x^(8 * len)
+ * plus the bytes taken as one polynomial. Four accumulators are folded 512
+ * bits at a time, merged, reduced to 16 bits through the byte table and the
+ * remaining bytes are taken one at a time */
+uint32_t crc16Row(const uint8_t* buf, intptr_t len, uint32_t crc)
+{
+    if (len < 64)
+        return crc16Bytes(buf, len, crc);
+
+    const __m128i bswap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i k128 = _mm_set_epi32(0, CRC16_X192, 0, CRC16_X128);
+    const __m128i k512 = _mm_set_epi32(0, CRC16_X576, 0, CRC16_X512);
+
+    /* the register leads the stream by 16 bits, x^128 ahead of the first block */
+    __m128i x0 = _mm_xor_si128(loadBlock(buf, bswap), _mm_clmulepi64_si128(_mm_cvtsi32_si128(crc), k128, 0x00));
+    __m128i x1 = loadBlock(buf + 16, bswap);
+    __m128i x2 = loadBlock(buf + 32, bswap);
+    __m128i x3 = loadBlock(buf + 48, bswap);
+    buf += 64;
+    len -= 64;
+
+    for (; len >= 64; buf += 64, len -= 64)
+    {
+        x0 = foldBlock(x0, k512, loadBlock(buf, bswap));
+        x1 = foldBlock(x1, k512, loadBlock(buf + 16, bswap));
+        x2 = foldBlock(x2, k512, loadBlock(buf + 32, bswap));
+        x3 = foldBlock(x3, k512, loadBlock(buf + 48, bswap));
+    }
+
+    x0 = foldBlock(x0, k128, x1);
+    x0 = foldBlock(x0, k128, x2);
+    x0 = foldBlock(x0, k128, x3);
+    for (; len >= 16; buf += 16, len -= 16)
+        x0 = foldBlock(x0, k128, loadBlock(buf, bswap));
+
+    ALIGN_VAR_16(uint8_t, rem[16]);
+    _mm_store_si128((__m128i*)rem, _mm_shuffle_epi8(x0, bswap));
+    crc = crc16Bytes(rem, 16, 0);
+
+    return crc16Bytes(buf, len, crc);
+}
+
+/* samples are little endian, so each row is hashed as it lies in memory */
+uint32_t hash_crc_pclmul(const pixel* src, intptr_t stride, int width, int height, uint32_t crc)
+{
+    for (int y = 0; y < height; y++)
+    {
+        crc = crc16Row((const uint8_t*)src, width * sizeof(pixel), crc);
+        src += stride;
+    }
+    return crc;
+}
+
+uint32_t hash_checksum_sse41(const pixel* src, intptr_t stride, int width, int height, int y, uint32_t sum)
+{
+    for (int j = 0; j < height; j++, y++)
+    {
+        const uint32_t yMask = (y & 0xff) ^ (y >> 8);
+        int x = 0;
+
+#if HIGH_BIT_DEPTH
+        /* groups of 8 samples start at a multiple of 8, so x & 0xff never
+         * carries across the group */
+        const __m128i ramp = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m128i lowByte = _mm_set1_epi16(0xff);
+        const __m128i one = _mm_set1_epi16(1);
+        __m128i acc = _mm_setzero_si128();
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i mask = _mm_xor_si128(_mm_add_epi16(ramp, _mm_set1_epi16((int16_t)(x & 0xff))), _mm_set1_epi16((int16_t)((x >> 8) ^ yMask)));
+            __m128i pix = _mm_loadu_si128((const __m128i*)(src + x));
+            __m128i lo = _mm_xor_si128(_mm_and_si128(pix, lowByte), mask);
+            __m128i hi = _mm_xor_si128(_mm_srli_epi16(pix, 8), mask);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_add_epi16(lo, hi), one));
+        }
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum += (uint32_t)_mm_cvtsi128_si32(acc);
+#else
+        const __m128i ramp = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i mask = _mm_xor_si128(_mm_add_epi8(ramp, _mm_set1_epi8((char)(x & 0xff))), _mm_set1_epi8((char)((x >> 8) ^ yMask)));
+            __m128i pix = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + x)), mask);
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(pix, zero));
+        }
+        sum += (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+
+        for (; x < width; x++)
+        {
+            uint32_t xorMask = (x & 0xff) ^ (x >> 8) ^ yMask;
+            sum += (src[x] & 0xff) ^ xorMask;
+#if HIGH_BIT_DEPTH
+            sum += (src[x] >> 8) ^ xorMask;
+#endif
+        }
+        src += stride;
+    }
+    return sum;
+}
+
+}
+
+namespace X265_NS {
+void setupIntrinsicHash_sse41(EncoderPrimitives &p, int cpuMask)
+{
+    p.hash_checksum = hash_checksum_sse41;
+    if (cpuMask & X265_CPU_PCLMUL)
+        p.hash_crc = hash_crc_pclmul;
+}
+}
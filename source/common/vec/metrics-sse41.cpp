@@ -0,0 +1,185 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+
+#include "common.h"
+#include "primitives.h"
+#include <smmintrin.h> // SSE4.1
+
+using namespace X265_NS;
+
+namespace {
+
+inline __m128i loadRow(const pixel* src)
+{
+#if HIGH_BIT_DEPTH
+    return _mm_loadu_si128((const __m128i*)src);
+#else
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)src));
+#endif
+}
+
+inline uint32_t sumLanes(__m128i acc)
+{
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(acc);
+}
+
+/* samples of up to 12 bits are positive 16-bit words, so pairwise products
+ * summed by pmaddwd stay within 32 bits */
+void vif_stats_sse41(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, uint32_t sums[5])
+{
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i s = _mm_setzero_si128();
+    __m128i r = _mm_setzero_si128();
+    __m128i ss = _mm_setzero_si128();
+    __m128i rr = _mm_setzero_si128();
+    __m128i sr = _mm_setzero_si128();
+
+    for (int y = 0; y < 8; y++)
+    {
+        __m128i srcRow = loadRow(src);
+        __m128i recRow = loadRow(rec);
+        s = _mm_add_epi32(s, _mm_madd_epi16(srcRow, one));
+        r = _mm_add_epi32(r, _mm_madd_epi16(recRow, one));
+        ss = _mm_add_epi32(ss, _mm_madd_epi16(srcRow, srcRow));
+        rr = _mm_add_epi32(rr, _mm_madd_epi16(recRow, recRow));
+        sr = _mm_add_epi32(sr, _mm_madd_epi16(srcRow, recRow));
+        src += srcStride;
+        rec += recStride;
+    }
+
+    sums[0] = sumLanes(s);
+    sums[1] = sumLanes(r);
+    sums[2] = sumLanes(ss);
+    sums[3] = sumLanes(rr);
+    sums[4] = sumLanes(sr);
+}
+
+/* Adds the cubes of four 32-bit magnitudes to two 64-bit lanes; a magnitude
+ * of 12-bit Haar detail is below 2^14, so its square fits in 32 bits */
+inline __m128i addCubes(__m128i acc, __m128i mag)
+{
+    __m128i sq = _mm_mullo_epi32(mag, mag);
+    acc = _mm_add_epi64(acc, _mm_mul_epu32(sq, mag));
+    return _mm_add_epi64(acc, _mm_mul_epu32(_mm_srli_epi64(sq, 32), _mm_srli_epi64(mag, 32)));
+}
+
+/* Four quads per iteration: pmaddwd with (1, 1) and (1, -1) gives the sums
+ * and differences of horizontal sample pairs, from which the three details
+ * and the average of each quad follow */
+void adm_stats_sse41(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, int width,
+                     pixel* srcNext, pixel* recNext, uint64_t sums[2])
+{
+    const __m128i pairSum = _mm_set1_epi16(1);
+    const __m128i pairDiff = _mm_set1_epi32((int)0xffff0001);
+    const __m128i round = _mm_set1_epi32(2);
+    __m128i restored = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+    int x = 0;
+
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i srcTop = loadRow(src + 2 * x);
+        __m128i srcBot = loadRow(src + 2 * x + srcStride);
+        __m128i recTop = loadRow(rec + 2 * x);
+        __m128i recBot = loadRow(rec + 2 * x + recStride);
+
+        __m128i srcTopSum = _mm_madd_epi16(srcTop, pairSum), srcTopDiff = _mm_madd_epi16(srcTop, pairDiff);
+        __m128i srcBotSum = _mm_madd_epi16(srcBot, pairSum), srcBotDiff = _mm_madd_epi16(srcBot, pairDiff);
+        __m128i recTopSum = _mm_madd_epi16(recTop, pairSum), recTopDiff = _mm_madd_epi16(recTop, pairDiff);
+        __m128i recBotSum = _mm_madd_epi16(recBot, pairSum), recBotDiff = _mm_madd_epi16(recBot, pairDiff);
+
+        __m128i srcDetail[3] = { _mm_sub_epi32(srcTopSum, srcBotSum),
+                                 _mm_add_epi32(srcTopDiff, srcBotDiff),
+                                 _mm_sub_epi32(srcTopDiff, srcBotDiff) };
+        __m128i recDetail[3] = { _mm_sub_epi32(recTopSum, recBotSum),
+                                 _mm_add_epi32(recTopDiff, recBotDiff),
+                                 _mm_sub_epi32(recTopDiff, recBotDiff) };
+
+        for (int band = 0; band < 3; band++)
+        {
+            __m128i mag = _mm_abs_epi32(srcDetail[band]);
+            __m128i sameSign = _mm_cmpgt_epi32(_mm_xor_si128(srcDetail[band], recDetail[band]), _mm_set1_epi32(-1));
+            total = addCubes(total, mag);
+            restored = addCubes(restored, _mm_and_si128(sameSign, _mm_min_epi32(mag, _mm_abs_epi32(recDetail[band]))));
+        }
+
+        if (srcNext)
+        {
+            __m128i srcAvg = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(srcTopSum, srcBotSum), round), 2);
+            __m128i recAvg = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(recTopSum, recBotSum), round), 2);
+            __m128i avg = _mm_packus_epi32(srcAvg, recAvg);
+#if HIGH_BIT_DEPTH
+            _mm_storel_epi64((__m128i*)(srcNext + x), avg);
+            _mm_storel_epi64((__m128i*)(recNext + x), _mm_unpackhi_epi64(avg, avg));
+#else
+            avg = _mm_packus_epi16(avg, avg);
+            *(uint32_t*)(srcNext + x) = (uint32_t)_mm_cvtsi128_si32(avg);
+            *(uint32_t*)(recNext + x) = (uint32_t)_mm_extract_epi32(avg, 1);
+#endif
+        }
+    }
+
+    ALIGN_VAR_16(uint64_t, lanes[2][2]);
+    _mm_store_si128((__m128i*)lanes[0], restored);
+    _mm_store_si128((__m128i*)lanes[1], total);
+    sums[0] += lanes[0][0] + lanes[0][1];
+    sums[1] += lanes[1][0] + lanes[1][1];
+
+    /* the last quads of a row one at a time, as adm_stats_c does */
+    for (src += 2 * x, rec += 2 * x; x < width; x++, src += 2, rec += 2)
+    {
+        int srcDetail[3] = { src[0] + src[1] - src[srcStride] - src[srcStride + 1],
+                             src[0] - src[1] + src[srcStride] - src[srcStride + 1],
+                             src[0] - src[1] - src[srcStride] + src[srcStride + 1] };
+        int recDetail[3] = { rec[0] + rec[1] - rec[recStride] - rec[recStride + 1],
+                             rec[0] - rec[1] + rec[recStride] - rec[recStride + 1],
+                             rec[0] - rec[1] - rec[recStride] + rec[recStride + 1] };
+
+        for (int band = 0; band < 3; band++)
+        {
+            uint64_t mag = abs(srcDetail[band]);
+            sums[1] += mag * mag * mag;
+            if ((srcDetail[band] ^ recDetail[band]) >= 0)
+            {
+                mag = X265_MIN(mag, (uint64_t)abs(recDetail[band]));
+                sums[0] += mag * mag * mag;
+            }
+        }
+
+        if (srcNext)
+        {
+            srcNext[x] = (pixel)((src[0] + src[1] + src[srcStride] + src[srcStride + 1] + 2) >> 2);
+            recNext[x] = (pixel)((rec[0] + rec[1] + rec[recStride] + rec[recStride + 1] + 2) >> 2);
+        }
+    }
+}
+}
+
+namespace X265_NS {
+void setupIntrinsicMetrics_sse41(EncoderPrimitives &p)
+{
+    p.vif_stats = vif_stats_sse41;
+    p.adm_stats = adm_stats_sse41;
+}
+}
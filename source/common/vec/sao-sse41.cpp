@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+
+#include "common.h"
+#include "primitives.h"
+#include <smmintrin.h> // SSE4.1
+
+using namespace X265_NS;
+
+namespace {
+
+/* layout of the statistics, as in class SAO */
+#define SAO_NUM_EO        4
+#define SAO_TYPE_BO       4
+#define SAO_NUM_EDGETYPE  5
+#define SAO_NUM_CLASS     32
+#define SAO_BO_BITS       5
+
+inline __m128i loadRow(const pixel* src)
+{
+#if HIGH_BIT_DEPTH
+    return _mm_loadu_si128((const __m128i*)src);
+#else
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)src));
+#endif
+}
+
+/* sign(a - b) of each lane, in -1..1 */
+inline __m128i signOf(__m128i a, __m128i b)
+{
+    return _mm_sub_epi16(_mm_cmpgt_epi16(b, a), _mm_cmpgt_epi16(a, b));
+}
+
+inline int32_t sumLanes32(__m128i acc)
+{
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+/* Eight samples of a row per step. The edge type of each lane is compared
+ * against all five types, so each type sums the differences of its lanes and
+ * counts them in 16 bits, which a block of 64x64 samples cannot overflow. The
+ * band offset histogram is gathered one sample at a time from the same row of
+ * differences */
+void saoCuStatsAll_sse41(const pixel *fenc, const pixel *rec, intptr_t stride, const int32_t bounds[][4], int32_t *stats, int32_t *count)
+{
+    static const uint32_t eoTable[SAO_NUM_EDGETYPE] = { 1, 2, 0, 3, 4 };
+    const intptr_t eoOffset[SAO_NUM_EO] = { 1, stride, stride + 1, stride - 1 };
+    const int boShift = X265_DEPTH - SAO_BO_BITS;
+    const __m128i ramp = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i sumStats[SAO_NUM_EO][SAO_NUM_EDGETYPE];
+    __m128i sumCount[SAO_NUM_EO][SAO_NUM_EDGETYPE];
+    ALIGN_VAR_16(int16_t, diff[MAX_CU_SIZE + 16]);
+
+    for (int type = 0; type < SAO_NUM_EO; type++)
+        for (int e = 0; e < SAO_NUM_EDGETYPE; e++)
+            sumStats[type][e] = sumCount[type][e] = _mm_setzero_si128();
+    memset(diff, 0, sizeof(diff));
+
+    int startY = MAX_CU_SIZE, endY = 0, endX = 0;
+    for (int type = 0; type <= SAO_TYPE_BO; type++)
+    {
+        if (bounds[type][0] < bounds[type][1] && bounds[type][2] < bounds[type][3])
+        {
+            startY = X265_MIN(startY, bounds[type][2]);
+            endY = X265_MAX(endY, bounds[type][3]);
+            endX = X265_MAX(endX, bounds[type][1]);
+        }
+    }
+
+    fenc += startY * stride;
+    rec += startY * stride;
+    for (int y = startY; y < endY; y++, fenc += stride, rec += stride)
+    {
+        for (int x = 0; x < endX; x += 8)
+            _mm_store_si128((__m128i*)(diff + x), _mm_sub_epi16(loadRow(fenc + x), loadRow(rec + x)));
+
+        if (y >= bounds[SAO_TYPE_BO][2] && y < bounds[SAO_TYPE_BO][3])
+        {
+            int32_t* boStats = stats + SAO_TYPE_BO * SAO_NUM_CLASS;
+            int32_t* boCount = count + SAO_TYPE_BO * SAO_NUM_CLASS;
+            for (int x = bounds[SAO_TYPE_BO][0]; x < bounds[SAO_TYPE_BO][1]; x++)
+            {
+                int classIdx = rec[x] >> boShift;
+                boStats[classIdx] += diff[x];
+                boCount[classIdx]++;
+            }
+        }
+
+        for (int type = 0; type < SAO_NUM_EO; type++)
+        {
+            if (y < bounds[type][2] || y >= bounds[type][3])
+                continue;
+
+            const intptr_t offset = eoOffset[type];
+            const int typeEndX = bounds[type][1];
+            for (int x = bounds[type][0]; x < typeEndX; x += 8)
+            {
+                __m128i inside = _mm_cmpgt_epi16(_mm_set1_epi16((int16_t)(typeEndX - x)), ramp);
+                __m128i cur = loadRow(rec + x);
+                __m128i edgeType = _mm_add_epi16(signOf(cur, loadRow(rec + x + offset)), signOf(cur, loadRow(rec + x - offset)));
+                __m128i d = _mm_loadu_si128((const __m128i*)(diff + x));
+
+                for (int e = 0; e < SAO_NUM_EDGETYPE; e++)
+                {
+                    __m128i mask = _mm_and_si128(_mm_cmpeq_epi16(edgeType, _mm_set1_epi16((int16_t)(e - 2))), inside);
+                    sumStats[type][e] = _mm_add_epi32(sumStats[type][e], _mm_madd_epi16(_mm_and_si128(d, mask), one));
+                    sumCount[type][e] = _mm_sub_epi16(sumCount[type][e], mask);
+                }
+            }
+        }
+    }
+
+    for (int type = 0; type < SAO_NUM_EO; type++)
+    {
+        for (int e = 0; e < SAO_NUM_EDGETYPE; e++)
+        {
+            stats[type * SAO_NUM_CLASS + eoTable[e]] += sumLanes32(sumStats[type][e]);
+            count[type * SAO_NUM_CLASS + eoTable[e]] += sumLanes32(_mm_madd_epi16(sumCount[type][e], one));
+        }
+    }
+}
+}
+
+namespace X265_NS {
+void setupIntrinsicSao_sse41(EncoderPrimitives &p)
+{
+    p.saoCuStatsAll = saoCuStatsAll_sse41;
+}
+}
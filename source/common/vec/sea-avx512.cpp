@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include <immintrin.h> // AVX-512 F, BW, VL
+
+using namespace X265_NS;
+
+namespace {
+
+inline int popCount16(__mmask16 mask)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt((unsigned int)mask);
+#else
+    return __builtin_popcount((unsigned int)mask);
+#endif
+}
+
+/* Successive elimination candidates, 16 motion vectors per iteration. The
+ * indices of the lanes below thresh are compressed into the front of a
+ * vector and stored with a mask, so mvs[] is never written past the last
+ * candidate, same as the C reference. */
+template<int NUM_DC>
+inline int adsN(const int encDC[], const uint32_t *sums, const int offset[], const uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const __m512i ramp = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i vthresh = _mm512_set1_epi32(thresh);
+    __m512i dc[NUM_DC];
+    for (int k = 0; k < NUM_DC; k++)
+        dc[k] = _mm512_set1_epi32(encDC[k]);
+
+    int nmv = 0;
+    for (int i = 0; i < width; i += 16)
+    {
+        __mmask16 valid = width - i >= 16 ? (__mmask16)0xffff : (__mmask16)((1 << (width - i)) - 1);
+        __m512i ads = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(valid, costMvX + i));
+        for (int k = 0; k < NUM_DC; k++)
+        {
+            __m512i s = _mm512_maskz_loadu_epi32(valid, sums + i + offset[k]);
+            ads = _mm512_add_epi32(ads, _mm512_abs_epi32(_mm512_sub_epi32(dc[k], s)));
+        }
+
+        __mmask16 hit = _mm512_mask_cmplt_epi32_mask(valid, ads, vthresh);
+        if (hit)
+        {
+            __m512i idx = _mm512_maskz_compress_epi32(hit, _mm512_add_epi32(ramp, _mm512_set1_epi32(i)));
+            int count = popCount16(hit);
+            _mm256_mask_storeu_epi16(mvs + nmv, (__mmask16)((1 << count) - 1), _mm512_cvtepi32_epi16(idx));
+            nmv += count;
+        }
+    }
+
+    return nmv;
+}
+
+template<int lx, int ly>
+int ads_x4_avx512(int encDC[4], uint32_t *sums, int delta, uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const int offset[4] = { 0, lx >> 1, delta, delta + (lx >> 1) };
+    return adsN<4>(encDC, sums, offset, costMvX, mvs, width, thresh);
+}
+
+template<int lx, int ly>
+int ads_x2_avx512(int encDC[2], uint32_t *sums, int delta, uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const int offset[2] = { 0, delta };
+    return adsN<2>(encDC, sums, offset, costMvX, mvs, width, thresh);
+}
+
+template<int lx, int ly>
+int ads_x1_avx512(int encDC[1], uint32_t *sums, int, uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const int offset[1] = { 0 };
+    return adsN<1>(encDC, sums, offset, costMvX, mvs, width, thresh);
+}
+
+#if HIGH_BIT_DEPTH
+/* Horizontal N-wide running sums added to the row above. The running sum at
+ * x is sum(pix[0..N-1]) plus an exclusive prefix sum of pix[k + N] - pix[k],
+ * which is scanned 16 lanes at a time with the last lane carried over. */
+template<int N>
+void integral_inith_avx512(uint32_t *sum, pixel *pix, intptr_t stride)
+{
+    int32_t v = 0;
+    for (int k = 0; k < N; k++)
+        v += pix[k];
+
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i last = _mm512_set1_epi32(15);
+    __m512i carry = _mm512_set1_epi32(v);
+    intptr_t width = stride - N;
+    for (intptr_t x = 0; x < width; x += 16)
+    {
+        __mmask16 valid = width - x >= 16 ? (__mmask16)0xffff : (__mmask16)((1 << (width - x)) - 1);
+        __m512i head = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(valid, pix + x));
+        __m512i tail = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(valid, pix + x + N));
+        __m512i diff = _mm512_sub_epi32(tail, head);
+
+        __m512i scan = diff;
+        scan = _mm512_add_epi32(scan, _mm512_alignr_epi32(scan, zero, 15));
+        scan = _mm512_add_epi32(scan, _mm512_alignr_epi32(scan, zero, 14));
+        scan = _mm512_add_epi32(scan, _mm512_alignr_epi32(scan, zero, 12));
+        scan = _mm512_add_epi32(scan, _mm512_alignr_epi32(scan, zero, 8));
+
+        __m512i run = _mm512_add_epi32(carry, _mm512_sub_epi32(scan, diff));
+        __m512i above = _mm512_maskz_loadu_epi32(valid, sum + x - stride);
+        _mm512_mask_storeu_epi32(sum + x, valid, _mm512_add_epi32(run, above));
+        carry = _mm512_add_epi32(carry, _mm512_permutexvar_epi32(last, scan));
+    }
+}
+#endif
+
+} // namespace
+
+namespace X265_NS {
+// private x265 namespace
+
+void setupIntrinsicSea_avx512(EncoderPrimitives &p)
+{
+    p.pu[LUMA_4x4].ads = ads_x1_avx512<4, 4>;
+    p.pu[LUMA_8x8].ads = ads_x1_avx512<8, 8>;
+    p.pu[LUMA_8x4].ads = ads_x2_avx512<8, 4>;
+    p.pu[LUMA_4x8].ads = ads_x2_avx512<4, 8>;
+    p.pu[LUMA_16x16].ads = ads_x4_avx512<16, 16>;
+    p.pu[LUMA_16x8].ads = ads_x2_avx512<16, 8>;
+    p.pu[LUMA_8x16].ads = ads_x2_avx512<8, 16>;
+    p.pu[LUMA_16x12].ads = ads_x1_avx512<16, 12>;
+    p.pu[LUMA_12x16].ads = ads_x1_avx512<12, 16>;
+    p.pu[LUMA_16x4].ads = ads_x1_avx512<16, 4>;
+    p.pu[LUMA_4x16].ads = ads_x1_avx512<4, 16>;
+    p.pu[LUMA_32x32].ads = ads_x4_avx512<32, 32>;
+    p.pu[LUMA_32x16].ads = ads_x2_avx512<32, 16>;
+    p.pu[LUMA_16x32].ads = ads_x2_avx512<16, 32>;
+    p.pu[LUMA_32x24].ads = ads_x4_avx512<32, 24>;
+    p.pu[LUMA_24x32].ads = ads_x4_avx512<24, 32>;
+    p.pu[LUMA_32x8].ads = ads_x4_avx512<32, 8>;
+    p.pu[LUMA_8x32].ads = ads_x4_avx512<8, 32>;
+    p.pu[LUMA_64x64].ads = ads_x4_avx512<64, 64>;
+    p.pu[LUMA_64x32].ads = ads_x2_avx512<64, 32>;
+    p.pu[LUMA_32x64].ads = ads_x2_avx512<32, 64>;
+    p.pu[LUMA_64x48].ads = ads_x4_avx512<64, 48>;
+    p.pu[LUMA_48x64].ads = ads_x4_avx512<48, 64>;
+    p.pu[LUMA_64x16].ads = ads_x4_avx512<64, 16>;
+    p.pu[LUMA_16x64].ads = ads_x4_avx512<16, 64>;
+
+#if HIGH_BIT_DEPTH
+    /* the AVX2 assembly has no high bit depth 24 and 32 wide inith; it is
+     * installed after the intrinsics and keeps the other widths */
+    p.integral_inith[INTEGRAL_24] = integral_inith_avx512<24>;
+    p.integral_inith[INTEGRAL_32] = integral_inith_avx512<32>;
+#endif
+}
+}
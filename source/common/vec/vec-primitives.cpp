@@ -31,6 +31,7 @@
 #define HAVE_SSSE3
 #define HAVE_SSE4
 #define HAVE_AVX2
+#define HAVE_PCLMUL
 #elif defined(__GNUC__)
 #define GCC_VERSION (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__)
 #if __clang__ || GCC_VERSION >= 40300 /* gcc_version >= gcc-4.3.0 */
@@ -40,6 +41,10 @@
 #endif
 #if __clang__ || GCC_VERSION >= 40700 /* gcc_version >= gcc-4.7.0 */
 #define HAVE_AVX2
+#define HAVE_PCLMUL
+#endif
+#if __clang__ || GCC_VERSION >= 50000 /* gcc_version >= gcc-5.0.0 */
+#define HAVE_AVX512
 #endif
 #elif defined(_MSC_VER)
 #define HAVE_SSE3
@@ -47,6 +52,10 @@
 #define HAVE_SSE4
 #if _MSC_VER >= 1700 // VC11
 #define HAVE_AVX2
+#define HAVE_PCLMUL
+#endif
+#if _MSC_VER >= 1910 // VC15
+#define HAVE_AVX512
 #endif
 #endif // compiler checks
 #endif // if X265_ARCH_X86
@@ -57,6 +66,11 @@ namespace X265_NS {
 void setupIntrinsicDCT_sse3(EncoderPrimitives&);
 void setupIntrinsicDCT_ssse3(EncoderPrimitives&);
 void setupIntrinsicDCT_sse41(EncoderPrimitives&);
+void setupIntrinsicMetrics_sse41(EncoderPrimitives&);
+void setupIntrinsicDeblock_sse41(EncoderPrimitives&);
+void setupIntrinsicSao_sse41(EncoderPrimitives&);
+void setupIntrinsicHash_sse41(EncoderPrimitives&, int cpuMask);
+void setupIntrinsicSea_avx512(EncoderPrimitives&);
 
 /* Use primitives for the best available vector architecture */
 void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask)
@@ -77,6 +91,21 @@ void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask)
     if (cpuMask & X265_CPU_SSE4)
     {
         setupIntrinsicDCT_sse41(p);
+        setupIntrinsicMetrics_sse41(p);
+        setupIntrinsicDeblock_sse41(p);
+        setupIntrinsicSao_sse41(p);
+    }
+#endif
+#ifdef HAVE_PCLMUL
+    if (cpuMask & X265_CPU_SSE4)
+    {
+        setupIntrinsicHash_sse41(p, cpuMask);
+    }
+#endif
+#ifdef HAVE_AVX512
+    if (cpuMask & X265_CPU_AVX512)
+    {
+        setupIntrinsicSea_avx512(p);
     }
 #endif
     (void)p;
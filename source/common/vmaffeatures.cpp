@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "picyuv.h"
+#include "vmaffeatures.h"
+
+using namespace X265_NS;
+
+namespace {
+
+/* model constants of the VIF feature, for variances in 8-bit units */
+const double VIF_SIGMA_NSQ = 2.0;
+const double VIF_EPS = 1e-10;
+const double VIF_GAIN_LIMIT = 100.0;
+
+/* s[] holds the sums of source, recon, source squared, recon squared and their
+ * product over a window of n samples. The feature is a ratio of sums of logs,
+ * so the base of the logarithm does not matter */
+void vifWindow(int64_t n, const int64_t s[5], double& num, double& den)
+{
+    const double norm = 1.0 / ((double)n * n * (1 << (2 * (X265_DEPTH - 8))));
+    double srcVar = (double)(n * s[2] - s[0] * s[0]) * norm;
+    double recVar = (double)(n * s[3] - s[1] * s[1]) * norm;
+    double covar = (double)(n * s[4] - s[0] * s[1]) * norm;
+
+    double gain = covar / (srcVar + VIF_EPS);
+    double noiseVar = recVar - gain * covar;
+    if (srcVar < VIF_EPS)
+    {
+        gain = 0;
+        noiseVar = recVar;
+        srcVar = 0;
+    }
+    if (recVar < VIF_EPS)
+    {
+        gain = 0;
+        noiseVar = 0;
+    }
+    if (gain < 0)
+    {
+        gain = 0;
+        noiseVar = recVar;
+    }
+    noiseVar = X265_MAX(noiseVar, VIF_EPS);
+    gain = X265_MIN(gain, VIF_GAIN_LIMIT);
+
+    num += log(1 + gain * gain * srcVar / (noiseVar + VIF_SIGMA_NSQ));
+    den += log(1 + srcVar / VIF_SIGMA_NSQ);
+}
+
+void measureVif(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride,
+                int width, int height, double& num, double& den)
+{
+    for (int y = 0; y < height; y += 8)
+    {
+        for (int x = 0; x < width; x += 8)
+        {
+            const pixel* s = src + y * srcStride + x;
+            const pixel* r = rec + y * recStride + x;
+            int w = X265_MIN(8, width - x);
+            int h = X265_MIN(8, height - y);
+            int64_t sums[5];
+
+            if (w == 8 && h == 8)
+            {
+                uint32_t sums8x8[5];
+                primitives.vif_stats(s, srcStride, r, recStride, sums8x8);
+                for (int i = 0; i < 5; i++)
+                    sums[i] = sums8x8[i];
+            }
+            else
+            {
+                memset(sums, 0, sizeof(sums));
+                for (int j = 0; j < h; j++, s += srcStride, r += recStride)
+                {
+                    for (int i = 0; i < w; i++)
+                    {
+                        sums[0] += s[i];
+                        sums[1] += r[i];
+                        sums[2] += s[i] * s[i];
+                        sums[3] += r[i] * r[i];
+                        sums[4] += s[i] * r[i];
+                    }
+                }
+            }
+
+            vifWindow(w * h, sums, num, den);
+        }
+    }
+}
+
+/* Splits the 2x2 quads of source and recon into their average, which is the
+ * next scale, and three Haar detail coefficients. Detail of the source is
+ * restored by the recon up to the smaller magnitude of the two, and not at all
+ * where the signs differ; anything beyond that is additive impairment, which
+ * ADM leaves out */
+void measureAdm(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride, int width, int height,
+                pixel* srcNext, pixel* recNext, double& num, double& den)
+{
+    uint64_t sums[2] = { 0, 0 };
+
+    for (int y = 0; y < height; y++)
+        primitives.adm_stats(src + 2 * y * srcStride, srcStride, rec + 2 * y * recStride, recStride, width,
+                             srcNext ? srcNext + y * width : NULL, recNext ? recNext + y * width : NULL, sums);
+
+    num += (double)sums[0];
+    den += (double)sums[1];
+}
+}
+
+double VmafFeatureSums::adm() const
+{
+    double num = 0, den = 0;
+    for (int i = 0; i < NUM_SCALES; i++)
+    {
+        num += pow(admNum[i], 1.0 / 3);
+        den += pow(admDen[i], 1.0 / 3);
+    }
+    return den > 0 ? num / den : 1.0;
+}
+
+VmafFeatures::VmafFeatures()
+{
+    m_srcBuf = NULL;
+    m_recBuf = NULL;
+}
+
+bool VmafFeatures::create(int width, int maxCUSize)
+{
+    /* the decimated scales of a row take less than 4/3 of the first */
+    size_t size = (size_t)(width >> 1) * (maxCUSize >> 1) * 2;
+
+    CHECKED_MALLOC(m_srcBuf, pixel, size);
+    CHECKED_MALLOC(m_recBuf, pixel, size);
+    return true;
+
+fail:
+    return false;
+}
+
+void VmafFeatures::destroy()
+{
+    X265_FREE(m_srcBuf);
+    X265_FREE(m_recBuf);
+    m_srcBuf = NULL;
+    m_recBuf = NULL;
+}
+
+void VmafFeatures::measureRow(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride,
+                              int width, int height, VmafFeatureSums& sums)
+{
+    pixel* srcNext = m_srcBuf;
+    pixel* recNext = m_recBuf;
+
+    x265_emms();
+
+    for (int scale = 0; scale < VmafFeatureSums::NUM_SCALES && width >= 2 && height >= 2; scale++)
+    {
+        bool bLast = scale == VmafFeatureSums::NUM_SCALES - 1;
+
+        measureVif(src, srcStride, rec, recStride, width, height, sums.vifNum[scale], sums.vifDen[scale]);
+        measureAdm(src, srcStride, rec, recStride, width >> 1, height >> 1,
+                   bLast ? NULL : srcNext, bLast ? NULL : recNext, sums.admNum[scale], sums.admDen[scale]);
+
+        src = srcNext;
+        rec = recNext;
+        width >>= 1;
+        height >>= 1;
+        srcStride = recStride = width;
+        srcNext += width * height;
+        recNext += width * height;
+    }
+}
+
+VmafMotion::VmafMotion()
+{
+    m_cur = NULL;
+    m_prev = NULL;
+    m_width = 0;
+    m_height = 0;
+    m_bHavePrev = false;
+}
+
+bool VmafMotion::create(int width, int height)
+{
+    m_width = width >> 1;
+    m_height = height >> 1;
+    m_bHavePrev = false;
+
+    CHECKED_MALLOC(m_cur, pixel, m_width * m_height);
+    CHECKED_MALLOC_ZERO(m_prev, pixel, m_width * m_height);
+    return true;
+
+fail:
+    return false;
+}
+
+void VmafMotion::destroy()
+{
+    X265_FREE(m_cur);
+    X265_FREE(m_prev);
+    m_cur = NULL;
+    m_prev = NULL;
+}
+
+double VmafMotion::measure(const PicYuv& pic)
+{
+    const pixel* src = pic.m_picOrg[0];
+    const intptr_t stride = pic.m_stride;
+    uint64_t sad = 0;
+
+    for (int y = 0; y < m_height; y++)
+    {
+        const pixel* s = src + 2 * y * stride;
+        pixel* cur = m_cur + y * m_width;
+        const pixel* prev = m_prev + y * m_width;
+        for (int x = 0; x < m_width; x++)
+        {
+            cur[x] = (pixel)((s[2 * x] + s[2 * x + 1] + s[2 * x + stride] + s[2 * x + stride + 1] + 2) >> 2);
+            sad += abs(cur[x] - prev[x]);
+        }
+    }
+
+    std::swap(m_cur, m_prev);
+    if (!m_bHavePrev)
+    {
+        m_bHavePrev = true;
+        return 0;
+    }
+
+    return (double)sad / ((double)m_width * m_height * (1 << (X265_DEPTH - 8)));
+}
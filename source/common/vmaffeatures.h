@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_VMAFFEATURES_H
+#define X265_VMAFFEATURES_H
+
+#include "common.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+class PicYuv;
+
+/* Partial sums of the VMAF elementary features over a region of luma. Sums of
+ * regions add up to the sums of the picture; scale s is the luma decimated by
+ * 2^s in each direction */
+struct VmafFeatureSums
+{
+    enum { NUM_SCALES = 4 };
+
+    double vifNum[NUM_SCALES];   /* information kept by the recon, per VIF window */
+    double vifDen[NUM_SCALES];   /* information in the source, per VIF window */
+    double admNum[NUM_SCALES];   /* cubed detail coefficients of the source restored by the recon */
+    double admDen[NUM_SCALES];   /* cubed detail coefficients of the source */
+
+    VmafFeatureSums() { clear(); }
+
+    void clear()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void accumulate(const VmafFeatureSums& other)
+    {
+        for (int i = 0; i < NUM_SCALES; i++)
+        {
+            vifNum[i] += other.vifNum[i];
+            vifDen[i] += other.vifDen[i];
+            admNum[i] += other.admNum[i];
+            admDen[i] += other.admDen[i];
+        }
+    }
+
+    double vif(int scale) const
+    {
+        return vifDen[scale] > 0 ? vifNum[scale] / vifDen[scale] : 1.0;
+    }
+
+    double adm() const;
+};
+
+/* Measures VIF and ADM of the recon against the source one CTU row at a time.
+ * VIF is taken over 8x8 windows at each scale, ADM over the Haar detail bands
+ * which also produce the next scale, so a row needs no pixels of its
+ * neighbours. An instance holds the decimated planes of one row and is used by
+ * one thread at a time */
+class VmafFeatures
+{
+public:
+
+    VmafFeatures();
+    ~VmafFeatures() { destroy(); }
+
+    bool create(int width, int maxCUSize);
+    void destroy();
+
+    void measureRow(const pixel* src, intptr_t srcStride, const pixel* rec, intptr_t recStride,
+                    int width, int height, VmafFeatureSums& sums);
+
+protected:
+
+    pixel*  m_srcBuf;
+    pixel*  m_recBuf;
+};
+
+/* The motion feature is the mean absolute difference of the 2x2 averaged luma
+ * of consecutive source pictures, which must be measured in display order */
+class VmafMotion
+{
+public:
+
+    VmafMotion();
+    ~VmafMotion() { destroy(); }
+
+    bool create(int width, int height);
+    void destroy();
+
+    double measure(const PicYuv& pic);
+
+protected:
+
+    pixel*  m_cur;
+    pixel*  m_prev;
+    int     m_width;
+    int     m_height;
+    bool    m_bHavePrev;
+};
+}
+
+#endif // ifndef X265_VMAFFEATURES_H
@@ -33,6 +33,7 @@
 #include "analysis.h"
 #include "rdcost.h"
 #include "encoder.h"
+#include "slicetype.h"
 
 using namespace X265_NS;
 
@@ -80,6 +81,11 @@ Analysis::Analysis()
     m_checkMergeAndSkipOnly[0] = false;
     m_checkMergeAndSkipOnly[1] = false;
     m_evaluateInter = 0;
+    m_cuPredictor = NULL;
+    m_modeGraph = NULL;
+    memset(m_cuPredValid, 0, sizeof(m_cuPredValid));
+    m_cuPredNeighDepth = -1;
+    m_cuPredLowresCosts = NULL;
 }
 
 bool Analysis::create(ThreadLocalData *tld)
@@ -142,6 +148,9 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
     m_bChromaSa8d = m_param->rdLevel >= 3;
     m_param = m_frame->m_param;
 
+    if (m_subpelCache)
+        m_subpelCache->prepare(ctu.m_encData->m_frameEncoderID, m_slice->m_poc, ctu.m_cuAddr, true);
+
 #if _DEBUG || CHECKED_BUILD
     invalidateContexts(0);
 #endif
@@ -219,6 +228,10 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
                 m_reuseRef[i] = -1;
     }
     ProfileCUScope(ctu, totalCTUTime, totalCTUs);
+#if DETAILED_CU_STATS
+    /* context copies made by this thread's coders since its last CTU, including pmode tasks */
+    collectContextCopyStats(m_stats[m_frame->m_encData->m_frameEncoderID]);
+#endif
 
     if (m_slice->m_sliceType == I_SLICE)
     {
@@ -260,6 +273,9 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
                 ctu.m_log2CUSize[i] = (uint8_t)m_param->maxLog2CUSize - ctu.m_cuDepth[i];
         }
 
+        if (m_cuPredictor)
+            initCUPredictor(ctu);
+
         if (m_param->bIntraRefresh && m_slice->m_sliceType == P_SLICE &&
             ctu.m_cuPelX / m_param->maxCUSize >= frame.m_encData->m_pir.pirStartCol
             && ctu.m_cuPelX / m_param->maxCUSize < frame.m_encData->m_pir.pirEndCol)
@@ -297,7 +313,18 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
             return *m_modeDepth[0].bestMode;
         }
         else if (m_param->bDistributeModeAnalysis && m_param->rdLevel >= 2)
-            compressInterCU_dist(ctu, cuGeom, qp);
+        {
+            if (m_param->bPModeGraph)
+            {
+                ModeTaskGraph modeGraph(*this);
+                m_modeGraph = &modeGraph;
+                compressInterCU_dist(ctu, cuGeom, qp);
+                modeGraph.close();
+                m_modeGraph = NULL;
+            }
+            else
+                compressInterCU_dist(ctu, cuGeom, qp);
+        }
         else if (m_param->rdLevel <= 4)
             compressInterCU_rd0_4(ctu, cuGeom, qp);
         else
@@ -313,6 +340,34 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
     return *m_modeDepth[0].bestMode;
 }
 
+#if DETAILED_CU_STATS
+void Analysis::collectContextCopyStats(CUStats& stats)
+{
+    Entropy* coders[1 + 4 * NUM_FULL_DEPTH + NUM_CU_DEPTH * MAX_PRED_TYPES];
+    int numCoders = 0;
+
+    coders[numCoders++] = &m_entropyCoder;
+    for (int i = 0; i < NUM_FULL_DEPTH; i++)
+    {
+        coders[numCoders++] = &m_rqt[i].cur;
+        coders[numCoders++] = &m_rqt[i].rqtRoot;
+        coders[numCoders++] = &m_rqt[i].rqtTemp;
+        coders[numCoders++] = &m_rqt[i].rqtTest;
+    }
+    for (int i = 0; i < NUM_CU_DEPTH; i++)
+        for (int j = 0; j < MAX_PRED_TYPES; j++)
+            coders[numCoders++] = &m_modeDepth[i].pred[j].contexts;
+
+    for (int i = 0; i < numCoders; i++)
+    {
+        stats.countContextCopies += coders[i]->m_ctxCopies;
+        stats.contextBytesCopied += coders[i]->m_ctxBytesCopied;
+        coders[i]->m_ctxCopies = 0;
+        coders[i]->m_ctxBytesCopied = 0;
+    }
+}
+#endif
+
 void Analysis::collectPUStatistics(const CUData& ctu, const CUGeom& cuGeom)
 {
     uint8_t depth = 0;
@@ -693,166 +748,364 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
         return;
     }
 
-    ModeDepth& md = m_modeDepth[pmode.cuGeom.depth];
-
     /* setup slave Analysis */
     if (&slave != this)
-    {
-        slave.m_slice = m_slice;
-        slave.m_frame = m_frame;
-        slave.m_param = m_param;
-        slave.m_bChromaSa8d = m_param->rdLevel >= 3;
-        slave.setLambdaFromQP(md.pred[PRED_2Nx2N].cu, m_rdCost.m_qp);
-        slave.invalidateContexts(0);
-        slave.m_rqt[pmode.cuGeom.depth].cur.load(m_rqt[pmode.cuGeom.depth].cur);
-    }
+        setupPmodeSlave(slave, pmode.cuGeom, m_rdCost.m_qp);
 
     /* perform Mode task, repeat until no more work is available */
     do
     {
-        uint32_t refMasks[2] = { 0, 0 };
+        runPmodeTask(slave, pmode.cuGeom, pmode.modes[task], m_splitRefIdx);
 
-        if (m_param->rdLevel <= 4)
+        task = -1;
+        pmode.m_lock.acquire();
+        if (pmode.m_jobTotal > pmode.m_jobAcquired)
+            task = pmode.m_jobAcquired++;
+        pmode.m_lock.release();
+    }
+    while (task >= 0);
+}
+
+void Analysis::setupPmodeSlave(Analysis& slave, const CUGeom& cuGeom, int qp)
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+
+    slave.m_slice = m_slice;
+    slave.m_frame = m_frame;
+    slave.m_param = m_param;
+    slave.m_bChromaSa8d = m_param->rdLevel >= 3;
+    slave.setLambdaFromQP(md.pred[PRED_2Nx2N].cu, qp);
+    slave.invalidateContexts(0);
+    slave.m_rqt[cuGeom.depth].cur.load(m_rqt[cuGeom.depth].cur);
+    if (slave.m_subpelCache)
+        slave.m_subpelCache->prepare(m_frame->m_encData->m_frameEncoderID, m_slice->m_poc, md.pred[PRED_2Nx2N].cu.m_cuAddr, false);
+}
+
+/* analyse one mode of the CU of the master (this) on the given Analysis instance,
+ * which is either the master itself or a slave set up by setupPmodeSlave() */
+void Analysis::runPmodeTask(Analysis& slave, const CUGeom& cuGeom, int mode, const uint32_t splitRefs[4])
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+    uint32_t refMasks[2] = { 0, 0 };
+
+    if (m_param->rdLevel <= 4)
+    {
+        switch (mode)
         {
-            switch (pmode.modes[task])
-            {
-            case PRED_INTRA:
-                slave.checkIntraInInter(md.pred[PRED_INTRA], pmode.cuGeom);
-                if (m_param->rdLevel > 2)
-                    slave.encodeIntraInInter(md.pred[PRED_INTRA], pmode.cuGeom);
-                break;
+        case PRED_INTRA:
+            slave.checkIntraInInter(md.pred[PRED_INTRA], cuGeom);
+            if (m_param->rdLevel > 2)
+                slave.encodeIntraInInter(md.pred[PRED_INTRA], cuGeom);
+            break;
 
-            case PRED_2Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3];
+        case PRED_2Nx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3];
 
-                slave.checkInter_rd0_4(md.pred[PRED_2Nx2N], pmode.cuGeom, SIZE_2Nx2N, refMasks);
-                if (m_slice->m_sliceType == B_SLICE)
-                    slave.checkBidir2Nx2N(md.pred[PRED_2Nx2N], md.pred[PRED_BIDIR], pmode.cuGeom);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_2Nx2N], cuGeom, SIZE_2Nx2N, refMasks);
+            if (m_slice->m_sliceType == B_SLICE)
+                slave.checkBidir2Nx2N(md.pred[PRED_2Nx2N], md.pred[PRED_BIDIR], cuGeom);
+            break;
 
-            case PRED_Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* right */
+        case PRED_Nx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[2]; /* left */
+            refMasks[1] = splitRefs[1] | splitRefs[3]; /* right */
 
-                slave.checkInter_rd0_4(md.pred[PRED_Nx2N], pmode.cuGeom, SIZE_Nx2N, refMasks);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_Nx2N], cuGeom, SIZE_Nx2N, refMasks);
+            break;
 
-            case PRED_2NxN:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* bot */
+        case PRED_2NxN:
+            refMasks[0] = splitRefs[0] | splitRefs[1]; /* top */
+            refMasks[1] = splitRefs[2] | splitRefs[3]; /* bot */
 
-                slave.checkInter_rd0_4(md.pred[PRED_2NxN], pmode.cuGeom, SIZE_2NxN, refMasks);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_2NxN], cuGeom, SIZE_2NxN, refMasks);
+            break;
 
-            case PRED_2NxnU:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* 25% top */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% bot */
+        case PRED_2NxnU:
+            refMasks[0] = splitRefs[0] | splitRefs[1]; /* 25% top */
+            refMasks[1] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% bot */
 
-                slave.checkInter_rd0_4(md.pred[PRED_2NxnU], pmode.cuGeom, SIZE_2NxnU, refMasks);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_2NxnU], cuGeom, SIZE_2NxnU, refMasks);
+            break;
 
-            case PRED_2NxnD:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* 25% bot */
+        case PRED_2NxnD:
+            refMasks[0] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% top */
+            refMasks[1] = splitRefs[2] | splitRefs[3]; /* 25% bot */
 
-                slave.checkInter_rd0_4(md.pred[PRED_2NxnD], pmode.cuGeom, SIZE_2NxnD, refMasks);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_2NxnD], cuGeom, SIZE_2NxnD, refMasks);
+            break;
 
-            case PRED_nLx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* 25% left */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% right */
+        case PRED_nLx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[2]; /* 25% left */
+            refMasks[1] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% right */
 
-                slave.checkInter_rd0_4(md.pred[PRED_nLx2N], pmode.cuGeom, SIZE_nLx2N, refMasks);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_nLx2N], cuGeom, SIZE_nLx2N, refMasks);
+            break;
 
-            case PRED_nRx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* 25% right */
+        case PRED_nRx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% left */
+            refMasks[1] = splitRefs[1] | splitRefs[3]; /* 25% right */
 
-                slave.checkInter_rd0_4(md.pred[PRED_nRx2N], pmode.cuGeom, SIZE_nRx2N, refMasks);
-                break;
+            slave.checkInter_rd0_4(md.pred[PRED_nRx2N], cuGeom, SIZE_nRx2N, refMasks);
+            break;
 
-            default:
-                X265_CHECK(0, "invalid job ID for parallel mode analysis\n");
-                break;
-            }
+        default:
+            X265_CHECK(0, "invalid job ID for parallel mode analysis\n");
+            break;
         }
-        else
+    }
+    else
+    {
+        switch (mode)
         {
-            switch (pmode.modes[task])
+        case PRED_INTRA:
+            slave.checkIntra(md.pred[PRED_INTRA], cuGeom, SIZE_2Nx2N);
+            if (cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3)
+                slave.checkIntra(md.pred[PRED_INTRA_NxN], cuGeom, SIZE_NxN);
+            break;
+
+        case PRED_2Nx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3];
+
+            slave.checkInter_rd5_6(md.pred[PRED_2Nx2N], cuGeom, SIZE_2Nx2N, refMasks);
+            md.pred[PRED_BIDIR].rdCost = MAX_INT64;
+            if (m_slice->m_sliceType == B_SLICE)
             {
-            case PRED_INTRA:
-                slave.checkIntra(md.pred[PRED_INTRA], pmode.cuGeom, SIZE_2Nx2N);
-                if (pmode.cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3)
-                    slave.checkIntra(md.pred[PRED_INTRA_NxN], pmode.cuGeom, SIZE_NxN);
-                break;
+                slave.checkBidir2Nx2N(md.pred[PRED_2Nx2N], md.pred[PRED_BIDIR], cuGeom);
+                if (md.pred[PRED_BIDIR].sa8dCost < MAX_INT64)
+                    slave.encodeResAndCalcRdInterCU(md.pred[PRED_BIDIR], cuGeom);
+            }
+            break;
 
-            case PRED_2Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3];
+        case PRED_Nx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[2]; /* left */
+            refMasks[1] = splitRefs[1] | splitRefs[3]; /* right */
 
-                slave.checkInter_rd5_6(md.pred[PRED_2Nx2N], pmode.cuGeom, SIZE_2Nx2N, refMasks);
-                md.pred[PRED_BIDIR].rdCost = MAX_INT64;
-                if (m_slice->m_sliceType == B_SLICE)
-                {
-                    slave.checkBidir2Nx2N(md.pred[PRED_2Nx2N], md.pred[PRED_BIDIR], pmode.cuGeom);
-                    if (md.pred[PRED_BIDIR].sa8dCost < MAX_INT64)
-                        slave.encodeResAndCalcRdInterCU(md.pred[PRED_BIDIR], pmode.cuGeom);
-                }
-                break;
+            slave.checkInter_rd5_6(md.pred[PRED_Nx2N], cuGeom, SIZE_Nx2N, refMasks);
+            break;
 
-            case PRED_Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* right */
+        case PRED_2NxN:
+            refMasks[0] = splitRefs[0] | splitRefs[1]; /* top */
+            refMasks[1] = splitRefs[2] | splitRefs[3]; /* bot */
 
-                slave.checkInter_rd5_6(md.pred[PRED_Nx2N], pmode.cuGeom, SIZE_Nx2N, refMasks);
-                break;
+            slave.checkInter_rd5_6(md.pred[PRED_2NxN], cuGeom, SIZE_2NxN, refMasks);
+            break;
 
-            case PRED_2NxN:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* bot */
+        case PRED_2NxnU:
+            refMasks[0] = splitRefs[0] | splitRefs[1]; /* 25% top */
+            refMasks[1] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% bot */
 
-                slave.checkInter_rd5_6(md.pred[PRED_2NxN], pmode.cuGeom, SIZE_2NxN, refMasks);
-                break;
+            slave.checkInter_rd5_6(md.pred[PRED_2NxnU], cuGeom, SIZE_2NxnU, refMasks);
+            break;
 
-            case PRED_2NxnU:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* 25% top */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% bot */
+        case PRED_2NxnD:
+            refMasks[0] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% top */
+            refMasks[1] = splitRefs[2] | splitRefs[3]; /* 25% bot */
+            slave.checkInter_rd5_6(md.pred[PRED_2NxnD], cuGeom, SIZE_2NxnD, refMasks);
+            break;
 
-                slave.checkInter_rd5_6(md.pred[PRED_2NxnU], pmode.cuGeom, SIZE_2NxnU, refMasks);
-                break;
+        case PRED_nLx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[2]; /* 25% left */
+            refMasks[1] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% right */
 
-            case PRED_2NxnD:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* 25% bot */
-                slave.checkInter_rd5_6(md.pred[PRED_2NxnD], pmode.cuGeom, SIZE_2NxnD, refMasks);
-                break;
+            slave.checkInter_rd5_6(md.pred[PRED_nLx2N], cuGeom, SIZE_nLx2N, refMasks);
+            break;
 
-            case PRED_nLx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* 25% left */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% right */
+        case PRED_nRx2N:
+            refMasks[0] = splitRefs[0] | splitRefs[1] | splitRefs[2] | splitRefs[3]; /* 75% left */
+            refMasks[1] = splitRefs[1] | splitRefs[3]; /* 25% right */
+            slave.checkInter_rd5_6(md.pred[PRED_nRx2N], cuGeom, SIZE_nRx2N, refMasks);
+            break;
 
-                slave.checkInter_rd5_6(md.pred[PRED_nLx2N], pmode.cuGeom, SIZE_nLx2N, refMasks);
-                break;
+        default:
+            X265_CHECK(0, "invalid job ID for parallel mode analysis\n");
+            break;
+        }
+    }
+}
 
-            case PRED_nRx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* 25% right */
-                slave.checkInter_rd5_6(md.pred[PRED_nRx2N], pmode.cuGeom, SIZE_nRx2N, refMasks);
-                break;
+Analysis::ModeTaskGraph::ModeTaskGraph(Analysis& m) : master(m)
+{
+    for (int i = 0; i < NUM_CU_DEPTH; i++)
+        m_cu[i].numTasks = m_cu[i].numAcquired = 0;
+    m_activePeers = 0;
+    m_maxPeers = X265_MAX(m.m_frame->m_encData->m_jobProvider->m_pool->m_numWorkers - 1, 1);
+    m_bClosed = false;
+}
 
-            default:
-                X265_CHECK(0, "invalid job ID for parallel mode analysis\n");
-                break;
+/* called by the master once the inputs of the CU's tasks are known */
+void Analysis::ModeTaskGraph::release(uint32_t depth, const CUGeom& cuGeom, int qp, const uint32_t splitRefs[4], const int* modes, int numTasks)
+{
+    CUTasks& cu = m_cu[depth];
+    cu.numCompleted.set(0);
+
+    m_lock.acquire();
+    cu.cuGeom = &cuGeom;
+    cu.qp = qp;
+    memcpy(cu.splitRefs, splitRefs, sizeof(cu.splitRefs));
+    memcpy(cu.modes, modes, numTasks * sizeof(int));
+    cu.numAcquired = 0;
+    cu.numTasks = numTasks;
+    int wanted = X265_MAX(X265_MIN(numTasks, m_maxPeers - m_activePeers), 0);
+    m_activePeers += wanted;
+    m_lock.release();
+
+    for (int i = 0; i < numTasks; i++)
+        m_taskEvent.trigger();
+
+    /* peers already bonded are woken above, recruit more while below the limit */
+    if (wanted)
+    {
+        int bonded = tryBondPeers(*master.m_frame->m_encData->m_jobProvider, wanted);
+        if (bonded < wanted)
+        {
+            ScopedLock lock(m_lock);
+            m_activePeers -= wanted - bonded;
+        }
+    }
+}
+
+/* add a task to the CU's released tasks, which must not have been joined */
+void Analysis::ModeTaskGraph::append(uint32_t depth, int mode)
+{
+    CUTasks& cu = m_cu[depth];
+
+    m_lock.acquire();
+    cu.modes[cu.numTasks++] = mode;
+    m_lock.release();
+
+    m_taskEvent.trigger();
+}
+
+/* run the tasks of the CU no peer has taken, then wait for the rest */
+void Analysis::ModeTaskGraph::join(uint32_t depth)
+{
+    CUTasks& cu = m_cu[depth];
+    int taskDepth, task;
+
+    for (;;)
+    {
+        m_lock.acquire();
+        bool bFound = acquire(taskDepth, task, depth);
+        m_lock.release();
+        if (!bFound)
+            break;
+
+        master.runPmodeTask(master, *cu.cuGeom, cu.modes[task], cu.splitRefs);
+        cu.numCompleted.incr();
+    }
+
+    int completed = cu.numCompleted.get();
+    while (completed < cu.numTasks)
+        completed = cu.numCompleted.waitForChange(completed);
+}
+
+/* all tasks have been joined; release the peers still waiting for work and
+ * wait for them to leave, before the graph may be destroyed */
+void Analysis::ModeTaskGraph::close()
+{
+    m_lock.acquire();
+    m_bClosed = true;
+    int peers = m_activePeers;
+    m_lock.release();
+
+    for (int i = 0; i < peers; i++)
+        m_taskEvent.trigger();
+
+    waitForExit();
+}
+
+bool Analysis::ModeTaskGraph::acquire(int& depth, int& task, int onlyDepth)
+{
+    /* the master joins the deepest CU first */
+    for (int d = NUM_CU_DEPTH - 1; d >= 0; d--)
+    {
+        CUTasks& cu = m_cu[d];
+        if ((onlyDepth < 0 || d == onlyDepth) && cu.numAcquired < cu.numTasks)
+        {
+            depth = d;
+            task = cu.numAcquired++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Analysis::ModeTaskGraph::processTasks(int workerThreadId)
+{
+    ProfileScopeEvent(pmode);
+    Analysis& slave = master.m_tld[workerThreadId].analysis;
+    const CUGeom* slaveGeom = NULL;
+    bool bIdle = false;
+
+    for (;;)
+    {
+        int depth, task;
+
+        m_lock.acquire();
+        bool bFound = acquire(depth, task, -1);
+        if (!bFound && (m_bClosed || bIdle))
+        {
+            m_activePeers--;
+            m_lock.release();
+            return;
+        }
+        m_lock.release();
+
+        if (bFound)
+        {
+            CUTasks& cu = m_cu[depth];
+#if DETAILED_CU_STATS
+            int fe = master.m_frame->m_encData->m_frameEncoderID;
+            master.m_stats[fe].countPModeTasks++;
+            ScopedElapsedTime pmodeTime(master.m_stats[fe].pmodeTime);
+#endif
+            if (cu.cuGeom != slaveGeom)
+            {
+                master.setupPmodeSlave(slave, *cu.cuGeom, cu.qp);
+                slaveGeom = cu.cuGeom;
             }
+            master.runPmodeTask(slave, *cu.cuGeom, cu.modes[task], cu.splitRefs);
+            cu.numCompleted.incr();
+            bIdle = false;
         }
+        else
+            /* leave if nothing is released within the wait, the master bonds
+             * peers again for later CUs */
+            bIdle = m_taskEvent.timedWait(1);
+    }
+}
 
-        task = -1;
-        pmode.m_lock.acquire();
-        if (pmode.m_jobTotal > pmode.m_jobAcquired)
-            task = pmode.m_jobAcquired++;
-        pmode.m_lock.release();
+/* initialize the prediction CUs of the modes analysed in parallel and list them */
+int Analysis::initPmodeTasks(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, bool bTryIntra, int* modes)
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+    int bTryAmp = m_slice->m_sps->maxAMPDepth > cuGeom.depth;
+    int numTasks = 0;
+
+    if (bTryIntra)
+    {
+        md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
+        if (cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3 && m_param->rdLevel >= 5)
+            md.pred[PRED_INTRA_NxN].cu.initSubCU(parentCTU, cuGeom, qp);
+        modes[numTasks++] = PRED_INTRA;
     }
-    while (task >= 0);
+    md.pred[PRED_2Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_2Nx2N;
+    md.pred[PRED_BIDIR].cu.initSubCU(parentCTU, cuGeom, qp);
+    if (m_param->bEnableRectInter)
+    {
+        md.pred[PRED_2NxN].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_2NxN;
+        md.pred[PRED_Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_Nx2N;
+    }
+    if (bTryAmp)
+    {
+        md.pred[PRED_2NxnU].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_2NxnU;
+        md.pred[PRED_2NxnD].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_2NxnD;
+        md.pred[PRED_nLx2N].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_nLx2N;
+        md.pred[PRED_nRx2N].cu.initSubCU(parentCTU, cuGeom, qp); modes[numTasks++] = PRED_nRx2N;
+    }
+
+    return numTasks;
 }
 
 uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
@@ -871,6 +1124,11 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
 
     PMODE pmode(*this, cuGeom);
 
+    /* without reference limiting no inter mode depends on the sub-CUs, so the
+     * graph may analyse them while the split is being evaluated. Intra writes
+     * its reconstruction to the picture inside the CU and waits for the split */
+    bool bEarlyTasks = m_modeGraph && !m_param->limitReferences && mightNotSplit && depth >= minDepth;
+
     if (mightNotSplit && depth >= minDepth)
     {
         /* Initialize all prediction CUs based on parentCTU */
@@ -883,6 +1141,13 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
             checkMerge2Nx2N_rd5_6(md.pred[PRED_SKIP], md.pred[PRED_MERGE], cuGeom);
     }
 
+    if (bEarlyTasks)
+    {
+        int modes[MAX_PRED_TYPES];
+        int numTasks = initPmodeTasks(parentCTU, cuGeom, qp, false, modes);
+        m_modeGraph->release(depth, cuGeom, m_rdCost.m_qp, splitRefs, modes, numTasks);
+    }
+
     bool bNoSplit = false;
     bool splitIntra = true;
     if (md.bestMode)
@@ -948,34 +1213,36 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
         if (m_slice->m_pps->bUseDQP && depth <= m_slice->m_pps->maxCuDQPDepth && m_slice->m_pps->maxCuDQPDepth != 0)
             setLambdaFromQP(parentCTU, qp);
 
-        if (bTryIntra)
+        if (m_modeGraph)
         {
-            md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
-            if (cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3 && m_param->rdLevel >= 5)
-                md.pred[PRED_INTRA_NxN].cu.initSubCU(parentCTU, cuGeom, qp);
-            pmode.modes[pmode.m_jobTotal++] = PRED_INTRA;
-        }
-        md.pred[PRED_2Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2Nx2N;
-        md.pred[PRED_BIDIR].cu.initSubCU(parentCTU, cuGeom, qp);
-        if (m_param->bEnableRectInter)
-        {
-            md.pred[PRED_2NxN].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxN;
-            md.pred[PRED_Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_Nx2N;
+            if (!bEarlyTasks)
+            {
+                int modes[MAX_PRED_TYPES];
+                int numTasks = initPmodeTasks(parentCTU, cuGeom, qp, bTryIntra, modes);
+                m_modeGraph->release(depth, cuGeom, m_rdCost.m_qp, splitRefs, modes, numTasks);
+            }
+            else if (bTryIntra)
+            {
+                md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
+                if (cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3 && m_param->rdLevel >= 5)
+                    md.pred[PRED_INTRA_NxN].cu.initSubCU(parentCTU, cuGeom, qp);
+                m_modeGraph->append(depth, PRED_INTRA);
+            }
+
+            ProfileCUScope(parentCTU, pmodeBlockTime, countPModeMasters);
+            m_modeGraph->join(depth);
         }
-        if (bTryAmp)
+        else
         {
-            md.pred[PRED_2NxnU].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxnU;
-            md.pred[PRED_2NxnD].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxnD;
-            md.pred[PRED_nLx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_nLx2N;
-            md.pred[PRED_nRx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_nRx2N;
-        }
+            pmode.m_jobTotal = initPmodeTasks(parentCTU, cuGeom, qp, bTryIntra, pmode.modes);
 
-        m_splitRefIdx[0] = splitRefs[0]; m_splitRefIdx[1] = splitRefs[1]; m_splitRefIdx[2] = splitRefs[2]; m_splitRefIdx[3] = splitRefs[3];
+            m_splitRefIdx[0] = splitRefs[0]; m_splitRefIdx[1] = splitRefs[1]; m_splitRefIdx[2] = splitRefs[2]; m_splitRefIdx[3] = splitRefs[3];
 
-        pmode.tryBondPeers(*m_frame->m_encData->m_jobProvider, pmode.m_jobTotal);
+            pmode.tryBondPeers(*m_frame->m_encData->m_jobProvider, pmode.m_jobTotal);
 
-        /* participate in processing jobs, until all are distributed */
-        processPmode(pmode, *this);
+            /* participate in processing jobs, until all are distributed */
+            processPmode(pmode, *this);
+        }
 
         /* the master worker thread (this one) does merge analysis. By doing
          * merge after all the other jobs are at least started, we usually avoid
@@ -1321,6 +1588,8 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     skipRecursion = complexityCheckCU(*md.bestMode);
             }
         }
+        if (m_cuPredictor && md.bestMode && mightSplit && mightNotSplit && depth >= minDepth && !bCtuInfoCheck)
+            checkCUPredictor(parentCTU, cuGeom, *md.bestMode, skipRecursion, skipModes);
         if (m_param->bAnalysisType == AVC_INFO && md.bestMode && cuGeom.numPartitions <= 16 && m_param->analysisReuseLevel == 7)
             skipRecursion = true;
         /* Step 2. Evaluate each of the 4 split sub-blocks in series */
@@ -1832,6 +2101,9 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
         }
     }
 
+    if (m_cuPredictor)
+        dumpCUPredictor(cuGeom);
+
     return splitCUData;
 }
 
@@ -2014,6 +2286,8 @@ SplitData Analysis::compressInterCU_rd5_6(const CUData& parentCTU, const CUGeom&
             if (m_param->bEnableRecursionSkip && depth && m_modeDepth[depth - 1].bestMode)
                 skipRecursion = md.bestMode && !md.bestMode->cu.getQtRootCbf(0);
         }
+        if (m_cuPredictor && md.bestMode && mightSplit && mightNotSplit && !bCtuInfoCheck)
+            checkCUPredictor(parentCTU, cuGeom, *md.bestMode, skipRecursion, skipModes);
         if (m_param->bAnalysisType == AVC_INFO && md.bestMode && cuGeom.numPartitions <= 16 && m_param->analysisReuseLevel == 7)
             skipRecursion = true;
         // estimate split cost
@@ -2399,6 +2673,9 @@ SplitData Analysis::compressInterCU_rd5_6(const CUData& parentCTU, const CUGeom&
         }
     }
 
+    if (m_cuPredictor)
+        dumpCUPredictor(cuGeom);
+
     return splitCUData;
 }
 
@@ -2807,7 +3084,7 @@ void Analysis::checkMerge2Nx2N_rd0_4(Mode& skip, Mode& merge, const CUGeom& cuGe
         tempPred->cu.m_refIdx[1][0] = (int8_t)candMvField[i][1].refIdx;
         motionCompensation(tempPred->cu, pu, tempPred->predYuv, true, m_bChromaSa8d && (m_csp != X265_CSP_I400 && m_frame->m_fencPic->m_picCsp != X265_CSP_I400));
 
-        tempPred->sa8dBits = getTUBits(i, numMergeCand);
+        tempPred->sa8dBits = m_bRateEstimate ? m_rqt[cuGeom.depth].cur.bitsMergePU(i, m_slice->m_maxNumMergeCand) : getTUBits(i, numMergeCand);
         tempPred->distortion = primitives.cu[sizeIdx].sa8d(fencYuv->m_buf[0], fencYuv->m_size, tempPred->predYuv.m_buf[0], tempPred->predYuv.m_size);
         if (m_bChromaSa8d && (m_csp != X265_CSP_I400 && m_frame->m_fencPic->m_picCsp != X265_CSP_I400))
         {
@@ -3260,6 +3537,18 @@ void Analysis::checkBidir2Nx2N(Mode& inter2Nx2N, Mode& bidir2Nx2N, const CUGeom&
             cu.m_mv[1][0] = bestME[1].mv;
         }
     }
+
+    if (m_bRateEstimate)
+    {
+        /* replace the approximate bits in the cost by an estimate of the bits
+         * of the prediction info */
+        int refIdx[2] = { ref0, ref1 };
+        int mvpIdx[2] = { cu.m_mvpIdx[0][0], cu.m_mvpIdx[1][0] };
+        MV mvd[2] = { cu.m_mvd[0][0], cu.m_mvd[1][0] };
+        uint32_t bits = m_rqt[cuGeom.depth].cur.bitsInterPU(cu, 0, 3, refIdx, mvd, mvpIdx);
+        bidir2Nx2N.sa8dCost = (bidir2Nx2N.sa8dCost - m_rdCost.getCost(bidir2Nx2N.sa8dBits)) + m_rdCost.getCost(bits);
+        bidir2Nx2N.sa8dBits = bits;
+    }
 }
 
 void Analysis::encodeResidue(const CUData& ctu, const CUGeom& cuGeom)
@@ -3543,6 +3832,134 @@ bool Analysis::complexityCheckCU(const Mode& bestMode)
     return false;
 }
 
+void Analysis::initCUPredictor(const CUData& ctu)
+{
+    /* average depth of the coded left and above CTUs */
+    const CUData* neigh[2] = { ctu.m_cuLeft, ctu.m_cuAbove };
+    uint32_t sum = 0, count = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        if (!neigh[i])
+            continue;
+        for (uint32_t j = 0; j < neigh[i]->m_numPartitions; j += 4)
+            sum += neigh[i]->m_cuDepth[j];
+        count += neigh[i]->m_numPartitions >> 2;
+    }
+    m_cuPredNeighDepth = count ? (double)sum / count : -1;
+
+    /* lowres costs of this frame against its nearest references, when the
+     * lookahead estimated that pair */
+    Lowres& lowres = m_frame->m_lowres;
+    int p0 = m_slice->m_numRefIdx[0] ? m_slice->m_poc - m_slice->m_refPOCList[0][0] : 0;
+    int p1 = m_slice->m_sliceType == B_SLICE && m_slice->m_numRefIdx[1] ? m_slice->m_refPOCList[1][0] - m_slice->m_poc : 0;
+    m_cuPredLowresCosts = NULL;
+    if (p0 > 0 && p0 <= X265_BFRAME_MAX + 1 && p1 >= 0 && p1 <= X265_BFRAME_MAX + 1 && lowres.costEst[p0][p1] > 0)
+        m_cuPredLowresCosts = lowres.lowresCosts[p0][p1];
+}
+
+void Analysis::cuPredictorFeatures(const CUData& parentCTU, const CUGeom& cuGeom, const Mode& bestMode, double* features)
+{
+    uint32_t depth = cuGeom.depth;
+    uint32_t cuSize = 1 << cuGeom.log2CUSize;
+    uint32_t numPixels = cuSize * cuSize;
+    uint32_t pelX = parentCTU.m_cuPelX + g_zscanToPelX[cuGeom.absPartIdx];
+    uint32_t pelY = parentCTU.m_cuPelY + g_zscanToPelY[cuGeom.absPartIdx];
+    Lowres& lowres = m_frame->m_lowres;
+
+    uint64_t cost = m_param->rdLevel > 1 ? bestMode.rdCost : bestMode.sa8dCost;
+
+    uint64_t sumSqr = primitives.cu[cuGeom.log2CUSize - 2].var(bestMode.fencYuv->m_buf[0], bestMode.fencYuv->m_size);
+    double sum = (double)(uint32_t)sumSqr;
+    double variance = ((double)(sumSqr >> 32) - sum * sum / numPixels) / numPixels;
+    variance /= (double)(1 << (2 * (X265_DEPTH - 8)));
+
+    /* lowres blocks cover 16x16 full resolution pixels */
+    uint32_t bx1 = X265_MIN((pelX + cuSize - 1) >> 4, lowres.maxBlocksInRow - 1);
+    uint32_t by1 = X265_MIN((pelY + cuSize - 1) >> 4, lowres.maxBlocksInCol - 1);
+    double intraCost = 0, interCost = 0;
+    uint32_t count = 0;
+    for (uint32_t by = pelY >> 4; by <= by1; by++)
+    {
+        for (uint32_t bx = pelX >> 4; bx <= bx1; bx++, count++)
+        {
+            uint32_t idx = by * lowres.maxBlocksInRow + bx;
+            intraCost += lowres.intraCost[idx];
+            interCost += m_cuPredLowresCosts ? (m_cuPredLowresCosts[idx] & LOWRES_COST_MASK) : lowres.intraCost[idx];
+        }
+    }
+    count *= X265_LOWRES_CU_SIZE * X265_LOWRES_CU_SIZE;
+
+    double cuTreeOffset = 0;
+    if (lowres.qpCuTreeOffset)
+    {
+        uint32_t shift = m_param->rc.qgSize == 8 ? 3 : 4;
+        uint32_t stride = m_param->rc.qgSize == 8 ? lowres.maxBlocksInRowFullRes : lowres.maxBlocksInRow;
+        uint32_t maxX = (m_param->rc.qgSize == 8 ? lowres.maxBlocksInRowFullRes : lowres.maxBlocksInRow) - 1;
+        uint32_t maxY = (m_param->rc.qgSize == 8 ? lowres.maxBlocksInColFullRes : lowres.maxBlocksInCol) - 1;
+        uint32_t blocks = 0;
+        for (uint32_t by = pelY >> shift; by <= X265_MIN((pelY + cuSize - 1) >> shift, maxY); by++)
+            for (uint32_t bx = pelX >> shift; bx <= X265_MIN((pelX + cuSize - 1) >> shift, maxX); bx++, blocks++)
+                cuTreeOffset += lowres.qpCuTreeOffset[by * stride + bx];
+        cuTreeOffset /= blocks;
+    }
+
+    /* co-located depth in the first L0 reference, as topSkipMinDepth */
+    double refDepth = depth;
+    if (m_slice->m_numRefIdx[0])
+    {
+        const CUData& cu = *m_slice->m_refFrameList[0][0]->m_encData->getPicCTU(parentCTU.m_cuAddr);
+        uint32_t depthSum = 0;
+        for (uint32_t i = 0; i < cuGeom.numPartitions; i += 4)
+            depthSum += cu.m_cuDepth[cuGeom.absPartIdx + i];
+        refDepth = (double)depthSum / (cuGeom.numPartitions >> 2);
+    }
+
+    features[CU_PRED_DEPTH] = depth;
+    features[CU_PRED_QP] = bestMode.cu.m_qp[0];
+    features[CU_PRED_LOG_COST] = X265_LOG2(1.0 + (double)cost / numPixels);
+    features[CU_PRED_LOG_VARIANCE] = X265_LOG2(1.0 + X265_MAX(variance, 0.0));
+    features[CU_PRED_LOG_LOWRES_INTRA] = X265_LOG2(1.0 + intraCost / count);
+    features[CU_PRED_LOG_LOWRES_INTER] = X265_LOG2(1.0 + interCost / count);
+    features[CU_PRED_NEIGH_DEPTH] = m_cuPredNeighDepth >= 0 ? m_cuPredNeighDepth - depth : 0;
+    features[CU_PRED_REF_DEPTH] = refDepth - depth;
+    features[CU_PRED_CUTREE_OFFSET] = cuTreeOffset;
+    features[CU_PRED_BEST_SKIP] = bestMode.cu.isSkipped(0);
+    features[CU_PRED_BEST_CBF] = !!bestMode.cu.getQtRootCbf(0);
+    features[CU_PRED_SLICE_TYPE] = m_slice->m_sliceType == P_SLICE;
+}
+
+void Analysis::checkCUPredictor(const CUData& parentCTU, const CUGeom& cuGeom, const Mode& bestMode, bool& skipRecursion, bool& skipModes)
+{
+    double* features = m_cuPredFeatures[cuGeom.depth];
+    cuPredictorFeatures(parentCTU, cuGeom, bestMode, features);
+    m_cuPredValid[cuGeom.depth] = true;
+
+    CUPredictorStats& stats = m_cuPredStats[m_frame->m_encData->m_frameEncoderID];
+    stats.evaluated++;
+    if (!m_param->bEnableCUPredictor)
+        return;
+
+    if (!skipRecursion && m_cuPredictor->pruneSplit(features))
+    {
+        skipRecursion = true;
+        stats.prunedSplit++;
+    }
+    if (!skipModes && m_cuPredictor->predictSkip(features))
+    {
+        skipModes = true;
+        stats.predictedSkip++;
+    }
+}
+
+/* record the features of the CU with its final decision */
+void Analysis::dumpCUPredictor(const CUGeom& cuGeom)
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+    if (m_cuPredValid[cuGeom.depth] && m_cuPredictor->m_dumpFile && md.bestMode)
+        m_cuPredictor->dump(m_slice->m_poc, m_cuPredFeatures[cuGeom.depth], md.bestMode == &md.pred[PRED_SPLIT], md.bestMode->cu.isSkipped(0));
+    m_cuPredValid[cuGeom.depth] = false;
+}
+
 uint32_t Analysis::calculateCUVariance(const CUData& ctu, const CUGeom& cuGeom)
 {
     uint32_t cuVariance = 0;
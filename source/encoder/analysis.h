@@ -35,6 +35,7 @@
 
 #include "entropy.h"
 #include "search.h"
+#include "cupredictor.h"
 
 namespace X265_NS {
 // private namespace
@@ -105,6 +106,54 @@ public:
 
     void processPmode(PMODE& pmode, Analysis& slave);
 
+    /* Mode analysis tasks of every CU of a CTU, used in place of PMODE by
+     * --pmode-graph. The master releases the tasks of a CU as soon as their
+     * inputs are known and joins them once the CU's own sub-CUs are decided,
+     * running whichever tasks no peer has taken. Bonded peers take tasks of
+     * any CU, deepest first, and leave when none arrive for a while */
+    class ModeTaskGraph : public BondedTaskGroup
+    {
+    public:
+
+        struct CUTasks
+        {
+            const CUGeom*     cuGeom;
+            int               qp;
+            uint32_t          splitRefs[4];
+            int               modes[MAX_PRED_TYPES];
+            int               numTasks;
+            int               numAcquired;
+            ThreadSafeInteger numCompleted;
+        };
+
+        Analysis& master;
+        CUTasks   m_cu[NUM_CU_DEPTH];
+        Event     m_taskEvent;
+        int       m_activePeers;
+        int       m_maxPeers;
+        bool      m_bClosed;
+
+        ModeTaskGraph(Analysis& m);
+
+        void release(uint32_t depth, const CUGeom& cuGeom, int qp, const uint32_t splitRefs[4], const int* modes, int numTasks);
+        void append(uint32_t depth, int mode);
+        void join(uint32_t depth);
+        void close();
+
+        void processTasks(int workerThreadId);
+
+    protected:
+
+        /* must be called with m_lock held */
+        bool acquire(int& depth, int& task, int onlyDepth);
+
+        ModeTaskGraph operator=(const ModeTaskGraph&);
+    };
+
+    void setupPmodeSlave(Analysis& slave, const CUGeom& cuGeom, int qp);
+    void runPmodeTask(Analysis& slave, const CUGeom& cuGeom, int mode, const uint32_t splitRefs[4]);
+    int  initPmodeTasks(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, bool bTryIntra, int* modes);
+
     ModeDepth m_modeDepth[NUM_CU_DEPTH];
     bool      m_bTryLossless;
     bool      m_bChromaSa8d;
@@ -113,6 +162,10 @@ public:
     bool      m_modeFlag[2];
     bool      m_checkMergeAndSkipOnly[2];
 
+    CUPredictor*     m_cuPredictor;  /* set by the frame encoder, NULL when unused */
+    ModeTaskGraph*   m_modeGraph;    /* set by compressCTU for --pmode-graph, else NULL */
+    CUPredictorStats m_cuPredStats[X265_MAX_FRAME_THREADS];
+
     Analysis();
 
     bool create(ThreadLocalData* tld);
@@ -141,6 +194,13 @@ protected:
     uint8_t*                m_additionalCtuInfo;
     int*                    m_prevCtuInfoChange;
 
+    /* CU predictor features per depth, valid between their evaluation and the
+     * end of the CU's analysis, and per CTU inputs of the features */
+    double                  m_cuPredFeatures[NUM_CU_DEPTH][CU_PRED_NUM_FEATURES];
+    bool                    m_cuPredValid[NUM_CU_DEPTH];
+    double                  m_cuPredNeighDepth;
+    const uint16_t*         m_cuPredLowresCosts;
+
     struct TrainingData
     {
         uint32_t cuVariance;
@@ -193,6 +253,12 @@ protected:
     bool recursionDepthCheck(const CUData& parentCTU, const CUGeom& cuGeom, const Mode& bestMode);
     bool complexityCheckCU(const Mode& bestMode);
 
+    /* decision tree early terminations for RD levels 0 to 6 */
+    void initCUPredictor(const CUData& ctu);
+    void cuPredictorFeatures(const CUData& parentCTU, const CUGeom& cuGeom, const Mode& bestMode, double* features);
+    void checkCUPredictor(const CUData& parentCTU, const CUGeom& cuGeom, const Mode& bestMode, bool& skipRecursion, bool& skipModes);
+    void dumpCUPredictor(const CUGeom& cuGeom);
+
     /* generate residual and recon pixels for an entire CTU recursively (RD0) */
     void encodeResidue(const CUData& parentCTU, const CUGeom& cuGeom);
 
@@ -207,6 +273,9 @@ protected:
     void normFactor(const pixel* src, uint32_t blockSize, CUData& ctu, int qp, TextType ttype);
 
     void collectPUStatistics(const CUData& ctu, const CUGeom& cuGeom);
+#if DETAILED_CU_STATS
+    void collectContextCopyStats(CUStats& stats);
+#endif
 
     /* check whether current mode is the new best */
     inline void checkBestMode(Mode& mode, uint32_t depth)
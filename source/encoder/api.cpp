@@ -210,8 +210,8 @@ x265_encoder *x265_encoder_open(x265_param *p)
         encoder->configureZone(zoneParam, param->rc.zones[i].zoneParam);
     }
 
-    /* Try to open CSV file handle */
-    if (encoder->m_param->csvfn)
+    /* Try to open CSV file handle, a segment plan run encodes no frames to log */
+    if (encoder->m_param->csvfn && !encoder->m_param->segmentPlanFile)
     {
         encoder->m_param->csvfpt = x265_csvlog_open(encoder->m_param);
         if (!encoder->m_param->csvfpt)
@@ -1279,6 +1279,10 @@ FILE* x265_csvlog_open(const x265_param* param)
                     fprintf(csvfp, "Y PSNR, U PSNR, V PSNR, YUV PSNR, ");
                 if (param->bEnableSsim)
                     fprintf(csvfp, "SSIM, SSIM(dB), ");
+                if (param->bVmafFeatures)
+                    fprintf(csvfp, "VIF Scale0, VIF Scale1, VIF Scale2, VIF Scale3, ADM, Motion, ");
+                if (param->bSaoSkipCopied)
+                    fprintf(csvfp, "SAO Skipped CTUs, ");
                 fprintf(csvfp, "Latency, ");
                 fprintf(csvfp, "List 0, List 1");
                 uint32_t size = param->maxCUSize;
@@ -1349,7 +1353,8 @@ FILE* x265_csvlog_open(const x265_param* param)
 
                     /* detailed performance statistics */
                     fprintf(csvfp, ", DecideWait (ms), Row0Wait (ms), Wall time (ms), Ref Wait Wall (ms), Total CTU time (ms),"
-                        "Stall Time (ms), Total frame time (ms), Avg WPP, Row Blocks");
+                        "Stall Time (ms), Total frame time (ms), Avg WPP, Row Blocks, RC Start (ms),"
+                        " LowresMV Searches, LowresMV Narrowed, LowresMV SADs Saved, Border Bytes Saved");
 #if ENABLE_LIBVMAF
                     fprintf(csvfp, ", VMAF Frame Score");
 #endif
@@ -1390,6 +1395,11 @@ void x265_csvlog_frame(const x265_param* param, const x265_picture* pic)
         fprintf(param->csvfpt, "%.3lf, %.3lf, %.3lf, %.3lf,", frameStats->psnrY, frameStats->psnrU, frameStats->psnrV, frameStats->psnr);
     if (param->bEnableSsim)
         fprintf(param->csvfpt, " %.6f, %6.3f,", frameStats->ssim, x265_ssim2dB(frameStats->ssim));
+    if (param->bVmafFeatures)
+        fprintf(param->csvfpt, " %.4f, %.4f, %.4f, %.4f, %.4f, %.3f,", frameStats->vmafVif[0], frameStats->vmafVif[1],
+                frameStats->vmafVif[2], frameStats->vmafVif[3], frameStats->vmafAdm, frameStats->vmafMotion);
+    if (param->bSaoSkipCopied)
+        fprintf(param->csvfpt, " %d,", frameStats->saoSkippedCTUs);
     fprintf(param->csvfpt, "%d, ", frameStats->frameLatency);
     if (frameStats->sliceType == 'I' || frameStats->sliceType == 'i')
         fputs(" -, -,", param->csvfpt);
@@ -1472,7 +1482,10 @@ void x265_csvlog_frame(const x265_param* param, const x265_picture* pic)
                                                                                      frameStats->totalCTUTime, frameStats->stallTime,
                                                                                      frameStats->totalFrameTime);
 
-        fprintf(param->csvfpt, " %.3lf, %d", frameStats->avgWPP, frameStats->countRowBlocks);
+        fprintf(param->csvfpt, " %.3lf, %d, %.3lf", frameStats->avgWPP, frameStats->countRowBlocks, frameStats->rateControlStartTime);
+        fprintf(param->csvfpt, ", %llu, %llu, %llu", (unsigned long long)frameStats->lowresMVSearches,
+                (unsigned long long)frameStats->lowresMVAdapted, (unsigned long long)frameStats->lowresMVSADsSaved);
+        fprintf(param->csvfpt, ", %llu", (unsigned long long)frameStats->borderBytesSaved);
 #if ENABLE_LIBVMAF
         fprintf(param->csvfpt, ", %lf", frameStats->vmafFrameScore);
 #endif
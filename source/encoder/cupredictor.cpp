@@ -0,0 +1,280 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "cupredictor.h"
+
+using namespace X265_NS;
+
+namespace {
+
+const char* const s_featureNames[CU_PRED_NUM_FEATURES] =
+{
+    "depth", "qp", "log-cost", "log-variance", "log-lowres-intra", "log-lowres-inter",
+    "neigh-depth", "ref-depth", "cutree-offset", "best-skip", "best-cbf", "p-slice"
+};
+
+const char* const s_treeNames[CU_PRED_NUM_TREES] = { "split", "skip" };
+
+/* Built-in trees, fitted by test/cupredictor.py to --cu-predictor-dump data
+ * of fast, medium and slow encodes at CRF 22, 30 and 37, and collapsed so
+ * only the nodes which change a decision at the default thresholds remain.
+ * Recursion is pruned only for CUs with no residual, a reference coded no
+ * deeper, a high QP, a low lowres inter cost and shallow neighbours */
+const CUPredictor::Node s_splitTree[] =
+{
+    { CU_PRED_BEST_CBF,          0.5,       1,  2, 0     },
+    { CU_PRED_REF_DEPTH,         0.5,       3,  4, 0     },
+    { -1,                        0,         0,  0, 0.545 },
+    { CU_PRED_QP,                31.5,      5,  6, 0     },
+    { -1,                        0,         0,  0, 0.219 },
+    { -1,                        0,         0,  0, 0.120 },
+    { CU_PRED_LOG_LOWRES_INTER,  2.529,     7,  8, 0     },
+    { CU_PRED_NEIGH_DEPTH,       0.01562,   9, 10, 0     },
+    { -1,                        0,         0,  0, 0.212 },
+    { -1,                        0,         0,  0, 0.025 },
+    { -1,                        0,         0,  0, 0.112 },
+};
+
+const CUPredictor::Node s_skipTree[] =
+{
+    { CU_PRED_BEST_SKIP,         0.5,       1,  2, 0     },
+    { -1,                        0,         0,  0, 0.545 },
+    { CU_PRED_REF_DEPTH,         -0.5,      3,  4, 0     },
+    { CU_PRED_QP,                31.5,      5,  6, 0     },
+    { CU_PRED_REF_DEPTH,         0.5,       7,  8, 0     },
+    { CU_PRED_LOG_VARIANCE,      3.538,     9, 10, 0     },
+    { CU_PRED_LOG_LOWRES_INTER,  2.484,    11, 12, 0     },
+    { CU_PRED_QP,                32.5,     13, 14, 0     },
+    { CU_PRED_REF_DEPTH,         1.125,    15, 16, 0     },
+    { CU_PRED_QP,                26.5,     17, 18, 0     },
+    { CU_PRED_DEPTH,             1.5,      19, 20, 0     },
+    { CU_PRED_LOG_COST,          7.958,    21, 22, 0     },
+    { CU_PRED_LOG_COST,          7.844,    23, 24, 0     },
+    { CU_PRED_DEPTH,             1.5,      25, 26, 0     },
+    { CU_PRED_LOG_VARIANCE,      9.102,    27, 28, 0     },
+    { CU_PRED_LOG_COST,          7.903,    29, 30, 0     },
+    { -1,                        0,         0,  0, 0.891 },
+    { CU_PRED_LOG_COST,          4.207,    31, 32, 0     },
+    { -1,                        0,         0,  0, 0.986 },
+    { -1,                        0,         0,  0, 0.910 },
+    { CU_PRED_QP,                24.5,     33, 34, 0     },
+    { -1,                        0,         0,  0, 0.992 },
+    { -1,                        0,         0,  0, 0.729 },
+    { CU_PRED_QP,                41.5,     35, 36, 0     },
+    { -1,                        0,         0,  0, 0.851 },
+    { -1,                        0,         0,  0, 0.899 },
+    { CU_PRED_LOG_VARIANCE,      3.538,    37, 38, 0     },
+    { CU_PRED_NEIGH_DEPTH,       0.01562,  39, 40, 0     },
+    { -1,                        0,         0,  0, 0.917 },
+    { CU_PRED_QP,                40.5,     41, 42, 0     },
+    { -1,                        0,         0,  0, 0.826 },
+    { -1,                        0,         0,  0, 0.972 },
+    { -1,                        0,         0,  0, 0.931 },
+    { -1,                        0,         0,  0, 0.896 },
+    { -1,                        0,         0,  0, 0.951 },
+    { -1,                        0,         0,  0, 0.911 },
+    { -1,                        0,         0,  0, 0.970 },
+    { -1,                        0,         0,  0, 0.977 },
+    { -1,                        0,         0,  0, 0.940 },
+    { -1,                        0,         0,  0, 0.975 },
+    { -1,                        0,         0,  0, 0.939 },
+    { -1,                        0,         0,  0, 0.924 },
+    { -1,                        0,         0,  0, 0.958 },
+};
+
+const double s_defaultThreshold[CU_PRED_NUM_TREES] = { 0.05, 0.95 };
+
+int treeIndex(const char* name)
+{
+    for (int i = 0; i < CU_PRED_NUM_TREES; i++)
+        if (!strcmp(name, s_treeNames[i]))
+            return i;
+    return -1;
+}
+
+}
+
+CUPredictor::CUPredictor()
+{
+    for (int i = 0; i < CU_PRED_NUM_TREES; i++)
+    {
+        m_trees[i] = NULL;
+        m_numNodes[i] = 0;
+        m_threshold[i] = s_defaultThreshold[i];
+    }
+    m_dumpFile = NULL;
+}
+
+bool CUPredictor::create(const x265_param& param)
+{
+    if (param.cuPredictorModel)
+    {
+        if (!loadModel(param))
+            return false;
+    }
+    else
+    {
+        m_numNodes[CU_PRED_SPLIT] = sizeof(s_splitTree) / sizeof(s_splitTree[0]);
+        m_numNodes[CU_PRED_SKIP] = sizeof(s_skipTree) / sizeof(s_skipTree[0]);
+        m_trees[CU_PRED_SPLIT] = X265_MALLOC(Node, m_numNodes[CU_PRED_SPLIT]);
+        m_trees[CU_PRED_SKIP] = X265_MALLOC(Node, m_numNodes[CU_PRED_SKIP]);
+        if (!m_trees[CU_PRED_SPLIT] || !m_trees[CU_PRED_SKIP])
+            return false;
+        memcpy(m_trees[CU_PRED_SPLIT], s_splitTree, sizeof(s_splitTree));
+        memcpy(m_trees[CU_PRED_SKIP], s_skipTree, sizeof(s_skipTree));
+    }
+
+    if (param.cuPredictorDump)
+    {
+        m_dumpFile = x265_fopen(param.cuPredictorDump, "w");
+        if (!m_dumpFile)
+        {
+            x265_log(&param, X265_LOG_ERROR, "cu-predictor: unable to open dump file %s\n", param.cuPredictorDump);
+            return false;
+        }
+        fprintf(m_dumpFile, "poc");
+        for (int i = 0; i < CU_PRED_NUM_FEATURES; i++)
+            fprintf(m_dumpFile, ",%s", s_featureNames[i]);
+        fprintf(m_dumpFile, ",split,skip\n");
+    }
+    return true;
+}
+
+void CUPredictor::destroy()
+{
+    for (int i = 0; i < CU_PRED_NUM_TREES; i++)
+    {
+        X265_FREE(m_trees[i]);
+        m_trees[i] = NULL;
+        m_numNodes[i] = 0;
+    }
+    if (m_dumpFile)
+    {
+        fclose(m_dumpFile);
+        m_dumpFile = NULL;
+    }
+}
+
+double CUPredictor::predict(int tree, const double* features) const
+{
+    const Node* nodes = m_trees[tree];
+    int idx = 0;
+    while (nodes[idx].feature >= 0)
+        idx = features[nodes[idx].feature] < nodes[idx].threshold ? nodes[idx].less : nodes[idx].greater;
+    return nodes[idx].value;
+}
+
+void CUPredictor::dump(int poc, const double* features, bool bSplit, bool bSkip)
+{
+    char line[512];
+    int len = sprintf(line, "%d", poc);
+    for (int i = 0; i < CU_PRED_NUM_FEATURES; i++)
+        len += sprintf(line + len, ",%.4g", features[i]);
+    sprintf(line + len, ",%d,%d\n", bSplit, bSkip);
+
+    ScopedLock lock(m_dumpLock);
+    fputs(line, m_dumpFile);
+}
+
+/* children must follow their parent so evaluation always terminates */
+bool CUPredictor::validate(int tree) const
+{
+    if (!m_numNodes[tree])
+        return false;
+    for (int i = 0; i < m_numNodes[tree]; i++)
+    {
+        const Node& n = m_trees[tree][i];
+        if (n.feature >= CU_PRED_NUM_FEATURES)
+            return false;
+        if (n.feature >= 0 && (n.less <= i || n.greater <= i || n.less >= m_numNodes[tree] || n.greater >= m_numNodes[tree]))
+            return false;
+    }
+    return true;
+}
+
+/* The model file is text. Lines beginning with # are comments, "threshold
+ * <tree> <value>" overrides a decision threshold and "tree <name>" begins the
+ * nodes of a tree, one per line: "<feature> <threshold> <less> <greater>
+ * <value>", numbered from 0 in file order, with feature -1 for leaves */
+bool CUPredictor::loadModel(const x265_param& param)
+{
+    const char* filename = param.cuPredictorModel;
+    FILE* f = x265_fopen(filename, "r");
+    if (!f)
+    {
+        x265_log(&param, X265_LOG_ERROR, "cu-predictor: unable to open model %s\n", filename);
+        return false;
+    }
+
+    int allocated[CU_PRED_NUM_TREES] = { 0 };
+    int tree = -1;
+    int lineNum = 0;
+    bool bError = false;
+    char line[256];
+    while (!bError && fgets(line, sizeof(line), f))
+    {
+        lineNum++;
+        char name[64];
+        double value;
+        Node n;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+            continue;
+        else if (sscanf(line, "threshold %63s %lf", name, &value) == 2 && treeIndex(name) >= 0)
+            m_threshold[treeIndex(name)] = value;
+        else if (sscanf(line, "tree %63s", name) == 1 && treeIndex(name) >= 0)
+            tree = treeIndex(name);
+        else if (tree >= 0 && sscanf(line, "%d %lf %d %d %lf", &n.feature, &n.threshold, &n.less, &n.greater, &n.value) == 5)
+        {
+            if (m_numNodes[tree] == allocated[tree])
+            {
+                allocated[tree] = allocated[tree] ? allocated[tree] * 2 : 64;
+                Node* nodes = X265_MALLOC(Node, allocated[tree]);
+                if (!nodes)
+                {
+                    bError = true;
+                    break;
+                }
+                if (m_trees[tree])
+                    memcpy(nodes, m_trees[tree], m_numNodes[tree] * sizeof(Node));
+                X265_FREE(m_trees[tree]);
+                m_trees[tree] = nodes;
+            }
+            m_trees[tree][m_numNodes[tree]++] = n;
+        }
+        else
+        {
+            x265_log(&param, X265_LOG_ERROR, "cu-predictor: syntax error in %s line %d\n", filename, lineNum);
+            bError = true;
+        }
+    }
+    fclose(f);
+
+    for (int i = 0; i < CU_PRED_NUM_TREES && !bError; i++)
+    {
+        if (!validate(i))
+        {
+            x265_log(&param, X265_LOG_ERROR, "cu-predictor: %s tree of %s is missing or malformed\n", s_treeNames[i], filename);
+            bError = true;
+        }
+    }
+    return !bError;
+}
@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_CUPREDICTOR_H
+#define X265_CUPREDICTOR_H 1
+
+#include "common.h"
+#include "threading.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+/* Features of an inter CU, measured once merge (and for RD 5 and 6, 2Nx2N)
+ * have been evaluated at its depth. All of them come from data the encoder
+ * has already computed; depths of neighbours are relative to the CU depth */
+enum CUPredictorFeature
+{
+    CU_PRED_DEPTH,             /* depth of the CU within the CTU */
+    CU_PRED_QP,                /* QP of the CU */
+    CU_PRED_LOG_COST,          /* log2 of 1 + best mode cost per pixel */
+    CU_PRED_LOG_VARIANCE,      /* log2 of 1 + luma variance of the source */
+    CU_PRED_LOG_LOWRES_INTRA,  /* log2 of 1 + lowres intra cost per lowres pixel */
+    CU_PRED_LOG_LOWRES_INTER,  /* log2 of 1 + lowres inter cost, or the intra cost when unknown */
+    CU_PRED_NEIGH_DEPTH,       /* average depth of the left and above CTUs minus CU depth */
+    CU_PRED_REF_DEPTH,         /* average co-located depth in the first L0 reference minus CU depth */
+    CU_PRED_CUTREE_OFFSET,     /* average cuTree QP offset, 0 without AQ */
+    CU_PRED_BEST_SKIP,         /* 1 if the best mode so far is skip */
+    CU_PRED_BEST_CBF,          /* 1 if the best mode so far codes a residual */
+    CU_PRED_SLICE_TYPE,        /* 0 for B slices, 1 for P slices */
+    CU_PRED_NUM_FEATURES
+};
+
+enum CUPredictorTree
+{
+    CU_PRED_SPLIT,             /* probability that the CU is coded split */
+    CU_PRED_SKIP,              /* probability that the CU is coded skip */
+    CU_PRED_NUM_TREES
+};
+
+struct CUPredictorStats
+{
+    uint64_t evaluated;        /* CUs whose features were evaluated */
+    uint64_t prunedSplit;      /* recursions avoided on a predicted no-split */
+    uint64_t predictedSkip;    /* mode analyses avoided on a predicted skip */
+
+    CUPredictorStats() { clear(); }
+
+    void clear()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void accumulate(const CUPredictorStats& other)
+    {
+        evaluated += other.evaluated;
+        prunedSplit += other.prunedSplit;
+        predictedSkip += other.predictedSkip;
+    }
+};
+
+/* Decision trees predicting whether inter CUs will be split or skipped, used
+ * to prune recursion and mode analysis. Built-in trees are used unless a model
+ * file is given; the training dump writes the features of every evaluated CU
+ * together with its final decision so trees may be fitted offline */
+class CUPredictor
+{
+public:
+
+    struct Node
+    {
+        int    feature;        /* feature index, -1 for a leaf */
+        double threshold;      /* features below the threshold go to less */
+        int    less;
+        int    greater;
+        double value;          /* predicted probability of a leaf */
+    };
+
+    Node*    m_trees[CU_PRED_NUM_TREES];
+    int      m_numNodes[CU_PRED_NUM_TREES];
+    double   m_threshold[CU_PRED_NUM_TREES];
+
+    FILE*    m_dumpFile;
+    Lock     m_dumpLock;
+
+    CUPredictor();
+    ~CUPredictor() { destroy(); }
+
+    bool create(const x265_param& param);
+    void destroy();
+
+    double predict(int tree, const double* features) const;
+
+    /* recursion is pruned when a split is improbable and remaining modes are
+     * skipped when skip is probable */
+    bool pruneSplit(const double* features) const { return predict(CU_PRED_SPLIT, features) <= m_threshold[CU_PRED_SPLIT]; }
+    bool predictSkip(const double* features) const { return predict(CU_PRED_SKIP, features) >= m_threshold[CU_PRED_SKIP]; }
+
+    void dump(int poc, const double* features, bool bSplit, bool bSkip);
+
+protected:
+
+    bool loadModel(const x265_param& param);
+    bool validate(int tree) const;
+};
+}
+
+#endif // ifndef X265_CUPREDICTOR_H
@@ -61,6 +61,21 @@ DPB::~DPB()
     }
 }
 
+/* take a recycled FrameData whose recon was placed on the NUMA node of the given
+ * thread pool. Each FrameData returns to the list it was taken from, so each
+ * pool finds as many as it has released */
+FrameData* DPB::popFrameData(int poolId)
+{
+    FrameData** link = &m_frameDataFreeList;
+    while (*link && (*link)->m_poolId != poolId)
+        link = &(*link)->m_freeListNext;
+
+    FrameData* encData = *link;
+    if (encData)
+        *link = encData->m_freeListNext;
+    return encData;
+}
+
 // move unreferenced pictures from picList to freeList for recycle
 void DPB::recycleUnreferenced()
 {
@@ -100,6 +115,12 @@ void DPB::recycleUnreferenced()
                     curFrame->m_encData->m_meBuffer[i] = NULL;
                 }
             }
+            for (int i = 0; i < 3; i++)
+            {
+                X265_FREE(curFrame->m_encData->m_hpelBuffer[i]);
+                curFrame->m_encData->m_hpelBuffer[i] = NULL;
+                curFrame->m_encData->m_hpelPlane[i] = NULL;
+            }
             if (curFrame->m_ctuInfo != NULL)
             {
                 uint32_t widthInCU = (curFrame->m_param->sourceWidth + curFrame->m_param->maxCUSize - 1) >> curFrame->m_param->maxLog2CUSize;
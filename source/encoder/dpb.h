@@ -73,6 +73,8 @@ public:
 
     void prepareEncode(Frame*);
 
+    FrameData* popFrameData(int poolId);
+
     void recycleUnreferenced();
 
 protected:
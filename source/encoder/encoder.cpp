@@ -37,6 +37,7 @@
 #include "slicetype.h"
 #include "frameencoder.h"
 #include "ratecontrol.h"
+#include "cupredictor.h"
 #include "dpb.h"
 #include "nal.h"
 
@@ -98,7 +99,16 @@ Encoder::Encoder()
     m_numLumaWPBiFrames = 0;
     m_numChromaWPBiFrames = 0;
     m_lookahead = NULL;
+    m_hpelPlaneBytes = 0;
+    m_hpelPlanePeakFrames = 0;
+    memset(m_vmafVifSum, 0, sizeof(m_vmafVifSum));
+    m_vmafAdmSum = 0;
+    m_vmafMotionSum = 0;
+    m_saoSkippedCTUs = 0;
+    m_saoInterCTUs = 0;
+    m_borderBytesSaved = 0;
     m_rateControl = NULL;
+    m_cuPredictor = NULL;
     m_dpb = NULL;
     m_exportedPic = NULL;
     m_numDelayedPic = 0;
@@ -245,6 +255,26 @@ void Encoder::create()
     if (!p->bEnableWavefront && !p->bDistributeModeAnalysis && !p->bDistributeMotionEstimation && !p->lookaheadSlices)
         allowPools = false;
 
+    if (p->bDeterministic)
+    {
+        /* The auto-detected frame thread count follows the host's core count,
+         * and frame parallelism changes the motion search clamping and the
+         * feedback delay of rate control. Pin it so outputs do not vary with
+         * the pools. Row VBV must only use data, never progress of other rows */
+        if (!p->frameNumThreads)
+            ThreadPool::getFrameThreadsCount(p, 8);
+        if (p->rc.vbvBufferSize && p->rc.vbvMaxBitrate && !p->rc.bEnableConstVbv)
+        {
+            x265_log(p, X265_LOG_INFO, "deterministic mode enables --const-vbv\n");
+            p->rc.bEnableConstVbv = 1;
+        }
+        if (p->bSpeculativeRC)
+        {
+            x265_log(p, X265_LOG_WARNING, "speculative rate control depends on thread timing, disabled by deterministic mode\n");
+            p->bSpeculativeRC = 0;
+        }
+    }
+
     m_numPools = 0;
     if (allowPools)
         m_threadPool = ThreadPool::allocThreadPools(p, m_numPools, 0);
@@ -267,11 +297,15 @@ void Encoder::create()
             x265_log(p, X265_LOG_WARNING, "No thread pool allocated, --pme disabled\n");
         if (p->bDistributeModeAnalysis)
             x265_log(p, X265_LOG_WARNING, "No thread pool allocated, --pmode disabled\n");
-        if (p->lookaheadSlices)
+        if (p->lookaheadSlices && !p->bDeterministic)
             x265_log(p, X265_LOG_WARNING, "No thread pool allocated, --lookahead-slices disabled\n");
 
         // disable all pool features if the thread pool is disabled or unusable.
-        p->bEnableWavefront = p->bDistributeModeAnalysis = p->bDistributeMotionEstimation = p->lookaheadSlices = 0;
+        // lookahead slices change the lowres costs, deterministic mode keeps
+        // them and the lookahead processes the slices serially
+        p->bEnableWavefront = p->bDistributeModeAnalysis = p->bDistributeMotionEstimation = 0;
+        if (!p->bDeterministic)
+            p->lookaheadSlices = 0;
     }
 
     x265_log(p, X265_LOG_INFO, "Slices                              : %d\n", p->maxSlices);
@@ -299,7 +333,9 @@ void Encoder::create()
     {
         for (int i = 0; i < m_param->frameNumThreads; i++)
         {
-            int pool = i % m_numPools;
+            /* consecutive frame encoders share a pool, so that a frame is
+             * mostly encoded on the NUMA node holding its nearest references */
+            int pool = i * m_numPools / m_param->frameNumThreads;
             m_frameEncoder[i]->m_pool = &m_threadPool[pool];
             m_frameEncoder[i]->m_jpId = m_threadPool[pool].m_numProviders++;
             m_threadPool[pool].m_jpTable[m_frameEncoder[i]->m_jpId] = m_frameEncoder[i];
@@ -314,6 +350,13 @@ void Encoder::create()
             m_frameEncoder[i]->m_jpId = 0;
     }
 
+    if (m_param->bVmafFeatures && !m_vmafMotion.create(m_param->sourceWidth, m_param->sourceHeight))
+    {
+        x265_log(m_param, X265_LOG_ERROR, "Unable to allocate VMAF motion feature buffers\n");
+        m_aborted = true;
+        return;
+    }
+
     if (!m_scalingList.init())
     {
         x265_log(m_param, X265_LOG_ERROR, "Unable to allocate scaling list arrays\n");
@@ -346,6 +389,15 @@ void Encoder::create()
     m_lookahead->m_numPools = pools;
     m_dpb = new DPB(m_param);
     m_rateControl = new RateControl(*m_param, this);
+    if (m_param->bEnableCUPredictor || m_param->cuPredictorDump)
+    {
+        m_cuPredictor = new CUPredictor;
+        if (!m_cuPredictor->create(*m_param))
+        {
+            x265_log(m_param, X265_LOG_ERROR, "Unable to initialize the CU predictor\n");
+            m_aborted = true;
+        }
+    }
     if (!m_param->bResetZoneConfig)
     {
         zoneReadCount = new ThreadSafeInteger[m_param->rc.zonefileCount];
@@ -914,6 +966,7 @@ void Encoder::destroy()
         m_rateControl->destroy();
         delete m_rateControl;
     }
+    delete m_cuPredictor;
 
     X265_FREE(m_offsetEmergency);
 
@@ -967,6 +1020,9 @@ void Encoder::destroy()
         free((char*)m_param->toneMapFile);
         free((char*)m_param->analysisSave);
         free((char*)m_param->analysisLoad);
+        free((char*)m_param->segmentPlanFile);
+        free((char*)m_param->cuPredictorModel);
+        free((char*)m_param->cuPredictorDump);
         PARAM_NS::x265_param_free(m_param);
     }
 }
@@ -1691,6 +1747,8 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
 
         /* Copy input picture into a Frame and PicYuv, send to lookahead */
         inFrame->m_fencPic->copyFromPicture(*inputPic, *m_param, m_sps.conformanceWindow.rightOffset, m_sps.conformanceWindow.bottomOffset);
+        if (m_param->bVmafFeatures)
+            inFrame->m_vmafMotion = m_vmafMotion.measure(*inFrame->m_fencPic);
 
         inFrame->m_poc       = ++m_pocLast;
         inFrame->m_userData  = inputPic->userData;
@@ -2141,11 +2199,13 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
             curEncoder->m_param = m_reconfigure ? m_latestParam : m_param;
             curEncoder->m_reconfigure = m_reconfigure;
 
-            /* give this frame a FrameData instance before encoding */
-            if (m_dpb->m_frameDataFreeList)
+            /* give this frame a FrameData instance before encoding, one whose
+             * recon lives on the NUMA node of this frame encoder if possible */
+            int poolId = curEncoder->m_pool ? (int)(curEncoder->m_pool - m_threadPool) : 0;
+            FrameData* encData = m_dpb->popFrameData(poolId);
+            if (encData)
             {
-                frameEnc->m_encData = m_dpb->m_frameDataFreeList;
-                m_dpb->m_frameDataFreeList = m_dpb->m_frameDataFreeList->m_freeListNext;
+                frameEnc->m_encData = encData;
                 frameEnc->reinit(m_sps);
                 frameEnc->m_param = m_reconfigure ? m_latestParam : m_param;
                 frameEnc->m_encData->m_param = m_reconfigure ? m_latestParam : m_param;
@@ -2153,6 +2213,7 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
             else
             {
                 frameEnc->allocEncodeData(m_reconfigure ? m_latestParam : m_param, m_sps);
+                frameEnc->m_encData->m_poolId = poolId;
                 Slice* slice = frameEnc->m_encData->m_slice;
                 slice->m_sps = &m_sps;
                 slice->m_pps = &m_pps;
@@ -2196,6 +2257,36 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
                         x265_log(m_param, X265_LOG_ERROR, "SEA motion search: POC %d Integral buffer[%d] unallocated\n", frameEnc->m_poc, i);
                 }
             }
+            if (m_param->bHpelPlanes && frameEnc->m_lowres.sliceType != X265_TYPE_B)
+            {
+                PicYuv* reconPic = frameEnc->m_reconPic;
+                uint32_t numCuInHeight = (reconPic->m_picHeight + m_param->maxCUSize - 1) / m_param->maxCUSize;
+                size_t planeSize = reconPic->m_stride * (numCuInHeight * m_param->maxCUSize + 2 * reconPic->m_lumaMarginY);
+                for (int i = 0; i < 3; i++)
+                {
+                    frameEnc->m_encData->m_hpelBuffer[i] = X265_MALLOC(pixel, planeSize);
+                    if (frameEnc->m_encData->m_hpelBuffer[i])
+                        frameEnc->m_encData->m_hpelPlane[i] = frameEnc->m_encData->m_hpelBuffer[i] + reconPic->m_lumaMarginY * reconPic->m_stride + reconPic->m_lumaMarginX;
+                    else
+                    {
+                        x265_log(m_param, X265_LOG_ERROR, "hpel-planes: POC %d half-pel plane %d unallocated\n", frameEnc->m_poc, i);
+                        for (int j = 0; j < i; j++)
+                        {
+                            X265_FREE(frameEnc->m_encData->m_hpelBuffer[j]);
+                            frameEnc->m_encData->m_hpelBuffer[j] = NULL;
+                            frameEnc->m_encData->m_hpelPlane[j] = NULL;
+                        }
+                        break;
+                    }
+                }
+
+                /* account for the half-pel planes held by reference frames */
+                int numFrames = 0;
+                for (Frame* f = m_dpb->m_picList.first(); f; f = f->m_next)
+                    numFrames += f->m_encData && f->m_encData->m_hpelBuffer[0] ? 1 : 0;
+                m_hpelPlaneBytes = 3 * planeSize * sizeof(pixel);
+                m_hpelPlanePeakFrames = X265_MAX(m_hpelPlanePeakFrames, numFrames);
+            }
 
             if (m_param->bOptQpPPS && frameEnc->m_lowres.bKeyframe && m_param->bRepeatHeaders)
             {
@@ -2285,6 +2376,11 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
                 slice->m_bUseSao = curEncoder->m_frameFilter.m_useSao = 0;
             }
 
+            /* the recon of a picture which is never referenced is left unfiltered */
+            curEncoder->m_frameFilter.m_bFilterRecon = !m_param->bSkipNonRefFilter || IS_REFERENCED(frameEnc);
+            if (!curEncoder->m_frameFilter.m_bFilterRecon)
+                frameEnc->m_encData->m_slice->m_bUseSao = curEncoder->m_frameFilter.m_useSao = 0;
+
             if (m_param->rc.rateControlMode != X265_RC_CQP)
                 m_lookahead->getEstimatedPictureCost(frameEnc);
             if (m_param->bIntraRefresh)
@@ -2594,7 +2690,74 @@ void Encoder::printSummary()
             m_rateControl->m_numEntries - m_rpsInSpsCount, 
             (float)100.0 * (m_rateControl->m_numEntries - m_rpsInSpsCount) / m_rateControl->m_numEntries);
     }
+    if (m_cuPredictor)
+    {
+        CUPredictorStats cuPredStats;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+            cuPredStats.accumulate(m_frameEncoder[i]->m_cuPredStats);
 
+        if (cuPredStats.evaluated)
+            x265_log(m_param, X265_LOG_INFO, "cu-predictor: %llu CUs evaluated, recursion pruned %.1f%%, early skip %.1f%%\n",
+                     (unsigned long long)cuPredStats.evaluated,
+                     100.0 * cuPredStats.prunedSplit / cuPredStats.evaluated,
+                     100.0 * cuPredStats.predictedSkip / cuPredStats.evaluated);
+    }
+    if (m_param->bLowresMVConfidence)
+    {
+        LowresMVStats lowresMVStats;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+            lowresMVStats.accumulate(m_frameEncoder[i]->m_lowresMVStats);
+
+        if (lowresMVStats.searches)
+            x265_log(m_param, X265_LOG_INFO, "lowres-mv-confidence: %.1f%% of %llu motion searches narrowed, ~%llu SADs saved\n",
+                     100.0 * lowresMVStats.adapted / lowresMVStats.searches,
+                     (unsigned long long)lowresMVStats.searches,
+                     (unsigned long long)lowresMVStats.sadsSaved);
+    }
+    if (m_param->bHpelPlanes && m_hpelPlanePeakFrames)
+        x265_log(m_param, X265_LOG_INFO, "hpel-planes: %.1f MiB per reference frame, peak %d frames (%.1f MiB)\n",
+                 m_hpelPlaneBytes / 1048576.0, m_hpelPlanePeakFrames,
+                 m_hpelPlaneBytes * (double)m_hpelPlanePeakFrames / 1048576.0);
+    if (m_param->subpelCacheSize)
+    {
+        SubpelCacheStats subpelCacheStats;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+            subpelCacheStats.accumulate(m_frameEncoder[i]->m_subpelCacheStats);
+
+        if (subpelCacheStats.lookups)
+            x265_log(m_param, X265_LOG_INFO, "subpel-cache: %llu lookups, hit %.1f%%, bypassed %.1f%%, %llu tiles interpolated\n",
+                     (unsigned long long)subpelCacheStats.lookups,
+                     100.0 * subpelCacheStats.hits / subpelCacheStats.lookups,
+                     100.0 * subpelCacheStats.bypassed / subpelCacheStats.lookups,
+                     (unsigned long long)subpelCacheStats.tilesFilled);
+    }
+
+    if (m_param->bRateEstimateCheck)
+    {
+        RateEstStats rateEstStats;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+            rateEstStats.accumulate(m_frameEncoder[i]->m_rateEstStats);
+
+        if (rateEstStats.count)
+            x265_log(m_param, X265_LOG_INFO, "rate-est: %llu inter CUs, prediction info estimated at %.2f bits, coded in %.2f bits, mean absolute error %.2f bits\n",
+                     (unsigned long long)rateEstStats.count,
+                     (double)rateEstStats.estimatedBits / rateEstStats.count,
+                     (double)rateEstStats.codedBits / rateEstStats.count,
+                     (double)rateEstStats.absError / rateEstStats.count);
+    }
+    if (m_param->bVmafFeatures && m_analyzeAll.m_numPics)
+    {
+        double numPics = m_analyzeAll.m_numPics;
+        x265_log(m_param, X265_LOG_INFO, "vmaf-features: mean VIF %.4f %.4f %.4f %.4f, ADM %.4f, motion %.3f\n",
+                 m_vmafVifSum[0] / numPics, m_vmafVifSum[1] / numPics, m_vmafVifSum[2] / numPics, m_vmafVifSum[3] / numPics,
+                 m_vmafAdmSum / numPics, m_vmafMotionSum / numPics);
+    }
+    if (m_param->bSaoSkipCopied && m_saoInterCTUs)
+        x265_log(m_param, X265_LOG_INFO, "sao-skip-copied: %.1f%% of %llu inter CTUs skipped SAO as they copy a filtered reference\n",
+                 100.0 * m_saoSkippedCTUs / m_saoInterCTUs, (unsigned long long)m_saoInterCTUs);
+    if (m_analyzeAll.m_numPics)
+        x265_log(m_param, X265_LOG_FULL, "border-extension: %.1f MiB of recon margins left unwritten, %.1f KiB per frame\n",
+                 m_borderBytesSaved / 1048576.0, m_borderBytesSaved / 1024.0 / m_analyzeAll.m_numPics);
     if (m_analyzeAll.m_numPics)
     {
         int p = 0;
@@ -2702,6 +2865,12 @@ void Encoder::printSummary()
     x265_log(m_param, X265_LOG_INFO, "CU: %%%05.2lf time spent in loop filters, average %.3lf ms per call\n",
              100.0 * cuStats.loopFilterElapsedTime / totalWorkerTime,
              ELAPSED_MSEC(cuStats.loopFilterElapsedTime) / cuStats.countLoopFilter);
+    if (cuStats.countContextCopies)
+    {
+        x265_log(m_param, X265_LOG_INFO, "CU: %.1lf entropy context copies per CTU, each moving %.1lf of %d context bytes\n",
+                 (double)cuStats.countContextCopies / cuStats.totalCTUs,
+                 (double)cuStats.contextBytesCopied / cuStats.countContextCopies, (int)sizeof(m_frameEncoder[0]->m_entropyCoder.m_contextState));
+    }
     if (cuStats.countWeightAnalyze && cuStats.weightAnalyzeTime)
     {
         x265_log(m_param, X265_LOG_INFO, "CU: %%%05.2lf time spent in weight analysis, average %.3lf ms per call\n",
@@ -2871,6 +3040,22 @@ void Encoder::finishFrameStats(Frame* curFrame, FrameEncoder *curEncoder, x265_f
         ssim = curEncoder->m_ssim / curEncoder->m_ssimCnt;
         m_analyzeAll.addSsim(ssim);
     }
+    if (m_param->bVmafFeatures)
+    {
+        for (int scale = 0; scale < VmafFeatureSums::NUM_SCALES; scale++)
+            m_vmafVifSum[scale] += curEncoder->m_vmafSums.vif(scale);
+        m_vmafAdmSum += curEncoder->m_vmafSums.adm();
+        m_vmafMotionSum += curFrame->m_vmafMotion;
+    }
+    int saoSkippedCTUs = 0;
+    if (m_param->bSaoSkipCopied && slice->m_bUseSao && !slice->isIntra())
+    {
+        for (int row = 0; row < curEncoder->m_frameFilter.m_numRows; row++)
+            saoSkippedCTUs += curEncoder->m_frameFilter.m_parallelFilter[row].m_sao.m_numSaoSkipped;
+        m_saoSkippedCTUs += saoSkippedCTUs;
+        m_saoInterCTUs += slice->m_sps->numCUsInFrame;
+    }
+    m_borderBytesSaved += curEncoder->m_frameFilter.m_borderBytesSaved;
     if (slice->isIntra())
     {
         m_analyzeI.addBits(bits);
@@ -2931,6 +3116,15 @@ void Encoder::finishFrameStats(Frame* curFrame, FrameEncoder *curEncoder, x265_f
         double psnr = (psnrY * 6 + psnrU + psnrV) / 8;
         frameStats->psnr = psnr;
         frameStats->ssim = ssim;
+        if (m_param->bVmafFeatures)
+        {
+            for (int scale = 0; scale < VmafFeatureSums::NUM_SCALES; scale++)
+                frameStats->vmafVif[scale] = curEncoder->m_vmafSums.vif(scale);
+            frameStats->vmafAdm = curEncoder->m_vmafSums.adm();
+            frameStats->vmafMotion = curFrame->m_vmafMotion;
+        }
+        if (m_param->bSaoSkipCopied)
+            frameStats->saoSkippedCTUs = saoSkippedCTUs;
         if (!slice->isIntra())
         {
             for (int ref = 0; ref < MAX_NUM_REF; ref++)
@@ -2954,6 +3148,11 @@ void Encoder::finishFrameStats(Frame* curFrame, FrameEncoder *curEncoder, x265_f
             frameStats->refWaitWallTime = ELAPSED_MSEC(curEncoder->m_row0WaitTime, curEncoder->m_allRowsAvailableTime);
             frameStats->totalCTUTime = ELAPSED_MSEC(0, curEncoder->m_totalWorkerElapsedTime);
             frameStats->stallTime = ELAPSED_MSEC(0, curEncoder->m_totalNoWorkerTime);
+            frameStats->rateControlStartTime = ELAPSED_MSEC(0, curEncoder->m_rateControlStartTime);
+            frameStats->lowresMVSearches = curEncoder->m_lowresMVFrameStats.searches;
+            frameStats->lowresMVAdapted = curEncoder->m_lowresMVFrameStats.adapted;
+            frameStats->lowresMVSADsSaved = curEncoder->m_lowresMVFrameStats.sadsSaved;
+            frameStats->borderBytesSaved = curEncoder->m_frameFilter.m_borderBytesSaved;
             frameStats->totalFrameTime = ELAPSED_MSEC(curFrame->m_encodeStartTime, x265_mdate());
             if (curEncoder->m_totalActiveWorkerCount)
                 frameStats->avgWPP = (double)curEncoder->m_totalActiveWorkerCount / curEncoder->m_activeWorkerCountSamples;
@@ -3725,6 +3924,20 @@ void Encoder::configure(x265_param *p)
         p->bDistributeModeAnalysis = 0;
     }
 
+    if (p->bPModeGraph && !p->bDistributeModeAnalysis)
+    {
+        x265_log(p, X265_LOG_WARNING, "pmode-graph requires pmode, disabling\n");
+        p->bPModeGraph = 0;
+    }
+
+    /* a plan run encodes nothing and segments see only part of the stats, and
+     * parallel segments would all rename their temp file onto the same stats */
+    if ((p->segmentPlanFile || p->segmentIndex >= 0) && p->rc.bStatWrite)
+    {
+        x265_log(p, X265_LOG_WARNING, "stats are not written when planning or encoding segments, disabling stat write\n");
+        p->rc.bStatWrite = 0;
+    }
+
     if (!p->rc.bStatWrite && !p->rc.bStatRead && (p->analysisMultiPassRefine || p->analysisMultiPassDistortion))
     {
         x265_log(p, X265_LOG_WARNING, "analysis-multi-pass/distortion is enabled only when rc multi pass is enabled. Disabling multi-pass-opt-analysis and multi-pass-opt-distortion");
@@ -3999,6 +4212,16 @@ void Encoder::configure(x265_param *p)
         x265_log(p, X265_LOG_WARNING, "maxSlices can not be more than min(rows, MAX_NAL_UNITS-1), force set to %d\n", slicesLimit);
         p->maxSlices = slicesLimit;
     }
+    if (p->bSkipNonRefFilter && (p->bEnablePsnr || p->bEnableSsim || p->bVmafFeatures || p->decodedPictureHashSEI))
+    {
+        x265_log(p, X265_LOG_WARNING, "skip-nonref-filter is not compatible with PSNR, SSIM, VMAF features or picture hash, disabling\n");
+        p->bSkipNonRefFilter = 0;
+    }
+    if (p->bHpelPlanes && p->maxSlices > 1)
+    {
+        x265_log(p, X265_LOG_WARNING, "hpel-planes is not supported with multiple slices, disabling\n");
+        p->bHpelPlanes = 0;
+    }
     if (p->bHDROpt)
     {
         if (p->internalCsp != X265_CSP_I420 || p->internalBitDepth != 10 || p->vui.colorPrimaries != 9 ||
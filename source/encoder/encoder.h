@@ -32,6 +32,7 @@
 #include "nal.h"
 #include "framedata.h"
 #include "svt.h"
+#include "vmaffeatures.h"
 #ifdef ENABLE_HDR10_PLUS
     #include "dynamicHDR10/hdr10plus.h"
 #endif
@@ -160,6 +161,7 @@ class FrameEncoder;
 class DPB;
 class Lookahead;
 class RateControl;
+class CUPredictor;
 class ThreadPool;
 class FrameData;
 
@@ -178,6 +180,15 @@ public:
     int64_t            m_bframeDelayTime;
     int64_t            m_prevReorderedPts[2];
     int64_t            m_encodeStartTime;
+    int64_t            m_hpelPlaneBytes;        // half-pel plane memory of one reference frame
+    int                m_hpelPlanePeakFrames;   // most reference frames holding half-pel planes at once
+    VmafMotion         m_vmafMotion;            // motion feature of the input pictures, in display order
+    double             m_vmafVifSum[VmafFeatureSums::NUM_SCALES]; // frame features summed over the encode
+    double             m_vmafAdmSum;
+    double             m_vmafMotionSum;
+    uint64_t           m_saoSkippedCTUs;   // CTUs of inter frames which coded SAO off as they copy a filtered reference
+    uint64_t           m_saoInterCTUs;
+    uint64_t           m_borderBytesSaved; // recon margins left unwritten, see FrameFilter::setBorderExtension()
 
     int                m_pocLast;         // time index (POC)
     int                m_encodedFrameNum;
@@ -205,6 +216,7 @@ public:
     x265_param*        m_param;
     x265_param*        m_latestParam;     // Holds latest param during a reconfigure
     RateControl*       m_rateControl;
+    CUPredictor*       m_cuPredictor;
     Lookahead*         m_lookahead;
     AdaptiveFrameDuplication* m_dupBuffer[DUP_BUFFER];      // picture buffer of size 2
     /*Frame duplication: Two pictures used to compute PSNR */
@@ -228,6 +228,19 @@ Entropy::Entropy()
     m_pad = 0;
     m_meanQP = 0;
     X265_CHECK(sizeof(m_contextState) >= sizeof(m_contextState[0]) * MAX_OFF_CTX_MOD, "context state table is too small\n");
+    X265_CHECK(sizeof(m_contextState) <= sizeof(uint64_t) * sizeof(m_ctxDirty) * CHAR_BIT, "context state table exceeds the dirty mask\n");
+
+    /* generations of each coder start in their own range so that a stale
+     * state can never be mistaken for one of a coder built at the same address */
+    static int s_ctxEpoch;
+    m_ctxGen = (uint64_t)ATOMIC_INC(&s_ctxEpoch) << 32;
+    m_ctxDirty = 0;
+    m_ctxOwner = NULL;
+    m_ctxOwnerGen = 0;
+#if DETAILED_CU_STATS
+    m_ctxCopies = 0;
+    m_ctxBytesCopied = 0;
+#endif
 }
 
 void Entropy::codeVPS(const VPS& vps)
@@ -1346,6 +1359,9 @@ void Entropy::resetEntropy(const Slice& slice)
     initBuffer(&m_contextState[OFF_SAO_TYPE_IDX_CTX], sliceType, qp, (uint8_t*)INIT_SAO_TYPE_IDX, NUM_SAO_TYPE_IDX_CTX);
     initBuffer(&m_contextState[OFF_TRANSFORMSKIP_FLAG_CTX], sliceType, qp, (uint8_t*)INIT_TRANSFORMSKIP_FLAG, 2 * NUM_TRANSFORMSKIP_FLAG_CTX);
     initBuffer(&m_contextState[OFF_TQUANT_BYPASS_FLAG_CTX], sliceType, qp, (uint8_t*)INIT_CU_TRANSQUANT_BYPASS_FLAG, NUM_TQUANT_BYPASS_FLAG_CTX);
+    m_ctxGen++;
+    m_ctxDirty = 0;
+    m_ctxOwner = NULL;
     // new structure
 
     start();
@@ -1504,6 +1520,7 @@ void Entropy::loadIntraDirModeLuma(const Entropy& src)
     X265_CHECK(src.m_valid, "invalid copy source context\n");
     m_fracBits = src.m_fracBits;
     m_contextState[OFF_ADI_CTX] = src.m_contextState[OFF_ADI_CTX];
+    markContexts(OFF_ADI_CTX, 1);
 }
 
 void Entropy::copyFrom(const Entropy& src)
@@ -1511,8 +1528,7 @@ void Entropy::copyFrom(const Entropy& src)
     X265_CHECK(src.m_valid, "invalid copy source context\n");
 
     copyState(src);
-
-    memcpy(m_contextState, src.m_contextState, MAX_OFF_CTX_MOD * sizeof(uint8_t));
+    copyContexts(src);
     markValid();
 }
 
@@ -1586,6 +1602,76 @@ void Entropy::codeMergeIndex(const CUData& cu, uint32_t absPartIdx)
     }
 }
 
+uint32_t Entropy::bitsMergePU(uint32_t mergeIdx, uint32_t numMergeCand) const
+{
+    uint32_t fracBits = sbacGetEntropyBits(m_contextState[OFF_MERGE_FLAG_EXT_CTX], 1);
+
+    if (numMergeCand > 1)
+    {
+        X265_CHECK(mergeIdx < numMergeCand, "mergeIdx out of range\n");
+        fracBits += sbacGetEntropyBits(m_contextState[OFF_MERGE_IDX_EXT_CTX], mergeIdx != 0);
+        if (mergeIdx)
+            fracBits += (mergeIdx - (mergeIdx == numMergeCand - 1)) << 15;
+    }
+
+    return fracToBits(fracBits);
+}
+
+uint32_t Entropy::bitsInterPU(const CUData& cu, uint32_t absPartIdx, uint32_t interDir, const int refIdx[2], const MV mvd[2], const int mvpIdx[2]) const
+{
+    uint8_t refCtx[2] = { m_contextState[OFF_REF_NO_CTX], m_contextState[OFF_REF_NO_CTX + 1] };
+    uint8_t mvdCtx[2] = { m_contextState[OFF_MV_RES_CTX], m_contextState[OFF_MV_RES_CTX + 1] };
+    uint8_t mvpCtx = m_contextState[OFF_MVP_IDX_CTX];
+    uint32_t fracBits = sbacGetEntropyBits(m_contextState[OFF_MERGE_FLAG_EXT_CTX], 0);
+
+    X265_CHECK(interDir >= 1 && interDir <= 3, "invalid interDir\n");
+    if (cu.m_slice->isInterB())
+    {
+        if (cu.m_partSize[absPartIdx] == SIZE_2Nx2N || cu.m_log2CUSize[absPartIdx] != 3)
+            fracBits += sbacGetEntropyBits(m_contextState[OFF_INTER_DIR_CTX + cu.m_cuDepth[absPartIdx]], interDir == 3);
+        if (interDir < 3)
+            fracBits += sbacGetEntropyBits(m_contextState[OFF_INTER_DIR_CTX + 4], interDir - 1);
+    }
+
+    for (int list = 0; list < 2; list++)
+    {
+        if (!(interDir & (1 << list)))
+            continue;
+
+        uint32_t numRefIdx = cu.m_slice->m_numRefIdx[list];
+        uint32_t ref = refIdx[list];
+        if (numRefIdx > 1)
+        {
+            fracBits += fracBitsBin(ref > 0, refCtx[0]);
+            if (ref > 0 && numRefIdx > 2)
+            {
+                fracBits += fracBitsBin(ref > 1, refCtx[1]);
+                if (ref > 1)
+                    fracBits += (ref - 1 - (ref == numRefIdx - 1)) << 15;
+            }
+        }
+
+        const uint32_t horAbs = abs(mvd[list].x);
+        const uint32_t verAbs = abs(mvd[list].y);
+        fracBits += fracBitsBin(horAbs != 0, mvdCtx[0]);
+        fracBits += fracBitsBin(verAbs != 0, mvdCtx[0]);
+        if (horAbs)
+            fracBits += fracBitsBin(horAbs > 1, mvdCtx[1]);
+        if (verAbs)
+            fracBits += fracBitsBin(verAbs > 1, mvdCtx[1]);
+        uint32_t numBins = (horAbs != 0) + (verAbs != 0); /* signs */
+        if (horAbs > 1)
+            numBins += bitsEpExGolomb(horAbs - 2, 1);
+        if (verAbs > 1)
+            numBins += bitsEpExGolomb(verAbs - 2, 1);
+        fracBits += numBins << 15;
+
+        fracBits += fracBitsBin(mvpIdx[list], mvpCtx);
+    }
+
+    return fracToBits(fracBits);
+}
+
 void Entropy::codeIntraDirLumaAng(const CUData& cu, uint32_t absPartIdx, bool isMultiple)
 {
     uint32_t dir[4], j;
@@ -1908,6 +1994,23 @@ void Entropy::codeCoeffNxN(const CUData& cu, const coeff_t* coeff, uint32_t absP
     // code significance flag
     uint8_t * const baseCoeffGroupCtx = &m_contextState[OFF_SIG_CG_FLAG_CTX + (bIsLuma ? 0 : NUM_SIG_CG_FLAG_CTX)];
     uint8_t * const baseCtx = bIsLuma ? &m_contextState[OFF_SIG_FLAG_CTX] : &m_contextState[OFF_SIG_FLAG_CTX + NUM_SIG_FLAG_CTX_LUMA];
+
+    /* the fast RD path updates significance and level contexts directly */
+    if (!m_bitIf)
+    {
+        if (bIsLuma)
+        {
+            markContexts(OFF_SIG_FLAG_CTX, NUM_SIG_FLAG_CTX_LUMA);
+            markContexts(OFF_ONE_FLAG_CTX, NUM_ONE_FLAG_CTX_LUMA);
+            markContexts(OFF_ABS_FLAG_CTX, NUM_ABS_FLAG_CTX_LUMA);
+        }
+        else
+        {
+            markContexts(OFF_SIG_FLAG_CTX + NUM_SIG_FLAG_CTX_LUMA, NUM_SIG_FLAG_CTX_CHROMA);
+            markContexts(OFF_ONE_FLAG_CTX + NUM_ONE_FLAG_CTX_LUMA, NUM_ONE_FLAG_CTX_CHROMA);
+            markContexts(OFF_ABS_FLAG_CTX + NUM_ABS_FLAG_CTX_LUMA, NUM_ABS_FLAG_CTX_CHROMA);
+        }
+    }
     uint32_t c1 = 1;
     int scanPosSigOff = scanPosLast - (lastScanSet << MLS_CG_SIZE) - 1;
     ALIGN_VAR_32(uint16_t, absCoeff[(1 << MLS_CG_SIZE) + 1]);   // extra 2 bytes(+1) space for AVX2 assembly, +1 because (numNonZero<=1) in costCoeffNxN path
@@ -2389,10 +2492,69 @@ void Entropy::copyContextsFrom(const Entropy& src)
 {
     X265_CHECK(src.m_valid, "invalid copy source context\n");
 
-    memcpy(m_contextState, src.m_contextState, MAX_OFF_CTX_MOD * sizeof(m_contextState[0]));
+    copyContexts(src);
     markValid();
 }
 
+void Entropy::copyContexts(const Entropy& src)
+{
+    /* when both coders derive from a common generation, only the words either
+     * has written since can differ */
+    if ((src.m_ctxOwner == this && src.m_ctxOwnerGen == m_ctxGen) ||
+        (m_ctxOwner == &src && m_ctxOwnerGen == src.m_ctxGen) ||
+        (m_ctxOwner && m_ctxOwner == src.m_ctxOwner && m_ctxOwnerGen == src.m_ctxOwnerGen))
+    {
+        copyContextWords(src, m_ctxDirty | src.m_ctxDirty);
+        m_ctxDirty = src.m_ctxDirty;
+    }
+    else
+    {
+        copyContextWords(src, ~0u);
+        m_ctxGen++;
+        m_ctxDirty = 0;
+        if (src.m_ctxDirty)
+            m_ctxOwner = NULL;
+        else if (src.m_ctxOwner)
+        {
+            m_ctxOwner = src.m_ctxOwner;
+            m_ctxOwnerGen = src.m_ctxOwnerGen;
+        }
+        else
+        {
+            m_ctxOwner = &src;
+            m_ctxOwnerGen = src.m_ctxGen;
+        }
+    }
+    X265_CHECK(!memcmp(m_contextState, src.m_contextState, MAX_OFF_CTX_MOD), "incremental context copy mismatch\n");
+}
+
+void Entropy::copyContextWords(const Entropy& src, uint32_t words)
+{
+    if (words == ~0u)
+    {
+        memcpy(m_contextState, src.m_contextState, sizeof(m_contextState));
+#if DETAILED_CU_STATS
+        m_ctxCopies++;
+        m_ctxBytesCopied += sizeof(m_contextState);
+#endif
+        return;
+    }
+
+#if DETAILED_CU_STATS
+    m_ctxCopies++;
+#endif
+    while (words)
+    {
+        unsigned long idx;
+        CTZ(idx, words);
+        words &= words - 1;
+        memcpy(&m_contextState[idx * sizeof(uint64_t)], &src.m_contextState[idx * sizeof(uint64_t)], sizeof(uint64_t));
+#if DETAILED_CU_STATS
+        m_ctxBytesCopied += sizeof(uint64_t);
+#endif
+    }
+}
+
 void Entropy::start()
 {
     m_low = 0;
@@ -2455,6 +2617,9 @@ void Entropy::encodeBin(uint32_t binValue, uint8_t &ctxModel)
 {
     uint32_t mstate = ctxModel;
 
+    X265_CHECK(&ctxModel >= m_contextState && &ctxModel < m_contextState + MAX_OFF_CTX_MOD, "context model out of range\n");
+    m_ctxDirty |= 1u << ((uint32_t)(&ctxModel - m_contextState) >> 3);
+
     ctxModel = sbacNext(mstate, binValue);
 
     if (!m_bitIf)
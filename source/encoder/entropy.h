@@ -113,6 +113,21 @@ public:
     EstBitsSbac   m_estBitsSbac;
     double        m_meanQP;
 
+    /* Incremental context copies. m_ctxDirty has a bit for each 8-byte word of
+     * m_contextState written since generation m_ctxGen of these contexts. When
+     * m_ctxOwner is set, generation m_ctxGen equals generation m_ctxOwnerGen of
+     * m_ctxOwner. Two coders related through a common generation differ only in
+     * the words either has written since, and only those are copied */
+    const Entropy* m_ctxOwner;
+    uint64_t      m_ctxOwnerGen;
+    uint64_t      m_ctxGen;
+    uint32_t      m_ctxDirty;
+
+#if DETAILED_CU_STATS
+    uint64_t      m_ctxCopies;        // context copies into this coder
+    uint64_t      m_ctxBytesCopied;   // context bytes copied into this coder
+#endif
+
     Entropy();
 
     void setBitstream(Bitstream* p)    { m_bitIf = p; }
@@ -203,6 +218,12 @@ public:
                bitsCodeBin(1, m_contextState[OFF_PRED_MODE_CTX]); /* intra */
     }
 
+    /* Return bit counts of signaling the prediction info of one inter PU, as
+     * codePUWise would code it, without coding. Bins which share a context are
+     * estimated against a local copy of its state, so the counts match coding */
+    uint32_t bitsMergePU(uint32_t mergeIdx, uint32_t numMergeCand) const;
+    uint32_t bitsInterPU(const CUData& cu, uint32_t absPartIdx, uint32_t interDir, const int refIdx[2], const MV mvd[2], const int mvpIdx[2]) const;
+
     /* these functions are only used to estimate the bits when cbf is 0 and will never be called when writing the bistream. */
     inline void codeQtRootCbfZero() { encodeBin(0, m_contextState[OFF_QT_ROOT_CBF_CTX]); }
 
@@ -224,6 +245,30 @@ private:
         return (uint32_t)(fracBits >> 15);
     }
 
+    /* return the bits of fractional bit count fracBits */
+    inline uint32_t fracToBits(uint32_t fracBits) const { return (uint32_t)(((m_fracBits & 32767) + fracBits) >> 15); }
+
+    /* return the fractional bits of a context bin, updating a copy of its state */
+    static inline uint32_t fracBitsBin(uint32_t binValue, uint8_t& ctxModel)
+    {
+        uint32_t fracBits = sbacGetEntropyBits(ctxModel, binValue);
+        ctxModel = sbacNext(ctxModel, binValue);
+        return fracBits;
+    }
+
+    /* return the number of bypass bins writeEpExGolomb codes */
+    static inline uint32_t bitsEpExGolomb(uint32_t symbol, uint32_t count)
+    {
+        uint32_t numBins = 1;
+        while (symbol >= (uint32_t)(1 << count))
+        {
+            numBins++;
+            symbol -= 1 << count;
+            count++;
+        }
+        return numBins + count;
+    }
+
     void encodeCU(const CUData& ctu, const CUGeom &cuGeom, uint32_t absPartIdx, uint32_t depth, bool& bEncodeDQP);
     void finishCU(const CUData& ctu, uint32_t absPartIdx, uint32_t depth, bool bEncodeDQP);
 
@@ -255,6 +300,13 @@ private:
 
     void copyFrom(const Entropy& src);
     void copyContextsFrom(const Entropy& src);
+    void copyContextWords(const Entropy& src, uint32_t words);
+    void copyContexts(const Entropy& src);
+
+    inline void markContexts(uint32_t offset, uint32_t num)
+    {
+        m_ctxDirty |= (2u << ((offset + num - 1) >> 3)) - (1u << (offset >> 3));
+    }
 };
 }
 
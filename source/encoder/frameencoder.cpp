@@ -45,6 +45,7 @@ FrameEncoder::FrameEncoder()
     m_isFrameEncoder = true;
     m_threadActive = true;
     m_slicetypeWaitTime = 0;
+    m_rateControlStartTime = 0;
     m_activeWorkerCount = 0;
     m_completionCount = 0;
     m_bAllRowsStop = false;
@@ -161,8 +162,8 @@ bool FrameEncoder::init(Encoder *top, int numRows, int numCols)
     range += 2 + (MotionEstimate::hpelIterationCount(m_param->subpelRefine) + 1) / 2; /* subpel refine steps */
     m_refLagRows = /*(m_param->maxSlices > 1 ? 1 : 0) +*/ 1 + ((range + m_param->maxCUSize - 1) / m_param->maxCUSize);
 
-    // NOTE: 2 times of numRows because both Encoder and Filter in same queue
-    if (!WaveFront::init(m_numRows * 2))
+    // NOTE: 4 times of numRows because Encoder, Filter and up to two metrics lanes in same queue
+    if (!WaveFront::init(m_numRows * 4))
     {
         x265_log(m_param, X265_LOG_ERROR, "unable to initialize wavefront queue\n");
         m_pool = NULL;
@@ -446,6 +447,7 @@ void FrameEncoder::compressFrame()
     m_SSDY = m_SSDU = m_SSDV = 0;
     m_ssim = 0;
     m_ssimCnt = 0;
+    m_vmafSums.clear();
     memset(&(m_frame->m_encData->m_frameStats), 0, sizeof(m_frame->m_encData->m_frameStats));
 
     /* Emit access unit delimiter unless this is the first frame and the user is
@@ -453,6 +455,11 @@ void FrameEncoder::compressFrame()
      * unit) */
     Slice* slice = m_frame->m_encData->m_slice;
 
+    /* this thread runs on the NUMA node of our pool, so a newly allocated recon
+     * is first touched, and its pages placed, where it will be written */
+    if (!m_frame->m_encData->m_bReconCleared)
+        m_frame->clearRecon(*slice->m_sps);
+
     if (m_param->bEnableAccessUnitDelimiters && (m_frame->m_poc || m_param->bRepeatHeaders))
     {
         m_bs.resetBits();
@@ -539,6 +546,12 @@ void FrameEncoder::compressFrame()
                 w = slice->m_weightPredTable[l][ref];
             slice->m_refReconPicList[l][ref] = slice->m_refFrameList[l][ref]->m_reconPic;
             m_mref[l][ref].init(slice->m_refReconPicList[l][ref], w, *m_param);
+
+            /* the precomputed half-pel planes interpolate unweighted luma */
+            FrameData& refData = *slice->m_refFrameList[l][ref]->m_encData;
+            bool bHpel = refData.m_hpelPlane[0] && m_mref[l][ref].fpelPlane[0] == refData.m_reconPic->m_picOrg[0];
+            for (int i = 0; i < 3; i++)
+                m_mref[l][ref].hpelPlane[i] = bHpel ? refData.m_hpelPlane[i] : NULL;
         }
         if (m_param->analysisSave && (bUseWeightP || bUseWeightB))
         {
@@ -556,7 +569,9 @@ void FrameEncoder::compressFrame()
 
     /* Get the QP for this frame from rate control. This call may block until
      * frames ahead of it in encode order have called rateControlEnd() */
+    int64_t rcStartTime = x265_mdate();
     int qp = m_top->m_rateControl->rateControlStart(m_frame, &m_rce, m_top);
+    m_rateControlStartTime = x265_mdate() - rcStartTime;
     m_rce.newQp = qp;
 
     if (m_nr)
@@ -782,8 +797,9 @@ void FrameEncoder::compressFrame()
      * tune RateControl parameters for other frames.
      * Hence, for these modes, update m_startEndOrder and unlock RC for previous threads waiting in
      * RateControlEnd here, after the slice contexts are initialized. For the rest - ABR
-     * and VBV, unlock only after rateControlUpdateStats of this frame is called */
-    if (m_param->rc.rateControlMode != X265_RC_ABR && !m_top->m_rateControl->m_isVbv)
+     * and VBV, unlock only after rateControlUpdateStats of this frame is called, unless
+     * rate control is speculative and folds those statistics in whenever they arrive */
+    if ((m_param->rc.rateControlMode != X265_RC_ABR && !m_top->m_rateControl->m_isVbv) || m_param->bSpeculativeRC)
     {
         m_top->m_rateControl->m_startEndOrder.incr();
 
@@ -1142,6 +1158,48 @@ void FrameEncoder::compressFrame()
         }
     }
 
+    if (m_top->m_cuPredictor)
+    {
+        for (int i = 0; i < numTLD; i++)
+        {
+            m_cuPredStats.accumulate(m_tld[i].analysis.m_cuPredStats[m_jpId]);
+            m_tld[i].analysis.m_cuPredStats[m_jpId].clear();
+        }
+    }
+
+    if (m_param->bLowresMVConfidence)
+    {
+        m_lowresMVFrameStats.clear();
+        for (int i = 0; i < numTLD; i++)
+        {
+            m_lowresMVFrameStats.accumulate(m_tld[i].analysis.m_lowresMVStats[m_jpId]);
+            m_tld[i].analysis.m_lowresMVStats[m_jpId].clear();
+        }
+        m_lowresMVStats.accumulate(m_lowresMVFrameStats);
+    }
+
+    if (m_param->subpelCacheSize)
+    {
+        for (int i = 0; i < numTLD; i++)
+        {
+            SubpelCache* cache = m_tld[i].analysis.m_subpelCache;
+            if (cache)
+            {
+                m_subpelCacheStats.accumulate(cache->m_stats[m_jpId]);
+                cache->m_stats[m_jpId].clear();
+            }
+        }
+    }
+
+    if (m_param->bRateEstimateCheck)
+    {
+        for (int i = 0; i < numTLD; i++)
+        {
+            m_rateEstStats.accumulate(m_tld[i].analysis.m_rateEstStats[m_jpId]);
+            m_tld[i].analysis.m_rateEstStats[m_jpId].clear();
+        }
+    }
+
 #if DETAILED_CU_STATS
     /* Accumulate CU statistics from each worker thread, we could report
      * per-frame stats here, but currently we do not. */
@@ -1153,74 +1211,49 @@ void FrameEncoder::compressFrame()
 }
 
 void FrameEncoder::initDecodedPictureHashSEI(int row, int cuAddr, int height)
+{
+    int numPlanes = m_param->internalCsp != X265_CSP_I400 ? 3 : 1;
+    for (int plane = 0; plane < numPlanes; plane++)
+        updateDecodedPictureHash(plane, row, cuAddr, height);
+}
+
+/* The hash of each plane is independent of the others, rows of a plane must be
+ * given in order */
+void FrameEncoder::updateDecodedPictureHash(int plane, int row, int cuAddr, int height)
 {
     PicYuv *reconPic = m_frame->m_reconPic;
-    uint32_t width = reconPic->m_picWidth;	
+    uint32_t width = reconPic->m_picWidth;
     intptr_t stride = reconPic->m_stride;
     uint32_t maxCUHeight = m_param->maxCUSize;
 
-    const uint32_t hChromaShift = CHROMA_H_SHIFT(m_param->internalCsp);
-    const uint32_t vChromaShift = CHROMA_V_SHIFT(m_param->internalCsp);
+    if (plane)
+    {
+        width >>= CHROMA_H_SHIFT(m_param->internalCsp);
+        height >>= CHROMA_V_SHIFT(m_param->internalCsp);
+        stride = reconPic->m_strideC;
+        maxCUHeight >>= CHROMA_V_SHIFT(m_param->internalCsp);
+    }
 
     if (m_param->decodedPictureHashSEI == 1)
     {
         if (!row)
-            MD5Init(&m_seiReconPictureDigest.m_state[0]);
-
-        updateMD5Plane(m_seiReconPictureDigest.m_state[0], reconPic->getLumaAddr(cuAddr), width, height, stride);
-        if (m_param->internalCsp != X265_CSP_I400)
-        {
-            if (!row)
-            {
-                MD5Init(&m_seiReconPictureDigest.m_state[1]);
-                MD5Init(&m_seiReconPictureDigest.m_state[2]);
-            }
-
-            width >>= hChromaShift;
-            height >>= vChromaShift;
-            stride = reconPic->m_strideC;
+            MD5Init(&m_seiReconPictureDigest.m_state[plane]);
 
-            updateMD5Plane(m_seiReconPictureDigest.m_state[1], reconPic->getCbAddr(cuAddr), width, height, stride);
-            updateMD5Plane(m_seiReconPictureDigest.m_state[2], reconPic->getCrAddr(cuAddr), width, height, stride);
-        }
+        updateMD5Plane(m_seiReconPictureDigest.m_state[plane], reconPic->getPlaneAddr(plane, cuAddr), width, height, stride);
     }
     else if (m_param->decodedPictureHashSEI == 2)
     {
-
         if (!row)
-            m_seiReconPictureDigest.m_crc[0] = 0xffff;
-
-        updateCRC(reconPic->getLumaAddr(cuAddr), m_seiReconPictureDigest.m_crc[0], height, width, stride);
-        if (m_param->internalCsp != X265_CSP_I400)
-        {
-            width >>= hChromaShift;
-            height >>= vChromaShift;
-            stride = reconPic->m_strideC;
-            m_seiReconPictureDigest.m_crc[1] = m_seiReconPictureDigest.m_crc[2] = 0xffff;
+            m_seiReconPictureDigest.m_crc[plane] = 0xffff;
 
-            updateCRC(reconPic->getCbAddr(cuAddr), m_seiReconPictureDigest.m_crc[1], height, width, stride);
-            updateCRC(reconPic->getCrAddr(cuAddr), m_seiReconPictureDigest.m_crc[2], height, width, stride);
-        }
+        updateCRC(reconPic->getPlaneAddr(plane, cuAddr), m_seiReconPictureDigest.m_crc[plane], height, width, stride);
     }
     else if (m_param->decodedPictureHashSEI == 3)
     {
         if (!row)
-            m_seiReconPictureDigest.m_checksum[0] = 0;
-
-        updateChecksum(reconPic->m_picOrg[0], m_seiReconPictureDigest.m_checksum[0], height, width, stride, row, maxCUHeight);
-        if (m_param->internalCsp != X265_CSP_I400)
-        {
-            width >>= hChromaShift;
-            height >>= vChromaShift;
-            stride = reconPic->m_strideC;
-            maxCUHeight >>= vChromaShift;
-
-            if (!row)
-                m_seiReconPictureDigest.m_checksum[1] = m_seiReconPictureDigest.m_checksum[2] = 0;
+            m_seiReconPictureDigest.m_checksum[plane] = 0;
 
-            updateChecksum(reconPic->m_picOrg[1], m_seiReconPictureDigest.m_checksum[1], height, width, stride, row, maxCUHeight);
-            updateChecksum(reconPic->m_picOrg[2], m_seiReconPictureDigest.m_checksum[2], height, width, stride, row, maxCUHeight);
-        }
+        updateChecksum(reconPic->m_picOrg[plane], m_seiReconPictureDigest.m_checksum[plane], height, width, stride, row, maxCUHeight);
     }
 }
 
@@ -1304,18 +1337,23 @@ void FrameEncoder::processRow(int row, int threadId)
     if (ATOMIC_INC(&m_activeWorkerCount) == 1 && m_stallStartTime)
         m_totalNoWorkerTime += x265_mdate() - m_stallStartTime;
 
-    const uint32_t realRow = m_idx_to_row[row >> 1];
-    const uint32_t typeNum = m_idx_to_row[row & 1];
-
-    if (!typeNum)
-        processRowEncoder(realRow, m_tld[threadId]);
+    if (row >= 2 * (int)m_numRows)
+        m_frameFilter.processMetricsRow(row - 2 * m_numRows);
     else
     {
-        m_frameFilter.processRow(realRow);
+        const uint32_t realRow = m_idx_to_row[row >> 1];
+        const uint32_t typeNum = m_idx_to_row[row & 1];
+
+        if (!typeNum)
+            processRowEncoder(realRow, m_tld[threadId]);
+        else
+        {
+            m_frameFilter.processRow(realRow);
 
-        // NOTE: Active next row
-        if (realRow != m_sliceBaseRow[m_rows[realRow].sliceId + 1] - 1)
-            enqueueRowFilter(m_row_to_idx[realRow + 1]);
+            // NOTE: Active next row
+            if (realRow != m_sliceBaseRow[m_rows[realRow].sliceId + 1] - 1)
+                enqueueRowFilter(m_row_to_idx[realRow + 1]);
+        }
     }
 
     if (ATOMIC_DEC(&m_activeWorkerCount) == 0)
@@ -1430,6 +1468,8 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
         }
     }
 
+    tld.analysis.m_cuPredictor = m_top->m_cuPredictor;
+
     // Initialize restrict on MV range in slices
     tld.analysis.m_sliceMinY = -(int32_t)(rowInSlice * m_param->maxCUSize * 4) + 3 * 4;
     tld.analysis.m_sliceMaxY = (int32_t)((endRowInSlicePlus1 - 1 - row) * (m_param->maxCUSize * 4) - 4 * 4);
@@ -133,6 +133,10 @@ public:
     Frame *getEncodedPicture(NALList& list);
 
     void initDecodedPictureHashSEI(int row, int cuAddr, int height);
+    void updateDecodedPictureHash(int plane, int row, int cuAddr, int height);
+
+    /* metrics jobs follow all encoder and filter jobs, at the lowest priority */
+    void enqueueRowMetrics(int job) { WaveFront::enableRow(m_numRows * 2 + job); WaveFront::enqueueRow(m_numRows * 2 + job); }
 
     Event                    m_enable;
     Event                    m_done;
@@ -167,6 +171,7 @@ public:
     double                   m_ssim;
     uint64_t                 m_accessUnitBits;
     uint32_t                 m_ssimCnt;
+    VmafFeatureSums          m_vmafSums;
 
     volatile int             m_activeWorkerCount;        // count of workers currently encoding or filtering CTUs
     volatile int             m_totalActiveWorkerCount;   // sum of m_activeWorkerCount sampled at end of each CTU
@@ -182,6 +187,12 @@ public:
     int64_t                  m_slicetypeWaitTime;        // total elapsed time waiting for decided frame
     int64_t                  m_totalWorkerElapsedTime;   // total elapsed time spent by worker threads processing CTUs
     int64_t                  m_totalNoWorkerTime;        // total elapsed time without any active worker threads
+    int64_t                  m_rateControlStartTime;     // elapsed time in rateControlStart(), including waits for earlier frames
+    CUPredictorStats         m_cuPredStats;              // CU predictor decisions of all frames encoded here
+    LowresMVStats            m_lowresMVFrameStats;       // lowres MV confidence of the last frame encoded here
+    LowresMVStats            m_lowresMVStats;            // lowres MV confidence of all frames encoded here
+    SubpelCacheStats         m_subpelCacheStats;         // sub-pel cache use of all frames encoded here
+    RateEstStats             m_rateEstStats;             // rate estimation errors of all frames encoded here
 #if DETAILED_CU_STATS
     CUStats                  m_cuStats;
 #endif
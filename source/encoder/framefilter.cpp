@@ -159,6 +159,9 @@ namespace X265_NS
 void FrameFilter::destroy()
 {
     X265_FREE(m_ssimBuf);
+    m_vmafFeatures.destroy();
+    X265_FREE(m_metricDeps);
+    X265_FREE(m_metricRowsDone);
 
     if (m_parallelFilter)
     {
@@ -178,6 +181,7 @@ void FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t
     m_param = frame->m_param;
     m_frameEncoder = frame;
     m_useSao = 1;
+    m_bFilterRecon = true;
     m_numRows = numRows;
     m_numCols = numCols;
     m_hChromaShift = CHROMA_H_SHIFT(m_param->internalCsp);
@@ -191,6 +195,23 @@ void FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t
 
     if (m_param->bEnableSsim)
         m_ssimBuf = X265_MALLOC(int, 8 * (m_param->sourceWidth / 4 + 3));
+    if (m_param->bVmafFeatures)
+    {
+        m_bVmafFeatures = m_vmafFeatures.create(m_param->sourceWidth, m_param->maxCUSize);
+        if (!m_bVmafFeatures)
+            x265_log(m_param, X265_LOG_ERROR, "Failed to allocate memory for the VMAF feature buffers, VMAF features disabled\n");
+    }
+
+    m_bAsyncMetrics = m_param->bEnableWavefront && frame->m_pool &&
+                      (m_param->bEnablePsnr || m_param->bEnableSsim || m_bVmafFeatures || (m_param->decodedPictureHashSEI && m_param->maxSlices == 1));
+    if (m_bAsyncMetrics)
+    {
+        if (m_param->bParallelHash && m_param->decodedPictureHashSEI && m_param->maxSlices == 1 && m_param->internalCsp != X265_CSP_I400)
+            m_metricLanes = 2;
+        m_metricDeps = X265_MALLOC(int, numRows * m_metricLanes);
+        m_metricRowsDone = X265_MALLOC(int, numRows);
+        m_bAsyncMetrics = m_metricDeps && m_metricRowsDone;
+    }
 
     m_parallelFilter = new ParallelFilter[numRows];
 
@@ -226,9 +247,39 @@ void FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t
 
 }
 
+/* Motion compensation reads no further outside the picture than a block moved
+ * by the largest vector CUData::clipMv() permits, plus a half-pel step and the
+ * interpolation taps, which is maxCUSize + 11 luma samples; the extension is
+ * rounded up to maxCUSize + 16. The horizontal margins are wider than that for
+ * alignment, so only this much of them is extended, unless SEA integrates the
+ * whole margin. Pictures which are never referenced are not extended at all */
+void FrameFilter::setBorderExtension(const PicYuv* reconPic)
+{
+    const bool bChroma = m_param->internalCsp != X265_CSP_I400;
+    const int reach = m_param->maxCUSize + 16;
+    const int marginX[2] = { (int)reconPic->m_lumaMarginX, (int)reconPic->m_chromaMarginX };
+    const int marginY[2] = { (int)reconPic->m_lumaMarginY, (int)reconPic->m_chromaMarginY };
+    const uint32_t width[2] = { reconPic->m_picWidth, reconPic->m_picWidth >> m_hChromaShift };
+    const uint32_t height[2] = { reconPic->m_picHeight, reconPic->m_picHeight >> m_vChromaShift };
+
+    m_bExtendBorder = IS_REFERENCED(m_frame);
+    m_extendX[0] = m_param->searchMethod == X265_SEA ? marginX[0] : X265_MIN(reach, marginX[0]);
+    m_extendX[1] = m_param->searchMethod == X265_SEA ? marginX[1] : X265_MIN(reach >> m_hChromaShift, marginX[1]);
+
+    m_borderBytesSaved = 0;
+    for (int plane = 0; plane < (bChroma ? 3 : 1); plane++)
+    {
+        int c = !!plane;
+        uint64_t full = 2 * ((uint64_t)marginX[c] * height[c] + (uint64_t)marginY[c] * (width[c] + 2 * marginX[c]));
+        uint64_t extended = 2 * ((uint64_t)m_extendX[c] * height[c] + (uint64_t)marginY[c] * (width[c] + 2 * m_extendX[c]));
+        m_borderBytesSaved += (full - (m_bExtendBorder ? extended : 0)) * sizeof(pixel);
+    }
+}
+
 void FrameFilter::start(Frame *frame, Entropy& initState)
 {
     m_frame = frame;
+    setBorderExtension(frame->m_reconPic);
 
     // Reset Filter Data Struct
     if (m_parallelFilter)
@@ -248,6 +299,15 @@ void FrameFilter::start(Frame *frame, Entropy& initState)
         if (m_useSao)
             m_parallelFilter[0].m_sao.resetStats();
     }
+
+    if (m_bAsyncMetrics)
+    {
+        /* the first row of a lane has no row above to wait for */
+        memset(m_metricDeps, 0, sizeof(int) * m_numRows * m_metricLanes);
+        memset(m_metricRowsDone, 0, sizeof(int) * m_numRows);
+        for (int lane = 0; lane < m_metricLanes; lane++)
+            m_metricDeps[lane * m_numRows] = 1;
+    }
 }
 
 /* restore original YUV samples to recon after SAO (if lossless) */
@@ -348,18 +408,20 @@ void FrameFilter::ParallelFilter::processPostCu(int col) const
     // Update finished CU cursor
     m_frameFilter->m_frame->m_reconColCount[m_row].set(col);
 
-    // shortcut path for non-border area
+    // shortcut path for non-border area, and pictures which are never referenced
     if ((col != 0) & (col != m_frameFilter->m_numCols - 1) & (m_row != 0) & (m_row != m_frameFilter->m_numRows - 1))
         return;
+    if (!m_frameFilter->m_bExtendBorder)
+        return;
 
     PicYuv *reconPic = m_frameFilter->m_frame->m_reconPic;
     const uint32_t lineStartCUAddr = m_rowAddr + col;
     const int realH = getCUHeight();
     const int realW = m_frameFilter->getCUWidth(col);
 
-    const uint32_t lumaMarginX = reconPic->m_lumaMarginX;
+    const uint32_t lumaMarginX = m_frameFilter->m_extendX[0];
     const uint32_t lumaMarginY = reconPic->m_lumaMarginY;
-    const uint32_t chromaMarginX = reconPic->m_chromaMarginX;
+    const uint32_t chromaMarginX = m_frameFilter->m_extendX[1];
     const uint32_t chromaMarginY = reconPic->m_chromaMarginY;
     const int hChromaShift = reconPic->m_hChromaShift;
     const int vChromaShift = reconPic->m_vChromaShift;
@@ -375,12 +437,12 @@ void FrameFilter::ParallelFilter::processPostCu(int col) const
     if ((col == 0) | (col == m_frameFilter->m_numCols - 1))
     {
         // TODO: improve by process on Left or Right only
-        primitives.extendRowBorder(reconPic->getLumaAddr(m_rowAddr), stride, reconPic->m_picWidth, realH, reconPic->m_lumaMarginX);
+        primitives.extendRowBorder(reconPic->getLumaAddr(m_rowAddr), stride, reconPic->m_picWidth, realH, lumaMarginX);
 
         if (m_frameFilter->m_param->internalCsp != X265_CSP_I400)
         {
-            primitives.extendRowBorder(reconPic->getCbAddr(m_rowAddr), strideC, reconPic->m_picWidth >> hChromaShift, realH >> vChromaShift, reconPic->m_chromaMarginX);
-            primitives.extendRowBorder(reconPic->getCrAddr(m_rowAddr), strideC, reconPic->m_picWidth >> hChromaShift, realH >> vChromaShift, reconPic->m_chromaMarginX);
+            primitives.extendRowBorder(reconPic->getCbAddr(m_rowAddr), strideC, reconPic->m_picWidth >> hChromaShift, realH >> vChromaShift, chromaMarginX);
+            primitives.extendRowBorder(reconPic->getCrAddr(m_rowAddr), strideC, reconPic->m_picWidth >> hChromaShift, realH >> vChromaShift, chromaMarginX);
         }
     }
 
@@ -459,9 +521,11 @@ void FrameFilter::ParallelFilter::processTasks(int /*workerThreadId*/)
         const uint32_t cuAddr = m_rowAddr + col;
         const CUData* ctu = m_encData->getPicCTU(cuAddr);
 
-        if (m_frameFilter->m_param->bEnableLoopFilter)
+        if (m_frameFilter->m_param->bEnableLoopFilter & m_frameFilter->m_bFilterRecon)
         {
-            deblockCTU(ctu, cuGeoms[ctuGeomMap[cuAddr]], Deblock::EDGE_VER);
+            // boundary strengths of both directions, kept until the horizontal pass of the next column
+            setEdgeMap(ctu, cuGeoms[ctuGeomMap[cuAddr]], m_edgeMap[col & 1]);
+            deblockCTU(ctu, m_edgeMap[col & 1], Deblock::EDGE_VER);
         }
 
         if (col >= 1)
@@ -469,7 +533,8 @@ void FrameFilter::ParallelFilter::processTasks(int /*workerThreadId*/)
             const CUData* ctuPrev = m_encData->getPicCTU(cuAddr - 1);
             if (m_frameFilter->m_param->bEnableLoopFilter)
             {
-                deblockCTU(ctuPrev, cuGeoms[ctuGeomMap[cuAddr - 1]], Deblock::EDGE_HOR);
+                if (m_frameFilter->m_bFilterRecon)
+                    deblockCTU(ctuPrev, m_edgeMap[(col - 1) & 1], Deblock::EDGE_HOR);
 
                 // When SAO Disable, setting column counter here
                 if (!m_frameFilter->m_useSao & !ctuPrev->m_bFirstRowInSlice)
@@ -478,6 +543,9 @@ void FrameFilter::ParallelFilter::processTasks(int /*workerThreadId*/)
 
             if (m_frameFilter->m_useSao)
             {
+                // SAO statistics of the CTU just deblocked
+                m_sao.calcSaoStatsDeblocked(saoParam, col - 1, cuAddr - 1);
+
                 // Save SAO bottom row reference pixels
                 copySaoAboveRef(ctuPrev, reconPic, cuAddr - 1, col - 1);
 
@@ -511,7 +579,8 @@ void FrameFilter::ParallelFilter::processTasks(int /*workerThreadId*/)
 
         if (m_frameFilter->m_param->bEnableLoopFilter)
         {
-            deblockCTU(ctuPrev, cuGeoms[ctuGeomMap[cuAddr]], Deblock::EDGE_HOR);
+            if (m_frameFilter->m_bFilterRecon)
+                deblockCTU(ctuPrev, m_edgeMap[(numCols - 1) & 1], Deblock::EDGE_HOR);
 
             // When SAO Disable, setting column counter here
             if (!m_frameFilter->m_useSao & !ctuPrev->m_bFirstRowInSlice)
@@ -523,6 +592,9 @@ void FrameFilter::ParallelFilter::processTasks(int /*workerThreadId*/)
         {
             const CUData* ctu = m_encData->getPicCTU(m_rowAddr + numCols - 2);
 
+            // SAO statistics of the CTU just deblocked
+            m_sao.calcSaoStatsDeblocked(saoParam, numCols - 1, cuAddr);
+
             // Save SAO bottom row reference pixels
             copySaoAboveRef(ctuPrev, reconPic, cuAddr, numCols - 1);
 
@@ -653,17 +725,70 @@ void FrameFilter::processRow(int row)
 
 void FrameFilter::processPostRow(int row)
 {
-    PicYuv *reconPic = m_frame->m_reconPic;
-    const uint32_t numCols = m_frame->m_encData->m_slice->m_sps->numCuInWidth;
-    const uint32_t lineStartCUAddr = row * numCols;
-
     /* Generate integral planes for SEA motion search */
     if(m_param->searchMethod == X265_SEA)
         computeMEIntegral(row);
+    /* Interpolate half-pel planes for motion search */
+    if (m_frame->m_encData->m_hpelPlane[0])
+        computeHpelPlanes(row);
     // Notify other FrameEncoders that this row of reconstructed pixels is available
     m_frame->m_reconRowFlag[row].set(1);
 
-    uint32_t cuAddr = lineStartCUAddr;
+    if (m_bAsyncMetrics)
+    {
+        for (int lane = 0; lane < m_metricLanes; lane++)
+        {
+            int job = lane * m_numRows + row;
+            if (ATOMIC_INC(&m_metricDeps[job]) == 2)
+                m_frameEncoder->enqueueRowMetrics(job);
+        }
+        return;
+    }
+
+    computeMetrics(row, 0);
+
+    if (ATOMIC_INC(&m_frameEncoder->m_completionCount) == 2 * (int)m_frameEncoder->m_numRows)
+    {
+        m_frameEncoder->m_completionEvent.trigger();
+    }
+}
+
+/* Runs as a frame encoder job once the recon of the row is final and the
+ * row above is done in the same lane, then releases the row below. The row
+ * counts towards frame completion only once every lane is done with it, so
+ * the frame is not output before its metrics are merged */
+void FrameFilter::processMetricsRow(int job)
+{
+    int lane = job / m_numRows;
+    int row = job % m_numRows;
+
+    computeMetrics(row, lane);
+
+    if (row + 1 < m_numRows && ATOMIC_INC(&m_metricDeps[job + 1]) == 2)
+        m_frameEncoder->enqueueRowMetrics(job + 1);
+
+    if (ATOMIC_INC(&m_metricRowsDone[row]) == m_metricLanes &&
+        ATOMIC_INC(&m_frameEncoder->m_completionCount) == 2 * (int)m_frameEncoder->m_numRows)
+    {
+        m_frameEncoder->m_completionEvent.trigger();
+    }
+}
+
+/* Rows must be measured in order; the hash state is sequential and the SSIM
+ * and VMAF feature sums are accumulated in floating point. Lane 1 hashes
+ * luma alone, lane 0 does everything else */
+void FrameFilter::computeMetrics(int row, int lane)
+{
+    PicYuv *reconPic = m_frame->m_reconPic;
+    const uint32_t numCols = m_frame->m_encData->m_slice->m_sps->numCuInWidth;
+    uint32_t cuAddr = row * numCols;
+
+    if (lane)
+    {
+        m_frameEncoder->updateDecodedPictureHash(0, row, cuAddr, m_parallelFilter[row].getCUHeight());
+        return;
+    }
+
     if (m_param->bEnablePsnr)
     {
         PicYuv* fencPic = m_frame->m_fencPic;
@@ -710,15 +835,56 @@ void FrameFilter::processPostRow(int row)
         m_frameEncoder->m_ssimCnt += ssim_cnt;
     }
 
+    if (m_bVmafFeatures)
+    {
+        PicYuv* fencPic = m_frame->m_fencPic;
+        m_vmafFeatures.measureRow(fencPic->getLumaAddr(cuAddr), fencPic->m_stride, reconPic->getLumaAddr(cuAddr), reconPic->m_stride,
+                                  m_param->sourceWidth, m_parallelFilter[row].getCUHeight(), m_frameEncoder->m_vmafSums);
+    }
+
     if (m_param->maxSlices == 1)
     {
         uint32_t height = m_parallelFilter[row].getCUHeight();
-        m_frameEncoder->initDecodedPictureHashSEI(row, cuAddr, height);
+        if (m_metricLanes > 1)
+        {
+            m_frameEncoder->updateDecodedPictureHash(1, row, cuAddr, height);
+            m_frameEncoder->updateDecodedPictureHash(2, row, cuAddr, height);
+        }
+        else
+            m_frameEncoder->initDecodedPictureHashSEI(row, cuAddr, height);
     } // end of (m_param->maxSlices == 1)
+}
 
-    if (ATOMIC_INC(&m_frameEncoder->m_completionCount) == 2 * (int)m_frameEncoder->m_numRows)
+/* Each call interpolates the half-pel rows whose filter taps lie in finished
+ * rows of the extended recon; the last four rows of a CTU row wait for the taps
+ * of the next. Only the extended part of the margins is read, see
+ * setBorderExtension(), which covers every block position permitted by MV
+ * clipping. The last block of a row is moved left to end at the extension */
+void FrameFilter::computeHpelPlanes(int row)
+{
+    const PicYuv* reconPic = m_frame->m_reconPic;
+    pixel* const* hpel = m_frame->m_encData->m_hpelPlane;
+    const intptr_t stride = reconPic->m_stride;
+    const int extendX = m_extendX[0];
+    const int marginY = reconPic->m_lumaMarginY;
+    const int maxCUSize = m_param->maxCUSize;
+    const int numRows = (int)m_frame->m_encData->m_slice->m_sps->numCuInHeight;
+
+    int startY = row ? row * maxCUSize - 4 : 4 - marginY;
+    int endY = row == numRows - 1 ? (int)reconPic->m_picHeight + marginY - 4 : (row + 1) * maxCUSize - 4;
+    int startX = 8 - extendX;
+    int endX = (int)reconPic->m_picWidth + extendX - 8;
+
+    for (int y = startY; y < endY; y += 4)
     {
-        m_frameEncoder->m_completionEvent.trigger();
+        for (int x = startX; x < endX; x += 16)
+        {
+            intptr_t offset = y * stride + X265_MIN(x, endX - 16);
+            const pixel* src = reconPic->m_picOrg[0] + offset;
+            primitives.pu[LUMA_16x4].luma_hpp(src, stride, hpel[0] + offset, stride, 2);
+            primitives.pu[LUMA_16x4].luma_vpp(src, stride, hpel[1] + offset, stride, 2);
+            primitives.pu[LUMA_16x4].luma_hvpp(src, stride, hpel[2] + offset, stride, 2, 2);
+        }
     }
 }
 
@@ -777,14 +943,17 @@ void FrameFilter::computeMEIntegral(int row)
             uint32_t *sum4x16 = m_frame->m_encData->m_meIntegral[10] + (y + 1) * stride - padX;
             uint32_t *sum4x4 = m_frame->m_encData->m_meIntegral[11] + (y + 1) * stride - padX;
 
+            /* Planes of the same width share their horizontal sums, accumulated
+             * down the columns, until initv reduces a row to its vertical window.
+             * The accumulated row is therefore computed once per width and copied */
             /*For width = 32 */
             primitives.integral_inith[INTEGRAL_32](sum32x32, pix, stride);
+            memcpy(sum32x24, sum32x32, (stride - 32) * sizeof(uint32_t));
+            memcpy(sum32x8, sum32x32, (stride - 32) * sizeof(uint32_t));
             if (y >= 32 - padY)
                 primitives.integral_initv[INTEGRAL_32](sum32x32 - 32 * stride, stride);
-            primitives.integral_inith[INTEGRAL_32](sum32x24, pix, stride);
             if (y >= 24 - padY)
                 primitives.integral_initv[INTEGRAL_24](sum32x24 - 24 * stride, stride);
-            primitives.integral_inith[INTEGRAL_32](sum32x8, pix, stride);
             if (y >= 8 - padY)
                 primitives.integral_initv[INTEGRAL_8](sum32x8 - 8 * stride, stride);
             /*For width = 24 */
@@ -793,12 +962,12 @@ void FrameFilter::computeMEIntegral(int row)
                 primitives.integral_initv[INTEGRAL_32](sum24x32 - 32 * stride, stride);
             /*For width = 16 */
             primitives.integral_inith[INTEGRAL_16](sum16x16, pix, stride);
+            memcpy(sum16x12, sum16x16, (stride - 16) * sizeof(uint32_t));
+            memcpy(sum16x4, sum16x16, (stride - 16) * sizeof(uint32_t));
             if (y >= 16 - padY)
                 primitives.integral_initv[INTEGRAL_16](sum16x16 - 16 * stride, stride);
-            primitives.integral_inith[INTEGRAL_16](sum16x12, pix, stride);
             if (y >= 12 - padY)
                 primitives.integral_initv[INTEGRAL_12](sum16x12 - 12 * stride, stride);
-            primitives.integral_inith[INTEGRAL_16](sum16x4, pix, stride);
             if (y >= 4 - padY)
                 primitives.integral_initv[INTEGRAL_4](sum16x4 - 4 * stride, stride);
             /*For width = 12 */
@@ -807,16 +976,16 @@ void FrameFilter::computeMEIntegral(int row)
                 primitives.integral_initv[INTEGRAL_16](sum12x16 - 16 * stride, stride);
             /*For width = 8 */
             primitives.integral_inith[INTEGRAL_8](sum8x32, pix, stride);
+            memcpy(sum8x8, sum8x32, (stride - 8) * sizeof(uint32_t));
             if (y >= 32 - padY)
                 primitives.integral_initv[INTEGRAL_32](sum8x32 - 32 * stride, stride);
-            primitives.integral_inith[INTEGRAL_8](sum8x8, pix, stride);
             if (y >= 8 - padY)
                 primitives.integral_initv[INTEGRAL_8](sum8x8 - 8 * stride, stride);
             /*For width = 4 */
             primitives.integral_inith[INTEGRAL_4](sum4x16, pix, stride);
+            memcpy(sum4x4, sum4x16, (stride - 4) * sizeof(uint32_t));
             if (y >= 16 - padY)
                 primitives.integral_initv[INTEGRAL_16](sum4x16 - 16 * stride, stride);
-            primitives.integral_inith[INTEGRAL_4](sum4x4, pix, stride);
             if (y >= 4 - padY)
                 primitives.integral_initv[INTEGRAL_4](sum4x4 - 4 * stride, stride);
         }
@@ -29,6 +29,7 @@
 #include "frame.h"
 #include "deblock.h"
 #include "sao.h"
+#include "vmaffeatures.h"
 #include "threadpool.h" // class BondedTaskGroup
 
 namespace X265_NS {
@@ -47,6 +48,7 @@ public:
     x265_param*   m_param;
     Frame*        m_frame;
     int           m_useSao;
+    bool          m_bFilterRecon;   /* deblock the recon, false for unreferenced pictures with --skip-nonref-filter */
     FrameEncoder* m_frameEncoder;
     int           m_hChromaShift;
     int           m_vChromaShift;
@@ -57,10 +59,27 @@ public:
     int           m_saoRowDelay;
     int           m_lastHeight;
     int           m_lastWidth;
+
+    bool          m_bExtendBorder;     /* extend the recon into its margins, only for referenced pictures */
+    int           m_extendX[2];        /* luma and chroma samples extended left and right of the picture */
+    uint64_t      m_borderBytesSaved;  /* bytes of margin the current picture leaves unwritten */
     
     ThreadSafeInteger integralCompleted;     /* check if integral calculation is completed in this row */
 
     void*         m_ssimBuf;        /* Temp storage for ssim computation */
+    VmafFeatures  m_vmafFeatures;   /* decimated planes of a row for the VMAF features */
+    bool          m_bVmafFeatures;
+
+    /* With WPP the PSNR, SSIM, VMAF features and picture hash of each finished
+     * row are computed by a low priority job of the frame encoder, rows in
+     * order, off the filter pipeline. With --parallel-hash the luma hash runs in a second
+     * lane of jobs. m_metricDeps counts the two events a row of a lane waits
+     * for: its recon being final and the row above being done in that lane.
+     * m_metricRowsDone counts the lanes done with each row */
+    bool          m_bAsyncMetrics;
+    int           m_metricLanes;
+    int*          m_metricDeps;
+    int*          m_metricRowsDone;
 
 #define MAX_PFILTER_CUS     (4) /* maximum CUs for every thread */
     class ParallelFilter : public Deblock
@@ -76,6 +95,7 @@ public:
         ThreadSafeInteger   m_lastCol;          /* The column that next to process */
         ThreadSafeInteger   m_allowedCol;       /* The column that processed from Encode pipeline */
         ThreadSafeInteger   m_lastDeblocked;   /* The column that finished all of Deblock stages  */
+        EdgeMap             m_edgeMap[2];       /* Edges of the last two deblocked columns */
 
         ParallelFilter()
             : m_rowHeight(0)
@@ -114,6 +134,11 @@ public:
         , m_frame(NULL)
         , m_frameEncoder(NULL)
         , m_ssimBuf(NULL)
+        , m_bVmafFeatures(false)
+        , m_bAsyncMetrics(false)
+        , m_metricLanes(1)
+        , m_metricDeps(NULL)
+        , m_metricRowsDone(NULL)
         , m_parallelFilter(NULL)
     {
     }
@@ -127,10 +152,14 @@ public:
     void destroy();
 
     void start(Frame *pic, Entropy& initState);
+    void setBorderExtension(const PicYuv* reconPic);
 
     void processRow(int row);
     void processPostRow(int row);
+    void processMetricsRow(int job);
+    void computeMetrics(int row, int lane);
     void computeMEIntegral(int row);
+    void computeHpelPlanes(int row);
 };
 }
 
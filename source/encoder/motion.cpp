@@ -111,6 +111,7 @@ MotionEstimate::MotionEstimate()
     blockOffset = 0;
     bChromaSATD = false;
     chromaSatd = NULL;
+    subpelCache = NULL;
     for (int i = 0; i < INTEGRAL_PLANE_NUM; i++)
         integral[i] = NULL;
 }
@@ -176,6 +177,7 @@ void MotionEstimate::setSourcePU(pixel *fencY, intptr_t stride, intptr_t offset,
 
 
     blockwidth = pwidth;
+    blockheight = pheight;
     blockOffset = offset;
     absPartIdx = ctuAddr = -1;
 
@@ -215,6 +217,7 @@ void MotionEstimate::setSourcePU(const Yuv& srcFencYuv, int _ctuAddr, int cuPart
     ctuAddr = _ctuAddr;
     absPartIdx = cuPartIdx + puPartIdx;
     blockwidth = pwidth;
+    blockheight = pheight;
     blockOffset = 0;
 
     /* copy PU from CU Yuv */
@@ -797,19 +800,7 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
 
     X265_CHECK(!(ref->isLowres && numCandidates), "lowres motion candidates not allowed\n")
     // measure SAD cost at each QPEL motion vector candidate
-    for (int i = 0; i < numCandidates; i++)
-    {
-        MV m = mvc[i].clipped(qmvmin, qmvmax);
-        if (m.notZero() & (m != pmv ? 1 : 0) & (m != bestpre ? 1 : 0)) // check already measured
-        {
-            int cost = subpelCompare(ref, m, sad) + mvcost(m);
-            if (cost < bprecost)
-            {
-                bprecost = cost;
-                bestpre = m;
-            }
-        }
-    }
+    bprecost = evaluateCandidates(ref, mvc, numCandidates, qmvmin, qmvmax, bestpre, bprecost);
 
     pmv = pmv.roundToFPel();
     MV omv = bmv;  // current search origin or starting point
@@ -1568,6 +1559,77 @@ me_hex2:
     return bcost;
 }
 
+/* Measure SAD plus MV cost of a list of QPEL candidates, clipped to the search
+ * range. Zero, bmv and repeated candidates are skipped; full-pel candidates
+ * are batched through sad_x4 and sad_x3. Returns the lowest cost, updating bmv
+ * if a candidate is cheaper than bcost. Candidates are compared in list order
+ * so the result matches measuring them one at a time */
+int MotionEstimate::evaluateCandidates(ReferencePlanes* ref, const MV* qmvs, int count, const MV& qmvmin, const MV& qmvmax, MV& bmv, int bcost)
+{
+    ALIGN_VAR_16(int, res[4]);
+    MV  mvs[MAX_BATCH_CANDIDATES];
+    int costs[MAX_BATCH_CANDIDATES];
+    int fpel[MAX_BATCH_CANDIDATES];
+    int numMvs = 0, numFpel = 0;
+
+    X265_CHECK(count <= MAX_BATCH_CANDIDATES, "too many motion candidates\n");
+    count = X265_MIN(count, MAX_BATCH_CANDIDATES);
+
+    for (int i = 0; i < count; i++)
+    {
+        MV m = qmvs[i].clipped(qmvmin, qmvmax);
+        if (!m.notZero() || m == bmv)
+            continue;
+
+        int j = 0;
+        while (j < numMvs && mvs[j] != m)
+            j++;
+        if (j < numMvs)
+            continue;
+
+        mvs[numMvs] = m;
+        if (m.isSubpel() || bChromaSATD)
+            costs[numMvs] = subpelCompare(ref, m, sad) + mvcost(m);
+        else
+            fpel[numFpel++] = numMvs;
+        numMvs++;
+    }
+
+    const pixel* fenc = fencPUYuv.m_buf[0];
+    const pixel* fref = ref->fpelPlane[0] + blockOffset;
+    intptr_t stride = ref->lumaStride;
+#define CAND_PIX(k) (fref + (mvs[fpel[k]].x >> 2) + (mvs[fpel[k]].y >> 2) * stride)
+
+    int i = 0;
+    for (; i + 4 <= numFpel; i += 4)
+    {
+        sad_x4(fenc, CAND_PIX(i), CAND_PIX(i + 1), CAND_PIX(i + 2), CAND_PIX(i + 3), stride, res);
+        for (int k = 0; k < 4; k++)
+            costs[fpel[i + k]] = res[k] + mvcost(mvs[fpel[i + k]]);
+    }
+    if (numFpel - i == 3)
+    {
+        sad_x3(fenc, CAND_PIX(i), CAND_PIX(i + 1), CAND_PIX(i + 2), stride, res);
+        for (int k = 0; k < 3; k++)
+            costs[fpel[i + k]] = res[k] + mvcost(mvs[fpel[i + k]]);
+        i += 3;
+    }
+    for (; i < numFpel; i++)
+        costs[fpel[i]] = sad(fenc, FENC_STRIDE, CAND_PIX(i), stride) + mvcost(mvs[fpel[i]]);
+#undef CAND_PIX
+
+    for (int j = 0; j < numMvs; j++)
+    {
+        if (costs[j] < bcost)
+        {
+            bcost = costs[j];
+            bmv = mvs[j];
+        }
+    }
+
+    return bcost;
+}
+
 int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_t cmp)
 {
     intptr_t refStride = ref->lumaStride;
@@ -1589,13 +1651,28 @@ int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_
          * the final 16bit values prior to rounding and down shifting. Instead we
          * are simply interpolating the weighted full-pel pixels. Not 100%
          * accurate but good enough for fast qpel ME */
-        if (!yFrac)
-            primitives.pu[partEnum].luma_hpp(fref, refStride, subpelbuf, blockwidth, xFrac);
-        else if (!xFrac)
-            primitives.pu[partEnum].luma_vpp(fref, refStride, subpelbuf, blockwidth, yFrac);
+        intptr_t cacheStride;
+        const pixel* cached = NULL;
+        if (ref->hpelPlane[0] && !((xFrac | yFrac) & 1))
+        {
+            cached = ref->hpelPlane[(yFrac >> 1) * 2 + (xFrac >> 1) - 1] + (fref - ref->fpelPlane[0]);
+            cacheStride = refStride;
+        }
+        else if (subpelCache && !ref->isLowres)
+            cached = subpelCache->getBlock(ref->fpelPlane[0], refStride, fref - ref->fpelPlane[0], xFrac, yFrac, blockwidth, blockheight, cacheStride);
+
+        if (cached)
+            cost = cmp(fencPUYuv.m_buf[0], fencStride, cached, cacheStride);
         else
-            primitives.pu[partEnum].luma_hvpp(fref, refStride, subpelbuf, blockwidth, xFrac, yFrac);
-        cost = cmp(fencPUYuv.m_buf[0], fencStride, subpelbuf, blockwidth);
+        {
+            if (!yFrac)
+                primitives.pu[partEnum].luma_hpp(fref, refStride, subpelbuf, blockwidth, xFrac);
+            else if (!xFrac)
+                primitives.pu[partEnum].luma_vpp(fref, refStride, subpelbuf, blockwidth, yFrac);
+            else
+                primitives.pu[partEnum].luma_hvpp(fref, refStride, subpelbuf, blockwidth, xFrac, yFrac);
+            cost = cmp(fencPUYuv.m_buf[0], fencStride, subpelbuf, blockwidth);
+        }
     }
 
     if (bChromaSATD)
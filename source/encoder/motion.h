@@ -30,6 +30,7 @@
 #include "mv.h"
 #include "bitcost.h"
 #include "yuv.h"
+#include "subpelcache.h"
 
 namespace X265_NS {
 // private x265 namespace
@@ -63,11 +64,13 @@ protected:
 public:
 
     static const int COST_MAX = 1 << 28;
+    static const int MAX_BATCH_CANDIDATES = 16;
 
     uint32_t* integral[INTEGRAL_PLANE_NUM];
     Yuv fencPUYuv;
     int partEnum;
     bool bChromaSATD;
+    SubpelCache* subpelCache;  /* optional, serves sub-pel luma of full-res references */
 
     MotionEstimate();
     ~MotionEstimate();
@@ -80,6 +83,8 @@ public:
 
     void setSourcePU(pixel *fencY, intptr_t stride, intptr_t offset, int pwidth, int pheight, const int searchMethod, const int searchL0, const int searchL1, const int subpelRefine);
     void setSourcePU(const Yuv& srcFencYuv, int ctuAddr, int cuPartIdx, int puPartIdx, int pwidth, int pheight, const int searchMethod, const int subpelRefine, bool bChroma);
+    void setSearchMethod(int method) { searchMethod = method; }
+    int  getSearchMethod() const     { return searchMethod; }
 
     /* buf*() and motionEstimate() methods all use cached fenc pixels and thus
      * require setSourcePU() to be called prior. */
@@ -98,6 +103,7 @@ public:
     int motionEstimate(ReferencePlanes* ref, const MV & mvmin, const MV & mvmax, const MV & qmvp, int numCandidates, const MV * mvc, int merange, MV & outQMv, uint32_t maxSlices, pixel *srcReferencePlane = 0);
 
     int subpelCompare(ReferencePlanes* ref, const MV &qmv, pixelcmp_t);
+    int evaluateCandidates(ReferencePlanes* ref, const MV* qmvs, int count, const MV& qmvmin, const MV& qmvmax, MV& bmv, int bcost);
 
 protected:
 
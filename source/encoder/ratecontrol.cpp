@@ -67,6 +67,45 @@ namespace {
     }\
 }
 
+/* Binary stats file: a header, the NUL terminated options string of the pass
+ * which wrote it, then one fixed size record per frame in encode order. The
+ * records are read back in place from a memory mapped file; the layout is in
+ * host byte order and is versioned so old files are rejected, not misread */
+static const char s_binaryStatsMagic[8] = { 'X', '2', '6', '5', 'S', 'T', 'A', 'T' };
+static const uint32_t s_binaryStatsVersion = 1;
+
+struct BinaryStatsHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t optionsSize;
+    uint32_t reserved;
+};
+
+struct BinaryStatsRecord
+{
+    int32_t  poc;
+    int32_t  encodeOrder;
+    int32_t  coeffBits;
+    int32_t  mvBits;
+    int32_t  miscBits;
+    int32_t  numberOfPictures;
+    int32_t  numberOfNegativePictures;
+    int32_t  numberOfPositivePictures;
+    double   qpRc;
+    double   qpAq;
+    double   qpNoVbv;
+    double   qRceq;
+    double   iCuCount;
+    double   pCuCount;
+    double   skipCuCount;
+    int32_t  deltaPOC[MAX_NUM_REF_PICS];
+    uint8_t  bUsed[MAX_NUM_REF_PICS];
+    char     picType;
+    uint8_t  reserved[7];
+};
+
 inline int calcScale(uint32_t x)
 {
     static uint8_t lut[16] = {4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
@@ -168,6 +207,8 @@ RateControl::RateControl(x265_param& p, Encoder *top)
     m_startEndOrder.set(0);
     m_bTerminated = false;
     m_finalFrameCount = 0;
+    memset(m_inFlight, 0, sizeof(m_inFlight));
+    m_vbvPredictionError = 0;
     m_numEntries = 0;
     m_isSceneTransition = false;
     m_lastPredictorReset = 0;
@@ -420,11 +461,24 @@ bool RateControl::init(const SPS& sps)
         if (m_param->rc.bStatRead)
         {
             m_expectedBitsSum = 0;
-            char *p, *statsIn, *statsBuf;
-            /* read 1st pass stats */
-            statsIn = statsBuf = x265_slurp_file(fileName);
-            if (!statsBuf)
+            char *p, *statsIn = NULL, *statsBuf = NULL;
+            const BinaryStatsHeader* binHeader = NULL;
+            const uint8_t* binRecords = NULL;
+            size_t statsMapSize = 0;
+            /* read 1st pass stats, binary stats files are mapped rather than loaded */
+            void* statsMap = x265_map_file(fileName, &statsMapSize);
+            if (!statsMap)
                 return false;
+            if (statsMapSize >= sizeof(BinaryStatsHeader) && !memcmp(statsMap, s_binaryStatsMagic, sizeof(s_binaryStatsMagic)))
+                binHeader = (const BinaryStatsHeader*)statsMap;
+            else
+            {
+                x265_unmap_file(statsMap, statsMapSize);
+                statsMap = NULL;
+                statsIn = statsBuf = x265_slurp_file(fileName);
+                if (!statsBuf)
+                    return false;
+            }
             if (m_param->rc.cuTree)
             {
                 char *tmpFile = strcatFilename(fileName, ".cutree");
@@ -440,7 +494,28 @@ bool RateControl::init(const SPS& sps)
             }
 
             /* check whether 1st pass options were compatible with current options */
-            if (strncmp(statsBuf, "#options:", 9))
+            if (binHeader)
+            {
+                size_t optionsEnd = sizeof(BinaryStatsHeader) + binHeader->optionsSize;
+                if (binHeader->version != s_binaryStatsVersion)
+                {
+                    x265_log(m_param, X265_LOG_ERROR, "binary stats file version %u is not supported\n", binHeader->version);
+                    return false;
+                }
+                if (binHeader->recordSize != sizeof(BinaryStatsRecord))
+                {
+                    x265_log(m_param, X265_LOG_ERROR, "binary stats file record size %u does not match the expected %u\n",
+                             binHeader->recordSize, (uint32_t)sizeof(BinaryStatsRecord));
+                    return false;
+                }
+                if (!binHeader->optionsSize || optionsEnd > statsMapSize || ((const char*)statsMap)[optionsEnd - 1])
+                {
+                    x265_log(m_param, X265_LOG_ERROR, "Malformed stats file\n");
+                    return false;
+                }
+                binRecords = (const uint8_t*)statsMap + optionsEnd;
+            }
+            else if (strncmp(statsBuf, "#options:", 9))
             {
                 x265_log(m_param, X265_LOG_ERROR,"options list in stats file not valid\n");
                 return false;
@@ -449,15 +524,21 @@ bool RateControl::init(const SPS& sps)
                 int i, j, m;
                 uint32_t k , l;
                 bool bErr = false;
-                char *opts = statsBuf;
-                statsIn = strchr(statsBuf, '\n');
-                if (!statsIn)
+                char *opts;
+                if (binHeader)
+                    opts = (char*)(binHeader + 1);
+                else
                 {
-                    x265_log(m_param, X265_LOG_ERROR, "Malformed stats file\n");
-                    return false;
+                    opts = statsBuf;
+                    statsIn = strchr(statsBuf, '\n');
+                    if (!statsIn)
+                    {
+                        x265_log(m_param, X265_LOG_ERROR, "Malformed stats file\n");
+                        return false;
+                    }
+                    *statsIn = '\0';
+                    statsIn++;
                 }
-                *statsIn = '\0';
-                statsIn++;
                 if ((p = strstr(opts, " input-res=")) == 0 || sscanf(p, " input-res=%dx%d", &i, &j) != 2)
                 {
                     x265_log(m_param, X265_LOG_ERROR, "Resolution specified in stats file not valid\n");
@@ -530,10 +611,23 @@ bool RateControl::init(const SPS& sps)
                     m_param->lookaheadDepth = i;
             }
             /* find number of pics */
-            p = statsIn;
             int numEntries;
-            for (numEntries = -1; p; numEntries++)
-                p = strchr(p + 1, ';');
+            if (binHeader)
+            {
+                size_t recordBytes = statsMapSize - (size_t)(binRecords - (const uint8_t*)statsMap);
+                if (recordBytes % sizeof(BinaryStatsRecord))
+                {
+                    x265_log(m_param, X265_LOG_ERROR, "binary stats file is truncated\n");
+                    return false;
+                }
+                numEntries = (int)(recordBytes / sizeof(BinaryStatsRecord));
+            }
+            else
+            {
+                p = statsIn;
+                for (numEntries = -1; p; numEntries++)
+                    p = strchr(p + 1, ';');
+            }
             if (!numEntries)
             {
                 x265_log(m_param, X265_LOG_ERROR, "empty stats file\n");
@@ -541,12 +635,12 @@ bool RateControl::init(const SPS& sps)
             }
             m_numEntries = numEntries;
 
-            if (m_param->totalFrames < m_numEntries && m_param->totalFrames > 0)
+            if (m_param->totalFrames < m_numEntries && m_param->totalFrames > 0 && m_param->segmentIndex < 0)
             {
                 x265_log(m_param, X265_LOG_WARNING, "2nd pass has fewer frames than 1st pass (%d vs %d)\n",
                          m_param->totalFrames, m_numEntries);
             }
-            if (m_param->totalFrames > m_numEntries)
+            if (m_param->totalFrames > m_numEntries && m_param->segmentIndex < 0)
             {
                 x265_log(m_param, X265_LOG_ERROR, "2nd pass has more frames than 1st pass (%d vs %d)\n",
                          m_param->totalFrames, m_numEntries);
@@ -584,39 +678,85 @@ bool RateControl::init(const SPS& sps)
                 int encodeOrder;
                 char picType;
                 int e;
-                char *next;
+                char *next = NULL;
                 double qpRc, qpAq, qNoVbv, qRceq;
-                next = strstr(p, ";");
-                if (next)
-                    *next++ = 0;
-                e = sscanf(p, " in:%d out:%d", &frameNumber, &encodeOrder);
-                if (frameNumber < 0 || frameNumber >= m_numEntries)
+                if (binHeader)
                 {
-                    x265_log(m_param, X265_LOG_ERROR, "bad frame number (%d) at stats line %d\n", frameNumber, i);
-                    return false;
-                }
-                rce = &m_rce2Pass[encodeOrder];
-                m_encOrder[frameNumber] = encodeOrder;
-                if (!m_param->bMultiPassOptRPS)
-                {
-                    e += sscanf(p, " in:%*d out:%*d type:%c q:%lf q-aq:%lf q-noVbv:%lf q-Rceq:%lf tex:%d mv:%d misc:%d icu:%lf pcu:%lf scu:%lf",
-                        &picType, &qpRc, &qpAq, &qNoVbv, &qRceq, &rce->coeffBits,
-                        &rce->mvBits, &rce->miscBits, &rce->iCuCount, &rce->pCuCount,
-                        &rce->skipCuCount);
+                    BinaryStatsRecord rec;
+                    memcpy(&rec, binRecords + (size_t)i * sizeof(BinaryStatsRecord), sizeof(rec));
+                    frameNumber = rec.poc;
+                    encodeOrder = rec.encodeOrder;
+                    if (frameNumber < 0 || frameNumber >= m_numEntries || encodeOrder < 0 || encodeOrder >= m_numEntries)
+                    {
+                        x265_log(m_param, X265_LOG_ERROR, "bad frame number (%d) at stats record %d\n", frameNumber, i);
+                        return false;
+                    }
+                    rce = &m_rce2Pass[encodeOrder];
+                    m_encOrder[frameNumber] = encodeOrder;
+                    picType = rec.picType;
+                    qpRc = rec.qpRc;
+                    qpAq = rec.qpAq;
+                    qNoVbv = rec.qpNoVbv;
+                    qRceq = rec.qRceq;
+                    rce->coeffBits = rec.coeffBits;
+                    rce->mvBits = rec.mvBits;
+                    rce->miscBits = rec.miscBits;
+                    rce->iCuCount = rec.iCuCount;
+                    rce->pCuCount = rec.pCuCount;
+                    rce->skipCuCount = rec.skipCuCount;
+                    if (m_param->bMultiPassOptRPS)
+                    {
+                        if (rec.numberOfPictures < 0 || rec.numberOfPictures > MAX_NUM_REF_PICS)
+                        {
+                            x265_log(m_param, X265_LOG_ERROR, "bad RPS size (%d) at stats record %d\n", rec.numberOfPictures, i);
+                            return false;
+                        }
+                        rce->rpsData.numberOfPictures = rec.numberOfPictures;
+                        rce->rpsData.numberOfNegativePictures = rec.numberOfNegativePictures;
+                        rce->rpsData.numberOfPositivePictures = rec.numberOfPositivePictures;
+                        for (int j = 0; j < rec.numberOfPictures; j++)
+                        {
+                            rce->rpsData.deltaPOC[j] = rec.deltaPOC[j];
+                            rce->rpsData.bUsed[j] = !!rec.bUsed[j];
+                        }
+                        rce->rpsIdx = -1;
+                    }
+                    e = 13;
                 }
                 else
                 {
-                    char deltaPOC[128];
-                    char bUsed[40];
-                    memset(deltaPOC, 0, sizeof(deltaPOC));
-                    memset(bUsed, 0, sizeof(bUsed));
-                    e += sscanf(p, " in:%*d out:%*d type:%c q:%lf q-aq:%lf q-noVbv:%lf q-Rceq:%lf tex:%d mv:%d misc:%d icu:%lf pcu:%lf scu:%lf nump:%d numnegp:%d numposp:%d deltapoc:%s bused:%s",
-                        &picType, &qpRc, &qpAq, &qNoVbv, &qRceq, &rce->coeffBits,
-                        &rce->mvBits, &rce->miscBits, &rce->iCuCount, &rce->pCuCount,
-                        &rce->skipCuCount, &rce->rpsData.numberOfPictures, &rce->rpsData.numberOfNegativePictures, &rce->rpsData.numberOfPositivePictures, deltaPOC, bUsed);
-                    splitdeltaPOC(deltaPOC, rce);
-                    splitbUsed(bUsed, rce);
-                    rce->rpsIdx = -1;
+                    next = strstr(p, ";");
+                    if (next)
+                        *next++ = 0;
+                    e = sscanf(p, " in:%d out:%d", &frameNumber, &encodeOrder);
+                    if (frameNumber < 0 || frameNumber >= m_numEntries)
+                    {
+                        x265_log(m_param, X265_LOG_ERROR, "bad frame number (%d) at stats line %d\n", frameNumber, i);
+                        return false;
+                    }
+                    rce = &m_rce2Pass[encodeOrder];
+                    m_encOrder[frameNumber] = encodeOrder;
+                    if (!m_param->bMultiPassOptRPS)
+                    {
+                        e += sscanf(p, " in:%*d out:%*d type:%c q:%lf q-aq:%lf q-noVbv:%lf q-Rceq:%lf tex:%d mv:%d misc:%d icu:%lf pcu:%lf scu:%lf",
+                            &picType, &qpRc, &qpAq, &qNoVbv, &qRceq, &rce->coeffBits,
+                            &rce->mvBits, &rce->miscBits, &rce->iCuCount, &rce->pCuCount,
+                            &rce->skipCuCount);
+                    }
+                    else
+                    {
+                        char deltaPOC[128];
+                        char bUsed[40];
+                        memset(deltaPOC, 0, sizeof(deltaPOC));
+                        memset(bUsed, 0, sizeof(bUsed));
+                        e += sscanf(p, " in:%*d out:%*d type:%c q:%lf q-aq:%lf q-noVbv:%lf q-Rceq:%lf tex:%d mv:%d misc:%d icu:%lf pcu:%lf scu:%lf nump:%d numnegp:%d numposp:%d deltapoc:%s bused:%s",
+                            &picType, &qpRc, &qpAq, &qNoVbv, &qRceq, &rce->coeffBits,
+                            &rce->mvBits, &rce->miscBits, &rce->iCuCount, &rce->pCuCount,
+                            &rce->skipCuCount, &rce->rpsData.numberOfPictures, &rce->rpsData.numberOfNegativePictures, &rce->rpsData.numberOfPositivePictures, deltaPOC, bUsed);
+                        splitdeltaPOC(deltaPOC, rce);
+                        splitbUsed(bUsed, rce);
+                        rce->rpsIdx = -1;
+                    }
                 }
                 rce->keptAsRef = true;
                 rce->isIdr = false;
@@ -646,6 +786,7 @@ bool RateControl::init(const SPS& sps)
                 p = next;
             }
             X265_FREE(statsBuf);
+            x265_unmap_file(statsMap, statsMapSize);
             if (m_param->rc.rateControlMode != X265_RC_CQP)
             {
                 m_start = 0;
@@ -653,6 +794,8 @@ bool RateControl::init(const SPS& sps)
                 if (!initPass2())
                     return false;
             } /* else we're using constant quant, so no need to run the bitrate allocation */
+            if (m_param->segmentFrames && !planSegments())
+                return false;
         }
         /* Open output file */
         /* If input and output files are the same, output to a temp file
@@ -671,7 +814,23 @@ bool RateControl::init(const SPS& sps)
                 return false;
             }
             p = x265_param2string(m_param, sps.conformanceWindow.rightOffset, sps.conformanceWindow.bottomOffset);
-            if (p)
+            if (m_param->statsFormat == X265_STATS_FORMAT_BINARY)
+            {
+                BinaryStatsHeader header;
+                memset(&header, 0, sizeof(header));
+                memcpy(header.magic, s_binaryStatsMagic, sizeof(header.magic));
+                header.version = s_binaryStatsVersion;
+                header.recordSize = sizeof(BinaryStatsRecord);
+                header.optionsSize = p ? (uint32_t)strlen(p) + 1 : 1;
+                if (fwrite(&header, sizeof(header), 1, m_statFileOut) < 1 ||
+                    fwrite(p ? p : "", 1, header.optionsSize, m_statFileOut) < header.optionsSize)
+                {
+                    x265_log_file(m_param, X265_LOG_ERROR, "can't write stats file %s.temp\n", fileName);
+                    X265_FREE(p);
+                    return false;
+                }
+            }
+            else if (p)
                 fprintf(m_statFileOut, "#options: %s\n", p);
             X265_FREE(p);
             if (m_param->rc.cuTree && !m_param->rc.bStatRead)
@@ -1253,10 +1412,24 @@ int RateControl::rateControlStart(Frame* curFrame, RateControlEntry* rce, Encode
         return 0;
     }
 
+    if (m_param->bSpeculativeRC && (m_param->rc.rateControlMode == X265_RC_ABR || m_isVbv))
+    {
+        /* earlier frames may still be short of their mid-frame statistics;
+         * fold in whatever has been posted, the rest is corrected later */
+        foldPendingRowStats();
+        rce->rowStatsState = 0;
+        m_inFlight[rce->encodeOrder % m_param->frameNumThreads] = rce;
+        ScopedLock errorLock(m_vbvPredictionErrorLock);
+        rce->vbvPredictionErrorAtStart = m_vbvPredictionError;
+    }
+
     FrameData& curEncData = *curFrame->m_encData;
     m_curSlice = curEncData.m_slice;
     m_sliceType = m_curSlice->m_sliceType;
     rce->sliceType = m_sliceType;
+    rce->totalBitsAtStart = m_totalBits;
+    rce->wantedBitsWindowAtStart = m_wantedBitsWindow;
+    rce->framesDoneAtStart = m_framesDone;
     if (!m_2pass)
         rce->keptAsRef = IS_REFERENCED(curFrame);
     m_predType = getPredictorType(curFrame->m_lowres.sliceType, m_sliceType);
@@ -1624,6 +1797,144 @@ bool RateControl::fixUnderflow(int t0, int t1, double adjustment, double qscaleM
     return adjusted;
 }
 
+/* Split the 2-pass plan into segments which start on closed GOP IDR frames,
+ * and give each its planned bits and the VBV fullness expected at both ends.
+ * When a single segment is encoded, the stats are narrowed to that segment so
+ * its rate control starts and ends on the buffer states of the global plan */
+bool RateControl::planSegments()
+{
+    if (m_param->rc.rateControlMode != X265_RC_ABR)
+    {
+        x265_log(m_param, X265_LOG_ERROR, "segment planning requires 2-pass ABR\n");
+        return false;
+    }
+
+    int *segStart = NULL, *pocOf = NULL;
+    int numSegments = 0;
+    CHECKED_MALLOC(segStart, int, m_numEntries + 1);
+    CHECKED_MALLOC(pocOf, int, m_numEntries);
+    for (int i = 0; i < m_numEntries; i++)
+        pocOf[m_encOrder[i]] = i;
+
+    /* a segment may start at encode position i only if it is an IDR whose POC
+     * is also i and every frame encoded before it is displayed before it, so
+     * no frame of the segment references or is reordered across the cut */
+    for (int i = 0, maxPoc = -1; i < m_numEntries; i++)
+    {
+        bool bCut = !i || (m_rce2Pass[i].isIdr && pocOf[i] == i && maxPoc == i - 1);
+        if (bCut && (!numSegments || i >= segStart[numSegments - 1] + m_param->segmentFrames))
+            segStart[numSegments++] = i;
+        maxPoc = X265_MAX(maxPoc, pocOf[i]);
+    }
+    segStart[numSegments] = m_numEntries;
+    X265_FREE(pocOf);
+
+    if (m_param->segmentPlanFile)
+    {
+        FILE* planFile = x265_fopen(m_param->segmentPlanFile, "w");
+        if (!planFile)
+        {
+            x265_log_file(m_param, X265_LOG_ERROR, "can't open segment plan file %s\n", m_param->segmentPlanFile);
+            X265_FREE(segStart);
+            return false;
+        }
+        fprintf(planFile, "#segments: %d frames: %d bitrate: %d vbv-maxrate: %d vbv-bufsize: %d\n",
+                numSegments, m_numEntries, m_param->rc.bitrate, m_param->rc.vbvMaxBitrate, m_param->rc.vbvBufferSize);
+        for (int s = 0; s < numSegments; s++)
+        {
+            int start = segStart[s], end = segStart[s + 1];
+            double bits = 0;
+            for (int i = start; i < end; i++)
+                bits += qScale2bits(&m_rce2Pass[i], m_rce2Pass[i].newQScale);
+            double vbvInit = 0, vbvEnd = 0;
+            if (m_isVbv)
+            {
+                vbvInit = start ? m_rce2Pass[start - 1].expectedVbv / m_bufferSize : m_param->rc.vbvBufferInit;
+                vbvEnd = m_rce2Pass[end - 1].expectedVbv / m_bufferSize;
+            }
+            fprintf(planFile, "segment:%d start:%d frames:%d bits:%.0f kbps:%.2f vbv-init:%.4f vbv-end:%.4f ;\n",
+                    s, start, end - start, bits, bits * m_fps / ((end - start) * 1000.), vbvInit, vbvEnd);
+        }
+        fclose(planFile);
+        x265_log(m_param, X265_LOG_INFO, "planned %d segments from %d frames, plan written to %s\n",
+                 numSegments, m_numEntries, m_param->segmentPlanFile);
+    }
+
+    if (m_param->segmentIndex >= 0)
+    {
+        int seg = m_param->segmentIndex;
+        if (seg >= numSegments)
+        {
+            x265_log(m_param, X265_LOG_ERROR, "segment %d requested but only %d segments planned\n", seg, numSegments);
+            X265_FREE(segStart);
+            return false;
+        }
+        int start = segStart[seg], frames = segStart[seg + 1] - start;
+        bool bLast = seg == numSegments - 1;
+        X265_FREE(segStart);
+        if (m_param->totalFrames > frames)
+        {
+            x265_log(m_param, X265_LOG_ERROR, "segment %d has fewer frames than the input (%d vs %d)\n",
+                     seg, frames, m_param->totalFrames);
+            return false;
+        }
+
+        /* the cutree stats only hold records for referenced frames, in encode order */
+        if (m_cutreeStatFileIn)
+        {
+            int64_t skipped = 0;
+            for (int i = 0; i < start; i++)
+                skipped += m_rce2Pass[i].keptAsRef;
+            int ncu = (m_param->rc.qgSize == 8) ? m_ncu * 4 : m_ncu;
+            if (fseeko(m_cutreeStatFileIn, skipped * (1 + ncu * sizeof(uint16_t)), SEEK_SET))
+            {
+                x265_log(m_param, X265_LOG_ERROR, "Incomplete CU-tree stats file.\n");
+                return false;
+            }
+        }
+
+        double vbvInit = 0, vbvEnd = 0;
+        if (m_isVbv)
+        {
+            vbvInit = start ? m_rce2Pass[start - 1].expectedVbv / m_bufferSize : m_param->rc.vbvBufferInit;
+            vbvEnd = m_rce2Pass[start + frames - 1].expectedVbv / m_bufferSize;
+        }
+        uint64_t bitsBefore = m_rce2Pass[start].expectedBits;
+        memmove(m_rce2Pass, m_rce2Pass + start, frames * sizeof(RateControlEntry));
+        for (int i = 0; i < frames; i++)
+        {
+            m_encOrder[i] = m_encOrder[start + i] - start;
+            m_rce2Pass[i].expectedBits -= bitsBefore;
+        }
+        m_numEntries = frames;
+
+        if (m_isVbv)
+        {
+            /* start from the fullness the previous segment was planned to end on,
+             * and steer the end of this one to where the next is planned to start */
+            m_param->rc.vbvBufferInit = x265_clip3(0.0, 1.0, X265_MAX(vbvInit, m_bufferRate / m_bufferSize));
+            m_bufferFillFinal = m_bufferFillActual = m_bufferSize * m_param->rc.vbvBufferInit;
+            if (!bLast)
+            {
+                m_param->vbvBufferEnd = x265_clip3(0.001, 1.0, vbvEnd);
+                m_param->vbvEndFrameAdjust = 1.0 - X265_MIN(frames / 2, (int)(m_fps + 0.5)) / (double)frames;
+            }
+        }
+        if (seg)
+            m_param->bEnableHRDConcatFlag = 1;
+        x265_log(m_param, X265_LOG_INFO, "encoding segment %d: frames %d-%d, vbv-init %.4f vbv-end %.4f\n",
+                 seg, start, start + frames - 1, m_isVbv ? m_param->rc.vbvBufferInit : 0, m_isVbv && !bLast ? m_param->vbvBufferEnd : 0);
+    }
+    else
+        X265_FREE(segStart);
+    return true;
+
+fail:
+    X265_FREE(segStart);
+    x265_log(m_param, X265_LOG_ERROR, "malloc failure in segment planning\n");
+    return false;
+}
+
 bool RateControl::cuTreeReadFor2Pass(Frame* frame)
 {
     int index = m_encOrder[frame->m_poc];
@@ -2155,6 +2466,50 @@ double RateControl::rateEstimateQscale(Frame* curFrame, RateControlEntry *rce)
 }
 
 void RateControl::rateControlUpdateStats(RateControlEntry* rce)
+{
+    if (m_param->bSpeculativeRC)
+    {
+        /* the next frame has not waited for these statistics; post them for
+         * the next rateControlStart or rateControlEnd to fold in */
+        ATOMIC_OR(&rce->rowStatsState, 1);
+        return;
+    }
+
+    foldRowStats(rce);
+
+    /* do not allow the next frame to enter rateControlStart() until this
+     * frame has updated its mid-frame statistics */
+    if (m_param->rc.rateControlMode == X265_RC_ABR || m_isVbv)
+    {
+        m_startEndOrder.incr();
+
+        if (rce->encodeOrder < m_param->frameNumThreads - 1)
+            m_startEndOrder.incr(); // faked rateControlEnd calls for negative frames
+    }
+}
+
+void RateControl::foldPendingRowStats()
+{
+    /* fold in encode order, stopping at the first frame whose statistics are
+     * still pending, so I frame amortization sees the same sequence as when
+     * every start waits for the previous frame's statistics */
+    for (;;)
+    {
+        RateControlEntry* next = NULL;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+        {
+            RateControlEntry* rce = m_inFlight[i];
+            if (rce && !(rce->rowStatsState & 2) && (!next || rce->encodeOrder < next->encodeOrder))
+                next = rce;
+        }
+        if (!next || !(ATOMIC_OR(&next->rowStatsState, 0) & 1))
+            return;
+        foldRowStats(next);
+        ATOMIC_OR(&next->rowStatsState, 2);
+    }
+}
+
+void RateControl::foldRowStats(RateControlEntry* rce)
 {
     if (!m_param->rc.bStatWrite && !m_param->rc.bStatRead)
     {
@@ -2195,16 +2550,6 @@ void RateControl::rateControlUpdateStats(RateControlEntry* rce)
 
     m_cplxrSum += rce->rowCplxrSum;
     m_totalBits += rce->rowTotalBits;
-
-    /* do not allow the next frame to enter rateControlStart() until this
-     * frame has updated its mid-frame statistics */
-    if (m_param->rc.rateControlMode == X265_RC_ABR || m_isVbv)
-    {
-        m_startEndOrder.incr();
-
-        if (rce->encodeOrder < m_param->frameNumThreads - 1)
-            m_startEndOrder.incr(); // faked rateControlEnd calls for negative frames
-    }
 }
 
 void RateControl::checkAndResetABR(RateControlEntry* rce, bool isFrameDone)
@@ -2275,6 +2620,106 @@ double RateControl::predictSize(Predictor *p, double q, double var)
     return (p->coeff * var + p->offset) / (q * p->count);
 }
 
+/* Flatten the lookahead plan of curFrame into m_vbvPlanBits, the predicted
+ * size of each planned frame at qscale 1 relative to the current frame, so a
+ * trial qscale only scales the array. Returns the number of planned frames
+ * which fit in the one second VBV horizon */
+int RateControl::initVbvPlan(Frame* curFrame)
+{
+    double typeFactor[3];
+    typeFactor[P_SLICE] = m_sliceType == I_SLICE ? m_param->rc.ipFactor : (m_sliceType == B_SLICE ? 1.0 / m_param->rc.pbFactor : 1.0);
+    typeFactor[B_SLICE] = typeFactor[P_SLICE] * m_param->rc.pbFactor;
+    typeFactor[I_SLICE] = typeFactor[P_SLICE] / m_param->rc.ipFactor;
+
+    double totalDuration = m_frameDuration;
+    int j;
+    for (j = 0; j < X265_LOOKAHEAD_MAX + 1; j++)
+    {
+        int type = curFrame->m_lowres.plannedType[j];
+        if (type == X265_TYPE_AUTO || totalDuration >= 1.0)
+            break;
+        totalDuration += m_frameDuration;
+        int64_t satd = curFrame->m_lowres.plannedSatd[j] >> (X265_DEPTH - 8);
+        type = IS_X265_TYPE_I(type) ? I_SLICE : IS_X265_TYPE_B(type) ? B_SLICE : P_SLICE;
+        int predType = getPredictorType(curFrame->m_lowres.plannedType[j], type);
+        m_vbvPlanBits[j] = predictSize(&m_pred[predType], typeFactor[type], (double)satd);
+        if (!m_param->bResetZoneConfig && ((uint64_t)j == (m_param->reconfigWindowSize - 1)))
+        {
+            j++;
+            break;
+        }
+    }
+    return j;
+}
+
+/* Buffer fill at the end of the VBV plan if the current frame, whose size at
+ * qscale 1 is curBits, is coded at qscale q. Stops early on underflow. bFull
+ * is set if the buffer was too full to take a frame's refill, where the fill
+ * stops rising with q */
+double RateControl::vbvPlanFill(double q, int planFrames, double curBits, double& totalDuration, bool& bFull)
+{
+    double invQ = 1.0 / q;
+    double wantedFrameSize = m_vbvMaxRate * m_frameDuration;
+    double bufferFillCur = m_bufferFill - curBits * invQ;
+    totalDuration = m_frameDuration;
+    for (int j = 0; j < planFrames && bufferFillCur >= 0; j++)
+    {
+        totalDuration += m_frameDuration;
+        if (bufferFillCur + wantedFrameSize <= m_bufferSize)
+            bufferFillCur += wantedFrameSize;
+        else
+            bFull = true;
+        bufferFillCur -= m_vbvPlanBits[j] * invQ;
+    }
+    return bufferFillCur;
+}
+
+/* Returns 1 if q leaves the buffer too empty at the end of the VBV plan, -1 if
+ * it leaves a CBR buffer too full, else 0 */
+int RateControl::vbvPlanCheck(double q, int planFrames, double curBits, bool& bFull)
+{
+    double totalDuration;
+    double bufferFillCur = vbvPlanFill(q, planFrames, curBits, totalDuration, bFull);
+    double finalDur = 1;
+    if (m_param->rc.bStrictCbr)
+        finalDur = x265_clip3(0.4, 1.0, totalDuration);
+    /* Try to get the buffer at least 50% filled, but don't set an impossible goal. */
+    double targetFill = X265_MIN(m_bufferFill + totalDuration * m_vbvMaxRate * 0.5, m_bufferSize * (1 - 0.5 * finalDur));
+    if (bufferFillCur < targetFill)
+        return 1;
+    /* Try to get the buffer not more than 80% filled, but don't set an impossible goal. */
+    targetFill = x265_clip3(m_bufferSize * (1 - 0.2 * finalDur), m_bufferSize, m_bufferFill - totalDuration * m_vbvMaxRate * 0.5);
+    if (m_isCbr && bufferFillCur > targetFill && !m_isSceneTransition)
+        return -1;
+    return 0;
+}
+
+/* Walk q in 1% steps until the buffer state at the end of the VBV plan is
+ * acceptable, or until the walk turns back */
+double RateControl::vbvPlanWalk(double q, int planFrames, double curBits)
+{
+    bool bFull = false;
+    int loopTerminate = 0;
+    /* Avoid an infinite loop. */
+    for (int iterations = 0; iterations < 1000 && loopTerminate != 3; iterations++)
+    {
+        int dir = vbvPlanCheck(q, planFrames, curBits, bFull);
+        if (dir > 0)
+        {
+            q *= 1.01;
+            loopTerminate |= 1;
+        }
+        else if (dir < 0)
+        {
+            q /= 1.01;
+            loopTerminate |= 2;
+        }
+        else
+            break;
+    }
+    return q;
+}
+
 double RateControl::clipQscale(Frame* curFrame, RateControlEntry* rce, double q)
 {
     // B-frames are not directly subject to VBV,
@@ -2291,40 +2736,17 @@ double RateControl::clipQscale(Frame* curFrame, RateControlEntry* rce, double q)
            /* Lookahead VBV: If lookahead is done, raise the quantizer as necessary
             * such that no frames in the lookahead overflow and such that the buffer
             * is in a reasonable state by the end of the lookahead. */
-            int loopTerminate = 0;
-            /* Avoid an infinite loop. */
-            for (int iterations = 0; iterations < 1000 && loopTerminate != 3; iterations++)
-            {
-                double frameQ[3];
-                double curBits;
-                curBits = predictSize(&m_pred[m_predType], q, (double)m_currentSatd);
-                double bufferFillCur = m_bufferFill - curBits;
-                double targetFill;
-                double totalDuration = m_frameDuration;
-                frameQ[P_SLICE] = m_sliceType == I_SLICE ? q * m_param->rc.ipFactor : (m_sliceType == B_SLICE ? q / m_param->rc.pbFactor : q);
-                frameQ[B_SLICE] = frameQ[P_SLICE] * m_param->rc.pbFactor;
-                frameQ[I_SLICE] = frameQ[P_SLICE] / m_param->rc.ipFactor;
-                /* Loop over the planned future frames. */
-                bool iter = true;
-                for (int j = 0; bufferFillCur >= 0 && iter ; j++)
-                {
-                    int type = curFrame->m_lowres.plannedType[j];
-                    if (type == X265_TYPE_AUTO || totalDuration >= 1.0)
-                        break;
-                    totalDuration += m_frameDuration;
-                    double wantedFrameSize = m_vbvMaxRate * m_frameDuration;
-                    if (bufferFillCur + wantedFrameSize <= m_bufferSize)
-                        bufferFillCur += wantedFrameSize;
-                    int64_t satd = curFrame->m_lowres.plannedSatd[j] >> (X265_DEPTH - 8);
-                    type = IS_X265_TYPE_I(type) ? I_SLICE : IS_X265_TYPE_B(type) ? B_SLICE : P_SLICE;
-                    int predType = getPredictorType(curFrame->m_lowres.plannedType[j], type);
-                    curBits = predictSize(&m_pred[predType], frameQ[type], (double)satd);
-                    bufferFillCur -= curBits;
-                    if (!m_param->bResetZoneConfig && ((uint64_t)j == (m_param->reconfigWindowSize - 1)))
-                        iter = false;
-                }
-                if (rce->vbvEndAdj)
+            int planFrames = initVbvPlan(curFrame);
+            double curBits = predictSize(&m_pred[m_predType], 1.0, (double)m_currentSatd);
+            if (rce->vbvEndAdj)
+            {
+                int loopTerminate = 0;
+                /* Avoid an infinite loop. */
+                for (int iterations = 0; iterations < 1000 && loopTerminate != 3; iterations++)
                 {
+                    double totalDuration;
+                    bool bFull = false;
+                    double bufferFillCur = vbvPlanFill(q, planFrames, curBits, totalDuration, bFull);
                     bool loopBreak = false;
                     double bufferDiff = m_param->vbvBufferEnd - (m_bufferFill / m_bufferSize);
                     rce->targetFill = m_bufferFill + m_bufferSize * (bufferDiff / (m_param->totalFrames - rce->encodeOrder));
@@ -2343,30 +2765,49 @@ double RateControl::clipQscale(Frame* curFrame, RateControlEntry* rce, double q)
                     if (!loopBreak)
                         break;
                 }
-                else
+            }
+            else
+            {
+                /* The planned fill rises with q, so rather than walking q in 1%
+                 * steps until the buffer state is acceptable, bracket the number
+                 * of steps exponentially and bisect it. When the walk overshoots
+                 * into the opposite limit it settles one step short, as before.
+                 * A buffer too full to take a refill breaks the rise, but only
+                 * above some q. The largest q is always among those tried, so when
+                 * none of them filled it the bisection holds; else it falls back
+                 * to the walk */
+                bool bFull = false;
+                int dir = vbvPlanCheck(q, planFrames, curBits, bFull);
+                if (dir)
                 {
-                    /* Try to get the buffer at least 50% filled, but don't set an impossible goal. */
-                    double finalDur = 1;
-                    if (m_param->rc.bStrictCbr)
+                    const int maxSteps = 1000;
+                    int lo = 0, hi = 1, result;
+                    while ((result = vbvPlanCheck(q * pow(1.01, dir * hi), planFrames, curBits, bFull)) == dir && hi < maxSteps)
                     {
-                        finalDur = x265_clip3(0.4, 1.0, totalDuration);
+                        lo = hi;
+                        hi = X265_MIN(hi * 2, maxSteps);
                     }
-                    targetFill = X265_MIN(m_bufferFill + totalDuration * m_vbvMaxRate * 0.5, m_bufferSize * (1 - 0.5 * finalDur));
-                    if (bufferFillCur < targetFill)
+                    if (result != dir)
                     {
-                        q *= 1.01;
-                        loopTerminate |= 1;
-                        continue;
-                    }
-                    /* Try to get the buffer not more than 80% filled, but don't set an impossible goal. */
-                    targetFill = x265_clip3(m_bufferSize * (1 - 0.2 * finalDur), m_bufferSize, m_bufferFill - totalDuration * m_vbvMaxRate * 0.5);
-                    if (m_isCbr && bufferFillCur > targetFill && !m_isSceneTransition)
-                    {
-                        q /= 1.01;
-                        loopTerminate |= 2;
-                        continue;
+                        while (hi - lo > 1)
+                        {
+                            int mid = (lo + hi) >> 1;
+                            int midResult = vbvPlanCheck(q * pow(1.01, dir * mid), planFrames, curBits, bFull);
+                            if (midResult == dir)
+                                lo = mid;
+                            else
+                            {
+                                hi = mid;
+                                result = midResult;
+                            }
+                        }
+                        if (result)
+                            hi--;
                     }
-                    break;
+                    if (bFull)
+                        q = vbvPlanWalk(q, planFrames, curBits);
+                    else
+                        q *= pow(1.01, dir * hi);
                 }
             }
             q = X265_MAX(q0 / 2, q);
@@ -2560,7 +3001,16 @@ int RateControl::rowVbvRateControl(Frame* curFrame, uint32_t row, RateControlEnt
     double qpMax = X265_MIN(prevRowQp + m_param->rc.qpStep, qpAbsoluteMax);
     double qpMin = X265_MAX(prevRowQp - m_param->rc.qpStep, qpAbsoluteMin);
     double stepSize = 0.5;
-    double bufferLeftPlanned = rce->bufferFill - rce->frameSizePlanned;
+
+    /* a speculative start planned with the budgets of the frames then in
+     * flight; correct the buffer by what those which finished actually used */
+    double bufferFill = rce->bufferFill;
+    if (m_param->bSpeculativeRC)
+    {
+        ScopedLock errorLock(m_vbvPredictionErrorLock);
+        bufferFill = x265_clip3(0.0, m_bufferSize, bufferFill + m_vbvPredictionError - rce->vbvPredictionErrorAtStart);
+    }
+    double bufferLeftPlanned = bufferFill - rce->frameSizePlanned;
 
     const SPS& sps = *curEncData.m_slice->m_sps;
     double maxFrameError = X265_MAX(0.05, 1.0 / sps.numCuInHeight);
@@ -2585,44 +3035,50 @@ int RateControl::rowVbvRateControl(Frame* curFrame, uint32_t row, RateControlEnt
         if (!m_isCbr)
             qpMin = X265_MAX(qpMin, rce->qpNoVbv);
 
-        double totalBitsNeeded = m_wantedBitsWindow;
+        /* other frame encoders update the totals while this frame is being
+         * compressed, deterministic mode uses the values sampled at its start */
+        int64_t totalBits = m_param->bDeterministic ? rce->totalBitsAtStart : m_totalBits;
+        double wantedBitsWindow = m_param->bDeterministic ? rce->wantedBitsWindowAtStart : m_wantedBitsWindow;
+        int framesDone = m_param->bDeterministic ? rce->framesDoneAtStart : m_framesDone;
+
+        double totalBitsNeeded = wantedBitsWindow;
         if (m_param->totalFrames)
             totalBitsNeeded = (m_param->totalFrames * m_bitrate) / m_fps;
-        double abrOvershoot = (accFrameBits + m_totalBits - m_wantedBitsWindow) / totalBitsNeeded;
+        double abrOvershoot = (accFrameBits + totalBits - wantedBitsWindow) / totalBitsNeeded;
 
         while (qpVbv < qpMax
                && (((accFrameBits > rce->frameSizePlanned + rcTol) ||
-                   (rce->bufferFill - accFrameBits < bufferLeftPlanned * 0.5) ||
+                   (bufferFill - accFrameBits < bufferLeftPlanned * 0.5) ||
                    (accFrameBits > rce->frameSizePlanned && qpVbv < rce->qpNoVbv) ||
-                   (rce->vbvEndAdj && ((rce->bufferFill - accFrameBits) < (rce->targetFill * vbvEndBias))))
+                   (rce->vbvEndAdj && ((bufferFill - accFrameBits) < (rce->targetFill * vbvEndBias))))
                    && (!m_param->rc.bStrictCbr ? 1 : abrOvershoot > 0.1)))
         {
             qpVbv += stepSize;
             accFrameBits = predictRowsSizeSum(curFrame, rce, qpVbv, encodedBitsSoFar);
-            abrOvershoot = (accFrameBits + m_totalBits - m_wantedBitsWindow) / totalBitsNeeded;
+            abrOvershoot = (accFrameBits + totalBits - wantedBitsWindow) / totalBitsNeeded;
         }
 
         while (qpVbv > qpMin
                && (qpVbv > curEncData.m_rowStat[0].rowQp || m_singleFrameVbv)
                && (((accFrameBits < rce->frameSizePlanned * 0.8f && qpVbv <= prevRowQp)
-                   || accFrameBits < (rce->bufferFill - m_bufferSize + m_bufferRate) * 1.1
-                   || (rce->vbvEndAdj && ((rce->bufferFill - accFrameBits) > (rce->targetFill * vbvEndBias))))
+                   || accFrameBits < (bufferFill - m_bufferSize + m_bufferRate) * 1.1
+                   || (rce->vbvEndAdj && ((bufferFill - accFrameBits) > (rce->targetFill * vbvEndBias))))
                    && (!m_param->rc.bStrictCbr ? 1 : abrOvershoot < 0)))
         {
             qpVbv -= stepSize;
             accFrameBits = predictRowsSizeSum(curFrame, rce, qpVbv, encodedBitsSoFar);
-            abrOvershoot = (accFrameBits + m_totalBits - m_wantedBitsWindow) / totalBitsNeeded;
+            abrOvershoot = (accFrameBits + totalBits - wantedBitsWindow) / totalBitsNeeded;
         }
 
         if (m_param->rc.bStrictCbr && m_param->totalFrames)
         {
-            double timeDone = (double)(m_framesDone) / m_param->totalFrames;
+            double timeDone = (double)(framesDone) / m_param->totalFrames;
             while (qpVbv < qpMax && (qpVbv < rce->qpNoVbv + (m_param->rc.qpStep * timeDone)) &&
                    (timeDone > 0.75 && abrOvershoot > 0))
             {
                 qpVbv += stepSize;
                 accFrameBits = predictRowsSizeSum(curFrame, rce, qpVbv, encodedBitsSoFar);
-                abrOvershoot = (accFrameBits + m_totalBits - m_wantedBitsWindow) / totalBitsNeeded;
+                abrOvershoot = (accFrameBits + totalBits - wantedBitsWindow) / totalBitsNeeded;
             }
             if (qpVbv > curEncData.m_rowStat[0].rowQp &&
                 abrOvershoot < -0.1 && timeDone > 0.5 && accFrameBits < rce->frameSizePlanned - rcTol)
@@ -2634,7 +3090,7 @@ int RateControl::rowVbvRateControl(Frame* curFrame, uint32_t row, RateControlEnt
 
         /* avoid VBV underflow or MinCr violation */
         while ((qpVbv < qpAbsoluteMax)
-               && ((rce->bufferFill - accFrameBits < m_bufferRate * maxFrameError) ||
+               && ((bufferFill - accFrameBits < m_bufferRate * maxFrameError) ||
                    (rce->frameSizeMaximum - accFrameBits < rce->frameSizeMaximum * maxFrameError)))
         {
             qpVbv += stepSize;
@@ -2667,7 +3123,7 @@ int RateControl::rowVbvRateControl(Frame* curFrame, uint32_t row, RateControlEnt
 
         /* Last-ditch attempt: if the last row of the frame underflowed the VBV,
          * try again. */
-        if ((rce->frameSizeEstimated > (rce->bufferFill - m_bufferRate * maxFrameError) &&
+        if ((rce->frameSizeEstimated > (bufferFill - m_bufferRate * maxFrameError) &&
              qpVbv < qpMax && canReencodeRow))
         {
             qpVbv = qpMax;
@@ -2782,6 +3238,18 @@ int RateControl::rateControlEnd(Frame* curFrame, int64_t bits, RateControlEntry*
         orderValue = m_startEndOrder.waitForChange(orderValue);
     }
 
+    int inFlightIdx = rce->encodeOrder % m_param->frameNumThreads;
+    if (m_inFlight[inFlightIdx] == rce)
+    {
+        /* the statistics were posted before the last row finished. Frames
+         * end in encode order except while flushing, when an earlier frame
+         * may still hold up the in-order fold */
+        foldPendingRowStats();
+        if (!(ATOMIC_OR(&rce->rowStatsState, 2) & 2))
+            foldRowStats(rce);
+        m_inFlight[inFlightIdx] = NULL;
+    }
+
     FrameData& curEncData = *curFrame->m_encData;
     int64_t actualBits = bits;
     Slice *slice = curEncData.m_slice;
@@ -2905,6 +3373,11 @@ int RateControl::rateControlEnd(Frame* curFrame, int64_t bits, RateControlEntry*
     if (m_isVbv)
     {
         *filler = updateVbv(actualBits, rce);
+        if (m_param->bSpeculativeRC)
+        {
+            ScopedLock errorLock(m_vbvPredictionErrorLock);
+            m_vbvPredictionError += rce->frameSizePlanned - actualBits;
+        }
 
         curFrame->m_rcData->bufferFillFinal = m_bufferFillFinal;
         for (int i = 0; i < 4; i++)
@@ -2954,7 +3427,39 @@ int RateControl::writeRateControlFrameStats(Frame* curFrame, RateControlEntry* r
         : rce->sliceType == P_SLICE ? 'P'
         : IS_REFERENCED(curFrame) ? 'B' : 'b';
     
-    if (!curEncData.m_param->bMultiPassOptRPS)
+    if (m_param->statsFormat == X265_STATS_FORMAT_BINARY)
+    {
+        RPS* rpsWriter = &curFrame->m_encData->m_slice->m_rps;
+        BinaryStatsRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.poc = rce->poc;
+        rec.encodeOrder = rce->encodeOrder;
+        rec.picType = cType;
+        rec.qpRc = curEncData.m_avgQpRc;
+        rec.qpAq = curEncData.m_avgQpAq;
+        rec.qpNoVbv = rce->qpNoVbv;
+        rec.qRceq = rce->qRceq;
+        rec.coeffBits = curEncData.m_frameStats.coeffBits;
+        rec.mvBits = curEncData.m_frameStats.mvBits;
+        rec.miscBits = curEncData.m_frameStats.miscBits;
+        rec.iCuCount = curEncData.m_frameStats.percent8x8Intra * m_ncu;
+        rec.pCuCount = curEncData.m_frameStats.percent8x8Inter * m_ncu;
+        rec.skipCuCount = curEncData.m_frameStats.percent8x8Skip * m_ncu;
+        if (curEncData.m_param->bMultiPassOptRPS)
+        {
+            rec.numberOfPictures = rpsWriter->numberOfPictures;
+            rec.numberOfNegativePictures = rpsWriter->numberOfNegativePictures;
+            rec.numberOfPositivePictures = rpsWriter->numberOfPositivePictures;
+            for (int i = 0; i < rpsWriter->numberOfPictures; i++)
+            {
+                rec.deltaPOC[i] = rpsWriter->deltaPOC[i];
+                rec.bUsed[i] = rpsWriter->bUsed[i];
+            }
+        }
+        if (fwrite(&rec, sizeof(rec), 1, m_statFileOut) < 1)
+            goto writeFailure;
+    }
+    else if (!curEncData.m_param->bMultiPassOptRPS)
     {
         if (fprintf(m_statFileOut,
             "in:%d out:%d type:%c q:%.2f q-aq:%.2f q-noVbv:%.2f q-Rceq:%.2f tex:%d mv:%d misc:%d icu:%.2f pcu:%.2f scu:%.2f ;\n",
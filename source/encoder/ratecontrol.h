@@ -123,6 +123,16 @@ struct RateControlEntry
     int      rpsIdx;
     RPS      rpsData;
     bool     isFadeEnd;
+    /* rate control totals sampled by rateControlStart, used by row level VBV
+     * in deterministic mode instead of the totals other frames update */
+    int64_t  totalBitsAtStart;
+    double   wantedBitsWindowAtStart;
+    int      framesDoneAtStart;
+    /* speculative rate control: flags of the mid-frame statistics (1 posted
+     * by the frame encoder, 2 folded into the totals) and VBV prediction
+     * error sampled at rateControlStart */
+    int      rowStatsState;
+    double   vbvPredictionErrorAtStart;
 };
 
 class RateControl
@@ -167,6 +177,7 @@ public:
     double m_bufferExcess;
     bool   m_isFirstMiniGop;
     Predictor m_pred[4];       /* Slice predictors to preidct bits for each Slice type - I,P,Bref and B */
+    double    m_vbvPlanBits[X265_LOOKAHEAD_MAX + 1]; /* lookahead VBV plan, frame sizes at qscale 1 */
     int64_t m_leadingNoBSatd;
     int     m_predType;       /* Type of slice predictors to be used - depends on the slice type */
     double  m_ipOffset;
@@ -221,6 +232,14 @@ public:
     int     m_finalFrameCount;   /* set when encoder begins flushing */
     bool    m_bTerminated;       /* set true when encoder is closing */
 
+    /* speculative rate control: frames between rateControlStart and
+     * rateControlEnd, indexed by encode order modulo frame threads, and the
+     * sum of planned minus actual sizes of every finished VBV frame, which
+     * row level VBV reads from the row threads */
+    RateControlEntry* m_inFlight[X265_MAX_FRAME_THREADS];
+    double  m_vbvPredictionError;
+    Lock    m_vbvPredictionErrorLock;
+
     /* hrd stuff */
     SEIBufferingPeriod m_bufPeriodSEI;
     double  m_nominalRemovalTime;
@@ -262,6 +281,8 @@ public:
     // to be called for each curFrame to process RateControl and set QP
     int  rateControlStart(Frame* curFrame, RateControlEntry* rce, Encoder* enc);
     void rateControlUpdateStats(RateControlEntry* rce);
+    void foldRowStats(RateControlEntry* rce);
+    void foldPendingRowStats();
     int  rateControlEnd(Frame* curFrame, int64_t bits, RateControlEntry* rce, int *filler);
     int  rowVbvRateControl(Frame* curFrame, uint32_t row, RateControlEntry* rce, double& qpVbv, uint32_t* m_sliceBaseRow, uint32_t sliceId);
     int  rateControlSliceType(int frameNum);
@@ -295,6 +316,10 @@ protected:
     int    updateVbv(int64_t bits, RateControlEntry* rce);
     void   updatePredictor(Predictor *p, double q, double var, double bits);
     double clipQscale(Frame* pic, RateControlEntry* rce, double q);
+    int    initVbvPlan(Frame* curFrame);
+    double vbvPlanFill(double q, int planFrames, double curBits, double& totalDuration, bool& bFull);
+    int    vbvPlanCheck(double q, int planFrames, double curBits, bool& bFull);
+    double vbvPlanWalk(double q, int planFrames, double curBits);
     void   updateVbvPlan(Encoder* enc);
     double predictSize(Predictor *p, double q, double var);
     void   checkAndResetABR(RateControlEntry* rce, bool isFrameDone);
@@ -306,6 +331,7 @@ protected:
     bool   vbv2Pass(uint64_t allAvailableBits, int frameCount, int startPos);
     bool   findUnderflow(double *fills, int *t0, int *t1, int over, int framesCount);
     bool   fixUnderflow(int t0, int t1, double adjustment, double qscaleMin, double qscaleMax);
+    bool   planSegments();
     double tuneQScaleForGrain(double rcOverflow);
     void   splitdeltaPOC(char deltapoc[], RateControlEntry *rce);
     void   splitbUsed(char deltapoc[], RateControlEntry *rce);
@@ -259,6 +259,7 @@ void SAO::startSlice(Frame* frame, Entropy& initState)
 
     m_numNoSao[0] = 0; // Luma
     m_numNoSao[1] = 0; // Chroma
+    m_numSaoSkipped = 0;
 
     // NOTE: Allow SAO automatic turn-off only when frame parallelism is disabled.
     if (m_param->frameNumThreads == 1)
@@ -732,15 +733,13 @@ void SAO::generateChromaOffsets(SaoCtuParam* ctuParam[3], int idxY, int idxX)
 }
 
 /* Calculate SAO statistics for current CTU without non-crossing slice */
-void SAO::calcSaoStatsCTU(int addr, int plane)
+void SAO::calcSaoStatsCTU(int addr, int plane, PerPlane& count, PerPlane& offsetOrg)
 {
     Slice* slice = m_frame->m_encData->m_slice;
     const PicYuv* reconPic = m_frame->m_reconPic;
     const CUData* cu = m_frame->m_encData->getPicCTU(addr);
     const pixel* fenc0 = m_frame->m_fencPic->getPlaneAddr(plane, addr);
     const pixel* rec0  = reconPic->getPlaneAddr(plane, addr);
-    const pixel* fenc;
-    const pixel* rec;
     intptr_t stride = plane ? reconPic->m_strideC : reconPic->m_stride;
     uint32_t picWidth  = m_param->sourceWidth;
     uint32_t picHeight = m_param->sourceHeight;
@@ -772,146 +771,85 @@ void SAO::calcSaoStatsCTU(int addr, int plane)
         picHeight = bpely;
     }
 
-    int startX;
-    int startY;
-    int endX;
-    int endY;
-
     const int plane_offset = plane ? 2 : 0;
-    int skipB = 4;
-    int skipR = 5;
-
-    int8_t _upBuff[2 * (MAX_CU_SIZE + 16 + 16)], *upBuff1 = _upBuff + 16, *upBufft = upBuff1 + (MAX_CU_SIZE + 16 + 16);
+    const bool bNonDeblocked = !!m_param->bSaoNonDeblocked;
 
-    ALIGN_VAR_32(int16_t, diff[MAX_CU_SIZE * MAX_CU_SIZE]);
-
-    // Calculate (fenc - frec) and put into diff[]
-    if ((lpelx + ctuWidth <  picWidth) & (tpely + ctuHeight < picHeight))
-    {
-        // WARNING: *) May read beyond bound on video than ctuWidth or ctuHeight is NOT multiple of cuSize
-        X265_CHECK((ctuWidth == ctuHeight) || (m_chromaFormat != X265_CSP_I420), "video size check failure\n");
-        if (plane)
-            primitives.chroma[m_chromaFormat].cu[m_param->maxLog2CUSize - 2].sub_ps(diff, MAX_CU_SIZE, fenc0, rec0, stride, stride);
-        else
-           primitives.cu[m_param->maxLog2CUSize - 2].sub_ps(diff, MAX_CU_SIZE, fenc0, rec0, stride, stride);
-    }
-    else
-    {
-        // path for non-square area (most in edge)
-        for(int y = 0; y < ctuHeight; y++)
-        {
-            for(int x = 0; x < ctuWidth; x++)
-            {
-                diff[y * MAX_CU_SIZE + x] = (fenc0[y * stride + x] - rec0[y * stride + x]);
-            }
-        }
-    }
+    // {startX, endX, startY, endY} of each type, samples whose neighbours are not deblocked yet are left out
+    int32_t bounds[MAX_NUM_SAO_TYPE][4];
+    const int startX = !lpelx;
+    const int startY = bAboveUnavail;
 
     // SAO_BO:
+    bounds[SAO_BO][0] = 0;
+    bounds[SAO_BO][1] = (rpelx == picWidth) ? ctuWidth : ctuWidth - (bNonDeblocked ? 4 : 5) + plane_offset;
+    bounds[SAO_BO][2] = 0;
+    bounds[SAO_BO][3] = (bpely == picHeight) ? ctuHeight : ctuHeight - (bNonDeblocked ? 3 : 4) + plane_offset;
+
+    // SAO_EO_0: // dir: -
+    bounds[SAO_EO_0][0] = startX;
+    bounds[SAO_EO_0][1] = (rpelx == picWidth) ? ctuWidth - 1 : ctuWidth - 5 + plane_offset;
+    bounds[SAO_EO_0][2] = 0;
+    bounds[SAO_EO_0][3] = ctuHeight - (bNonDeblocked ? 3 : 4) + plane_offset;
+
+    // SAO_EO_1: // dir: |
+    bounds[SAO_EO_1][0] = 0;
+    bounds[SAO_EO_1][1] = (rpelx == picWidth) ? ctuWidth : ctuWidth - (bNonDeblocked ? 4 : 5) + plane_offset;
+    bounds[SAO_EO_1][2] = startY;
+    bounds[SAO_EO_1][3] = (bpely == picHeight) ? ctuHeight - 1 : ctuHeight - 4 + plane_offset;
+
+    if (!m_param->bLimitSAO || ((slice->m_sliceType == P_SLICE && !cu->isSkipped(0)) ||
+        (slice->m_sliceType != B_SLICE)))
     {
-        if (m_param->bSaoNonDeblocked)
+        // SAO_EO_2: // dir: 135
+        // SAO_EO_3: // dir: 45
+        for (int type = SAO_EO_2; type <= SAO_EO_3; type++)
         {
-            skipB = 3;
-            skipR = 4;
+            bounds[type][0] = startX;
+            bounds[type][1] = (rpelx == picWidth) ? ctuWidth - 1 : ctuWidth - 5 + plane_offset;
+            bounds[type][2] = startY;
+            bounds[type][3] = (bpely == picHeight) ? ctuHeight - 1 : ctuHeight - 4 + plane_offset;
         }
-
-        endX = (rpelx == picWidth) ? ctuWidth : ctuWidth - skipR + plane_offset;
-        endY = (bpely == picHeight) ? ctuHeight : ctuHeight - skipB + plane_offset;
-
-        primitives.saoCuStatsBO(diff, rec0, stride, endX, endY, m_offsetOrg[plane][SAO_BO], m_count[plane][SAO_BO]);
     }
+    else
+        memset(bounds[SAO_EO_2], 0, sizeof(bounds[SAO_EO_2]) * 2);
 
-    {
-        // SAO_EO_0: // dir: -
-        {
-            if (m_param->bSaoNonDeblocked)
-            {
-                skipB = 3;
-                skipR = 5;
-            }
-
-            startX = !lpelx;
-            endX   = (rpelx == picWidth) ? ctuWidth - 1 : ctuWidth - skipR + plane_offset;
-
-            primitives.saoCuStatsE0(diff + startX, rec0 + startX, stride, endX - startX, ctuHeight - skipB + plane_offset, m_offsetOrg[plane][SAO_EO_0], m_count[plane][SAO_EO_0]);
-        }
+    primitives.saoCuStatsAll(fenc0, rec0, stride, bounds, offsetOrg[plane][0], count[plane][0]);
+}
 
-        // SAO_EO_1: // dir: |
-        {
-            if (m_param->bSaoNonDeblocked)
-            {
-                skipB = 4;
-                skipR = 4;
-            }
+/* Statistics of a CTU are taken right after its deblocking finishes, while its
+ * samples are still in cache. With limitSAO the types measured depend on the
+ * decision of the left and above CTUs, so they are taken at decision time.
+ * CTUs which skip SAO as they copy a filtered reference need none, see
+ * skipCopiedSaoUnitCu() */
+void SAO::calcSaoStatsDeblocked(const SAOParam* saoParam, int idxX, int addr)
+{
+    m_bCopiesRef[idxX & 1] = m_param->bSaoSkipCopied && copiesSaoFilteredRef(addr);
+    if (m_param->bLimitSAO || m_bCopiesRef[idxX & 1])
+        return;
 
-            rec  = rec0;
+    PerPlane& count = m_countDblk[idxX & 1];
+    PerPlane& offsetOrg = m_offsetOrgDblk[idxX & 1];
 
-            startY = bAboveUnavail;
-            endX   = (rpelx == picWidth) ? ctuWidth : ctuWidth - skipR + plane_offset;
-            endY   = (bpely == picHeight) ? ctuHeight - 1 : ctuHeight - skipB + plane_offset;
-            if (startY)
-            {
-                rec += stride;
-            }
+    memset(count, 0, sizeof(count));
+    memset(offsetOrg, 0, sizeof(offsetOrg));
 
-            primitives.sign(upBuff1, rec, &rec[- stride], ctuWidth);
+    if (saoParam->bSaoFlag[0])
+        calcSaoStatsCTU(addr, 0, count, offsetOrg);
+    if (saoParam->bSaoFlag[1])
+    {
+        calcSaoStatsCTU(addr, 1, count, offsetOrg);
+        calcSaoStatsCTU(addr, 2, count, offsetOrg);
+    }
+}
 
-            primitives.saoCuStatsE1(diff + startY * MAX_CU_SIZE, rec0 + startY * stride, stride, upBuff1, endX, endY - startY, m_offsetOrg[plane][SAO_EO_1], m_count[plane][SAO_EO_1]);
-        }
-        if (!m_param->bLimitSAO || ((slice->m_sliceType == P_SLICE && !cu->isSkipped(0)) ||
-            (slice->m_sliceType != B_SLICE)))
+void SAO::addSaoStatsDeblocked(int idxX, int plane)
+{
+    for (int typeIdx = 0; typeIdx < MAX_NUM_SAO_TYPE; typeIdx++)
+    {
+        for (int classIdx = 0; classIdx < MAX_NUM_SAO_CLASS; classIdx++)
         {
-            // SAO_EO_2: // dir: 135
-            {
-                if (m_param->bSaoNonDeblocked)
-                {
-                    skipB = 4;
-                    skipR = 5;
-                }
-
-                fenc = fenc0;
-                rec  = rec0;
-
-                startX = !lpelx;
-                endX   = (rpelx == picWidth) ? ctuWidth - 1 : ctuWidth - skipR + plane_offset;
-
-                startY = bAboveUnavail;
-                endY   = (bpely == picHeight) ? ctuHeight - 1 : ctuHeight - skipB + plane_offset;
-                if (startY)
-                {
-                    fenc += stride;
-                    rec += stride;
-                }
-
-                primitives.sign(upBuff1, &rec[startX], &rec[startX - stride - 1], (endX - startX));
-
-                primitives.saoCuStatsE2(diff + startX + startY * MAX_CU_SIZE, rec0  + startX + startY * stride, stride, upBuff1, upBufft, endX - startX, endY - startY, m_offsetOrg[plane][SAO_EO_2], m_count[plane][SAO_EO_2]);
-            }
-            // SAO_EO_3: // dir: 45
-            {
-                if (m_param->bSaoNonDeblocked)
-                {
-                    skipB = 4;
-                    skipR = 5;
-                }
-                fenc = fenc0;
-                rec  = rec0;
-                startX = !lpelx;
-                endX   = (rpelx == picWidth) ? ctuWidth - 1 : ctuWidth - skipR + plane_offset;
-
-                startY = bAboveUnavail;
-                endY   = (bpely == picHeight) ? ctuHeight - 1 : ctuHeight - skipB + plane_offset;
-
-                if (startY)
-                {
-                    fenc += stride;
-                    rec += stride;
-                }
-
-                primitives.sign(upBuff1, &rec[startX - 1], &rec[startX - 1 - stride + 1], (endX - startX + 1));
-
-                primitives.saoCuStatsE3(diff + startX + startY * MAX_CU_SIZE, rec0  + startX + startY * stride, stride, upBuff1 + 1, endX - startX, endY - startY, m_offsetOrg[plane][SAO_EO_3], m_count[plane][SAO_EO_3]);
-            }
+            m_count[plane][typeIdx][classIdx] += m_countDblk[idxX & 1][plane][typeIdx][classIdx];
+            m_offsetOrg[plane][typeIdx][classIdx] += m_offsetOrgDblk[idxX & 1][plane][typeIdx][classIdx];
         }
     }
 }
@@ -1261,6 +1199,10 @@ void SAO::rdoSaoUnitCu(SAOParam* saoParam, int rowBaseAddr, int idxX, int addr)
 
     for (int i = 0; i < planes; i++)
         saoParam->ctuParam[i][addr].reset();
+    if (m_param->bSaoSkipCopied && (saoParam->bSaoFlag[0] || saoParam->bSaoFlag[1]) &&
+        skipCopiedSaoUnitCu(saoParam, allowMerge, addrMerge, idxX, addr))
+        return;
+
     // SAO distortion calculation
     m_entropyCoder.load(m_rdContexts.cur);
     m_entropyCoder.resetBits();
@@ -1290,7 +1232,10 @@ void SAO::rdoSaoUnitCu(SAOParam* saoParam, int rowBaseAddr, int idxX, int addr)
     {
         if (!m_param->bLimitSAO || !bSaoOff)
         {
-            calcSaoStatsCTU(addr, 0);
+            if (m_param->bLimitSAO)
+                calcSaoStatsCTU(addr, 0, m_count, m_offsetOrg);
+            else
+                addSaoStatsDeblocked(idxX, 0);
             saoStatsInitialOffset(addr, 0);
             saoLumaComponentParamDist(saoParam, addr, rateDist, lambda, bestCost);
         }
@@ -1301,8 +1246,16 @@ void SAO::rdoSaoUnitCu(SAOParam* saoParam, int rowBaseAddr, int idxX, int addr)
     {
         if (!m_param->bLimitSAO || ((lclCtuParam->typeIdx != -1) && !bSaoOff))
         {
-            calcSaoStatsCTU(addr, 1);
-            calcSaoStatsCTU(addr, 2);
+            if (m_param->bLimitSAO)
+            {
+                calcSaoStatsCTU(addr, 1, m_count, m_offsetOrg);
+                calcSaoStatsCTU(addr, 2, m_count, m_offsetOrg);
+            }
+            else
+            {
+                addSaoStatsDeblocked(idxX, 1);
+                addSaoStatsDeblocked(idxX, 2);
+            }
             saoStatsInitialOffset(addr, 1);
             saoChromaComponentParamDist(saoParam, addr, rateDist, lambda, bestCost);
         }
@@ -1373,6 +1326,107 @@ void SAO::rdoSaoUnitCu(SAOParam* saoParam, int rowBaseAddr, int idxX, int addr)
     }
 }
 
+/* True when every CU of the CTU is a skip with zero motion and unweighted
+ * prediction from one reference which used SAO, so that the recon is a copy
+ * of samples which were SAO filtered already */
+bool SAO::copiesSaoFilteredRef(int addr) const
+{
+    const Slice* slice = m_frame->m_encData->m_slice;
+    const CUData* cu = m_frame->m_encData->getPicCTU(addr);
+
+    if (slice->isIntra())
+        return false;
+
+    const Frame* refFrame = NULL;
+    for (uint32_t absPartIdx = 0; absPartIdx < cu->m_numPartitions; absPartIdx++)
+    {
+        if (cu->m_cuPelX + g_zscanToPelX[absPartIdx] >= (uint32_t)m_param->sourceWidth ||
+            cu->m_cuPelY + g_zscanToPelY[absPartIdx] >= (uint32_t)m_param->sourceHeight)
+            continue;
+        if (!cu->isSkipped(absPartIdx))
+            return false;
+
+        const Frame* partRef = NULL;
+        for (int list = 0; list < 2; list++)
+        {
+            if (!(cu->m_interDir[absPartIdx] & (1 << list)))
+                continue;
+
+            int refIdx = cu->m_refIdx[list][absPartIdx];
+            if (cu->m_mv[list][absPartIdx].word || slice->m_weightPredTable[list][refIdx][0].wtPresent)
+                return false;
+            if (!partRef)
+                partRef = slice->m_refFrameList[list][refIdx];
+        }
+        if (refFrame && partRef != refFrame)
+            return false;
+        refFrame = partRef;
+    }
+
+    return refFrame && refFrame->m_encData->m_slice->m_bUseSao;
+}
+
+static bool sameSaoParam(const SaoCtuParam& a, const SaoCtuParam& b)
+{
+    if (a.typeIdx != b.typeIdx)
+        return false;
+    if (a.typeIdx < 0)
+        return true;
+    if (a.typeIdx == SAO_BO && a.bandPos != b.bandPos)
+        return false;
+    return !memcmp(a.offset, b.offset, sizeof(a.offset));
+}
+
+/* Codes SAO off in place of the RDO for a CTU which copies a SAO filtered
+ * reference, as offsets applied to it would filter those samples twice. The
+ * parameters were reset to off by the caller; they are merged from the left
+ * or above CTU when that one is off as well */
+bool SAO::skipCopiedSaoUnitCu(SAOParam* saoParam, const bool allowMerge[2], const int addrMerge[2], int idxX, int addr)
+{
+    if (!m_bCopiesRef[idxX & 1])
+        return false;
+
+    bool chroma = m_param->internalCsp != X265_CSP_I400 && m_frame->m_fencPic->m_picCsp != X265_CSP_I400;
+    int planes = chroma ? 3 : 1;
+
+    /* the merge flags are coded from the luma parameters */
+    SaoMergeMode mergeMode = SAO_MERGE_NONE;
+    for (int mergeIdx = 0; mergeIdx < 2 && saoParam->bSaoFlag[0] && mergeMode == SAO_MERGE_NONE; mergeIdx++)
+    {
+        if (!allowMerge[mergeIdx])
+            continue;
+
+        bool bSame = true;
+        for (int plane = 0; plane < planes; plane++)
+            bSame = bSame && sameSaoParam(saoParam->ctuParam[plane][addr], saoParam->ctuParam[plane][addrMerge[mergeIdx]]);
+        if (bSame)
+            mergeMode = mergeIdx ? SAO_MERGE_UP : SAO_MERGE_LEFT;
+    }
+
+    m_entropyCoder.load(m_rdContexts.cur);
+    if (allowMerge[0])
+        m_entropyCoder.codeSaoMerge(mergeMode == SAO_MERGE_LEFT);
+    if (allowMerge[1] && mergeMode != SAO_MERGE_LEFT)
+        m_entropyCoder.codeSaoMerge(mergeMode == SAO_MERGE_UP);
+    for (int plane = 0; plane < planes; plane++)
+    {
+        if (!saoParam->bSaoFlag[plane > 0])
+            continue;
+        if (mergeMode != SAO_MERGE_NONE)
+            saoParam->ctuParam[plane][addr].mergeMode = mergeMode;
+        else
+            m_entropyCoder.codeSaoOffset(saoParam->ctuParam[plane][addr], plane);
+    }
+    m_entropyCoder.store(m_rdContexts.cur);
+
+    if (saoParam->ctuParam[0][addr].typeIdx < 0)
+        m_numNoSao[0]++;
+    if (chroma && saoParam->ctuParam[1][addr].typeIdx < 0)
+        m_numNoSao[1]++;
+    m_numSaoSkipped++;
+    return true;
+}
+
 // Rounds the division of initial offsets by the number of samples in
 // each of the statistics table entries.
 void SAO::saoStatsInitialOffset(int addr, int planes)
@@ -1924,6 +1978,79 @@ void saoCuStatsE3_c(const int16_t *diff, const pixel *rec, intptr_t stride, int8
     }
 }
 
+/* Statistics of all SAO types of a block in one pass over its rows; the
+ * difference of each row is taken once and shared by every type. Each type
+ * counts samples in its own bounds, {startX, endX, startY, endY} relative to
+ * the block, and empty bounds skip the type */
+void saoCuStatsAll_c(const pixel *fenc, const pixel *rec, intptr_t stride, const int32_t bounds[][4], int32_t *stats, int32_t *count)
+{
+    static const int eoOffsetX[SAO_BO] = { 1, 0, 1, -1 };
+    static const int eoOffsetY[SAO_BO] = { 0, 1, 1, 1 };
+    const int boShift = X265_DEPTH - SAO_BO_BITS;
+
+    int32_t tmp_stats[SAO_BO][SAO::NUM_EDGETYPE];
+    int32_t tmp_count[SAO_BO][SAO::NUM_EDGETYPE];
+    int16_t diff[MAX_CU_SIZE];
+
+    memset(tmp_stats, 0, sizeof(tmp_stats));
+    memset(tmp_count, 0, sizeof(tmp_count));
+
+    int startY = MAX_CU_SIZE, endY = 0, endX = 0;
+    for (int type = 0; type < MAX_NUM_SAO_TYPE; type++)
+    {
+        if (bounds[type][0] < bounds[type][1] && bounds[type][2] < bounds[type][3])
+        {
+            startY = X265_MIN(startY, bounds[type][2]);
+            endY = X265_MAX(endY, bounds[type][3]);
+            endX = X265_MAX(endX, bounds[type][1]);
+        }
+    }
+    X265_CHECK(endX <= MAX_CU_SIZE && endY <= MAX_CU_SIZE, "SAO stats bounds check failure\n");
+
+    fenc += startY * stride;
+    rec += startY * stride;
+    for (int y = startY; y < endY; y++, fenc += stride, rec += stride)
+    {
+        for (int x = 0; x < endX; x++)
+            diff[x] = (int16_t)(fenc[x] - rec[x]);
+
+        if (y >= bounds[SAO_BO][2] && y < bounds[SAO_BO][3])
+        {
+            int32_t* boStats = stats + SAO_BO * SAO::MAX_NUM_SAO_CLASS;
+            int32_t* boCount = count + SAO_BO * SAO::MAX_NUM_SAO_CLASS;
+            for (int x = bounds[SAO_BO][0]; x < bounds[SAO_BO][1]; x++)
+            {
+                int classIdx = rec[x] >> boShift;
+                boStats[classIdx] += diff[x];
+                boCount[classIdx]++;
+            }
+        }
+
+        for (int type = SAO_EO_0; type < SAO_BO; type++)
+        {
+            if (y < bounds[type][2] || y >= bounds[type][3])
+                continue;
+
+            const intptr_t offset = eoOffsetY[type] * stride + eoOffsetX[type];
+            for (int x = bounds[type][0]; x < bounds[type][1]; x++)
+            {
+                uint32_t edgeType = signOf2(rec[x], rec[x + offset]) + signOf2(rec[x], rec[x - offset]) + 2;
+                tmp_stats[type][edgeType] += diff[x];
+                tmp_count[type][edgeType]++;
+            }
+        }
+    }
+
+    for (int type = SAO_EO_0; type < SAO_BO; type++)
+    {
+        for (int x = 0; x < SAO::NUM_EDGETYPE; x++)
+        {
+            stats[type * SAO::MAX_NUM_SAO_CLASS + SAO::s_eoTable[x]] += tmp_stats[type][x];
+            count[type * SAO::MAX_NUM_SAO_CLASS + SAO::s_eoTable[x]] += tmp_count[type][x];
+        }
+    }
+}
+
 void setupSaoPrimitives_c(EncoderPrimitives &p)
 {
     // TODO: move other sao functions to here
@@ -1932,6 +2059,7 @@ void setupSaoPrimitives_c(EncoderPrimitives &p)
     p.saoCuStatsE1 = saoCuStatsE1_c;
     p.saoCuStatsE2 = saoCuStatsE2_c;
     p.saoCuStatsE3 = saoCuStatsE3_c;
+    p.saoCuStatsAll = saoCuStatsAll_c;
 }
 }
 
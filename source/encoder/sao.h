@@ -65,6 +65,11 @@ protected:
     PerPlane    m_offset;
     PerPlane    m_offsetOrg;
 
+    /* gathered as soon as a CTU is deblocked, by parity of the CTU column */
+    PerPlane    m_countDblk[2];
+    PerPlane    m_offsetOrgDblk[2];
+    bool        m_bCopiesRef[2];   // copiesSaoFilteredRef() of the CTU, with --sao-skip-copied
+
     /* allocated per CTU */
     PerPlane*   m_countPreDblk;
     PerPlane*   m_offsetOrgPreDblk;
@@ -102,6 +107,7 @@ public:
     x265_param* m_param;
     int         m_refDepth;
     int         m_numNoSao[2];
+    int         m_numSaoSkipped;
 
     SAO();
 
@@ -120,7 +126,9 @@ public:
     void generateLumaOffsets(SaoCtuParam* ctuParam, int idxY, int idxX);
     void generateChromaOffsets(SaoCtuParam* ctuParam[3], int idxY, int idxX);
 
-    void calcSaoStatsCTU(int addr, int plane);
+    void calcSaoStatsCTU(int addr, int plane, PerPlane& count, PerPlane& offsetOrg);
+    void calcSaoStatsDeblocked(const SAOParam* saoParam, int idxX, int addr);
+    void addSaoStatsDeblocked(int idxX, int plane);
     void calcSaoStatsCu_BeforeDblk(Frame* pic, int idxX, int idxY);
 
     void saoLumaComponentParamDist(SAOParam* saoParam, int addr, int64_t& rateDist, int64_t* lambda, int64_t& bestCost);
@@ -129,6 +137,8 @@ public:
     void estIterOffset(int typeIdx, int64_t lambda, int32_t count, int32_t offsetOrg, int32_t& offset, int32_t& distClasses, int64_t& costClasses);
     void rdoSaoUnitRowEnd(const SAOParam* saoParam, int numctus);
     void rdoSaoUnitCu(SAOParam* saoParam, int rowBaseAddr, int idxX, int addr);
+    bool copiesSaoFilteredRef(int addr) const;
+    bool skipCopiedSaoUnitCu(SAOParam* saoParam, const bool allowMerge[2], const int addrMerge[2], int idxX, int addr);
     int64_t calcSaoRdoCost(int64_t distortion, uint32_t bits, int64_t lambda);
     void saoStatsInitialOffset(int addr, int planes);
     friend class FrameFilter;
@@ -75,6 +75,7 @@ bool Search::initSearch(const x265_param& param, ScalingList& scalingList)
     uint32_t maxLog2CUSize = g_log2Size[param.maxCUSize];
     m_param = &param;
     m_bFrameParallel = param.frameNumThreads > 1;
+    m_bRateEstimate = param.bRateEstimate && param.rdLevel >= 3;
     m_numLayers = g_log2Size[param.maxCUSize] - 2;
 
     m_rdCost.setPsyRdScale(param.psyRd);
@@ -171,6 +172,18 @@ bool Search::initSearch(const x265_param& param, ScalingList& scalingList)
     CHECKED_MALLOC(m_tsResidual, int16_t, MAX_TS_SIZE * MAX_TS_SIZE);
     CHECKED_MALLOC(m_tsRecon,    pixel,   MAX_TS_SIZE * MAX_TS_SIZE);
 
+    if (param.subpelCacheSize)
+    {
+        m_subpelCache = new SubpelCache;
+        if (m_subpelCache->create(param))
+            m_me.subpelCache = m_subpelCache;
+        else
+        {
+            delete m_subpelCache;
+            m_subpelCache = NULL;
+        }
+    }
+
     return ok;
 
 fail:
@@ -200,6 +213,7 @@ Search::~Search()
     X265_FREE(m_tsCoeff);
     X265_FREE(m_tsResidual);
     X265_FREE(m_tsRecon);
+    delete m_subpelCache;
 }
 
 int Search::setLambdaFromQP(const CUData& ctu, int qp, int lambdaQp)
@@ -1947,7 +1961,7 @@ uint32_t Search::mergeEstimation(CUData& cu, const CUGeom& cuGeom, const Predict
         if (m_me.bChromaSATD)
             costCand += m_me.bufChromaSATD(tempYuv, pu.puAbsPartIdx);
 
-        uint32_t bitsCand = getTUBits(mergeCand, numMergeCand);
+        uint32_t bitsCand = m_bRateEstimate ? m_rqt[cuGeom.depth].cur.bitsMergePU(mergeCand, m_slice->m_maxNumMergeCand) : getTUBits(mergeCand, numMergeCand);
         costCand = costCand + m_rdCost.getCost(bitsCand);
         if (costCand < outCost)
         {
@@ -1987,6 +2001,104 @@ MV Search::getLowresMV(const CUData& cu, const PredictionUnit& pu, int list, int
     return mvs[idx] << 1; /* scale up lowres mv */
 }
 
+/* Integer-pel SAD evaluations a motion search may spend within merange. Pattern
+ * searches are bounded by their iteration limits, exhaustive ones by their window */
+static uint32_t searchBudget(int method, int merange)
+{
+    switch (method)
+    {
+    case X265_DIA_SEARCH:
+        return 4 * merange;
+    case X265_HEX_SEARCH:
+        return 6 + 3 * (merange >> 1) + 8;
+    case X265_UMH_SEARCH:
+        return 7 * merange + 12;
+    case X265_STAR_SEARCH:
+    {
+        int stages = 1;
+        while ((1 << stages) <= merange)
+            stages++;
+        return 8 * stages + 16;
+    }
+    default:
+        return (2 * merange + 1) * (2 * merange + 1);
+    }
+}
+
+/* lowres vectors agree when they are within one full resolution pel */
+static inline bool lowresMVsAgree(const MV& a, const MV& b)
+{
+    return abs(a.x - b.x) <= 2 && abs(a.y - b.y) <= 2;
+}
+
+/* Narrow the motion search of a PU when the lookahead's vector for its block
+ * is reliable: cheap relative to intra, or agreeing with the vectors of the
+ * neighbouring blocks. The range always reaches the lowres vector from the
+ * MVP. Sets the search method of m_me and returns the search range */
+int Search::getLowresMVSearchRange(const CUData& cu, const PredictionUnit& pu, int list, int ref, const MV& mvp)
+{
+    int merange = m_param->searchRange;
+    int method = m_param->searchMethod;
+    m_me.setSearchMethod(method);
+
+    int diffPoc = abs(m_slice->m_poc - m_slice->m_refPOCList[list][ref]);
+    if (diffPoc > m_param->bframes + 1)
+        return merange;
+
+    const Lowres& lowres = m_frame->m_lowres;
+    const MV* mvs = lowres.lowresMvs[list][diffPoc];
+    if (mvs[0].x == 0x7FFF)
+        return merange;
+
+    int blockX = (cu.m_cuPelX + g_zscanToPelX[pu.puAbsPartIdx] + pu.width / 2) >> 4;
+    int blockY = (cu.m_cuPelY + g_zscanToPelY[pu.puAbsPartIdx] + pu.height / 2) >> 4;
+    int stride = lowres.maxBlocksInRow;
+    int idx = blockY * stride + blockX;
+    const MV& lmv = mvs[idx];
+
+    bool bAgree = true;
+    if (blockX > 0)
+        bAgree &= lowresMVsAgree(lmv, mvs[idx - 1]);
+    if (blockX + 1 < stride)
+        bAgree &= lowresMVsAgree(lmv, mvs[idx + 1]);
+    if (blockY > 0)
+        bAgree &= lowresMVsAgree(lmv, mvs[idx - stride]);
+    if (blockY + 1 < (int)lowres.maxBlocksInCol)
+        bAgree &= lowresMVsAgree(lmv, mvs[idx + stride]);
+    bool bCheap = lowres.lowresMvCosts[list][diffPoc][idx] * 4 <= lowres.intraCost[idx];
+
+    LowresMVStats& stats = m_lowresMVStats[m_frame->m_encData->m_frameEncoderID];
+    stats.searches++;
+    if (!bAgree && !bCheap)
+        return merange;
+
+    MV dist = (lmv << 1) - mvp;
+    int reach = (X265_MAX(abs(dist.x), abs(dist.y)) + 3) >> 2;
+    int range;
+    if (bAgree && bCheap)
+    {
+        range = reach + 4;
+        method = X265_MIN(method, X265_HEX_SEARCH);
+    }
+    else
+    {
+        range = X265_MAX(reach + 8, merange >> 1);
+        method = X265_MIN(method, X265_STAR_SEARCH);
+    }
+    range = X265_MIN(range, merange);
+    if (range == merange && method == m_param->searchMethod)
+        return merange;
+
+    uint32_t fullBudget = searchBudget(m_param->searchMethod, merange);
+    uint32_t budget = searchBudget(method, range);
+    stats.adapted++;
+    if (fullBudget > budget)
+        stats.sadsSaved += fullBudget - budget;
+
+    m_me.setSearchMethod(method);
+    return range;
+}
+
 /* Pick between the two AMVP candidates which is the best one to use as
  * MVP for the motion search, based on SAD cost */
 int Search::selectMVP(const CUData& cu, const PredictionUnit& pu, const MV amvp[AMVP_NUM_CANDS], int list, int ref)
@@ -2058,6 +2170,8 @@ void Search::processPME(PME& pme, Search& slave)
         slave.setLambdaFromQP(pme.mode.cu, m_rdCost.m_qp);
         bool bChroma = slave.m_frame->m_fencPic->m_picCsp != X265_CSP_I400;
         slave.m_me.setSourcePU(*pme.mode.fencYuv, pme.pu.ctuAddr, pme.pu.cuAbsPartIdx, pme.pu.puAbsPartIdx, pme.pu.width, pme.pu.height, m_param->searchMethod, m_param->subpelRefine, bChroma);
+        if (slave.m_subpelCache)
+            slave.m_subpelCache->prepare(m_frame->m_encData->m_frameEncoderID, m_slice->m_poc, pme.pu.ctuAddr, false);
     }
 
     /* Perform ME, repeat until no more work is available */
@@ -2098,6 +2212,7 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
     int mvpIdx = selectMVP(interMode.cu, pu, amvp, list, ref);
     bool bLowresMVP = false;
     MV mvmin, mvmax, outmv, mvp = amvp[mvpIdx], mvp_lowres;
+    int merange = m_param->searchRange;
 
     if (!m_param->analysisSave && !m_param->analysisLoad) /* Prevents load/save outputs from diverging if lowresMV is not available */
     {
@@ -2106,18 +2221,20 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
             mvc[numMvc++] = lmv;
         if (m_param->bEnableHME)
             mvp_lowres = lmv;
+        if (m_param->bLowresMVConfidence)
+            merange = getLowresMVSearchRange(interMode.cu, pu, list, ref, mvp);
     }
 
-    setSearchRange(interMode.cu, mvp, m_param->searchRange, mvmin, mvmax);
+    setSearchRange(interMode.cu, mvp, merange, mvmin, mvmax);
 
-    int satdCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, m_param->searchRange, outmv, m_param->maxSlices, 
+    int satdCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, merange, outmv, m_param->maxSlices, 
       m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
 
     if (m_param->bEnableHME && mvp_lowres.notZero() && mvp_lowres != mvp)
     {
         MV outmv_lowres;
-        setSearchRange(interMode.cu, mvp_lowres, m_param->searchRange, mvmin, mvmax);
-        int lowresMvCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp_lowres, numMvc, mvc, m_param->searchRange, outmv_lowres, m_param->maxSlices,
+        setSearchRange(interMode.cu, mvp_lowres, merange, mvmin, mvmax);
+        int lowresMvCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp_lowres, numMvc, mvc, merange, outmv_lowres, m_param->maxSlices,
             m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
         if (lowresMvCost < satdCost)
         {
@@ -2409,6 +2526,7 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                     int mvpIdx = selectMVP(cu, pu, amvp, list, ref);
                     MV mvmin, mvmax, outmv, mvp = amvp[mvpIdx], mvp_lowres;
                     bool bLowresMVP = false;
+                    int merange = m_param->searchRange;
 
                     if (!m_param->analysisSave && !m_param->analysisLoad) /* Prevents load/save outputs from diverging when lowresMV is not available */
                     {
@@ -2417,6 +2535,8 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                             mvc[numMvc++] = lmv;
                         if (m_param->bEnableHME)
                             mvp_lowres = lmv;
+                        if (m_param->bLowresMVConfidence)
+                            merange = getLowresMVSearchRange(cu, pu, list, ref, mvp);
                     }
                     if (m_param->searchMethod == X265_SEA)
                     {
@@ -2425,15 +2545,15 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                         for (int planes = 0; planes < INTEGRAL_PLANE_NUM; planes++)
                             m_me.integral[planes] = interMode.fencYuv->m_integral[list][ref][planes] + puX * pu.width + puY * pu.height * m_slice->m_refFrameList[list][ref]->m_reconPic->m_stride;
                     }
-                    setSearchRange(cu, mvp, m_param->searchRange, mvmin, mvmax);
-                    int satdCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, m_param->searchRange, outmv, m_param->maxSlices, 
+                    setSearchRange(cu, mvp, merange, mvmin, mvmax);
+                    int satdCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, merange, outmv, m_param->maxSlices, 
                       m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
 
                     if (m_param->bEnableHME && mvp_lowres.notZero() && mvp_lowres != mvp)
                     {
                         MV outmv_lowres;
-                        setSearchRange(cu, mvp_lowres, m_param->searchRange, mvmin, mvmax);
-                        int lowresMvCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp_lowres, numMvc, mvc, m_param->searchRange, outmv_lowres, m_param->maxSlices,
+                        setSearchRange(cu, mvp_lowres, merange, mvmin, mvmax);
+                        int lowresMvCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp_lowres, numMvc, mvc, merange, outmv_lowres, m_param->maxSlices,
                             m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
                         if (lowresMvCost < satdCost)
                         {
@@ -2577,6 +2697,28 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
             }
         }
 
+        if (m_bRateEstimate)
+        {
+            /* replace the approximate bits in the costs of the motion search
+             * results by estimates of the bits of their prediction info */
+            for (int list = 0; list < numPredDir; list++)
+            {
+                if (bestME[list].cost != MAX_UINT)
+                {
+                    uint32_t bits = estimateMotionBits(cu, pu, cuGeom, 1 << list, bestME);
+                    bestME[list].cost = (bestME[list].cost - m_rdCost.getCost(bestME[list].bits)) + m_rdCost.getCost(bits);
+                    bestME[list].bits = bits;
+                }
+            }
+            if (bidirCost != MAX_UINT)
+            {
+                /* the cost of a zero bidir MV counts the bits of each list separately */
+                uint32_t bits = estimateMotionBits(cu, pu, cuGeom, 3, bidir);
+                bidirCost = (bidirCost - X265_MIN(bidirCost, m_rdCost.getCost(bidirBits))) + m_rdCost.getCost(bits);
+                bidirBits = bits;
+            }
+        }
+
         /* select best option and store into CU */
         if (mrgCost < bidirCost && mrgCost < bestME[0].cost && mrgCost < bestME[1].cost)
         {
@@ -2698,6 +2840,26 @@ void Search::getBlkBits(PartSize cuMode, bool bPSlice, int partIdx, uint32_t las
     }
 }
 
+/* Estimate the bits of the prediction info of motion data for the lists of interDir */
+uint32_t Search::estimateMotionBits(const CUData& cu, const PredictionUnit& pu, const CUGeom& cuGeom, uint32_t interDir, const MotionData* me) const
+{
+    int refIdx[2] = { 0, 0 };
+    int mvpIdx[2] = { 0, 0 };
+    MV mvd[2];
+
+    for (int list = 0; list < 2; list++)
+    {
+        if (interDir & (1 << list))
+        {
+            refIdx[list] = me[list].ref;
+            mvpIdx[list] = me[list].mvpIdx;
+            mvd[list] = me[list].mv - me[list].mvp;
+        }
+    }
+
+    return m_rqt[cuGeom.depth].cur.bitsInterPU(cu, pu.puAbsPartIdx, interDir, refIdx, mvd, mvpIdx);
+}
+
 /* Check if using an alternative MVP would result in a smaller MVD + signal bits */
 const MV& Search::checkBestMVP(const MV* amvpCand, const MV& mv, int& mvpIdx, uint32_t& outBits, uint32_t& outCost) const
 {
@@ -2932,9 +3094,22 @@ void Search::encodeResAndCalcRdInterCU(Mode& interMode, const CUGeom& cuGeom)
         int skipFlagBits = m_entropyCoder.getNumberOfWrittenBits();
         m_entropyCoder.codePredMode(cu.m_predMode[0]);
         m_entropyCoder.codePartSize(cu, 0, cuGeom.depth);
+        uint32_t predInfoStart = m_entropyCoder.getNumberOfWrittenBits();
         m_entropyCoder.codePredInfo(cu, 0);
         mvBits = m_entropyCoder.getNumberOfWrittenBits() - skipFlagBits;
 
+        /* modes evaluated by motion search or merge estimation carry the bits
+         * their prediction info was estimated at in sa8dBits */
+        if (m_param->bRateEstimateCheck && interMode.sa8dBits)
+        {
+            RateEstStats& stats = m_rateEstStats[m_frame->m_encData->m_frameEncoderID];
+            uint32_t predInfoBits = m_entropyCoder.getNumberOfWrittenBits() - predInfoStart;
+            stats.count++;
+            stats.estimatedBits += interMode.sa8dBits;
+            stats.codedBits += predInfoBits;
+            stats.absError += abs((int)interMode.sa8dBits - (int)predInfoBits);
+        }
+
         bool bCodeDQP = m_slice->m_pps->bUseDQP;
         m_entropyCoder.codeCoeff(cu, 0, bCodeDQP, tuDepthRange);
         bits = m_entropyCoder.getNumberOfWrittenBits();
@@ -195,6 +195,8 @@ struct CUStats
     uint64_t countPModeTasks;
     uint64_t countPModeMasters;
     uint64_t countWeightAnalyze;
+    uint64_t countContextCopies;
+    uint64_t contextBytesCopied;
     uint64_t totalCTUs;
 
     CUStats() { clear(); }
@@ -236,6 +238,8 @@ struct CUStats
         countPModeTasks += other.countPModeTasks;
         countPModeMasters += other.countPModeMasters;
         countWeightAnalyze += other.countWeightAnalyze;
+        countContextCopies += other.countContextCopies;
+        contextBytesCopied += other.contextBytesCopied;
         totalCTUs += other.totalCTUs;
 
         other.clear();
@@ -243,6 +247,55 @@ struct CUStats
 }; 
 #endif
 
+/* Motion searches narrowed by the confidence of the lookahead's motion
+ * vectors. SADs saved are estimated from the integer-pel budget of the full
+ * and the narrowed search, exhaustive methods counting their whole window */
+struct LowresMVStats
+{
+    uint64_t searches;       /* searches with a lowres motion vector available */
+    uint64_t adapted;        /* searches given a narrower range or cheaper method */
+    uint64_t sadsSaved;      /* estimated integer-pel SAD evaluations avoided */
+
+    LowresMVStats() { clear(); }
+
+    void clear()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void accumulate(const LowresMVStats& other)
+    {
+        searches += other.searches;
+        adapted += other.adapted;
+        sadsSaved += other.sadsSaved;
+    }
+};
+
+/* Bits of the prediction info of inter CUs as estimated when the CU was
+ * analysed, against the bits counted when it was coded for its RD cost */
+struct RateEstStats
+{
+    uint64_t count;          /* inter CUs coded with prediction info */
+    uint64_t estimatedBits;
+    uint64_t codedBits;
+    uint64_t absError;
+
+    RateEstStats() { clear(); }
+
+    void clear()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void accumulate(const RateEstStats& other)
+    {
+        count += other.count;
+        estimatedBits += other.estimatedBits;
+        codedBits += other.codedBits;
+        absError += other.absError;
+    }
+};
+
 inline int getTUBits(int idx, int numIdx)
 {
     return idx + (idx < numIdx - 1);
@@ -277,6 +330,7 @@ public:
     pixel*          m_tsRecon;        /* transform skip reconstructed pixels 32x32 */
 
     bool            m_bFrameParallel;
+    bool            m_bRateEstimate;  /* rank inter candidates by Entropy rate estimates */
     uint32_t        m_numLayers;
     uint32_t        m_refLagPixels;
 
@@ -291,6 +345,12 @@ public:
     CUStats         m_stats[X265_MAX_FRAME_THREADS];
 #endif
 
+    /* Accumulate lowres MV confidence statistics separately for each frame encoder */
+    LowresMVStats   m_lowresMVStats[X265_MAX_FRAME_THREADS];
+
+    /* Accumulate rate estimation errors separately for each frame encoder */
+    RateEstStats    m_rateEstStats[X265_MAX_FRAME_THREADS];
+
     Search();
     ~Search();
 
@@ -328,6 +388,7 @@ public:
     void checkDQPForSplitPred(Mode& mode, const CUGeom& cuGeom);
 
     MV getLowresMV(const CUData& cu, const PredictionUnit& pu, int list, int ref);
+    int getLowresMVSearchRange(const CUData& cu, const PredictionUnit& pu, int list, int ref, const MV& mvp);
 
     class PME : public BondedTaskGroup
     {
@@ -424,6 +485,7 @@ protected:
     const MV& checkBestMVP(const MV amvpCand[2], const MV& mv, int& mvpIdx, uint32_t& outBits, uint32_t& outCost) const;
     void     setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mvmin, MV& mvmax) const;
     uint32_t mergeEstimation(CUData& cu, const CUGeom& cuGeom, const PredictionUnit& pu, int puIdx, MergeData& m);
+    uint32_t estimateMotionBits(const CUData& cu, const PredictionUnit& pu, const CUGeom& cuGeom, uint32_t interDir, const MotionData* me) const;
     static void getBlkBits(PartSize cuMode, bool bPSlice, int puIdx, uint32_t lastMode, uint32_t blockBit[3]);
     void      updateMVP(const MV amvp, const MV& mv, uint32_t& outBits, uint32_t& outCost, const MV& alterMVP);
 
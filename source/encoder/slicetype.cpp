@@ -1006,7 +1006,9 @@ Lookahead::Lookahead(x265_param *param, ThreadPool* pool)
      * of work */
     m_bBatchFrameCosts = m_bBatchMotionSearch;
 
-    if (m_param->lookaheadSlices && !m_pool)
+    /* in deterministic mode the slices are processed serially when no pool is
+     * available, since they change the lowres motion searches and costs */
+    if (m_param->lookaheadSlices && !m_pool && !m_param->bDeterministic)
     {
         x265_log(param, X265_LOG_WARNING, "No pools found; disabling lookahead-slices\n");
         m_param->lookaheadSlices = 0;
@@ -1031,6 +1033,13 @@ Lookahead::Lookahead(x265_param *param, ThreadPool* pool)
         m_numRowsPerSlice = m_8x8Height;
         m_numCoopSlices = 1;
     }
+
+    /* Batched estimates search the whole frame while cooperative slices
+     * restrict the motion candidates at slice boundaries. Which of the two
+     * performs a given search depends on the pool size, so deterministic mode
+     * performs all the searches with the cooperative slices */
+    if (m_param->bDeterministic && m_numCoopSlices > 1)
+        m_bBatchMotionSearch = m_bBatchFrameCosts = false;
     if (param->gopLookahead && (param->gopLookahead > (param->lookaheadDepth - param->bframes - 2)))
     {
         param->gopLookahead = X265_MAX(0, param->lookaheadDepth - param->bframes - 2);
@@ -3092,7 +3101,8 @@ int64_t CostEstimateGroup::estimateFrameCost(LookaheadTLD& tld, int p0, int p1,
             m_jobAcquired = 0;
             m_lock.release();
 
-            tryBondPeers(*m_lookahead.m_pool, m_jobTotal);
+            if (m_lookahead.m_pool)
+                tryBondPeers(*m_lookahead.m_pool, m_jobTotal);
 
             processTasks(-1);
 
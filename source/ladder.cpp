@@ -0,0 +1,710 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "param.h"
+#include "threadpool.h"
+#include "ladder.h"
+
+#include <string>
+
+using namespace X265_NS;
+
+namespace {
+
+/* out.hevc becomes out_960x540.hevc */
+char* rungFileName(const char* name, int width, int height)
+{
+    std::string fname(name);
+    size_t dot = fname.rfind('.');
+    size_t slash = fname.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        dot = fname.length();
+
+    char suffix[32];
+    sprintf(suffix, "_%dx%d", width, height);
+    fname.insert(dot, suffix);
+    return strdup(fname.c_str());
+}
+
+/* averages each 2x2 block of samples of src into one sample of dst */
+template<typename T>
+void halvePlane(T* dst, intptr_t dstStride, const T* src, intptr_t srcStride, int width, int height)
+{
+    for (int y = 0; y < height; y++, dst += dstStride, src += 2 * srcStride)
+    {
+        const T* src1 = src + srcStride;
+        for (int x = 0; x < width; x++)
+            dst[x] = (T)((src[2 * x] + src[2 * x + 1] + src1[2 * x] + src1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+#define COPY_ARRAY(dst, src, type, count) \
+    if ((src) && (dst)) \
+        memcpy(dst, src, sizeof(type) * (count));
+
+/* The analysis returned with an output picture is freed by the next call to the
+ * encoder, so the analysis rung keeps a copy for the rung which loads it. The
+ * ladder shares analysis at analysis-reuse-level 10 with no distortion
+ * refinement or lookahead data, and those arrays are all this copies */
+void copyAnalysis(x265_param* param, x265_analysis_data* dst, const x265_analysis_data* src)
+{
+    *dst = *src;
+    dst->wt = NULL;
+    dst->intraData = NULL;
+    dst->interData = NULL;
+    dst->distortionData = NULL;
+    dst->modeFlag[0] = dst->modeFlag[1] = NULL;
+    dst->lookahead.vbvCost = dst->lookahead.intraVbvCost = NULL;
+    dst->lookahead.satdForVbv = dst->lookahead.intraSatdForVbv = NULL;
+    x265_alloc_analysis_data(param, dst);
+
+    uint32_t numPlanes = param->internalCsp == X265_CSP_I400 ? 1 : 3;
+    size_t count = (size_t)src->numPartitions * src->numCUsInFrame;
+
+    COPY_ARRAY(dst->wt, src->wt, x265_weight_param, numPlanes * 2);
+    for (int dir = 0; dir < 2; dir++)
+        COPY_ARRAY(dst->modeFlag[dir], src->modeFlag[dir], uint8_t, count);
+
+    if (src->intraData && dst->intraData)
+    {
+        const x265_analysis_intra_data* s = src->intraData;
+        x265_analysis_intra_data* d = dst->intraData;
+        COPY_ARRAY(d->depth, s->depth, uint8_t, count);
+        COPY_ARRAY(d->modes, s->modes, uint8_t, count);
+        COPY_ARRAY(d->partSizes, s->partSizes, char, count);
+        COPY_ARRAY(d->chromaModes, s->chromaModes, uint8_t, count);
+        COPY_ARRAY(d->cuQPOff, s->cuQPOff, int8_t, count);
+    }
+
+    if (src->interData && dst->interData)
+    {
+        const x265_analysis_inter_data* s = src->interData;
+        x265_analysis_inter_data* d = dst->interData;
+        COPY_ARRAY(d->depth, s->depth, uint8_t, count);
+        COPY_ARRAY(d->modes, s->modes, uint8_t, count);
+        COPY_ARRAY(d->partSize, s->partSize, uint8_t, count);
+        COPY_ARRAY(d->mergeFlag, s->mergeFlag, uint8_t, count);
+        COPY_ARRAY(d->interDir, s->interDir, uint8_t, count);
+        COPY_ARRAY(d->sadCost, s->sadCost, int64_t, count);
+        COPY_ARRAY(d->cuQPOff, s->cuQPOff, int8_t, count);
+        for (int dir = 0; dir < 2; dir++)
+        {
+            COPY_ARRAY(d->mvpIdx[dir], s->mvpIdx[dir], uint8_t, count);
+            COPY_ARRAY(d->refIdx[dir], s->refIdx[dir], int8_t, count);
+            COPY_ARRAY(d->mv[dir], s->mv[dir], x265_analysis_MV, count);
+        }
+    }
+}
+
+#undef COPY_ARRAY
+}
+
+LadderRung::LadderRung(AbrLadder& ladder, int id)
+    : m_ladder(ladder)
+{
+    m_id = id;
+    m_bitrate = 0;
+    m_width = m_height = 0;
+    m_param = NULL;
+    m_encoder = NULL;
+    m_output = NULL;
+    m_bOwnOutput = false;
+    m_bAnalysisRung = false;
+    m_bLoadAnalysis = false;
+    m_totalBytes = 0;
+    m_queue = NULL;
+    m_queueSize = 0;
+}
+
+LadderRung::~LadderRung()
+{
+    if (m_bOwnOutput && m_output)
+        m_output->release();
+    if (m_param)
+        m_ladder.m_api->param_free(m_param);
+    delete [] m_queue;
+}
+
+void LadderRung::enqueue(LadderFrame* frame)
+{
+    int written = m_writeCount.get();
+    int read = m_readCount.get();
+    while (written - read >= m_queueSize)
+        read = m_readCount.waitForChange(read);
+
+    m_queue[written % m_queueSize] = frame;
+    m_writeCount.incr();
+}
+
+LadderFrame* LadderRung::dequeue()
+{
+    int read = m_readCount.get();
+    int written = m_writeCount.get();
+    while (read == written)
+        written = m_writeCount.waitForChange(written);
+
+    LadderFrame* frame = m_queue[read % m_queueSize];
+    m_readCount.incr();
+    return frame;
+}
+
+int LadderRung::encode(x265_picture* pic, x265_picture& picOut)
+{
+    x265_nal* nal;
+    uint32_t numNal;
+
+    int numEncoded = m_ladder.m_api->encoder_encode(m_encoder, &nal, &numNal, pic, &picOut);
+    if (numEncoded < 0)
+    {
+        x265_log(m_param, X265_LOG_ERROR, "ladder rung %dx%d failed to encode\n", m_width, m_height);
+        m_ladder.abort();
+        return numEncoded;
+    }
+
+    if (numEncoded && m_bAnalysisRung)
+    {
+        for (std::deque<LadderFrame*>::iterator it = m_pending.begin(); it != m_pending.end(); ++it)
+        {
+            LadderFrame* frame = *it;
+            if (frame->pic[m_id].pts == picOut.pts)
+            {
+                m_pending.erase(it);
+                m_ladder.decide(frame, &picOut);
+                m_ladder.release(frame);
+                break;
+            }
+        }
+    }
+
+    if (numNal)
+        m_totalBytes += m_output->writeFrame(nal, numNal, picOut);
+    if (numEncoded)
+        m_encodedCount.incr();
+    return numEncoded;
+}
+
+void LadderRung::threadMain()
+{
+    THREAD_NAME("Ladder", m_id);
+
+    x265_picture picOut;
+    m_ladder.m_api->picture_init(m_param, &picOut);
+
+    /* a NULL frame ends the input */
+    while (LadderFrame* frame = dequeue())
+    {
+        x265_picture* pic = &frame->pic[m_id];
+        if (m_bAnalysisRung)
+            m_pending.push_back(frame);
+        else if (m_ladder.m_share != LADDER_SHARE_NONE)
+        {
+            m_ladder.waitDecision(frame);
+            pic->sliceType = frame->sliceType;
+            if (m_bLoadAnalysis)
+                pic->analysisData = frame->analysis;
+        }
+
+        if (!m_ladder.m_bAborted)
+            encode(pic, picOut);
+
+        if (!m_bAnalysisRung)
+            m_ladder.release(frame);
+        else if (m_ladder.m_bAborted)
+        {
+            /* nothing more will be decided, release the rungs waiting on us */
+            while (!m_pending.empty())
+            {
+                m_ladder.decide(m_pending.front(), NULL);
+                m_ladder.release(m_pending.front());
+                m_pending.pop_front();
+            }
+        }
+    }
+
+    while (!m_ladder.m_bAborted && encode(NULL, picOut) > 0)
+    {}
+
+    while (!m_pending.empty())
+    {
+        m_ladder.decide(m_pending.front(), NULL);
+        m_ladder.release(m_pending.front());
+        m_pending.pop_front();
+    }
+}
+
+AbrLadder::AbrLadder()
+{
+    m_api = NULL;
+    m_numRungs = 0;
+    m_inputDepth = 8;
+    m_share = LADDER_SHARE_TYPES;
+    m_bShareAnalysis = false;
+    m_bAborted = false;
+    m_freeList = NULL;
+    for (int i = 0; i < MAX_LADDER_RUNGS; i++)
+        m_rung[i] = NULL;
+}
+
+AbrLadder::~AbrLadder()
+{
+    while (m_freeList)
+    {
+        LadderFrame* next = m_freeList->next;
+        freeFrame(m_freeList);
+        m_freeList = next;
+    }
+    for (int i = 0; i < m_numRungs; i++)
+        delete m_rung[i];
+}
+
+bool AbrLadder::init(const x265_api* api, x265_param* param, const char* bitrates, const char* share,
+                     const char* outputName, InputFileInfo& info, OutputFile* output)
+{
+    m_api = api;
+    m_inputDepth = info.depth;
+
+    if (param->analysisSave || param->analysisLoad || param->rc.bStatWrite || param->rc.bStatRead ||
+        param->bEnableFrameDuplication || param->bEnableSvtHevc)
+    {
+        x265_log(param, X265_LOG_ERROR, "ladder is not compatible with analysis save/load, multi-pass, frame-dup or svt\n");
+        return false;
+    }
+    if (param->internalCsp > X265_CSP_I444)
+    {
+        x265_log(param, X265_LOG_ERROR, "ladder requires a planar input color space\n");
+        return false;
+    }
+
+    if (share)
+    {
+        static const char* const shareNames[] = { "none", "types", "analysis" };
+        m_share = -1;
+        for (int i = 0; i < 3; i++)
+            if (!strcmp(share, shareNames[i]))
+                m_share = i;
+        if (m_share < 0)
+        {
+            x265_log(param, X265_LOG_ERROR, "invalid ladder-share <%s>, expected none, types or analysis\n", share);
+            return false;
+        }
+    }
+
+    int kbps[MAX_LADDER_RUNGS];
+    for (const char* s = bitrates; *s; m_numRungs++)
+    {
+        char* end;
+        long value = strtol(s, &end, 10);
+        if (m_numRungs == MAX_LADDER_RUNGS || value <= 0 || end == s || (*end && *end != ','))
+        {
+            x265_log(param, X265_LOG_ERROR, "invalid ladder <%s>, expected up to %d comma separated bitrates\n", bitrates, MAX_LADDER_RUNGS);
+            return false;
+        }
+        kbps[m_numRungs] = (int)value;
+        s = *end ? end + 1 : end;
+    }
+    if (m_numRungs < 2)
+    {
+        x265_log(param, X265_LOG_ERROR, "ladder needs at least two bitrates\n");
+        return false;
+    }
+
+    /* rungs keep the chroma subsampling of the input, so their sizes stay
+     * multiples of the chroma block */
+    const x265_cli_csp& csp = x265_cli_csps[param->internalCsp];
+    int alignW = 1 << csp.width[1];
+    int alignH = 1 << csp.height[1];
+    int width = param->sourceWidth, height = param->sourceHeight;
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        if (i)
+        {
+            width = (width >> 1) & ~(alignW - 1);
+            height = (height >> 1) & ~(alignH - 1);
+        }
+        if (width < MIN_FRAME_WIDTH || height < MIN_FRAME_HEIGHT)
+        {
+            x265_log(param, X265_LOG_ERROR, "ladder rung %d would be %dx%d, below the minimum of %dx%d\n",
+                     i, width, height, MIN_FRAME_WIDTH, MIN_FRAME_HEIGHT);
+            return false;
+        }
+
+        m_rung[i] = new LadderRung(*this, i);
+        m_rung[i]->m_width = width;
+        m_rung[i]->m_height = height;
+        m_rung[i]->m_bitrate = kbps[i];
+    }
+
+    /* analysis can only be scaled up by exactly two */
+    if (m_share != LADDER_SHARE_NONE)
+    {
+        LadderRung& analysisRung = *m_rung[m_numRungs - 1];
+        LadderRung& loadRung = *m_rung[m_numRungs - 2];
+        analysisRung.m_bAnalysisRung = true;
+        m_bShareAnalysis = m_share == LADDER_SHARE_ANALYSIS &&
+                           loadRung.m_width == 2 * analysisRung.m_width && loadRung.m_height == 2 * analysisRung.m_height;
+        loadRung.m_bLoadAnalysis = m_bShareAnalysis;
+    }
+
+    /* Without an explicit NUMA layout, the rungs split the cores of the
+     * machine in proportion to their area instead of each starting a pool of
+     * all of them. The analysis rung counts double, every rung waits on it */
+    int totalThreads = 0;
+    if (!param->numaPools || !*param->numaPools)
+        totalThreads = ThreadPool::getCpuCount();
+    else if (strspn(param->numaPools, "0123456789") == strlen(param->numaPools))
+        totalThreads = atoi(param->numaPools);
+    double totalArea = 0;
+    for (int i = 0; i < m_numRungs; i++)
+        totalArea += (double)m_rung[i]->m_width * m_rung[i]->m_height * (m_rung[i]->m_bAnalysisRung ? 2 : 1);
+
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        LadderRung& rung = *m_rung[i];
+        x265_param* p = rung.m_param = api->param_alloc();
+        if (!p)
+        {
+            x265_log(param, X265_LOG_ERROR, "param alloc failed\n");
+            return false;
+        }
+        x265_copy_params(p, param);
+
+        p->sourceWidth = rung.m_width;
+        p->sourceHeight = rung.m_height;
+        p->rc.rateControlMode = X265_RC_ABR;
+        p->rc.bitrate = rung.m_bitrate;
+        if (i)
+        {
+            /* VBV is given for the top rung, the others scale it with their bitrate */
+            double scale = (double)rung.m_bitrate / kbps[0];
+            p->rc.vbvMaxBitrate = (int)(param->rc.vbvMaxBitrate * scale + 0.5);
+            p->rc.vbvBufferSize = (int)(param->rc.vbvBufferSize * scale + 0.5);
+            if (param->csvfn)
+                p->csvfn = rungFileName(param->csvfn, rung.m_width, rung.m_height);
+        }
+
+        if (totalThreads)
+        {
+            double area = (double)rung.m_width * rung.m_height * (rung.m_bAnalysisRung ? 2 : 1);
+            char pools[16];
+            sprintf(pools, "%d", X265_MAX(1, (int)(totalThreads * area / totalArea + 0.5)));
+            api->param_parse(p, "pools", pools);
+        }
+
+        if (m_bShareAnalysis && (rung.m_bAnalysisRung || rung.m_bLoadAnalysis))
+        {
+            p->bUseAnalysisFile = 0;
+            p->analysisReuseLevel = 10;
+            p->scaleFactor = 2;
+        }
+        if (rung.m_bAnalysisRung && m_bShareAnalysis)
+            p->analysisSave = strdup("ladder");
+        if (rung.m_bLoadAnalysis)
+        {
+            /* scaled level 10 analysis needs inter refinement */
+            p->analysisLoad = strdup("ladder");
+            if (!p->interRefine && !p->bDynamicRefine)
+                p->interRefine = 1;
+        }
+
+        if (i)
+        {
+            char* fname = rungFileName(outputName, rung.m_width, rung.m_height);
+            InputFileInfo rungInfo = info;
+            rungInfo.width = rung.m_width;
+            rungInfo.height = rung.m_height;
+            rung.m_output = OutputFile::open(fname, rungInfo);
+            rung.m_bOwnOutput = true;
+            if (rung.m_output->isFail())
+            {
+                x265_log_file(param, X265_LOG_ERROR, "failed to open output file <%s> for writing\n", fname);
+                free(fname);
+                return false;
+            }
+            general_log_file(param, rung.m_output->getName(), X265_LOG_INFO, "output file: %s\n", fname);
+            free(fname);
+        }
+        else
+            rung.m_output = output;
+    }
+
+    return true;
+}
+
+bool AbrLadder::start()
+{
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        LadderRung& rung = *m_rung[i];
+        rung.m_output->setParam(rung.m_param);
+        rung.m_encoder = m_api->encoder_open(rung.m_param);
+        if (!rung.m_encoder)
+        {
+            x265_log(rung.m_param, X265_LOG_ERROR, "failed to open encoder for ladder rung %dx%d\n", rung.m_width, rung.m_height);
+            stopRungs(0);
+            return false;
+        }
+        m_api->encoder_parameters(rung.m_encoder, rung.m_param);
+
+        if (!rung.m_param->bRepeatHeaders)
+        {
+            x265_nal* nal;
+            uint32_t numNal;
+            if (m_api->encoder_headers(rung.m_encoder, &nal, &numNal) < 0)
+            {
+                x265_log(rung.m_param, X265_LOG_ERROR, "Failure generating stream headers\n");
+                stopRungs(0);
+                return false;
+            }
+            rung.m_totalBytes += rung.m_output->writeHeaders(nal, numNal);
+        }
+    }
+
+    /* Every rung waits on the decisions of the analysis rung, which returns a
+     * picture only after its lookahead, mini-GOP and frame encoders are full.
+     * Queues deeper than that never leave the reader blocked on a rung which
+     * waits for a decision that needs more input */
+    const x265_param* p = m_rung[m_numRungs - 1]->m_param;
+    int queueSize = p->lookaheadDepth + p->bframes + p->frameNumThreads + 4;
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        m_rung[i]->m_queueSize = queueSize;
+        m_rung[i]->m_queue = new LadderFrame*[queueSize];
+    }
+
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        if (!m_rung[i]->start())
+        {
+            x265_log(m_rung[i]->m_param, X265_LOG_ERROR, "failed to start ladder thread\n");
+            stopRungs(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Undoes a start() which failed part way. The threads of the first numStarted
+ * rungs have been given no frames yet, they see the abort and end at the NULL
+ * frame without flushing. The encoders opened so far are closed */
+void AbrLadder::stopRungs(int numStarted)
+{
+    abort();
+    for (int i = 0; i < numStarted; i++)
+    {
+        m_rung[i]->enqueue(NULL);
+        m_rung[i]->stop();
+    }
+
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        if (m_rung[i]->m_encoder)
+        {
+            m_api->encoder_close(m_rung[i]->m_encoder);
+            m_rung[i]->m_encoder = NULL;
+        }
+    }
+}
+
+bool AbrLadder::push(const x265_picture& in)
+{
+    if (m_bAborted)
+        return false;
+
+    LadderFrame* frame = getFrame();
+    if (!frame)
+    {
+        x265_log(NULL, X265_LOG_ERROR, "unable to allocate ladder frame\n");
+        abort();
+        return false;
+    }
+
+    const x265_cli_csp& csp = x265_cli_csps[m_rung[0]->m_param->internalCsp];
+    int bytes = m_inputDepth > 8 ? 2 : 1;
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        x265_picture& pic = frame->pic[i];
+        for (int p = 0; p < csp.planes; p++)
+        {
+            int width = m_rung[i]->m_width >> csp.width[p];
+            int height = m_rung[i]->m_height >> csp.height[p];
+            if (!i)
+            {
+                const char* src = (const char*)in.planes[p];
+                char* dst = (char*)pic.planes[p];
+                for (int y = 0; y < height; y++, src += in.stride[p], dst += pic.stride[p])
+                    memcpy(dst, src, width * bytes);
+            }
+            else if (bytes == 1)
+                halvePlane((uint8_t*)pic.planes[p], pic.stride[p], (const uint8_t*)frame->pic[i - 1].planes[p],
+                           frame->pic[i - 1].stride[p], width, height);
+            else
+                halvePlane((uint16_t*)pic.planes[p], pic.stride[p] / 2, (const uint16_t*)frame->pic[i - 1].planes[p],
+                           frame->pic[i - 1].stride[p] / 2, width, height);
+        }
+        pic.pts = in.pts;
+        pic.poc = in.poc;
+        pic.sliceType = X265_TYPE_AUTO;
+    }
+
+    frame->sliceType = X265_TYPE_AUTO;
+    frame->bDecided = false;
+    frame->bHasAnalysis = false;
+    frame->refCount = m_numRungs;
+
+    /* the analysis rung first, it holds up the others */
+    for (int i = m_numRungs - 1; i >= 0; i--)
+        m_rung[i]->enqueue(frame);
+
+    return !m_bAborted;
+}
+
+bool AbrLadder::finish(int argc, char** argv)
+{
+    for (int i = m_numRungs - 1; i >= 0; i--)
+        m_rung[i]->enqueue(NULL);
+
+    for (int i = 0; i < m_numRungs; i++)
+        m_rung[i]->stop();
+
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        LadderRung& rung = *m_rung[i];
+        x265_stats stats;
+
+        m_api->encoder_get_stats(rung.m_encoder, &stats, sizeof(stats));
+        if (rung.m_param->csvfn && !m_bAborted)
+            m_api->encoder_log(rung.m_encoder, argc, argv);
+        m_api->encoder_close(rung.m_encoder);
+        rung.m_encoder = NULL;
+        rung.m_output->closeFile(0, 0);
+
+        x265_log(rung.m_param, X265_LOG_INFO, "ladder rung %dx%d: %u frames, %d kb/s target, %.2f kb/s\n",
+                 rung.m_width, rung.m_height, stats.encodedPictureCount, rung.m_bitrate, stats.bitrate);
+    }
+
+    return !m_bAborted;
+}
+
+void AbrLadder::decide(LadderFrame* frame, const x265_picture* picOut)
+{
+    if (picOut)
+    {
+        frame->sliceType = picOut->sliceType;
+        if (m_bShareAnalysis)
+        {
+            copyAnalysis(m_rung[m_numRungs - 1]->m_param, &frame->analysis, &picOut->analysisData);
+            frame->bHasAnalysis = true;
+        }
+    }
+
+    /* the count is bumped under its lock after the flag is set, so a waiter
+     * which read the count before seeing the flag cleared is always woken */
+    frame->bDecided = true;
+    m_decisionCount.incr();
+}
+
+void AbrLadder::waitDecision(LadderFrame* frame)
+{
+    int count = m_decisionCount.get();
+    while (!frame->bDecided && !m_bAborted)
+        count = m_decisionCount.waitForChange(count);
+}
+
+void AbrLadder::abort()
+{
+    m_bAborted = true;
+    m_decisionCount.incr();
+}
+
+void AbrLadder::release(LadderFrame* frame)
+{
+    if (ATOMIC_DEC(&frame->refCount))
+        return;
+
+    if (frame->bHasAnalysis)
+    {
+        x265_free_analysis_data(m_rung[m_numRungs - 1]->m_param, &frame->analysis);
+        frame->bHasAnalysis = false;
+    }
+
+    ScopedLock lock(m_freeLock);
+    frame->next = m_freeList;
+    m_freeList = frame;
+}
+
+LadderFrame* AbrLadder::getFrame()
+{
+    {
+        ScopedLock lock(m_freeLock);
+        if (m_freeList)
+        {
+            LadderFrame* frame = m_freeList;
+            m_freeList = frame->next;
+            return frame;
+        }
+    }
+
+    LadderFrame* frame = new LadderFrame;
+    memset(frame, 0, sizeof(*frame));
+
+    const x265_cli_csp& csp = x265_cli_csps[m_rung[0]->m_param->internalCsp];
+    int bytes = m_inputDepth > 8 ? 2 : 1;
+    for (int i = 0; i < m_numRungs; i++)
+    {
+        LadderRung& rung = *m_rung[i];
+        x265_picture& pic = frame->pic[i];
+        size_t size = 0;
+
+        m_api->picture_init(rung.m_param, &pic);
+        pic.bitDepth = m_inputDepth;
+        pic.colorSpace = rung.m_param->internalCsp;
+        pic.width = rung.m_width;
+        pic.height = rung.m_height;
+        for (int p = 0; p < csp.planes; p++)
+        {
+            pic.stride[p] = (rung.m_width >> csp.width[p]) * bytes;
+            size += (size_t)pic.stride[p] * (rung.m_height >> csp.height[p]);
+        }
+        pic.framesize = size;
+
+        frame->buf[i] = X265_MALLOC(char, size);
+        if (!frame->buf[i])
+        {
+            freeFrame(frame);
+            return NULL;
+        }
+        char* plane = frame->buf[i];
+        for (int p = 0; p < csp.planes; p++)
+        {
+            pic.planes[p] = plane;
+            plane += (size_t)pic.stride[p] * (rung.m_height >> csp.height[p]);
+        }
+    }
+    return frame;
+}
+
+void AbrLadder::freeFrame(LadderFrame* frame)
+{
+    for (int i = 0; i < m_numRungs; i++)
+        X265_FREE(frame->buf[i]);
+    delete frame;
+}
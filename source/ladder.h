@@ -0,0 +1,145 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_LADDER_H
+#define X265_LADDER_H
+
+#include "x265.h"
+#include "threading.h"
+#include "input/input.h"
+#include "output/output.h"
+
+#include <deque>
+
+namespace X265_NS {
+// private x265 namespace
+
+#define MAX_LADDER_RUNGS 8
+
+/* what the smallest rung of the ladder hands on to the others */
+enum LadderShare
+{
+    LADDER_SHARE_NONE,      /* nothing, every rung decides for itself */
+    LADDER_SHARE_TYPES,     /* its slice types and scene cuts */
+    LADDER_SHARE_ANALYSIS,  /* also its analysis, to the rung twice its size */
+};
+
+class AbrLadder;
+
+/* One picture of the input, downscaled once for every rung of the ladder. The
+ * slice type the analysis rung decides for it, and that rung's analysis of it,
+ * are handed on to the other rungs along with the picture */
+struct LadderFrame
+{
+    x265_picture       pic[MAX_LADDER_RUNGS];
+    char*              buf[MAX_LADDER_RUNGS];
+    int                sliceType;
+    volatile bool      bDecided;
+    bool               bHasAnalysis;
+    x265_analysis_data analysis;
+    int                refCount;      /* rungs which are not yet done with the frame */
+    LadderFrame*       next;
+};
+
+/* Encodes one rung of the ladder on a thread of its own, taking frames from a
+ * queue which the thread reading the input fills */
+class LadderRung : public Thread
+{
+public:
+
+    AbrLadder&        m_ladder;
+    int               m_id;
+    int               m_bitrate;
+    int               m_width;          /* size of the rung, before any padding */
+    int               m_height;
+    x265_param*       m_param;
+    x265_encoder*     m_encoder;
+    OutputFile*       m_output;
+    bool              m_bOwnOutput;
+    bool              m_bAnalysisRung;  /* decides the slice types of the ladder, saves its analysis */
+    bool              m_bLoadAnalysis;  /* loads the analysis of the analysis rung, at twice its size */
+    uint64_t          m_totalBytes;
+    ThreadSafeInteger m_encodedCount;
+
+    LadderFrame**     m_queue;
+    int               m_queueSize;
+    ThreadSafeInteger m_readCount;
+    ThreadSafeInteger m_writeCount;
+
+    LadderRung(AbrLadder& ladder, int id);
+    ~LadderRung();
+
+    void enqueue(LadderFrame* frame);
+
+protected:
+
+    std::deque<LadderFrame*> m_pending;  /* frames given to the analysis rung and not yet decided */
+
+    LadderFrame* dequeue();
+    int  encode(x265_picture* pic, x265_picture& picOut);
+    void threadMain();
+};
+
+/* Encodes one input into several resolutions and bitrates in one process. Each
+ * rung is half the width and height of the one above it and is downscaled from
+ * it, so the input is read and converted only once. Unless sharing is off, the
+ * smallest rung decides the slice types and scene cuts of all the others, and
+ * with analysis sharing the rung above it, when exactly twice its size, also
+ * loads its analysis, scaled up */
+class AbrLadder
+{
+public:
+
+    const x265_api*   m_api;
+    LadderRung*       m_rung[MAX_LADDER_RUNGS];
+    int               m_numRungs;
+    int               m_inputDepth;
+    int               m_share;
+    bool              m_bShareAnalysis;
+    volatile bool     m_bAborted;
+
+    AbrLadder();
+    ~AbrLadder();
+
+    bool init(const x265_api* api, x265_param* param, const char* bitrates, const char* share,
+              const char* outputName, InputFileInfo& info, OutputFile* output);
+    bool start();
+    bool push(const x265_picture& pic);
+    bool finish(int argc, char** argv);
+
+    void decide(LadderFrame* frame, const x265_picture* picOut);
+    void waitDecision(LadderFrame* frame);
+    void release(LadderFrame* frame);
+    void abort();
+
+protected:
+
+    LadderFrame*      m_freeList;
+    Lock              m_freeLock;
+    ThreadSafeInteger m_decisionCount;
+
+    LadderFrame* getFrame();
+    void freeFrame(LadderFrame* frame);
+    void stopRungs(int numStarted);
+};
+}
+
+#endif // ifndef X265_LADDER_H
@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+# Copyright (C) 2013-2020 MulticoreWare, Inc
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# Fits and evaluates the decision trees of --cu-predictor.
+#
+#   cupredictor.py train [--collapse] [--cpp] dump.csv [dump.csv ...] > model.txt
+#
+# fits the split and skip trees to the CSV files written by
+# --cu-predictor-dump and prints them in the --cu-predictor-model format,
+# or with --cpp as the node tables of encoder/cupredictor.cpp. --collapse
+# shrinks the trees without changing their decisions at the thresholds. The
+# built-in trees are the output of --collapse --cpp with the defaults. Dump from
+# encodes without --cu-predictor and with --no-rskip so the labels are not
+# biased by the pruning. The skip tree predicts that the remaining modes of
+# a depth can be skipped: the CU is coded skip, or it is split, in which case
+# the modes of the depth lose anyway.
+#
+#   cupredictor.py report [--x265 PATH] [--presets fast,medium,slow]
+#                         [--crf 22,27,32,37] [--model FILE] input [input ...]
+#
+# encodes every input with each preset at each CRF with and without
+# --cu-predictor and prints, per preset, the change in encode time and the
+# BD-rate (Y'CbCr PSNR) of the predictor, averaged over the inputs.
+
+import argparse
+import math
+import re
+import subprocess
+import sys
+
+FEATURES = ['depth', 'qp', 'log-cost', 'log-variance', 'log-lowres-intra', 'log-lowres-inter',
+            'neigh-depth', 'ref-depth', 'cutree-offset', 'best-skip', 'best-cbf', 'p-slice']
+
+TREES = ['split', 'skip']
+
+# --- training ----------------------------------------------------------------
+
+def read_dumps(names):
+    rows = []
+    for name in names:
+        with open(name) as f:
+            header = f.readline().strip().split(',')
+            if header[1:-2] != FEATURES or header[-2:] != ['split', 'skip']:
+                sys.exit('%s: not a cu-predictor dump of this version' % name)
+            for line in f:
+                v = line.split(',')
+                feats = tuple(float(x) for x in v[1:-2])
+                split, skip = int(v[-2]), int(v[-1])
+                rows.append((feats, split, skip or split))
+    return rows
+
+def gini(pos, n):
+    if not n:
+        return 0.0
+    p = pos / n
+    return 2 * p * (1 - p) * n
+
+def best_split(rows, label, min_leaf):
+    n = len(rows)
+    pos = sum(r[label] for r in rows)
+    parent = gini(pos, n)
+    best = None
+    for f in range(len(FEATURES)):
+        hist = {}
+        for r in rows:
+            h = hist.setdefault(r[0][f], [0, 0])
+            h[0] += 1
+            h[1] += r[label]
+        values = sorted(hist)
+        ln = lpos = 0
+        for i in range(len(values) - 1):
+            ln += hist[values[i]][0]
+            lpos += hist[values[i]][1]
+            if ln < min_leaf:
+                continue
+            if n - ln < min_leaf:
+                break
+            gain = parent - gini(lpos, ln) - gini(pos - lpos, n - ln)
+            if best is None or gain > best[0]:
+                best = (gain, f, (values[i] + values[i + 1]) / 2)
+    return best
+
+def fit(rows, label, max_depth, min_leaf):
+    # nodes are numbered breadth first, so children always follow their parent
+    nodes = []
+    queue = [(rows, 0, None)]
+    while queue:
+        part, depth, parent = queue.pop(0)
+        idx = len(nodes)
+        if parent:
+            nodes[parent[0]][parent[1]] = idx
+        pos = sum(r[label] for r in part)
+        # smoothed towards one half, small leaves never predict certainty
+        value = (pos + 1.0) / (len(part) + 2.0)
+        split = None
+        if depth < max_depth and 0 < pos < len(part):
+            split = best_split(part, label, min_leaf)
+        if not split or split[0] <= 0:
+            nodes.append([-1, 0, 0, 0, value, len(part)])
+            continue
+        _, f, thresh = split
+        nodes.append([f, thresh, 0, 0, value, len(part)])
+        queue.append(([r for r in part if r[0][f] < thresh], depth + 1, (idx, 2)))
+        queue.append(([r for r in part if r[0][f] >= thresh], depth + 1, (idx, 3)))
+    return nodes
+
+def collapse(nodes, decide):
+    # subtrees whose leaves all make the same decision become one leaf with
+    # the probability of the whole subtree, then the nodes are renumbered
+    def decisions(i):
+        n = nodes[i]
+        if n[0] < 0:
+            return set([decide(n[4])])
+        return decisions(n[2]) | decisions(n[3])
+
+    out = []
+    queue = [(0, None)]
+    while queue:
+        i, parent = queue.pop(0)
+        if parent:
+            out[parent[0]][parent[1]] = len(out)
+        n = nodes[i]
+        if n[0] < 0 or len(decisions(i)) == 1:
+            out.append([-1, 0, 0, 0, n[4]])
+            continue
+        idx = len(out)
+        out.append([n[0], n[1], 0, 0, 0])
+        queue.append((n[2], (idx, 2)))
+        queue.append((n[3], (idx, 3)))
+    return out
+
+def train(args):
+    rows = read_dumps(args.dumps)
+    if not rows:
+        sys.exit('no CUs in the dumps')
+    trees = [fit(rows, 1 + t, args.max_depth, args.min_leaf) for t in range(len(TREES))]
+    if args.collapse:
+        trees[0] = collapse(trees[0], lambda p: p <= args.split_threshold)
+        trees[1] = collapse(trees[1], lambda p: p >= args.skip_threshold)
+
+    print('# fitted to %d CUs of %d dumps' % (len(rows), len(args.dumps)))
+    for t, nodes in enumerate(trees):
+        if args.cpp:
+            print('const CUPredictor::Node s_%sTree[] =\n{' % TREES[t])
+            for n in nodes:
+                if n[0] < 0:
+                    print('    { -1, 0, 0, 0, %.3f },' % n[4])
+                else:
+                    print('    { CU_PRED_%s, %.4g, %d, %d, 0 },' % (FEATURES[n[0]].upper().replace('-', '_'), n[1], n[2], n[3]))
+            print('};\n')
+        else:
+            print('threshold %s %g' % (TREES[t], args.split_threshold if t == 0 else args.skip_threshold))
+            print('tree %s' % TREES[t])
+            for n in nodes:
+                print('%d %.4g %d %d %.3f' % (n[0], n[1], n[2], n[3], n[4]))
+
+# --- report ------------------------------------------------------------------
+
+def encode(args, preset, crf, name, predictor):
+    cmd = [args.x265, '--input', name, '--preset', preset, '--crf', str(crf), '--psnr', '--no-progress', '-o', args.output]
+    if predictor:
+        cmd.append('--cu-predictor')
+        if args.model:
+            cmd += ['--cu-predictor-model', args.model]
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True).stdout
+    m = re.search(r'encoded \d+ frames in ([\d.]+)s .* ([\d.]+) kb/s, Avg QP:[\d.]+, Global PSNR: ([\d.]+)', out)
+    if not m:
+        sys.exit('failed to encode: %s\n%s' % (' '.join(cmd), out))
+    return float(m.group(1)), float(m.group(2)), float(m.group(3))
+
+def polyfit3(x, y):
+    # least squares cubic, coefficients from the constant term up
+    a = [[sum(xi ** (i + j) for xi in x) for j in range(4)] + [sum(yi * xi ** i for xi, yi in zip(x, y))] for i in range(4)]
+    for c in range(4):
+        p = max(range(c, 4), key=lambda r: abs(a[r][c]))
+        a[c], a[p] = a[p], a[c]
+        for r in range(4):
+            if r != c:
+                k = a[r][c] / a[c][c]
+                a[r] = [vr - k * vc for vr, vc in zip(a[r], a[c])]
+    return [a[i][4] / a[i][i] for i in range(4)]
+
+def integral(c, lo, hi):
+    return sum(c[i] * (hi ** (i + 1) - lo ** (i + 1)) / (i + 1) for i in range(4))
+
+def bdrate(ref, test):
+    # Bjontegaard delta rate: log rate fitted as a cubic of PSNR, which is
+    # centered on the overlap of the curves to keep the fit well conditioned
+    lo = max(min(p for _, p in ref), min(p for _, p in test))
+    hi = min(max(p for _, p in ref), max(p for _, p in test))
+    if hi <= lo:
+        return float('nan')
+    mid = (lo + hi) / 2
+    lo, hi = lo - mid, hi - mid
+    rp, rr = [p - mid for _, p in ref], [math.log10(r) for r, _ in ref]
+    tp, tr = [p - mid for _, p in test], [math.log10(r) for r, _ in test]
+    avg = (integral(polyfit3(tp, tr), lo, hi) - integral(polyfit3(rp, rr), lo, hi)) / (hi - lo)
+    return (10 ** avg - 1) * 100
+
+def report(args):
+    crfs = [float(c) for c in args.crf.split(',')]
+    if len(crfs) < 4:
+        sys.exit('BD-rate needs at least four CRF values')
+
+    print('%-10s %12s %12s %10s %10s' % ('preset', 'time', 'time pred', 'speedup', 'BD-rate'))
+    for preset in args.presets.split(','):
+        times = [0.0, 0.0]
+        rates = []
+        for name in args.inputs:
+            points = [[], []]
+            for crf in crfs:
+                for predictor in range(2):
+                    secs, kbps, psnr = encode(args, preset, crf, name, predictor)
+                    times[predictor] += secs
+                    points[predictor].append((kbps, psnr))
+            rates.append(bdrate(points[0], points[1]))
+        print('%-10s %11.2fs %11.2fs %9.1f%% %9.2f%%' % (preset, times[0], times[1],
+              (times[0] / times[1] - 1) * 100, sum(rates) / len(rates)))
+        sys.stdout.flush()
+
+def main():
+    parser = argparse.ArgumentParser(description='fit and evaluate the trees of --cu-predictor')
+    sub = parser.add_subparsers(dest='command')
+
+    t = sub.add_parser('train', help='fit trees to --cu-predictor-dump files')
+    t.add_argument('--max-depth', type=int, default=6, help='depth of the trees (default 6)')
+    t.add_argument('--min-leaf', type=int, default=300, help='fewest CUs in a leaf (default 300)')
+    t.add_argument('--split-threshold', type=float, default=0.05, help='prune recursion at or below (default 0.05)')
+    t.add_argument('--skip-threshold', type=float, default=0.95, help='skip the modes at or above (default 0.95)')
+    t.add_argument('--collapse', action='store_true', help='merge subtrees which make one decision at the thresholds')
+    t.add_argument('--cpp', action='store_true', help='print the node tables of cupredictor.cpp')
+    t.add_argument('dumps', nargs='+')
+
+    r = sub.add_parser('report', help='speed and BD-rate of the predictor per preset')
+    r.add_argument('--x265', default='x265', help='encoder binary (default x265)')
+    r.add_argument('--presets', default='fast,medium,slow')
+    r.add_argument('--crf', default='22,27,32,37')
+    r.add_argument('--model', help='evaluate a --cu-predictor-model instead of the built-in trees')
+    r.add_argument('--output', default='cupredictor.hevc', help='scratch bitstream (default cupredictor.hevc)')
+    r.add_argument('inputs', nargs='+')
+
+    args = parser.parse_args()
+    if args.command == 'train':
+        train(args)
+    elif args.command == 'report':
+        report(args)
+    else:
+        parser.print_help()
+
+if __name__ == '__main__':
+    main()
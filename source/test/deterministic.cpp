@@ -0,0 +1,186 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "md5.h"
+
+using namespace X265_NS;
+
+/* Encodes the same synthetic clip in deterministic mode with thread pools of
+ * different sizes, through the public API only, and fails when the MD5 of any
+ * output bitstream differs from that of the single thread encode */
+
+namespace {
+
+const int width = 1280;
+const int height = 720;
+
+/* A noisy gradient with a block moving across it, so motion search, rate
+ * control and the lookahead all have work which depends on the content */
+void makePicture(uint8_t* planes[3], int frame)
+{
+    uint32_t seed = 0x1234567;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            int value = ((x + 2 * frame) >> 3) + ((y + frame) >> 2) + (int)((seed >> 24) & 15);
+            int bx = x - 13 * frame, by = y - 7 * frame;
+            if (bx >= 0 && bx < 192 && by >= 0 && by < 128)
+                value = 255 - value;
+            planes[0][y * width + x] = (uint8_t)value;
+        }
+    }
+    for (int p = 1; p < 3; p++)
+        for (int y = 0; y < height / 2; y++)
+            for (int x = 0; x < width / 2; x++)
+                planes[p][y * width / 2 + x] = (uint8_t)(128 + (p == 1 ? x - y : y - x + frame) / 8);
+}
+
+bool encode(const char* pools, int frames, uint8_t digest[16])
+{
+    x265_param* param = x265_param_alloc();
+    if (!param)
+        return false;
+
+    x265_param_default_preset(param, "medium", NULL);
+    param->sourceWidth = width;
+    param->sourceHeight = height;
+    param->fpsNum = 25;
+    param->fpsDenom = 1;
+    param->internalCsp = X265_CSP_I420;
+    param->logLevel = X265_LOG_ERROR;
+
+    /* the settings of the deterministic lines of regression-tests.txt */
+    static const char* const options[][2] =
+    {
+        { "bitrate", "3000" }, { "vbv-maxrate", "3000" }, { "vbv-bufsize", "3000" },
+        { "strict-cbr", "1" }, { "lookahead-slices", "4" }, { "deterministic", "1" },
+    };
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++)
+    {
+        if (x265_param_parse(param, options[i][0], options[i][1]))
+        {
+            printf("failed to set %s=%s\n", options[i][0], options[i][1]);
+            x265_param_free(param);
+            return false;
+        }
+    }
+    x265_param_parse(param, "pools", pools);
+
+    x265_encoder* encoder = x265_encoder_open(param);
+    if (!encoder)
+    {
+        printf("failed to open the encoder with --pools %s\n", pools);
+        x265_param_free(param);
+        return false;
+    }
+
+    uint8_t* buf = X265_MALLOC(uint8_t, width * height * 3 / 2);
+    x265_picture pic;
+    x265_picture_init(param, &pic);
+    pic.planes[0] = buf;
+    pic.planes[1] = buf + width * height;
+    pic.planes[2] = buf + width * height * 5 / 4;
+    pic.stride[0] = width;
+    pic.stride[1] = pic.stride[2] = width / 2;
+
+    MD5 md5;
+    x265_nal* nal;
+    uint32_t numNal;
+    bool bOk = true;
+
+    if (x265_encoder_headers(encoder, &nal, &numNal) < 0)
+        bOk = false;
+    for (uint32_t i = 0; bOk && i < numNal; i++)
+        md5.update(nal[i].payload, nal[i].sizeBytes);
+
+    for (int frame = 0; bOk; frame++)
+    {
+        x265_picture* in = NULL;
+        if (frame < frames)
+        {
+            makePicture((uint8_t**)pic.planes, frame);
+            pic.pts = frame;
+            in = &pic;
+        }
+
+        int ret = x265_encoder_encode(encoder, &nal, &numNal, in, NULL);
+        if (ret < 0)
+            bOk = false;
+        for (uint32_t i = 0; bOk && i < numNal; i++)
+            md5.update(nal[i].payload, nal[i].sizeBytes);
+        if (!in && !ret)
+            break;
+    }
+    md5.finalize(digest);
+
+    if (!bOk)
+        printf("encode failed with --pools %s\n", pools);
+
+    X265_FREE(buf);
+    x265_encoder_close(encoder);
+    x265_param_free(param);
+    return bOk;
+}
+
+void printDigest(const char* pools, const uint8_t digest[16])
+{
+    printf("--pools %-3s ", pools);
+    for (int i = 0; i < 16; i++)
+        printf("%02x", digest[i]);
+    printf("\n");
+}
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 20;
+    if (frames <= 0)
+    {
+        printf("usage: DeterministicTest [frames]\n");
+        return 1;
+    }
+
+    static const char* const pools[] = { "1", "4", "32" };
+    uint8_t digest[3][16];
+    int ret = 0;
+
+    printf("Encoding %d frames of %dx%d with --deterministic\n", frames, width, height);
+    for (int i = 0; i < 3; i++)
+    {
+        if (!encode(pools[i], frames, digest[i]))
+            return 1;
+
+        printDigest(pools[i], digest[i]);
+        if (i && memcmp(digest[i], digest[0], 16))
+        {
+            printf("** output with --pools %s does not match --pools %s\n", pools[i], pools[0]);
+            ret = 1;
+        }
+    }
+
+    if (!ret)
+        printf("\nAll outputs match\n");
+    x265_cleanup();
+    return ret;
+}
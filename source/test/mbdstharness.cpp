@@ -413,6 +413,51 @@ bool MBDstHarness::check_psyRdoQuant_primitive_avx2(psyRdoQuant_t1 ref, psyRdoQu
 
     return true;
 }
+bool MBDstHarness::check_rdoQuantLevelDist_primitive(rdoQuantLevelDist_t ref, rdoQuantLevelDist_t opt)
+{
+    int j = 0;
+
+    ALIGN_VAR_32(int64_t, ref_dest[MAX_TU_SIZE]);
+    ALIGN_VAR_32(int64_t, opt_dest[MAX_TU_SIZE]);
+    ALIGN_VAR_32(int64_t, ref_level[2 * 16]);
+    ALIGN_VAR_32(int64_t, opt_level[2 * 16]);
+    ALIGN_VAR_32(int16_t, levels[MAX_TU_SIZE]);
+    ALIGN_VAR_32(int32_t, scale[MAX_TU_SIZE]);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        for (int k = 0; k < MAX_TU_SIZE; k++)
+        {
+            levels[k] = (int16_t)(rand() % 32);
+            scale[k] = rand() % 1024;
+        }
+
+        int64_t psyScale = rand() & 1 ? rand() : 0;
+        int per = rand() % 9;
+        int unquantShift = 1 + rand() % 8;
+        uint32_t blkPos = 4 * (rand() % 8);
+
+        memset(ref_dest, 0, MAX_TU_SIZE * sizeof(int64_t));
+        memset(opt_dest, 0, MAX_TU_SIZE * sizeof(int64_t));
+
+        int index1 = rand() % TEST_CASES;
+
+        ref(short_test_buff[index1] + j, short_test_buff1[index1] + j, levels, scale, ref_dest, ref_level, psyScale, per, unquantShift, blkPos);
+        checked(opt, short_test_buff[index1] + j, short_test_buff1[index1] + j, levels, scale, opt_dest, opt_level, psyScale, per, unquantShift, blkPos);
+
+        if (memcmp(ref_dest, opt_dest, MAX_TU_SIZE * sizeof(int64_t)))
+            return false;
+
+        if (memcmp(ref_level, opt_level, sizeof(ref_level)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool MBDstHarness::check_count_nonzero_primitive(count_nonzero_t ref, count_nonzero_t opt)
 {
     int j = 0;
@@ -584,6 +629,17 @@ bool MBDstHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
         }
     }
     for (int i = 0; i < NUM_TR_SIZE; i++)
+    {
+        if (opt.cu[i].rdoQuantLevelDist)
+        {
+            if (!check_rdoQuantLevelDist_primitive(ref.cu[i].rdoQuantLevelDist, opt.cu[i].rdoQuantLevelDist))
+            {
+                printf("rdoQuantLevelDist[%dx%d]: Failed!\n", 4 << i, 4 << i);
+                return false;
+            }
+        }
+    }
+    for (int i = 0; i < NUM_TR_SIZE; i++)
     {
         if (opt.cu[i].count_nonzero)
         {
@@ -707,6 +763,16 @@ void MBDstHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         }
     }
     for (int value = 0; value < NUM_TR_SIZE; value++)
+    {
+        if (opt.cu[value].rdoQuantLevelDist)
+        {
+            ALIGN_VAR_32(int64_t, opt_dest[MAX_TU_SIZE]);
+            ALIGN_VAR_32(int64_t, opt_level[2 * 16]);
+            printf("rdoQuantLevelDist[%dx%d]", 4 << value, 4 << value);
+            REPORT_SPEEDUP(opt.cu[value].rdoQuantLevelDist, ref.cu[value].rdoQuantLevelDist, short_test_buff[0], short_test_buff1[0], mshortbuf2, int_test_buff[0], opt_dest, opt_level, 256, 2, 3, 0);
+        }
+    }
+    for (int value = 0; value < NUM_TR_SIZE; value++)
     {
         if (opt.cu[value].count_nonzero)
         {
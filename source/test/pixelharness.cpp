@@ -201,6 +201,34 @@ bool PixelHarness::check_pixelcmp_x4(pixelcmp_x4_t ref, pixelcmp_x4_t opt)
     return true;
 }
 
+bool PixelHarness::check_ads(pixelcmp_ads_t ref, pixelcmp_ads_t opt)
+{
+    ALIGN_VAR_16(int16_t, ref_mvs[64]);
+    ALIGN_VAR_16(int16_t, opt_mvs[64]);
+    int encDC[4];
+    int width = 64, delta = 64;
+    int j = 0;
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        for (int k = 0; k < 4; k++)
+            encDC[k] = rand() % SHORT_MAX;
+        int thresh = rand() % (4 * SHORT_MAX);
+        uint32_t* sums = (uint32_t*)int_test_buff[index] + j;
+
+        int ref_nmv = ref(encDC, sums, delta, ushort_test_buff[0] + j, ref_mvs, width, thresh);
+        int opt_nmv = (int)checked(opt, encDC, sums, delta, ushort_test_buff[0] + j, opt_mvs, width, thresh);
+
+        if (ref_nmv != opt_nmv || memcmp(ref_mvs, opt_mvs, ref_nmv * sizeof(int16_t)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_calresidual(calcresidual_t ref, calcresidual_t opt)
 {
     ALIGN_VAR_16(int16_t, ref_dest[64 * 64]);
@@ -1013,6 +1041,111 @@ bool PixelHarness::check_ssim_4x4x2_core(ssim_4x4x2_core_t ref, ssim_4x4x2_core_
     return true;
 }
 
+/* rows of up to 8 * STRIDE samples, so the vector paths see whole blocks as
+ * well as ragged row ends */
+bool PixelHarness::check_hash_crc(hash_crc_t ref, hash_crc_t opt)
+{
+    intptr_t stride = STRIDE * 8;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = rand() % TEST_CASES;
+        int width = (rand() % (int)stride) + 1;
+        int height = (rand() % 8) + 1;
+        uint32_t crc = rand() & 0xffff;
+
+        uint32_t cres = ref(pixel_test_buff[index] + j, stride, width, height, crc);
+        uint32_t vres = (uint32_t)checked(opt, pixel_test_buff[index] + j, stride, width, height, crc);
+        if (cres != vres)
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_hash_checksum(hash_checksum_t ref, hash_checksum_t opt)
+{
+    intptr_t stride = STRIDE * 8;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = rand() % TEST_CASES;
+        int width = (rand() % (int)stride) + 1;
+        int height = (rand() % 8) + 1;
+        int y = rand() % 4096;
+        uint32_t sum = rand();
+
+        uint32_t cres = ref(pixel_test_buff[index] + j, stride, width, height, y, sum);
+        uint32_t vres = (uint32_t)checked(opt, pixel_test_buff[index] + j, stride, width, height, y, sum);
+        if (cres != vres)
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_vif_stats(vif_stats_t ref, vif_stats_t opt)
+{
+    uint32_t cres[5], vres[5];
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index1 = rand() % TEST_CASES;
+        int index2 = rand() % TEST_CASES;
+
+        ref(pixel_test_buff[index1] + j, STRIDE, pixel_test_buff[index2] + j, STRIDE, cres);
+        checked(opt, pixel_test_buff[index1] + j, STRIDE, pixel_test_buff[index2] + j, STRIDE, vres);
+        if (memcmp(cres, vres, sizeof(cres)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_adm_stats(adm_stats_t ref, adm_stats_t opt)
+{
+    ALIGN_VAR_16(pixel, ref_next[2][32]);
+    ALIGN_VAR_16(pixel, opt_next[2][32]);
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index1 = rand() % TEST_CASES;
+        int index2 = rand() % TEST_CASES;
+        int width = 1 + rand() % 32;
+        bool bNext = rand() & 1;
+        uint64_t cres[2] = { 0, 0 };
+        uint64_t vres[2] = { 0, 0 };
+
+        memset(ref_next, 0, sizeof(ref_next));
+        memset(opt_next, 0, sizeof(opt_next));
+
+        ref(pixel_test_buff[index1] + j, STRIDE, pixel_test_buff[index2] + j, STRIDE, width,
+            bNext ? ref_next[0] : NULL, bNext ? ref_next[1] : NULL, cres);
+        checked(opt, pixel_test_buff[index1] + j, STRIDE, pixel_test_buff[index2] + j, STRIDE, width,
+                bNext ? opt_next[0] : NULL, bNext ? opt_next[1] : NULL, vres);
+        if (memcmp(cres, vres, sizeof(cres)) || memcmp(ref_next, opt_next, sizeof(ref_next)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_ssim_end(ssim_end4_t ref, ssim_end4_t opt)
 {
     ALIGN_VAR_32(int, sum0[5][4]);
@@ -1462,6 +1595,51 @@ bool PixelHarness::check_saoCuStatsE3_t(saoCuStatsE3_t ref, saoCuStatsE3_t opt)
     return true;
 }
 
+bool PixelHarness::check_saoCuStatsAll_t(saoCuStatsAll_t ref, saoCuStatsAll_t opt)
+{
+    enum { NUM_STATS = 5 * 32 };
+    int32_t stats_ref[NUM_STATS];
+    int32_t stats_vec[NUM_STATS];
+
+    int32_t count_ref[NUM_STATS];
+    int32_t count_vec[NUM_STATS];
+
+    int32_t bounds[5][4];
+    intptr_t stride = 64 + 16;
+
+    int j = 0;
+    for (int i = 0; i < ITERS; i++)
+    {
+        for (int x = 0; x < NUM_STATS; x++)
+        {
+            stats_ref[x] = stats_vec[x] = rand();
+            count_ref[x] = count_vec[x] = rand();
+        }
+
+        // {startX, endX, startY, endY} as calcSaoStatsCTU derives them for EO 0..3 and BO
+        int width = 8 << (rand() % 4);
+        int height = 8 << (rand() % 4);
+        for (int type = 0; type < 5; type++)
+        {
+            bounds[type][0] = (type == 1 || type == 4) ? 0 : rand() % 2;
+            bounds[type][1] = width - (rand() % 6);
+            bounds[type][2] = (type == 0 || type == 4) ? 0 : rand() % 2;
+            bounds[type][3] = height - (rand() % 6);
+        }
+
+        ref(pbuf2 + stride + 1 + j, pbuf3 + stride + 1 + j, stride, bounds, stats_ref, count_ref);
+        checked(opt, pbuf2 + stride + 1 + j, pbuf3 + stride + 1 + j, stride, bounds, stats_vec, count_vec);
+
+        if (memcmp(stats_ref, stats_vec, sizeof(stats_ref)) || memcmp(count_ref, count_vec, sizeof(count_ref)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_saoCuOrgE3_32_t(saoCuOrgE3_t ref, saoCuOrgE3_t opt)
 {
     ALIGN_VAR_16(pixel, ref_dest[64 * 64]);
@@ -2138,6 +2316,74 @@ bool PixelHarness::check_pelFilterLumaStrong_V(pelFilterLumaStrong_t ref, pelFil
     return true;
 }
 
+bool PixelHarness::check_pelFilterLumaEdge_H(pelFilterLumaEdge_t ref, pelFilterLumaEdge_t opt)
+{
+    intptr_t srcStep = 1, offset = 64;
+    int16_t beta[8], tc[8];
+    int j = 0;
+
+    pixel pixel_test_buff1[TEST_CASES][BUFFSIZE];
+    for (int i = 0; i < TEST_CASES; i++)
+        memcpy(pixel_test_buff1[i], pixel_test_buff[i], sizeof(pixel) * BUFFSIZE);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            beta[k] = (int16_t)((rand() % 65) << (X265_DEPTH - 8));
+            tc[k]   = (int16_t)((rand() % 25) << (X265_DEPTH - 8));
+        }
+
+        int index = rand() % 3;
+        int numSegs = 2 * (1 + rand() % 4);
+
+        ref(pixel_test_buff[index]  + 4 * offset + j, srcStep, offset, beta, tc, numSegs);
+        checked(opt, pixel_test_buff1[index] + 4 * offset + j, srcStep, offset, beta, tc, numSegs);
+
+        if (memcmp(pixel_test_buff[index], pixel_test_buff1[index], sizeof(pixel) * BUFFSIZE))
+            return false;
+
+        reportfail()
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_pelFilterLumaEdge_V(pelFilterLumaEdge_t ref, pelFilterLumaEdge_t opt)
+{
+    intptr_t srcStep = 64, offset = 1;
+    int16_t beta[8], tc[8];
+    int j = 0;
+
+    pixel pixel_test_buff1[TEST_CASES][BUFFSIZE];
+    for (int i = 0; i < TEST_CASES; i++)
+        memcpy(pixel_test_buff1[i], pixel_test_buff[i], sizeof(pixel) * BUFFSIZE);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            beta[k] = (int16_t)((rand() % 65) << (X265_DEPTH - 8));
+            tc[k]   = (int16_t)((rand() % 25) << (X265_DEPTH - 8));
+        }
+
+        int index = rand() % 3;
+        int numSegs = 2 * (1 + rand() % 4);
+
+        ref(pixel_test_buff[index]  + 4 + j, srcStep, offset, beta, tc, numSegs);
+        checked(opt, pixel_test_buff1[index] + 4 + j, srcStep, offset, beta, tc, numSegs);
+
+        if (memcmp(pixel_test_buff[index], pixel_test_buff1[index], sizeof(pixel) * BUFFSIZE))
+            return false;
+
+        reportfail()
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_pelFilterChroma_H(pelFilterChroma_t ref, pelFilterChroma_t opt)
 {
     intptr_t srcStep = 1, offset = 64;
@@ -2357,6 +2603,14 @@ bool PixelHarness::testPU(int part, const EncoderPrimitives& ref, const EncoderP
             return false;
         }
     }
+    if (opt.pu[part].ads)
+    {
+        if (!check_ads(ref.pu[part].ads, opt.pu[part].ads))
+        {
+            printf("ads[%s]: failed!\n", lumaPartStr[part]);
+            return false;
+        }
+    }
     if (opt.pu[part].pixelavg_pp[NONALIGNED])
     {
         if (!check_pixelavg_pp(ref.pu[part].pixelavg_pp[NONALIGNED], opt.pu[part].pixelavg_pp[NONALIGNED]))
@@ -2838,6 +3092,42 @@ bool PixelHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
         }
     }
 
+    if (opt.hash_crc)
+    {
+        if (!check_hash_crc(ref.hash_crc, opt.hash_crc))
+        {
+            printf("hash_crc failed!\n");
+            return false;
+        }
+    }
+
+    if (opt.hash_checksum)
+    {
+        if (!check_hash_checksum(ref.hash_checksum, opt.hash_checksum))
+        {
+            printf("hash_checksum failed!\n");
+            return false;
+        }
+    }
+
+    if (opt.vif_stats)
+    {
+        if (!check_vif_stats(ref.vif_stats, opt.vif_stats))
+        {
+            printf("vif_stats failed!\n");
+            return false;
+        }
+    }
+
+    if (opt.adm_stats)
+    {
+        if (!check_adm_stats(ref.adm_stats, opt.adm_stats))
+        {
+            printf("adm_stats failed!\n");
+            return false;
+        }
+    }
+
     if (opt.sign)
     {
         if (!check_calSign(ref.sign, opt.sign))
@@ -2958,6 +3248,15 @@ bool PixelHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
         }
     }
 
+    if (opt.saoCuStatsAll)
+    {
+        if (!check_saoCuStatsAll_t(ref.saoCuStatsAll, opt.saoCuStatsAll))
+        {
+            printf("saoCuStatsAll failed\n");
+            return false;
+        }
+    }
+
     if (opt.planecopy_sp)
     {
         if (!check_planecopy_sp(ref.planecopy_sp, opt.planecopy_sp))
@@ -3076,6 +3375,24 @@ bool PixelHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
         }
     }
 
+    if (opt.pelFilterLumaEdge[0])
+    {
+        if (!check_pelFilterLumaEdge_V(ref.pelFilterLumaEdge[0], opt.pelFilterLumaEdge[0]))
+        {
+            printf("pelFilterLumaEdge Vertical failed!\n");
+            return false;
+        }
+    }
+
+    if (opt.pelFilterLumaEdge[1])
+    {
+        if (!check_pelFilterLumaEdge_H(ref.pelFilterLumaEdge[1], opt.pelFilterLumaEdge[1]))
+        {
+            printf("pelFilterLumaEdge Horizontal failed!\n");
+            return false;
+        }
+    }
+
     if (opt.pelFilterChroma[0])
     {
         if (!check_pelFilterChroma_V(ref.pelFilterChroma[0], opt.pelFilterChroma[0]))
@@ -3209,6 +3526,14 @@ void PixelHarness::measurePartition(int part, const EncoderPrimitives& ref, cons
         REPORT_SPEEDUP(opt.pu[part].sad_x4, ref.pu[part].sad_x4, pbuf1, fref, fref + 1, fref - 1, fref - INCR, FENC_STRIDE + 5, &cres[0]);
     }
 
+    if (opt.pu[part].ads)
+    {
+        ALIGN_VAR_16(int16_t, mvs[64]);
+        int encDC[4] = { 1024, 2048, 3072, 4096 };
+        HEADER("ads[%s]", lumaPartStr[part]);
+        REPORT_SPEEDUP(opt.pu[part].ads, ref.pu[part].ads, encDC, (uint32_t*)ibuf1, 64, (uint16_t*)sbuf1, mvs, 64, 1 << 16);
+    }
+
     if (opt.pu[part].copy_pp)
     {
         HEADER("copy_pp[%s]", lumaPartStr[part]);
@@ -3522,6 +3847,32 @@ void PixelHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         REPORT_SPEEDUP(opt.ssim_end_4, ref.ssim_end_4, (int(*)[4])pbuf2, (int(*)[4])pbuf1, 4);
     }
 
+    if (opt.hash_crc)
+    {
+        HEADER0("hash_crc");
+        REPORT_SPEEDUP(opt.hash_crc, ref.hash_crc, pbuf1, 64, 64, 64, 0xffff);
+    }
+
+    if (opt.hash_checksum)
+    {
+        HEADER0("hash_checksum");
+        REPORT_SPEEDUP(opt.hash_checksum, ref.hash_checksum, pbuf1, 64, 64, 64, 0, 0);
+    }
+
+    if (opt.vif_stats)
+    {
+        uint32_t sums[5];
+        HEADER0("vif_stats");
+        REPORT_SPEEDUP(opt.vif_stats, ref.vif_stats, pbuf1, STRIDE, pbuf2, STRIDE, sums);
+    }
+
+    if (opt.adm_stats)
+    {
+        uint64_t sums[2] = { 0, 0 };
+        HEADER0("adm_stats");
+        REPORT_SPEEDUP(opt.adm_stats, ref.adm_stats, pbuf1, STRIDE, pbuf2, STRIDE, 32, pbuf3, pbuf4, sums);
+    }
+
     if (opt.sign)
     {
         HEADER0("calSign");
@@ -3619,6 +3970,14 @@ void PixelHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         REPORT_SPEEDUP(opt.saoCuStatsE3, ref.saoCuStatsE3, sbuf2, pbuf3, 64, upBuff1 + 1, 60, 61, stats, count);
     }
 
+    if (opt.saoCuStatsAll)
+    {
+        int32_t bounds[5][4] = { { 1, 59, 0, 60 }, { 0, 59, 1, 60 }, { 1, 59, 1, 60 }, { 1, 59, 1, 60 }, { 0, 59, 0, 60 } };
+        int32_t stats[5 * 32], count[5 * 32];
+        HEADER0("saoCuStatsAll");
+        REPORT_SPEEDUP(opt.saoCuStatsAll, ref.saoCuStatsAll, pbuf2 + 64 + 1, pbuf3 + 64 + 1, 64, bounds, stats, count);
+    }
+
     if (opt.planecopy_sp)
     {
         HEADER0("planecopy_sp");
@@ -3725,6 +4084,30 @@ void PixelHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         REPORT_SPEEDUP(opt.pelFilterLumaStrong[1], ref.pelFilterLumaStrong[1], pbuf1, 1, STRIDE, tcP, tcQ);
     }
 
+    if (opt.pelFilterLumaEdge[0])
+    {
+        int16_t beta[16], tc[16];
+        for (int k = 0; k < 16; k++)
+        {
+            beta[k] = (int16_t)((rand() % 65) << (X265_DEPTH - 8));
+            tc[k]   = (int16_t)((rand() % 25) << (X265_DEPTH - 8));
+        }
+        HEADER0("pelFilterLumaEdge_Vertical");
+        REPORT_SPEEDUP(opt.pelFilterLumaEdge[0], ref.pelFilterLumaEdge[0], pbuf1 + 4, STRIDE, 1, beta, tc, 16);
+    }
+
+    if (opt.pelFilterLumaEdge[1])
+    {
+        int16_t beta[16], tc[16];
+        for (int k = 0; k < 16; k++)
+        {
+            beta[k] = (int16_t)((rand() % 65) << (X265_DEPTH - 8));
+            tc[k]   = (int16_t)((rand() % 25) << (X265_DEPTH - 8));
+        }
+        HEADER0("pelFilterLumaEdge_Horizontal");
+        REPORT_SPEEDUP(opt.pelFilterLumaEdge[1], ref.pelFilterLumaEdge[1], pbuf1 + 4 * STRIDE, 1, STRIDE, beta, tc, 16);
+    }
+
     if (opt.pelFilterChroma[0])
     {
         int32_t tc = (rand() % PIXEL_MAX);
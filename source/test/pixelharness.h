@@ -74,6 +74,7 @@ protected:
     bool check_pixel_sse_ss(pixel_sse_ss_t ref, pixel_sse_ss_t opt);
     bool check_pixelcmp_x3(pixelcmp_x3_t ref, pixelcmp_x3_t opt);
     bool check_pixelcmp_x4(pixelcmp_x4_t ref, pixelcmp_x4_t opt);
+    bool check_ads(pixelcmp_ads_t ref, pixelcmp_ads_t opt);
     bool check_copy_pp(copy_pp_t ref, copy_pp_t opt);
     bool check_copy_sp(copy_sp_t ref, copy_sp_t opt);
     bool check_copy_ps(copy_ps_t ref, copy_ps_t opt);
@@ -118,6 +119,7 @@ protected:
     bool check_saoCuStatsE1_t(saoCuStatsE1_t ref, saoCuStatsE1_t opt);
     bool check_saoCuStatsE2_t(saoCuStatsE2_t ref, saoCuStatsE2_t opt);
     bool check_saoCuStatsE3_t(saoCuStatsE3_t ref, saoCuStatsE3_t opt);
+    bool check_saoCuStatsAll_t(saoCuStatsAll_t ref, saoCuStatsAll_t opt);
     bool check_planecopy_sp(planecopy_sp_t ref, planecopy_sp_t opt);
     bool check_planecopy_cp(planecopy_cp_t ref, planecopy_cp_t opt);
     bool check_cutree_propagate_cost(cutree_propagate_cost ref, cutree_propagate_cost opt);
@@ -132,12 +134,18 @@ protected:
     bool check_costC1C2Flag(costC1C2Flag_t ref, costC1C2Flag_t opt);
     bool check_pelFilterLumaStrong_V(pelFilterLumaStrong_t ref, pelFilterLumaStrong_t opt);
     bool check_pelFilterLumaStrong_H(pelFilterLumaStrong_t ref, pelFilterLumaStrong_t opt);
+    bool check_pelFilterLumaEdge_V(pelFilterLumaEdge_t ref, pelFilterLumaEdge_t opt);
+    bool check_pelFilterLumaEdge_H(pelFilterLumaEdge_t ref, pelFilterLumaEdge_t opt);
     bool check_pelFilterChroma_V(pelFilterChroma_t ref, pelFilterChroma_t opt);
     bool check_pelFilterChroma_H(pelFilterChroma_t ref, pelFilterChroma_t opt);
     bool check_integral_initv(integralv_t ref, integralv_t opt);
     bool check_integral_inith(integralh_t ref, integralh_t opt);
     bool check_ssimDist(ssimDistortion_t ref, ssimDistortion_t opt);
     bool check_normFact(normFactor_t ref, normFactor_t opt, int block);
+    bool check_hash_crc(hash_crc_t ref, hash_crc_t opt);
+    bool check_hash_checksum(hash_checksum_t ref, hash_checksum_t opt);
+    bool check_vif_stats(vif_stats_t ref, vif_stats_t opt);
+    bool check_adm_stats(adm_stats_t ref, adm_stats_t opt);
 
 public:
 
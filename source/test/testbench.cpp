@@ -166,6 +166,7 @@ int main(int argc, char *argv[])
         { "SSE3", X265_CPU_SSE3 },
         { "SSSE3", X265_CPU_SSSE3 },
         { "SSE4", X265_CPU_SSE4 },
+        { "PCLMUL", X265_CPU_SSE4 | X265_CPU_PCLMUL },
         { "AVX", X265_CPU_AVX },
         { "XOP", X265_CPU_XOP },
         { "AVX2", X265_CPU_AVX2 },
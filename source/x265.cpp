@@ -32,6 +32,7 @@
 #include "output/output.h"
 #include "output/reconplay.h"
 #include "svt.h"
+#include "ladder.h"
 
 #if HAVE_VLD
 /* Visual Leak Detector */
@@ -74,6 +75,7 @@ struct CLIOptions
     InputFile* input;
     ReconFile* recon;
     OutputFile* output;
+    AbrLadder*  ladder;
     FILE*       qpfile;
     FILE*       zoneFile;
     FILE*    dolbyVisionRpu;    /* File containing Dolby Vision BL RPU metadata */
@@ -98,6 +100,7 @@ struct CLIOptions
         input = NULL;
         recon = NULL;
         output = NULL;
+        ladder = NULL;
         qpfile = NULL;
         zoneFile = NULL;
         dolbyVisionRpu = NULL;
@@ -139,6 +142,8 @@ void CLIOptions::destroy()
     if (dolbyVisionRpu)
         fclose(dolbyVisionRpu);
     dolbyVisionRpu = NULL;
+    delete ladder;
+    ladder = NULL;
     if (output)
         output->release();
     output = NULL;
@@ -285,6 +290,8 @@ bool CLIOptions::parse(int argc, char **argv)
     const char *inputfn = NULL;
     const char *reconfn = NULL;
     const char *outputfn = NULL;
+    const char *ladderSpec = NULL;
+    const char *ladderShare = NULL;
     const char *preset = NULL;
     const char *tune = NULL;
     const char *profile = NULL;
@@ -422,6 +429,8 @@ bool CLIOptions::parse(int argc, char **argv)
             OPT("output") outputfn = optarg;
             OPT("input") inputfn = optarg;
             OPT("recon") reconfn = optarg;
+            OPT("ladder") ladderSpec = optarg;
+            OPT("ladder-share") ladderShare = optarg;
             OPT("input-depth") inputBitDepth = (uint32_t)x265_atoi(optarg, bError);
             OPT("dither") this->bDither = true;
             OPT("recon-depth") reconFileBitDepth = (uint32_t)x265_atoi(optarg, bError);
@@ -609,6 +618,12 @@ bool CLIOptions::parse(int argc, char **argv)
 
     this->input->startReader();
 
+    if ((reconfn || reconPlayCmd) && param->bSkipNonRefFilter)
+    {
+        x265_log(param, X265_LOG_WARNING, "skip-nonref-filter is not compatible with recon output, disabling\n");
+        param->bSkipNonRefFilter = 0;
+    }
+
     if (reconfn)
     {
         if (reconFileBitDepth == 0)
@@ -651,6 +666,17 @@ bool CLIOptions::parse(int argc, char **argv)
         return true;
     }
 #endif
+    /* a segment plan run encodes nothing, so no output file is opened */
+    if (param->segmentPlanFile)
+    {
+        if (ladderSpec)
+        {
+            x265_log(param, X265_LOG_ERROR, "ladder is not compatible with segment-plan\n");
+            return true;
+        }
+        return false;
+    }
+
     this->output = OutputFile::open(outputfn, info);
     if (this->output->isFail())
     {
@@ -658,6 +684,18 @@ bool CLIOptions::parse(int argc, char **argv)
         return true;
     }
     general_log_file(param, this->output->getName(), X265_LOG_INFO, "output file: %s\n", outputfn);
+
+    if (ladderSpec)
+    {
+        if (reconfn || reconPlayCmd || qpfile || zoneFile || dolbyVisionRpu || bDither || param->bField)
+        {
+            x265_log(param, X265_LOG_ERROR, "ladder is not compatible with recon, qpfile, zonefile, dolby-vision-rpu, dither or field coding\n");
+            return true;
+        }
+        this->ladder = new AbrLadder;
+        if (!this->ladder->init(api, param, ladderSpec, ladderShare, outputfn, info, this->output))
+            return true;
+    }
     return false;
 }
 
@@ -835,6 +873,50 @@ static int rpuParser(x265_picture * pic, FILE * ptr)
 }
 
 
+/* Reads the input once and hands every picture to all rungs of the ladder,
+ * which encode on threads of their own. Progress is that of the top rung */
+static int encodeLadder(CLIOptions& cliopt, int argc, char **argv)
+{
+    x265_param* param = cliopt.param;
+    AbrLadder* ladder = cliopt.ladder;
+    LadderRung* top = ladder->m_rung[0];
+
+    if (!ladder->start())
+        return 2;
+
+    if (signal(SIGINT, sigint_handler) == SIG_ERR)
+        x265_log(param, X265_LOG_ERROR, "Unable to register CTRL+C handler: %s\n", strerror(errno));
+
+    x265_picture pic;
+    cliopt.api->picture_init(param, &pic);
+    uint32_t inFrameCount = 0;
+
+    while (!b_ctrl_c)
+    {
+        if (cliopt.framesToBeEncoded && inFrameCount >= cliopt.framesToBeEncoded)
+            break;
+        if (!cliopt.input->readPicture(pic))
+            break;
+
+        pic.pts = pic.poc = inFrameCount++;
+        if (!ladder->push(pic))
+            break;
+
+        cliopt.totalbytes = top->m_totalBytes;
+        cliopt.printStatus(top->m_encodedCount.get());
+    }
+
+    bool bOk = ladder->finish(argc, argv);
+    if (cliopt.bProgress)
+        fprintf(stderr, "%*s\r", 80, " ");
+
+    if (b_ctrl_c)
+        general_log(param, NULL, X265_LOG_INFO, "aborted at input frame %d, output frame %d\n",
+                    cliopt.seek + inFrameCount, top->m_encodedCount.get());
+
+    return bOk ? 0 : 4;
+}
+
 /* CLI return codes:
  *
  * 0 - encode successful
@@ -870,13 +952,29 @@ int main(int argc, char **argv)
         exit(1);
     }
 
+    if (cliopt.ladder)
+    {
+        int ladderRet = encodeLadder(cliopt, argc, argv);
+        cliopt.api->cleanup();
+        cliopt.destroy();
+        cliopt.api->param_free(cliopt.param);
+        SetConsoleTitle(orgConsoleTitle);
+        SetThreadExecutionState(ES_CONTINUOUS);
+#if _WIN32
+        if (argv != orgArgv)
+            free(argv);
+#endif
+        return ladderRet;
+    }
+
     x265_param* param = cliopt.param;
     const x265_api* api = cliopt.api;
 #if ENABLE_LIBVMAF
     x265_vmaf_data* vmafdata = cliopt.vmafData;
 #endif
     /* This allows muxers to modify bitstream format */
-    cliopt.output->setParam(param);
+    if (cliopt.output)
+        cliopt.output->setParam(param);
 
     if (cliopt.reconPlayCmd)
         reconPlay = new ReconPlay(cliopt.reconPlayCmd, *param);
@@ -905,6 +1003,23 @@ int main(int argc, char **argv)
         exit(2);
     }
 
+    /* the segment plan was written when the encoder opened, nothing to encode */
+    if (param->segmentPlanFile)
+    {
+        api->encoder_close(encoder);
+        api->cleanup();
+        delete reconPlay;
+        cliopt.destroy();
+        api->param_free(param);
+        SetConsoleTitle(orgConsoleTitle);
+        SetThreadExecutionState(ES_CONTINUOUS);
+#if _WIN32
+        if (argv != orgArgv)
+            free(argv);
+#endif
+        return 0;
+    }
+
     /* get the encoder parameters post-initialization */
     api->encoder_parameters(encoder, param);
 
@@ -302,6 +302,15 @@ typedef struct x265_frame_stats
     double           totalFrameTime;
     double           vmafFrameScore;
     double           bufferFillFinal;
+    double           rateControlStartTime;
+    uint64_t         lowresMVSearches;
+    uint64_t         lowresMVAdapted;
+    uint64_t         lowresMVSADsSaved;
+    double           vmafVif[4];
+    double           vmafAdm;
+    double           vmafMotion;
+    int              saoSkippedCTUs;
+    uint64_t         borderBytesSaved;
 } x265_frame_stats;
 
 typedef struct x265_ctu_info_t
@@ -523,6 +532,7 @@ typedef enum
                                              * new SLOW flags. */
 #define X265_CPU_SLOW_PSHUFB     (1 << 24)  /* such as on the Intel Atom */
 #define X265_CPU_SLOW_PALIGNR    (1 << 25)  /* such as on the AMD Bobcat */
+#define X265_CPU_PCLMUL          (1 << 26)  /* PCLMULQDQ carry-less multiply */
 
 /* ARM */
 #define X265_CPU_ARMV6           0x0000001
@@ -598,6 +608,9 @@ typedef enum
 #define X265_ANALYSIS_SAVE 1
 #define X265_ANALYSIS_LOAD 2
 
+#define X265_STATS_FORMAT_TEXT   0
+#define X265_STATS_FORMAT_BINARY 1
+
 typedef struct x265_cli_csp
 {
     int planes;
@@ -672,6 +685,7 @@ static const char * const x265_sar_names[] = { "unknown", "1:1", "12:11", "10:11
                                                "32:11", "80:33", "18:11", "15:11", "64:33", "160:99", "4:3", "3:2", "2:1", 0 };
 static const char * const x265_interlace_names[] = { "prog", "tff", "bff", 0 };
 static const char * const x265_analysis_names[] = { "off", "save", "load", 0 };
+static const char * const x265_stats_format_names[] = { "text", "binary", 0 };
 
 struct x265_zone;
 struct x265_param;
@@ -1859,6 +1873,138 @@ typedef struct x265_param
 
     /* Enable HME search ranges for L0, L1 and L2 respectively. */
     int       hmeRange[3];
+
+    /* Make the output bitstream independent of thread scheduling and of the
+     * size of the worker pools. The auto-detected frame thread count is pinned,
+     * VBV uses the consistent (const-vbv) algorithm, lookahead slices are kept
+     * when no pool is available and row level VBV only reads rate control state
+     * sampled when the frame began. Default disabled */
+    int       bDeterministic;
+
+    /* Format of the multi-pass stats file written when rc.bStatWrite is set.
+     * X265_STATS_FORMAT_TEXT writes the human readable per-frame lines,
+     * X265_STATS_FORMAT_BINARY writes fixed size records which are memory
+     * mapped when read back, avoiding the text parse at the start of the
+     * next pass. The format of an input stats file is detected automatically.
+     * Default X265_STATS_FORMAT_TEXT */
+    int       statsFormat;
+
+    /* Minimum length in frames of the segments planned from the stats file of
+     * a previous pass. Segments begin on closed GOP IDR frames and each one is
+     * given its share of the 2-pass bit allocation together with the VBV
+     * fullness that allocation expects at its first and last frame, so that
+     * segments encoded independently concatenate into one stream which obeys
+     * the VBV model of the whole. Requires 2-pass ABR. Default 0 (disabled) */
+    int       segmentFrames;
+
+    /* Index of the planned segment to encode when reading a stats file. The
+     * input must begin at the first frame of the segment. -1 encodes every
+     * frame of the stats file. Default -1 */
+    int       segmentIndex;
+
+    /* Filename the segment plan is written to, one line per segment with its
+     * first frame, frame count, bit budget and VBV fullness at both ends. The
+     * x265 CLI exits once the plan is written. Default NULL */
+    const char* segmentPlanFile;
+
+    /* Let ABR and VBV frames begin rate control as soon as the previous frame
+     * has chosen its QP, without waiting for its mid-frame bit statistics. The
+     * statistics are folded into the totals when they arrive and row level VBV
+     * corrects the speculative QP by the difference between the planned and
+     * the actual size of preceding frames which complete meanwhile. Ignored
+     * in deterministic mode. Default disabled */
+    int       bSpeculativeRC;
+
+    /* Prune CU recursion and mode analysis of P and B slices with decision
+     * trees predicting whether a CU will be split or skipped, from features
+     * the encoder has already computed (costs, source variance, lowres costs,
+     * neighbour and co-located depths and cuTree offsets). Default disabled */
+    int       bEnableCUPredictor;
+
+    /* Filename of the decision trees used by the CU predictor. Built-in trees
+     * are used when NULL. Default NULL */
+    const char* cuPredictorModel;
+
+    /* Filename of a CSV file receiving the features of every CU the predictor
+     * evaluates together with the final split and skip decisions, for training
+     * trees offline. Does not require bEnableCUPredictor. Default NULL */
+    const char* cuPredictorDump;
+
+    /* Adapt the full resolution motion search of each PU to the confidence
+     * of the lookahead's motion vector for the block it covers. Vectors with
+     * a low lowres inter cost relative to the intra cost, or which agree with
+     * their neighbours, shrink the search range to little more than the
+     * distance from the MVP to the lowres vector; when both hold the search
+     * method is also reduced to hex. Default disabled */
+    int       bLowresMVConfidence;
+
+    /* Size in KiB of the sub-pel interpolation cache of each worker thread. The
+     * cache holds interpolated luma of the reference frames around the CTU
+     * being analysed, filled in 16x16 tiles as motion search and motion
+     * compensation request them, so that each sub-pel position is
+     * interpolated once per CTU. 0 disables the cache. Default 0 */
+    int       subpelCacheSize;
+
+    /* Precompute the three half-pel luma planes of every reference frame as
+     * its rows are reconstructed, so that motion estimation reads half-pel
+     * candidates directly instead of interpolating them for each refinement.
+     * Costs three luma planes of memory per reference frame. Ignored with
+     * more than one slice. Default disabled */
+    int       bHpelPlanes;
+
+    /* Schedule the mode analysis of --pmode through a graph of tasks
+     * spanning the whole CTU. Worker threads stay bonded to the CTU rather
+     * than to each CU, and when reference limiting does not depend on sub-CU
+     * decisions the inter modes of a CU are analysed while its sub-CUs are
+     * being decided. Output is identical to --pmode. Requires
+     * bDistributeModeAnalysis. Default disabled */
+    int       bPModeGraph;
+
+    /* Approximate RDOQ: quantized levels of 4 or more are kept without measuring
+     * the cost of coding them one smaller, halving the rate estimates of large
+     * coefficients. Trades a small loss in compression for faster RDOQ at low
+     * QPs. Has no effect without rdoqLevel. Default disabled */
+    int       bRdoqApprox;
+
+    /* Rank merge candidates and motion search results in RD analysis (rdLevel
+     * 3 and above) by the bits CABAC would spend on their prediction info,
+     * estimated from the current contexts, instead of approximate code
+     * lengths. Default disabled */
+    int       bRateEstimate;
+
+    /* Compare the bits estimated for the prediction info of inter CUs during
+     * analysis with the bits counted when the CU is coded, and log the error
+     * at the end of the encode. Default disabled */
+    int       bRateEstimateCheck;
+
+    /* Hash the luma plane of each CTU row for the decoded picture hash SEI in
+     * a job of its own, in parallel with the chroma planes and the PSNR and
+     * SSIM measurements of the row. Requires WPP and a thread pool, and has no
+     * effect with multiple slices. Default disabled */
+    int       bParallelHash;
+
+    /* Measure VMAF elementary features of each frame, VIF at four scales, ADM
+     * and motion, on the luma of the recon against the source, and report them
+     * in the frame stats and CSV log. Computed by the encoder itself, so libvmaf
+     * is not needed; the features approximate those of libvmaf and no model is
+     * applied to them. Default disabled */
+    int       bVmafFeatures;
+
+    /* Code SAO off for CTUs coded entirely as a zero-motion skip from a
+     * reference which used SAO, instead of gathering statistics and deciding
+     * the parameters again. Their recon copies already filtered samples, which
+     * new offsets would filter twice. Meant for static content such as screen
+     * sharing and lectures, where such CTUs are common. The number of these
+     * CTUs is reported in the frame stats. Default disabled */
+    int       bSaoSkipCopied;
+
+    /* Neither deblock nor SAO filter the recon of pictures which are never
+     * referenced, since nothing but the recon output and the quality metrics
+     * read it; SAO is disabled in their slices. Has no effect when PSNR, SSIM,
+     * VMAF features or a decoded picture hash are requested. The recon of
+     * those pictures returned by x265_encoder_encode() is unfiltered. Default
+     * disabled */
+    int       bSkipNonRefFilter;
 } x265_param;
 
 /* x265_param_alloc:
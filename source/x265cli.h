@@ -49,8 +49,14 @@ static const struct option long_options[] =
     { "frame-threads",  required_argument, NULL, 'F' },
     { "no-pmode",             no_argument, NULL, 0 },
     { "pmode",                no_argument, NULL, 0 },
+    { "no-pmode-graph",       no_argument, NULL, 0 },
+    { "pmode-graph",          no_argument, NULL, 0 },
     { "no-pme",               no_argument, NULL, 0 },
     { "pme",                  no_argument, NULL, 0 },
+    { "no-deterministic",     no_argument, NULL, 0 },
+    { "deterministic",        no_argument, NULL, 0 },
+    { "no-speculative-rc",    no_argument, NULL, 0 },
+    { "speculative-rc",       no_argument, NULL, 0 },
     { "log-level",      required_argument, NULL, 0 },
     { "profile",        required_argument, NULL, 'P' },
     { "level-idc",      required_argument, NULL, 0 },
@@ -67,6 +73,8 @@ static const struct option long_options[] =
     { "no-progress",          no_argument, NULL, 0 },
     { "output",         required_argument, NULL, 'o' },
     { "output-depth",   required_argument, NULL, 'D' },
+    { "ladder",         required_argument, NULL, 0 },
+    { "ladder-share",   required_argument, NULL, 0 },
     { "input",          required_argument, NULL, 0 },
     { "input-depth",    required_argument, NULL, 0 },
     { "input-res",      required_argument, NULL, 0 },
@@ -98,6 +106,11 @@ static const struct option long_options[] =
     { "hme",                  no_argument, NULL, 0 },
     { "no-hme",               no_argument, NULL, 0 },
     { "hme-search",     required_argument, NULL, 0 },
+    { "lowres-mv-confidence", no_argument, NULL, 0 },
+    { "no-lowres-mv-confidence", no_argument, NULL, 0 },
+    { "subpel-cache",   required_argument, NULL, 0 },
+    { "hpel-planes",          no_argument, NULL, 0 },
+    { "no-hpel-planes",       no_argument, NULL, 0 },
     { "rdpenalty",      required_argument, NULL, 0 },
     { "no-rect",              no_argument, NULL, 0 },
     { "rect",                 no_argument, NULL, 0 },
@@ -107,6 +120,10 @@ static const struct option long_options[] =
     { "early-skip",           no_argument, NULL, 0 },
     { "no-rskip",             no_argument, NULL, 0 },
     { "rskip",                no_argument, NULL, 0 },
+    { "no-cu-predictor",      no_argument, NULL, 0 },
+    { "cu-predictor",         no_argument, NULL, 0 },
+    { "cu-predictor-model", required_argument, NULL, 0 },
+    { "cu-predictor-dump", required_argument, NULL, 0 },
     { "no-fast-cbf",          no_argument, NULL, 0 },
     { "fast-cbf",             no_argument, NULL, 0 },
     { "no-tskip",             no_argument, NULL, 0 },
@@ -168,6 +185,9 @@ static const struct option long_options[] =
     { "vbv-end-fr-adj", required_argument, NULL, 0 },
     { "chunk-start",    required_argument, NULL, 0 },
     { "chunk-end",      required_argument, NULL, 0 },
+    { "segment-frames", required_argument, NULL, 0 },
+    { "segment-index",  required_argument, NULL, 0 },
+    { "segment-plan",   required_argument, NULL, 0 },
     { "bitrate",        required_argument, NULL, 0 },
     { "qp",             required_argument, NULL, 'q' },
     { "aq-mode",        required_argument, NULL, 0 },
@@ -190,6 +210,12 @@ static const struct option long_options[] =
     { "rd",             required_argument, NULL, 0 },
     { "rdoq-level",     required_argument, NULL, 0 },
     { "no-rdoq-level",        no_argument, NULL, 0 },
+    { "rdoq-approx",          no_argument, NULL, 0 },
+    { "no-rdoq-approx",       no_argument, NULL, 0 },
+    { "rate-est",             no_argument, NULL, 0 },
+    { "no-rate-est",          no_argument, NULL, 0 },
+    { "rate-est-check",       no_argument, NULL, 0 },
+    { "no-rate-est-check",    no_argument, NULL, 0 },
     { "dynamic-rd",     required_argument, NULL, 0 },
     { "psy-rd",         required_argument, NULL, 0 },
     { "psy-rdoq",       required_argument, NULL, 0 },
@@ -211,11 +237,19 @@ static const struct option long_options[] =
     { "sao",                  no_argument, NULL, 0 },
     { "no-sao-non-deblock",   no_argument, NULL, 0 },
     { "sao-non-deblock",      no_argument, NULL, 0 },
+    { "no-sao-skip-copied",   no_argument, NULL, 0 },
+    { "sao-skip-copied",      no_argument, NULL, 0 },
+    { "no-skip-nonref-filter", no_argument, NULL, 0 },
+    { "skip-nonref-filter",   no_argument, NULL, 0 },
     { "no-ssim",              no_argument, NULL, 0 },
     { "ssim",                 no_argument, NULL, 0 },
     { "no-psnr",              no_argument, NULL, 0 },
     { "psnr",                 no_argument, NULL, 0 },
+    { "no-vmaf-features",     no_argument, NULL, 0 },
+    { "vmaf-features",        no_argument, NULL, 0 },
     { "hash",           required_argument, NULL, 0 },
+    { "parallel-hash",        no_argument, NULL, 0 },
+    { "no-parallel-hash",     no_argument, NULL, 0 },
     { "no-strong-intra-smoothing", no_argument, NULL, 0 },
     { "strong-intra-smoothing",    no_argument, NULL, 0 },
     { "no-cutree",                 no_argument, NULL, 0 },
@@ -264,6 +298,7 @@ static const struct option long_options[] =
     { "nr-intra",       required_argument, NULL, 0 },
     { "nr-inter",       required_argument, NULL, 0 },
     { "stats",          required_argument, NULL, 0 },
+    { "stats-format",   required_argument, NULL, 0 },
     { "pass",           required_argument, NULL, 0 },
     { "multi-pass-opt-analysis", no_argument, NULL, 0 },
     { "no-multi-pass-opt-analysis",    no_argument, NULL, 0 },
@@ -383,6 +418,8 @@ static void showHelp(x265_param *param)
     H0("\nOutput Options:\n");
     H0("-o/--output <filename>           Bitstream output file name\n");
     H0("-D/--output-depth 8|10|12        Output bit depth (also internal bit depth). Default %d\n", param->internalBitDepth);
+    H0("   --ladder <kbps,kbps,...>      Also encode each half size rung at the given bitrates, one per rung. Default disabled\n");
+    H0("   --ladder-share <string>       What the smallest ladder rung hands on to the others: none, types, analysis. Default types\n");
     H0("   --log-level <string>          Logging level: none error warning info debug full. Default %s\n", X265_NS::logLevelNames[param->logLevel + 1]);
     H0("   --no-progress                 Disable CLI progress reports\n");
     H0("   --csv <filename>              Comma separated log file, if csv-log-level > 0 frame level statistics, else one line per run\n");
@@ -415,6 +452,7 @@ static void showHelp(x265_param *param)
     H0("\nQuality reporting metrics:\n");
     H0("   --[no-]ssim                   Enable reporting SSIM metric scores. Default %s\n", OPT(param->bEnableSsim));
     H0("   --[no-]psnr                   Enable reporting PSNR metric scores. Default %s\n", OPT(param->bEnablePsnr));
+    H0("   --[no-]vmaf-features          Enable reporting VIF, ADM and motion features of each frame. Default %s\n", OPT(param->bVmafFeatures));
     H0("\nProfile, Level, Tier:\n");
     H0("-P/--profile <string>            Enforce an encode profile: main, main10, mainstillpicture\n");
     H0("   --level-idc <integer|float>   Force a minimum required decoder level (as '5.0' or '50')\n");
@@ -428,7 +466,10 @@ static void showHelp(x265_param *param)
     H0("   --[no-]wpp                    Enable Wavefront Parallel Processing. Default %s\n", OPT(param->bEnableWavefront));
     H0("   --[no-]slices <integer>       Enable Multiple Slices feature. Default %d\n", param->maxSlices);
     H0("   --[no-]pmode                  Parallel mode analysis. Default %s\n", OPT(param->bDistributeModeAnalysis));
+    H1("   --[no-]pmode-graph            Schedule parallel mode analysis across the CTU. Default %s\n", OPT(param->bPModeGraph));
     H0("   --[no-]pme                    Parallel motion estimation. Default %s\n", OPT(param->bDistributeMotionEstimation));
+    H0("   --[no-]deterministic          Output independent of thread scheduling and pool size. Default %s\n", OPT(param->bDeterministic));
+    H1("   --[no-]speculative-rc         Start ABR/VBV frames before the previous frame's row statistics are known. Default %s\n", OPT(param->bSpeculativeRC));
     H0("   --[no-]asm <bool|int|string>  Override CPU detection. Default: auto\n");
     H0("\nPresets:\n");
     H0("-p/--preset <string>             Trade off performance for compression efficiency. Default medium\n");
@@ -444,14 +485,20 @@ static void showHelp(x265_param *param)
     H0("   --limit-tu <0..4>             Enable early exit from TU recursion for inter coded blocks. Default %d\n", param->limitTU);
     H0("\nAnalysis:\n");
     H0("   --rd <1..6>                   Level of RDO in mode decision 1:least....6:full RDO. Default %d\n", param->rdLevel);
+    H1("   --[no-]rate-est               Rank inter candidates by CABAC estimates of their motion bits at rd 3 and above. Default %s\n", OPT(param->bRateEstimate));
+    H1("   --[no-]rate-est-check         Log the error of motion bits estimated in analysis against coded bits. Default %s\n", OPT(param->bRateEstimateCheck));
     H0("   --[no-]psy-rd <0..5.0>        Strength of psycho-visual rate distortion optimization, 0 to disable. Default %.1f\n", param->psyRd);
     H0("   --[no-]rdoq-level <0|1|2>     Level of RDO in quantization 0:none, 1:levels, 2:levels & coding groups. Default %d\n", param->rdoqLevel);
+    H1("   --[no-]rdoq-approx            Keep quantized levels of 4 or more in RDOQ without trying one less. Default %s\n", OPT(param->bRdoqApprox));
     H0("   --[no-]psy-rdoq <0..50.0>     Strength of psycho-visual optimization in RDO quantization, 0 to disable. Default %.1f\n", param->psyRdoq);
     H0("   --dynamic-rd <0..4.0>         Strength of dynamic RD, 0 to disable. Default %.2f\n", param->dynamicRd);
     H0("   --[no-]ssim-rd                Enable ssim rate distortion optimization, 0 to disable. Default %s\n", OPT(param->bSsimRd));
     H0("   --[no-]rd-refine              Enable QP based RD refinement for rd levels 5 and 6. Default %s\n", OPT(param->bEnableRdRefine));
     H0("   --[no-]early-skip             Enable early SKIP detection. Default %s\n", OPT(param->bEnableEarlySkip));
     H0("   --[no-]rskip                  Enable early exit from recursion. Default %s\n", OPT(param->bEnableRecursionSkip));
+    H1("   --[no-]cu-predictor           Prune inter CU recursion and modes with split/skip decision trees. Default %s\n", OPT(param->bEnableCUPredictor));
+    H1("   --cu-predictor-model <file>   Decision trees of the CU predictor. Default built-in\n");
+    H1("   --cu-predictor-dump <file>    Write CU features and decisions as CSV for training. Default none\n");
     H1("   --[no-]tskip-fast             Enable fast intra transform skipping. Default %s\n", OPT(param->bEnableTSkipFast));
     H1("   --[no-]splitrd-skip           Enable skipping split RD analysis when sum of split CU rdCost larger than one split CU rdCost for Intra CU. Default %s\n", OPT(param->bEnableSplitRdSkip));
     H1("   --nr-intra <integer>          An integer value in range of 0 to 2000, which denotes strength of noise reduction in intra CUs. Default 0\n");
@@ -481,6 +528,9 @@ static void showHelp(x265_param *param)
     H1("   --[no-]hme                    Enable Hierarchical Motion Estimation. Default %s\n", OPT(param->bEnableHME));
     H1("   --hme-search <string>         Motion search-method for HME L0,L1 and L2. Default(L0,L1,L2) is %d,%d,%d\n", param->hmeSearchMethod[0], param->hmeSearchMethod[1], param->hmeSearchMethod[2]);
     H1("   --hme-range <int>,<int>,<int> Motion search-range for HME L0,L1 and L2. Default(L0,L1,L2) is %d,%d,%d\n", param->hmeRange[0], param->hmeRange[1], param->hmeRange[2]);
+    H1("   --[no-]lowres-mv-confidence   Narrow motion searches where lookahead MVs are reliable. Default %s\n", OPT(param->bLowresMVConfidence));
+    H1("   --subpel-cache <integer>      KiB per worker for caching sub-pel interpolated reference luma. 0 disables. Default %d\n", param->subpelCacheSize);
+    H1("   --[no-]hpel-planes            Precompute half-pel luma planes of reference frames. Default %s\n", OPT(param->bHpelPlanes));
     H0("\nSpatial / intra options:\n");
     H0("   --[no-]strong-intra-smoothing Enable strong intra smoothing for 32x32 blocks. Default %s\n", OPT(param->bEnableStrongIntraSmoothing));
     H0("   --[no-]constrained-intra      Constrained intra prediction (use only intra coded reference pixels) Default %s\n", OPT(param->bEnableConstrainedIntra));
@@ -536,6 +586,9 @@ static void showHelp(x265_param *param)
     H0("   --vbv-end-fr-adj <float>      Frame from which qp has to be adjusted to achieve final decode buffer emptiness. Default 0\n");
     H0("   --chunk-start <integer>       First frame of the chunk. Default 0 (disabled)\n");
     H0("   --chunk-end <integer>         Last frame of the chunk. Default 0 (disabled)\n");
+    H1("   --segment-frames <integer>    Minimum length of the segments planned from a 2-pass stats file. Default 0 (disabled)\n");
+    H1("   --segment-index <integer>     Planned segment to encode in 2-pass, -1 for all. Default %d\n", param->segmentIndex);
+    H1("   --segment-plan <filename>     Write the segment plan and exit without encoding. Default none\n");
     H0("   --pass                        Multi pass rate control.\n"
        "                                   - 1 : First pass, creates stats file\n"
        "                                   - 2 : Last pass, does not overwrite stats file\n"
@@ -543,6 +596,7 @@ static void showHelp(x265_param *param)
     H0("   --[no-]multi-pass-opt-analysis   Refine analysis in 2 pass based on analysis information from pass 1\n");
     H0("   --[no-]multi-pass-opt-distortion Use distortion of CTU from pass 1 to refine qp in 2 pass\n");
     H0("   --stats                       Filename for stats file in multipass pass rate control. Default x265_2pass.log\n");
+    H1("   --stats-format <string>       Format of the stats file written in multipass rate control: text, binary. Default %s\n", x265_stats_format_names[param->statsFormat]);
     H0("   --[no-]analyze-src-pics       Motion estimation uses source frame planes. Default disable\n");
     H0("   --[no-]slow-firstpass         Enable a slow first pass in a multipass rate control mode. Default %s\n", OPT(param->rc.bEnableSlowFirstPass));
     H0("   --[no-]strict-cbr             Enable stricter conditions and tolerance for bitrate deviations in CBR mode. Default %s\n", OPT(param->rc.bStrictCbr));
@@ -609,6 +663,8 @@ static void showHelp(x265_param *param)
     H1("   --[no-]sao-non-deblock        Use non-deblocked pixels, else right/bottom boundary areas skipped. Default %s\n", OPT(param->bSaoNonDeblocked));
     H0("   --[no-]limit-sao              Limit Sample Adaptive Offset types. Default %s\n", OPT(param->bLimitSAO));
     H0("   --selective-sao <int>         Enable slice-level SAO filter. Default %d\n", param->selectiveSAO);
+    H1("   --[no-]sao-skip-copied        Code SAO off for zero-motion skipped CTUs of a SAO filtered reference. Default %s\n", OPT(param->bSaoSkipCopied));
+    H1("   --[no-]skip-nonref-filter     Skip deblocking and SAO of pictures which are never referenced. Default %s\n", OPT(param->bSkipNonRefFilter));
     H0("\nVUI options:\n");
     H0("   --sar <width:height|int>      Sample Aspect Ratio, the ratio of width to height of an individual pixel.\n");
     H0("                                 Choose from 0=undef, 1=1:1(\"square\"), 2=12:11, 3=10:11, 4=16:11,\n");
@@ -642,6 +698,7 @@ static void showHelp(x265_param *param)
     H0("   --[no-]temporal-layers        Enable a temporal sublayer for unreferenced B frames. Default %s\n", OPT(param->bEnableTemporalSubLayers));
     H0("   --[no-]aud                    Emit access unit delimiters at the start of each access unit. Default %s\n", OPT(param->bEnableAccessUnitDelimiters));
     H1("   --hash <integer>              Decoded Picture Hash SEI 0: disabled, 1: MD5, 2: CRC, 3: Checksum. Default %d\n", param->decodedPictureHashSEI);
+    H1("   --[no-]parallel-hash          Hash the luma of each CTU row in parallel with the chroma planes. Default %s\n", OPT(param->bParallelHash));
     H0("   --atc-sei <integer>           Emit the alternative transfer characteristics SEI message where the integer is the preferred transfer characteristics. Default disabled\n");
     H0("   --pic-struct <integer>        Set the picture structure and emits it in the picture timing SEI message. Values in the range 0..12. See D.3.3 of the HEVC spec. for a detailed explanation.\n");
     H0("   --log2-max-poc-lsb <integer>  Maximum of the picture order count\n");